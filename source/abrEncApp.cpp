@@ -30,6 +30,7 @@
 #include <signal.h>
 #include <errno.h>
 
+#include <algorithm>
 #include <queue>
 
 using namespace X265_NS;
@@ -45,13 +46,29 @@ namespace X265_NS {
     // private namespace
 #define X265_INPUT_QUEUE_SIZE 250
 
-    AbrEncoder::AbrEncoder(CLIOptions cliopt[], uint8_t numEncodes, int &ret)
+    AbrEncoder::AbrEncoder(CLIOptions cliopt[], uint8_t numEncodes, const char* playlist, int &ret)
     {
         m_numEncodes = numEncodes;
+        m_playlist = playlist;
+        m_bAlignKeyframes = playlist && numEncodes > 1;
+        m_keyframesDecided.set(-1);
         m_numActiveEncodes.set(numEncodes);
         m_queueSize = (numEncodes > 1) ? X265_INPUT_QUEUE_SIZE : 1;
         m_passEnc = X265_MALLOC(PassEncoder*, m_numEncodes);
 
+        /* the encodes of a ladder run concurrently, let them share one set of
+         * worker threads (weighted by --pool-weight) rather than each of them
+         * spawning a thread per core. This requires all of them to use the
+         * same libx265 build */
+        m_context = NULL;
+        bool sameApi = true;
+        for (uint8_t i = 1; i < m_numEncodes; i++)
+            sameApi &= cliopt[i].api == cliopt[0].api;
+        if (m_numEncodes > 1 && sameApi)
+            m_context = cliopt[0].api->context_create(cliopt[0].param);
+        for (uint8_t i = 0; i < m_numEncodes; i++)
+            cliopt[i].param->context = m_context;
+
         for (uint8_t i = 0; i < m_numEncodes; i++)
         {
             m_passEnc[i] = new PassEncoder(i, cliopt[i], this);
@@ -63,6 +80,44 @@ namespace X265_NS {
             m_passEnc[i]->init(ret);
         }
 
+        if (m_playlist)
+        {
+            string dir(m_playlist);
+            size_t sep = dir.find_last_of("/\\");
+            dir = sep != string::npos ? dir.substr(0, sep + 1) : "";
+
+            for (uint8_t i = 0; i < m_numEncodes && m_playlist; i++)
+            {
+                CLIOptions& opt = m_passEnc[i]->m_cliopt;
+                if (!opt.output || strcmp(opt.output->getName(), "cmaf"))
+                {
+                    x265_log(NULL, X265_LOG_WARNING, "ladder playlist requires .cmaf outputs, not writing %s\n", m_playlist);
+                    m_playlist = NULL;
+                    break;
+                }
+
+                /* CMAFOutput keeps its media playlist next to the index */
+                Variant v;
+                v.uri = opt.outputName;
+                size_t dot = v.uri.rfind('.');
+                sep = v.uri.find_last_of("/\\");
+                if (dot != string::npos && (sep == string::npos || dot > sep))
+                    v.uri.erase(dot);
+                v.uri += ".m3u8";
+                if (!dir.empty() && !v.uri.compare(0, dir.size(), dir))
+                    v.uri.erase(0, dir.size());
+
+                x265_param* p = m_passEnc[i]->m_param;
+                v.width = p->sourceWidth - p->confWinRightOffset;
+                v.height = p->sourceHeight - p->confWinBottomOffset;
+                v.fps = (double)p->fpsNum / p->fpsDenom;
+                v.peakKbps = p->rc.vbvMaxBitrate ? p->rc.vbvMaxBitrate : p->rc.rateControlMode == X265_RC_ABR ? p->rc.bitrate : 0;
+                m_variants.push_back(v);
+            }
+            if (m_playlist && !writePlaylist())
+                m_playlist = NULL;
+        }
+
         if (!allocBuffers())
         {
             x265_log(NULL, X265_LOG_ERROR, "Unable to allocate memory for buffers\n");
@@ -109,8 +164,89 @@ namespace X265_NS {
         return false;
     }
 
+    void AbrEncoder::publishKeyframe(int poc, int sliceType)
+    {
+        if (IS_X265_TYPE_I(sliceType))
+        {
+            ScopedLock lock(m_keyframeLock);
+            Keyframe k = { poc, sliceType };
+            m_keyframes.push_back(k);
+        }
+        if (poc > m_keyframesDecided.get())
+            m_keyframesDecided.set(poc);
+    }
+
+    void AbrEncoder::endKeyframes()
+    {
+        m_keyframesDecided.set(INT_MAX);
+    }
+
+    static bool keyframeBefore(const AbrEncoder::Keyframe& k, int poc)
+    {
+        return k.poc < poc;
+    }
+
+    /* Returns the slice type the first encode gave the picture, or AUTO if it
+     * was not a keyframe. Pictures leave the encoder in decode order, and no
+     * picture following a keyframe in decode order precedes it in display
+     * order; so once a higher POC was output, a keyframe at this POC would
+     * have been published already */
+    int AbrEncoder::alignedSliceType(int poc)
+    {
+        int decided = m_keyframesDecided.get();
+        while (decided < poc)
+            decided = m_keyframesDecided.waitForChange(decided);
+
+        ScopedLock lock(m_keyframeLock);
+        std::vector<Keyframe>::iterator it = std::lower_bound(m_keyframes.begin(), m_keyframes.end(), poc, keyframeBefore);
+        return it != m_keyframes.end() && it->poc == poc ? it->sliceType : X265_TYPE_AUTO;
+    }
+
+    /* Writes the HLS master playlist of the ladder. Before the encodes have
+     * finished the bandwidth of a rung without a VBV or ABR target is not
+     * known; the playlist is rewritten with the measured bitrates at the end */
+    bool AbrEncoder::writePlaylist()
+    {
+        string name(m_playlist);
+        string tmpName = name + ".tmp";
+        FILE* fp = x265_fopen(tmpName.c_str(), "wb");
+        if (!fp)
+        {
+            x265_log_file(NULL, X265_LOG_ERROR, "unable to open ladder playlist %s\n", tmpName.c_str());
+            return false;
+        }
+
+        fprintf(fp, "#EXTM3U\n#EXT-X-VERSION:7\n#EXT-X-INDEPENDENT-SEGMENTS\n");
+        for (size_t i = 0; i < m_variants.size(); i++)
+        {
+            const Variant& v = m_variants[i];
+            double average = m_passEnc[i]->m_bitrate;
+            double peak = X265_MAX((double)v.peakKbps, average);
+            fprintf(fp, "#EXT-X-STREAM-INF:BANDWIDTH=%.0f", peak * 1000);
+            if (average > 0)
+                fprintf(fp, ",AVERAGE-BANDWIDTH=%.0f", average * 1000);
+            fprintf(fp, ",RESOLUTION=%dx%d,FRAME-RATE=%.3f\n%s\n", v.width, v.height, v.fps, v.uri.c_str());
+        }
+
+        bool ok = !ferror(fp);
+        ok &= !fclose(fp);
+#ifdef _WIN32
+        remove(name.c_str());
+#endif
+        if (!ok || rename(tmpName.c_str(), name.c_str()))
+        {
+            x265_log_file(NULL, X265_LOG_ERROR, "unable to write ladder playlist %s\n", name.c_str());
+            return false;
+        }
+        return true;
+    }
+
     void AbrEncoder::destroy()
     {
+        if (m_playlist)
+            writePlaylist();
+        if (m_context)
+            m_passEnc[0]->m_cliopt.api->context_free(m_context);
         x265_cleanup(); /* Free library singletons */
         for (uint8_t pass = 0; pass < m_numEncodes; pass++)
         {
@@ -159,6 +295,7 @@ namespace X265_NS {
         m_scaler = NULL;
         m_reader = NULL;
         m_ret = 0;
+        m_bitrate = 0;
     }
 
     int PassEncoder::init(int &result)
@@ -195,6 +332,19 @@ namespace X265_NS {
             }
         }
         m_cliopt.output->setParam(m_param);
+
+        if (m_parent->m_bAlignKeyframes && m_id)
+        {
+            /* keyframes are placed by the first encode, this one must not
+             * start a GOP on its own before the first one does */
+            x265_param* top = m_parent->m_passEnc[0]->m_param;
+            m_param->keyframeMax = top->keyframeMax == INT_MAX ? -1 : top->keyframeMax + 1;
+            m_param->keyframeMin = top->keyframeMin;
+            m_param->scenecutThreshold = 0;
+            m_param->bHistBasedSceneCut = 0;
+            m_param->bOpenGOP = top->bOpenGOP;
+        }
+
         /* note: we could try to acquire a different libx265 API here based on
         * the profile found during option parsing, but it must be done before
         * opening an encoder */
@@ -541,7 +691,9 @@ ret:
             x265_picture *pic_in = &pic_orig;
             /* Allocate recon picture if analysis save/load is enabled */
             std::priority_queue<int64_t>* pts_queue = m_cliopt.output->needPTS() ? new std::priority_queue<int64_t>() : NULL;
-            x265_picture *pic_recon = (m_cliopt.recon || m_param->analysisSave || m_param->analysisLoad || pts_queue || reconPlay || m_param->csvLogLevel) ? &pic_out : NULL;
+            x265_picture *pic_recon = (m_cliopt.recon || m_param->analysisSave || m_param->analysisLoad || pts_queue || reconPlay || m_param->csvLogLevel || (m_parent->m_bAlignKeyframes && !m_id)) ? &pic_out : NULL;
+            bool bPublishKeyframes = m_parent->m_bAlignKeyframes && !m_id;
+            bool bAlignKeyframes = m_parent->m_bAlignKeyframes && m_id;
             uint32_t inFrameCount = 0;
             uint32_t outFrameCount = 0;
             x265_nal *p_nal;
@@ -736,6 +888,13 @@ ret:
                     else
                         picInput = pic_in;
 
+                    if (bAlignKeyframes && picInput)
+                    {
+                        int sliceType = m_parent->alignedSliceType(picInput->poc);
+                        if (sliceType != X265_TYPE_AUTO || IS_X265_TYPE_I(picInput->sliceType))
+                            picInput->sliceType = sliceType;
+                    }
+
                     int numEncoded = api->encoder_encode(m_encoder, &p_nal, &nal, picInput, pic_recon);
 
                     int idx = (inFrameCount - 1) % m_parent->m_queueSize;
@@ -759,6 +918,9 @@ ret:
 
                     outFrameCount += numEncoded;
 
+                    if (bPublishKeyframes && numEncoded)
+                        m_parent->publishKeyframe(pic_out.poc, pic_out.sliceType);
+
                     if (isAbrSave && numEncoded)
                     {
                         copyInfo(analysisInfo);
@@ -769,6 +931,13 @@ ret:
                     if (nal)
                     {
                         m_cliopt.totalbytes += m_cliopt.output->writeFrame(p_nal, nal, pic_out);
+                        if (m_cliopt.output->isFail())
+                        {
+                            x265_log(m_param, X265_LOG_ERROR, "failure writing output file in %s\n", profileName);
+                            b_ctrl_c = 1;
+                            m_ret = 5;
+                            break;
+                        }
                         if (pts_queue)
                         {
                             pts_queue->push(-pic_out.pts);
@@ -794,6 +963,8 @@ ret:
                     reconPlay->writePicture(*pic_recon);
 
                 outFrameCount += numEncoded;
+                if (bPublishKeyframes && numEncoded)
+                    m_parent->publishKeyframe(pic_out.poc, pic_out.sliceType);
                 if (isAbrSave && numEncoded)
                 {
                     copyInfo(analysisInfo);
@@ -804,6 +975,12 @@ ret:
                 if (nal)
                 {
                     m_cliopt.totalbytes += m_cliopt.output->writeFrame(p_nal, nal, pic_out);
+                    if (m_cliopt.output->isFail())
+                    {
+                        x265_log(m_param, X265_LOG_ERROR, "failure writing output file in %s\n", profileName);
+                        m_ret = 5;
+                        break;
+                    }
                     if (pts_queue)
                     {
                         pts_queue->push(-pic_out.pts);
@@ -827,6 +1004,9 @@ ret:
                     profileName);
             }
 
+            /* account for the frames still queued for the output writer */
+            m_cliopt.totalbytes += m_cliopt.output->flush();
+
             /* clear progress report */
             if (m_cliopt.bProgress)
             {
@@ -846,7 +1026,12 @@ ret:
 
             delete reconPlay;
 
+            /* release the encodes waiting for keyframe decisions */
+            if (bPublishKeyframes)
+                m_parent->endKeyframes();
+
             api->encoder_get_stats(m_encoder, &stats, sizeof(stats));
+            m_bitrate = stats.bitrate;
             if (m_param->csvfn && !b_ctrl_c)
 #if ENABLE_LIBVMAF
                 api->vmaf_encoder_log(m_encoder, m_cliopt.argCnt, m_cliopt.argString, m_cliopt.param, vmafdata);
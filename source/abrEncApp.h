@@ -31,6 +31,9 @@
 #include "threading.h"
 #include "x265cli.h"
 
+#include <string>
+#include <vector>
+
 namespace X265_NS {
     // private namespace
 
@@ -45,6 +48,7 @@ namespace X265_NS {
         PassEncoder        **m_passEnc;
         uint32_t           m_queueSize;
         ThreadSafeInteger  m_numActiveEncodes;
+        x265_context       *m_context; // thread pools shared by all encodes
 
         x265_picture       ***m_inputPicBuffer; //[numEncodes][queueSize]
         x265_analysis_data **m_analysisBuffer; //[numEncodes][queueSize]
@@ -58,10 +62,41 @@ namespace X265_NS {
         ThreadSafeInteger  **m_analysisWrite; //[numEncodes][queueSize]
         ThreadSafeInteger  **m_analysisRead; //[numEncodes][queueSize]
 
-        AbrEncoder(CLIOptions cliopt[], uint8_t numEncodes, int& ret);
+        /* With a ladder playlist the keyframes of every encode are aligned to
+         * those of the first encode, so that segments switch cleanly between
+         * the rungs. The first encode publishes its keyframes as it outputs
+         * them; the others force the same slice types on their input */
+        struct Keyframe
+        {
+            int poc;
+            int sliceType;
+        };
+
+        struct Variant
+        {
+            std::string uri;   // media playlist, relative to the master playlist
+            int    width;
+            int    height;
+            double fps;
+            int    peakKbps;   // 0 when only known once the encode has finished
+        };
+
+        const char*        m_playlist;
+        std::vector<Variant> m_variants;
+        bool               m_bAlignKeyframes;
+        Lock               m_keyframeLock;
+        std::vector<Keyframe> m_keyframes;     // in decode (and POC) order
+        ThreadSafeInteger  m_keyframesDecided; // highest POC output by the first encode, INT_MAX once it ended
+
+        AbrEncoder(CLIOptions cliopt[], uint8_t numEncodes, const char* playlist, int& ret);
         bool allocBuffers();
         void destroy();
 
+        void publishKeyframe(int poc, int sliceType);
+        void endKeyframes();
+        int  alignedSliceType(int poc);
+        bool writePlaylist();
+
     };
 
     class PassEncoder : public Thread
@@ -93,6 +128,7 @@ namespace X265_NS {
         FILE*    m_dolbyVisionRpu;/* File containing Dolby Vision BL RPU metadata */
 
         int m_ret;
+        double m_bitrate; // average kbps of the finished encode
 
         PassEncoder(uint32_t id, CLIOptions cliopt, AbrEncoder *parent);
         int init(int &result);
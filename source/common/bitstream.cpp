@@ -1,5 +1,6 @@
 #include "common.h"
 #include "bitstream.h"
+#include "primitives.h"
 #include "threading.h"
 
 using namespace X265_NS;
@@ -13,96 +14,104 @@ using namespace X265_NS;
 Bitstream::Bitstream()
 {
     m_fifo = X265_MALLOC(uint8_t, MIN_FIFO_SIZE);
-    m_byteAlloc = MIN_FIFO_SIZE;
+    m_byteAlloc = m_fifo ? MIN_FIFO_SIZE : 0;
     resetBits();
 }
 
-void Bitstream::push_back(uint8_t val)
+bool Bitstream::grow(uint32_t size)
 {
     if (!m_fifo)
-        return;
+        return false;
 
-    if (m_byteOccupancy >= m_byteAlloc)
+    /** reallocate buffer with at least doubled size */
+    uint32_t allocSize = X265_MAX(size, m_byteAlloc * 2);
+    uint8_t *temp = X265_MALLOC(uint8_t, allocSize);
+    if (!temp)
     {
-        /** reallocate buffer with doubled size */
-        uint8_t *temp = X265_MALLOC(uint8_t, m_byteAlloc * 2);
-        if (temp)
-        {
-            memcpy(temp, m_fifo, m_byteOccupancy);
-            X265_FREE(m_fifo);
-            m_fifo = temp;
-            m_byteAlloc *= 2;
-        }
-        else
-        {
-            x265_log(NULL, X265_LOG_ERROR, "Unable to realloc bitstream buffer");
-            return;
-        }
+        x265_log(NULL, X265_LOG_ERROR, "Unable to realloc bitstream buffer");
+        return false;
     }
-    m_fifo[m_byteOccupancy++] = val;
+
+    memcpy(temp, m_fifo, m_byteOccupancy);
+    X265_FREE(m_fifo);
+    m_fifo = temp;
+    m_byteAlloc = allocSize;
+    return true;
 }
 
-void Bitstream::write(uint32_t val, uint32_t numBits)
+/* move the oldest 32 cached bits to the FIFO, most significant byte first */
+void Bitstream::flushWord()
 {
-    X265_CHECK(numBits <= 32, "numBits out of range\n");
-    X265_CHECK(numBits == 32 || ((val & (~0u << numBits)) == 0), "numBits & val out of range\n");
+    X265_CHECK(m_cacheBits >= 32, "flushing incomplete word\n");
 
-    uint32_t totalPartialBits = m_partialByteBits + numBits;
-    uint32_t nextPartialBits = totalPartialBits & 7;
-    uint8_t  nextHeldByte = val << (8 - nextPartialBits);
-    uint32_t writeBytes = totalPartialBits >> 3;
+    m_cacheBits -= 32;
+    if (m_byteOccupancy + 4 > m_byteAlloc && !grow(m_byteOccupancy + 4))
+        return;
 
-    if (writeBytes)
-    {
-        /* topword aligns m_partialByte with the msb of val */
-        uint32_t topword = (numBits - nextPartialBits) & ~7;
-#if USING_FTRAPV
-        uint32_t write_bits = (topword < 32 ? m_partialByte << topword : 0) | (val >> nextPartialBits);
-#else
-        uint32_t write_bits = (m_partialByte << topword) | (val >> nextPartialBits);
-#endif
+    uint32_t word = (uint32_t)(m_cache >> m_cacheBits);
+    uint8_t* out = m_fifo + m_byteOccupancy;
+    out[0] = (uint8_t)(word >> 24);
+    out[1] = (uint8_t)(word >> 16);
+    out[2] = (uint8_t)(word >> 8);
+    out[3] = (uint8_t)word;
+    m_byteOccupancy += 4;
+}
 
-        switch (writeBytes)
-        {
-        case 4: push_back(write_bits >> 24);  // fall-through
-        case 3: push_back(write_bits >> 16);  // fall-through
-        case 2: push_back(write_bits >> 8);   // fall-through
-        case 1: push_back(write_bits);
-        }
+void Bitstream::flushBytes()
+{
+    uint32_t numBytes = m_cacheBits >> 3;
+    if (!numBytes)
+        return;
 
-        m_partialByte = nextHeldByte;
-        m_partialByteBits = nextPartialBits;
+    if (m_byteOccupancy + numBytes > m_byteAlloc && !grow(m_byteOccupancy + numBytes))
+    {
+        m_cacheBits &= 7;
+        return;
     }
-    else
+
+    while (m_cacheBits >= 8)
     {
-        m_partialByte |= nextHeldByte;
-        m_partialByteBits = nextPartialBits;
+        m_cacheBits -= 8;
+        m_fifo[m_byteOccupancy++] = (uint8_t)(m_cache >> m_cacheBits);
     }
 }
 
+void Bitstream::write(uint32_t val, uint32_t numBits)
+{
+    X265_CHECK(numBits <= 32, "numBits out of range\n");
+    X265_CHECK(numBits == 32 || ((val & (~0u << numBits)) == 0), "numBits & val out of range\n");
+
+    /* fewer than 32 bits are cached on entry, so the 64bit cache never
+     * overflows; bits above m_cacheBits are stale and never read */
+    m_cache = (m_cache << numBits) | val;
+    m_cacheBits += numBits;
+    if (m_cacheBits >= 32)
+        flushWord();
+}
+
 void Bitstream::writeByte(uint32_t val)
 {
     // Only CABAC will call writeByte, the fifo must be byte aligned
-    X265_CHECK(!m_partialByteBits, "expecting m_partialByteBits = 0\n");
+    X265_CHECK(!(m_cacheBits & 7), "expecting byte aligned bitstream\n");
 
-    push_back(val);
+    write(val & 0xff, 8);
 }
 
 void Bitstream::writeAlignOne()
 {
-    uint32_t numBits = (8 - m_partialByteBits) & 0x7;
+    uint32_t numBits = (8 - m_cacheBits) & 0x7;
 
     write((1 << numBits) - 1, numBits);
 }
 
 void Bitstream::writeAlignZero()
 {
-    if (m_partialByteBits)
-    {
-        push_back(m_partialByte);
-        m_partialByte = 0;
-        m_partialByteBits = 0;
-    }
+    uint32_t numBits = (8 - m_cacheBits) & 0x7;
+    m_cache <<= numBits;
+    m_cacheBits += numBits;
+
+    /* the FIFO is complete afterwards */
+    flushBytes();
 }
 
 void Bitstream::writeByteAlignment()
@@ -125,3 +134,23 @@ void SyntaxElementWriter::writeUvlc(uint32_t code)
     m_bitIf->write(0, length >> 1);
     m_bitIf->write(code, (length + 1) >> 1);
 }
+
+namespace {
+uint32_t findZeroPair_c(const uint8_t* src, uint32_t size)
+{
+    for (uint32_t i = 0; i + 1 < size; i++)
+    {
+        if (!src[i] && !src[i + 1])
+            return i;
+    }
+
+    return size;
+}
+}
+
+namespace X265_NS {
+void setupBitstreamPrimitives_c(EncoderPrimitives &p)
+{
+    p.findZeroPair = findZeroPair_c;
+}
+}
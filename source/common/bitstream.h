@@ -67,11 +67,12 @@ public:
     Bitstream();
     ~Bitstream()                             { X265_FREE(m_fifo); }
 
-    void     resetBits()                     { m_partialByteBits = m_byteOccupancy = 0; m_partialByte = 0; }
-    uint32_t getNumberOfWrittenBytes() const { return m_byteOccupancy; }
-    uint32_t getNumberOfWrittenBits()  const { return m_byteOccupancy * 8 + m_partialByteBits; }
-    const uint8_t* getFIFO() const           { return m_fifo; }
-    void     copyBits(Bitstream* stream)     { m_partialByteBits = stream->m_partialByteBits; m_byteOccupancy = stream->m_byteOccupancy; m_partialByte = stream->m_partialByte; }
+    void     resetBits()                     { m_byteOccupancy = m_cacheBits = 0; m_cache = 0; }
+    uint32_t getNumberOfWrittenBytes()       { flushBytes(); return m_byteOccupancy; } // whole bytes written
+    uint32_t getNumberOfWrittenBits()  const { return m_byteOccupancy * 8 + m_cacheBits; }
+    const uint8_t* getFIFO()                 { flushBytes(); return m_fifo; }
+    void     copyBits(Bitstream* stream)     { m_byteOccupancy = stream->m_byteOccupancy; m_cache = stream->m_cache; m_cacheBits = stream->m_cacheBits; }
+    void     reserve(uint32_t size)          { if (size > m_byteAlloc) grow(size); }
 
     void     write(uint32_t val, uint32_t numBits);
     void     writeByte(uint32_t val);
@@ -85,10 +86,12 @@ private:
     uint8_t *m_fifo;
     uint32_t m_byteAlloc;
     uint32_t m_byteOccupancy;
-    uint32_t m_partialByteBits;
-    uint8_t  m_partialByte;
+    uint64_t m_cache;      // bits not yet flushed to the FIFO, right aligned
+    uint32_t m_cacheBits;  // less than 32 between calls to write()
 
-    void     push_back(uint8_t val);
+    void     flushWord();
+    void     flushBytes();  // move the whole bytes of the cache to the FIFO
+    bool     grow(uint32_t size);
 };
 
 static const uint8_t bitSize[256] =
@@ -45,6 +45,9 @@
 #if ENABLE_PPA && ENABLE_VTUNE
 #error "PPA and VTUNE cannot both be enabled. Disable one of them."
 #endif
+#if ENABLE_EVENT_STATS && (ENABLE_PPA || ENABLE_VTUNE)
+#error "EVENT_STATS cannot be combined with PPA or VTUNE. Disable one of them."
+#endif
 #if ENABLE_PPA
 #include "profile/PPA/ppa.h"
 #define ProfileScopeEvent(x) PPAScopeEvent(x)
@@ -59,6 +62,13 @@
 #define PROFILE_INIT()       vtuneInit()
 #define PROFILE_PAUSE()      __itt_pause()
 #define PROFILE_RESUME()     __itt_resume()
+#elif ENABLE_EVENT_STATS
+#include "eventstats.h"
+#define ProfileScopeEvent(x) EventStatsScope _eventStats(x)
+#define THREAD_NAME(n,i)
+#define PROFILE_INIT()
+#define PROFILE_PAUSE()
+#define PROFILE_RESUME()
 #else
 #define ProfileScopeEvent(x)
 #define THREAD_NAME(n,i)
@@ -286,6 +286,7 @@ void CUData::initCTU(const Frame& frame, uint32_t cuAddr, int qp, uint32_t first
     m_cuPelX        = (cuAddr % m_slice->m_sps->numCuInWidth) << m_slice->m_param->maxLog2CUSize;
     m_cuPelY        = (cuAddr / m_slice->m_sps->numCuInWidth) << m_slice->m_param->maxLog2CUSize;
     m_absIdxInCTU   = 0;
+    m_firstAvailIdx = 0;
     m_numPartitions = m_encData->m_param->num4x4Partitions;
     m_bFirstRowInSlice = (uint8_t)firstRowInSlice;
     m_bLastRowInSlice  = (uint8_t)lastRowInSlice;
@@ -326,6 +327,7 @@ void CUData::initCTU(const Frame& frame, uint32_t cuAddr, int qp, uint32_t first
 void CUData::initSubCU(const CUData& ctu, const CUGeom& cuGeom, int qp)
 {
     m_absIdxInCTU   = cuGeom.absPartIdx;
+    m_firstAvailIdx = ctu.m_firstAvailIdx;
     m_encData       = ctu.m_encData;
     m_slice         = ctu.m_slice;
     m_cuAddr        = ctu.m_cuAddr;
@@ -441,6 +443,7 @@ void CUData::initLosslessCU(const CUData& cu, const CUGeom& cuGeom)
     m_cuAboveLeft  = cu.m_cuAboveLeft;
     m_cuAboveRight = cu.m_cuAboveRight;
     m_absIdxInCTU  = cuGeom.absPartIdx;
+    m_firstAvailIdx = cu.m_firstAvailIdx;
     m_numPartitions = cuGeom.numPartitions;
     memcpy(m_qp, cu.m_qp, BytesPerPartition * m_numPartitions);
     memcpy(m_mv[0],  cu.m_mv[0],  m_numPartitions * sizeof(MV));
@@ -611,7 +614,7 @@ const CUData* CUData::getPULeft(uint32_t& lPartUnitIdx, uint32_t curPartUnitIdx)
         uint32_t absZorderCUIdx   = g_zscanToRaster[m_absIdxInCTU];
         lPartUnitIdx = g_rasterToZscan[absPartIdx - 1];
         if (isEqualCol(absPartIdx, absZorderCUIdx))
-            return m_encData->getPicCTU(m_cuAddr);
+            return getCTUNeighbour(lPartUnitIdx);
         else
         {
             lPartUnitIdx -= m_absIdxInCTU;
@@ -632,7 +635,7 @@ const CUData* CUData::getPUAbove(uint32_t& aPartUnitIdx, uint32_t curPartUnitIdx
         uint32_t absZorderCUIdx = g_zscanToRaster[m_absIdxInCTU];
         aPartUnitIdx = g_rasterToZscan[absPartIdx - RASTER_SIZE];
         if (isEqualRow(absPartIdx, absZorderCUIdx))
-            return m_encData->getPicCTU(m_cuAddr);
+            return getCTUNeighbour(aPartUnitIdx);
         else
             aPartUnitIdx -= m_absIdxInCTU;
         return this;
@@ -653,7 +656,7 @@ const CUData* CUData::getPUAboveLeft(uint32_t& alPartUnitIdx, uint32_t curPartUn
             uint32_t absZorderCUIdx  = g_zscanToRaster[m_absIdxInCTU];
             alPartUnitIdx = g_rasterToZscan[absPartIdx - RASTER_SIZE - 1];
             if (isEqualRowOrCol(absPartIdx, absZorderCUIdx))
-                return m_encData->getPicCTU(m_cuAddr);
+                return getCTUNeighbour(alPartUnitIdx);
             else
             {
                 alPartUnitIdx -= m_absIdxInCTU;
@@ -690,7 +693,7 @@ const CUData* CUData::getPUAboveRight(uint32_t& arPartUnitIdx, uint32_t curPartU
                 uint32_t absZorderCUIdx = g_zscanToRaster[m_absIdxInCTU] + (1 << (m_log2CUSize[0] - LOG2_UNIT_SIZE)) - 1;
                 arPartUnitIdx = g_rasterToZscan[absPartIdxRT - RASTER_SIZE + 1];
                 if (isEqualRowOrCol(absPartIdxRT, absZorderCUIdx))
-                    return m_encData->getPicCTU(m_cuAddr);
+                    return getCTUNeighbour(arPartUnitIdx);
                 else
                 {
                     arPartUnitIdx -= m_absIdxInCTU;
@@ -726,7 +729,7 @@ const CUData* CUData::getPUBelowLeft(uint32_t& blPartUnitIdx, uint32_t curPartUn
                 uint32_t absZorderCUIdxLB = g_zscanToRaster[m_absIdxInCTU] + (((1 << (m_log2CUSize[0] - LOG2_UNIT_SIZE)) - 1) << LOG2_RASTER_SIZE);
                 blPartUnitIdx = g_rasterToZscan[absPartIdxLB + RASTER_SIZE - 1];
                 if (isEqualRowOrCol(absPartIdxLB, absZorderCUIdxLB))
-                    return m_encData->getPicCTU(m_cuAddr);
+                    return getCTUNeighbour(blPartUnitIdx);
                 else
                 {
                     blPartUnitIdx -= m_absIdxInCTU;
@@ -758,7 +761,7 @@ const CUData* CUData::getPUBelowLeftAdi(uint32_t& blPartUnitIdx,  uint32_t curPa
                 uint32_t absZorderCUIdxLB = g_zscanToRaster[m_absIdxInCTU] + (((1 << (m_log2CUSize[0] - LOG2_UNIT_SIZE)) - 1) << LOG2_RASTER_SIZE);
                 blPartUnitIdx = g_rasterToZscan[absPartIdxLB + (partUnitOffset << LOG2_RASTER_SIZE) - 1];
                 if (isEqualRowOrCol(absPartIdxLB, absZorderCUIdxLB))
-                    return m_encData->getPicCTU(m_cuAddr);
+                    return getCTUNeighbour(blPartUnitIdx);
                 else
                 {
                     blPartUnitIdx -= m_absIdxInCTU;
@@ -790,7 +793,7 @@ const CUData* CUData::getPUAboveRightAdi(uint32_t& arPartUnitIdx, uint32_t curPa
                 uint32_t absZorderCUIdx = g_zscanToRaster[m_absIdxInCTU] + (1 << (m_log2CUSize[0] - LOG2_UNIT_SIZE)) - 1;
                 arPartUnitIdx = g_rasterToZscan[absPartIdxRT - RASTER_SIZE + partUnitOffset];
                 if (isEqualRowOrCol(absPartIdxRT, absZorderCUIdx))
-                    return m_encData->getPicCTU(m_cuAddr);
+                    return getCTUNeighbour(arPartUnitIdx);
                 else
                 {
                     arPartUnitIdx -= m_absIdxInCTU;
@@ -810,6 +813,11 @@ const CUData* CUData::getPUAboveRightAdi(uint32_t& arPartUnitIdx, uint32_t curPa
     return m_cuAboveRight;
 }
 
+const CUData* CUData::getCTUNeighbour(uint32_t absPartIdx) const
+{
+    return absPartIdx >= m_firstAvailIdx ? m_encData->getPicCTU(m_cuAddr) : NULL;
+}
+
 /* Get left QpMinCu */
 const CUData* CUData::getQpMinCuLeft(uint32_t& lPartUnitIdx, uint32_t curAbsIdxInCTU) const
 {
@@ -824,7 +832,7 @@ const CUData* CUData::getQpMinCuLeft(uint32_t& lPartUnitIdx, uint32_t curAbsIdxI
     lPartUnitIdx = g_rasterToZscan[absRorderQpMinCUIdx - 1];
 
     // return pointer to current CTU
-    return m_encData->getPicCTU(m_cuAddr);
+    return getCTUNeighbour(lPartUnitIdx);
 }
 
 /* Get above QpMinCu */
@@ -841,7 +849,7 @@ const CUData* CUData::getQpMinCuAbove(uint32_t& aPartUnitIdx, uint32_t curAbsIdx
     aPartUnitIdx = g_rasterToZscan[absRorderQpMinCUIdx - RASTER_SIZE];
 
     // return pointer to current CTU
-    return m_encData->getPicCTU(m_cuAddr);
+    return getCTUNeighbour(aPartUnitIdx);
 }
 
 /* Get reference QP from left QpMinCu or latest coded QP */
@@ -876,7 +884,10 @@ int8_t CUData::getLastCodedQP(uint32_t absPartIdx) const
         return m_qp[lastValidPartIdx];
     else
     {
-        if (m_absIdxInCTU)
+        /* a speculative analysis cannot see the QPs of the parts preceding its
+         * region, it predicts from the start of the CTU instead */
+        bool bAvail = !m_firstAvailIdx || (m_absIdxInCTU & quPartIdxMask) > m_firstAvailIdx;
+        if (m_absIdxInCTU && bAvail)
             return m_encData->getPicCTU(m_cuAddr)->getLastCodedQP(m_absIdxInCTU);
         else if (m_cuAddr > 0 && !(m_slice->m_pps->bEntropyCodingSyncEnabled && !(m_cuAddr % m_slice->m_sps->numCuInWidth)))
             return m_encData->getPicCTU(m_cuAddr - 1)->getLastCodedQP(m_encData->m_param->num4x4Partitions);
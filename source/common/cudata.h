@@ -27,6 +27,7 @@
 #include "common.h"
 #include "slice.h"
 #include "mv.h"
+#include "framearena.h"
 
 #define NUM_TU_DEPTH 21
 
@@ -176,6 +177,7 @@ public:
 
     uint32_t      m_cuAddr;           // address of CTU within the picture in raster order
     uint32_t      m_absIdxInCTU;      // address of CU within its CTU in Z scan order
+    uint32_t      m_firstAvailIdx;    // parts of the CTU before this Z scan address are not available as neighbours
     uint32_t      m_cuPelX;           // CU position within the picture, in pixels (X)
     uint32_t      m_cuPelY;           // CU position within the picture, in pixels (Y)
     uint32_t      m_numPartitions;    // maximum number of 4x4 partitions within this CU
@@ -317,6 +319,10 @@ protected:
     int8_t getLastCodedQP(uint32_t absPartIdx) const;
     int  getLastValidPartIdx(int absPartIdx) const;
 
+    /* the picture CTU, as the neighbour of a part outside this CU; NULL when the
+     * part precedes m_firstAvailIdx (speculative analysis, see Analysis::SplitSpec) */
+    const CUData* getCTUNeighbour(uint32_t absPartIdx) const;
+
     bool hasEqualMotion(uint32_t absPartIdx, const CUData& candCU, uint32_t candAbsPartIdx) const;
 
     /* Check whether the current PU and a spatial neighboring PU are in same merge region */
@@ -357,27 +363,29 @@ struct CUDataMemPool
     uint64_t* dynRefineRdBlock;
     uint32_t* dynRefCntBlock;
     uint32_t* dynRefVarBlock;
+    bool     bArena;  // blocks allocated from the frame arena
 
     CUDataMemPool() { charMemBlock = NULL; trCoeffMemBlock = NULL; mvMemBlock = NULL; distortionMemBlock = NULL; 
-                      dynRefineRdBlock = NULL; dynRefCntBlock = NULL; dynRefVarBlock = NULL;}
+                      dynRefineRdBlock = NULL; dynRefCntBlock = NULL; dynRefVarBlock = NULL; bArena = false; }
 
     bool create(uint32_t depth, uint32_t csp, uint32_t numInstances, const x265_param& param)
     {
+        bArena = !!param.bFrameArena;
         uint32_t numPartition = param.num4x4Partitions >> (depth * 2);
         uint32_t cuSize = param.maxCUSize >> depth;
         uint32_t sizeL = cuSize * cuSize;
         if (csp == X265_CSP_I400)
         {
-            CHECKED_MALLOC(trCoeffMemBlock, coeff_t, (sizeL) * numInstances);
+            CHECKED_ARENA_MALLOC(bArena, trCoeffMemBlock, coeff_t, (sizeL) * numInstances);
         }
         else
         {            
             uint32_t sizeC = sizeL >> (CHROMA_H_SHIFT(csp) + CHROMA_V_SHIFT(csp));
-            CHECKED_MALLOC(trCoeffMemBlock, coeff_t, (sizeL + sizeC * 2) * numInstances);
+            CHECKED_ARENA_MALLOC(bArena, trCoeffMemBlock, coeff_t, (sizeL + sizeC * 2) * numInstances);
         }
-        CHECKED_MALLOC(charMemBlock, uint8_t, numPartition * numInstances * CUData::BytesPerPartition);
-        CHECKED_MALLOC_ZERO(mvMemBlock, MV, numPartition * 4 * numInstances);
-        CHECKED_MALLOC(distortionMemBlock, sse_t, numPartition * numInstances);
+        CHECKED_ARENA_MALLOC(bArena, charMemBlock, uint8_t, numPartition * numInstances * CUData::BytesPerPartition);
+        CHECKED_ARENA_MALLOC_ZERO(bArena, mvMemBlock, MV, numPartition * 4 * numInstances);
+        CHECKED_ARENA_MALLOC(bArena, distortionMemBlock, sse_t, numPartition * numInstances);
         return true;
     fail:
         return false;
@@ -385,10 +393,10 @@ struct CUDataMemPool
 
     void destroy()
     {
-        X265_FREE(trCoeffMemBlock);
-        X265_FREE(mvMemBlock);
-        X265_FREE(charMemBlock);
-        X265_FREE(distortionMemBlock);
+        ARENA_FREE(bArena, trCoeffMemBlock);
+        ARENA_FREE(bArena, mvMemBlock);
+        ARENA_FREE(bArena, charMemBlock);
+        ARENA_FREE(bArena, distortionMemBlock);
     }
 };
 }
@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "threading.h"
+
+#if ENABLE_EVENT_STATS
+
+#include "eventstats.h"
+
+#if !_WIN32
+#include <pthread.h>
+#endif
+
+using namespace X265_NS;
+
+namespace {
+
+#define CPU_EVENT(x) #x,
+const char* eventNames[] =
+{
+#include "../profile/cpuEvents.h"
+};
+#undef CPU_EVENT
+
+/* The counters of every thread which ever recorded an event. The counters of
+ * a thread which exits are folded into s_retired and handed to the next new
+ * thread, so the list is bounded by the number of live threads rather than
+ * by the number of thread pools the process created over its lifetime */
+Lock           s_lock;
+EventCounters* s_threads;
+EventCounters  s_retired;
+
+void retireThread(void* ptr)
+{
+    EventCounters* c = (EventCounters*)ptr;
+    ScopedLock lock(s_lock);
+    for (int i = 0; i < NUM_EVENT_STATS; i++)
+    {
+        s_retired.count[i] += c->count[i];
+        s_retired.ticks[i] += c->ticks[i];
+        EVENT_STATS_STORE(&c->count[i], 0);
+        EVENT_STATS_STORE(&c->ticks[i], 0);
+    }
+    c->bInUse = false;
+}
+
+#if _WIN32
+DWORD s_retireKey = FLS_OUT_OF_INDEXES;
+void WINAPI retireCallback(void* ptr) { if (ptr) retireThread(ptr); }
+#else
+pthread_key_t s_retireKey;
+bool s_bRetireKey;
+#endif
+
+}
+
+namespace X265_NS {
+
+EVENT_STATS_TLS EventCounters* g_eventCounters;
+
+EventCounters* eventStatsRegisterThread()
+{
+    EventCounters* c;
+    {
+        ScopedLock lock(s_lock);
+        for (c = s_threads; c && c->bInUse; c = c->next)
+        {}
+        if (!c)
+        {
+            /* whole cache lines, so no other thread's data shares a line
+             * with the counters; they are never freed */
+            size_t size = (sizeof(EventCounters) + 63) & ~(size_t)63;
+            c = (EventCounters*)x265_malloc(size);
+            if (!c)
+                return &s_retired; /* racy, but only under memory exhaustion */
+            memset((void*)c, 0, size);
+            c->next = s_threads;
+            s_threads = c;
+        }
+        c->bInUse = true;
+
+#if _WIN32
+        if (s_retireKey == FLS_OUT_OF_INDEXES)
+            s_retireKey = FlsAlloc(retireCallback);
+#else
+        if (!s_bRetireKey)
+            s_bRetireKey = !pthread_key_create(&s_retireKey, retireThread);
+#endif
+    }
+
+#if _WIN32
+    if (s_retireKey != FLS_OUT_OF_INDEXES)
+        FlsSetValue(s_retireKey, c);
+#else
+    if (s_bRetireKey)
+        pthread_setspecific(s_retireKey, c);
+#endif
+    g_eventCounters = c;
+    return c;
+}
+
+#if !X265_ARCH_X86
+uint64_t eventStatsTicks()
+{
+    return (uint64_t)x265_mdate();
+}
+#endif
+
+void EventStats::get()
+{
+    ScopedLock lock(s_lock);
+    memcpy(count, s_retired.count, sizeof(count));
+    memcpy(ticks, s_retired.ticks, sizeof(ticks));
+    for (EventCounters* c = s_threads; c; c = c->next)
+    {
+        for (int i = 0; i < NUM_EVENT_STATS; i++)
+        {
+            count[i] += EVENT_STATS_LOAD(&c->count[i]);
+            ticks[i] += EVENT_STATS_LOAD(&c->ticks[i]);
+        }
+    }
+    tick = eventStatsTicks();
+    time = x265_mdate();
+}
+
+double EventStats::seconds(const EventStats& since, int event) const
+{
+    if (time <= since.time || tick <= since.tick)
+        return 0;
+    double ticksPerSecond = (double)(tick - since.tick) * 1000000 / (time - since.time);
+    return (double)(ticks[event] - since.ticks[event]) / ticksPerSecond;
+}
+
+const char* EventStats::name(int event)
+{
+    return eventNames[event];
+}
+
+}
+
+#endif // if ENABLE_EVENT_STATS
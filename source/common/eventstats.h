@@ -0,0 +1,114 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_EVENTSTATS_H
+#define X265_EVENTSTATS_H
+
+/* Native backend of the ProfileScopeEvent() instrumentation (ENABLE_EVENT_STATS).
+ * Each thread counts the calls and the elapsed ticks of every CPU_EVENT in
+ * counters of its own, which only it writes; the counters of all threads are
+ * summed when the statistics are read. Scopes nest, so the time of an event
+ * includes the time of the events within it. The counters are process-wide;
+ * encoders running concurrently in one process see each other's events */
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define EVENT_STATS_TLS __declspec(thread)
+#else
+#if X265_ARCH_X86
+#include <x86intrin.h>
+#endif
+#define EVENT_STATS_TLS __thread
+#endif
+
+/* The counters of a thread are read by other threads while it updates them.
+ * Only the owning thread writes them, so a relaxed load and store suffice for
+ * the reader never to see a torn value; no read-modify-write is needed */
+#if defined(__GNUC__)
+#define EVENT_STATS_LOAD(ptr)       __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#define EVENT_STATS_STORE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELAXED)
+#else
+#define EVENT_STATS_LOAD(ptr)       (*(volatile uint64_t*)(ptr))
+#define EVENT_STATS_STORE(ptr, val) (*(volatile uint64_t*)(ptr) = (val))
+#endif
+
+namespace X265_NS {
+// private x265 namespace
+
+#define CPU_EVENT(x) x,
+enum EventStatsEnum
+{
+#include "../profile/cpuEvents.h"
+    NUM_EVENT_STATS
+};
+#undef CPU_EVENT
+
+struct EventCounters
+{
+    uint64_t       count[NUM_EVENT_STATS];
+    uint64_t       ticks[NUM_EVENT_STATS];
+    EventCounters* next;
+    bool           bInUse;   // owned by a live thread
+};
+
+/* Snapshot of the counters of all threads, and the clocks it was taken at */
+struct EventStats
+{
+    uint64_t count[NUM_EVENT_STATS];
+    uint64_t ticks[NUM_EVENT_STATS];
+    uint64_t tick;      // eventStatsTicks() when the snapshot was taken
+    int64_t  time;      // x265_mdate() when the snapshot was taken
+
+    void     get();
+
+    /* seconds spent in event since the earlier snapshot; the tick rate is
+     * derived from both clocks across the two snapshots */
+    double   seconds(const EventStats& since, int event) const;
+    static const char* name(int event);
+};
+
+extern EVENT_STATS_TLS EventCounters* g_eventCounters;
+EventCounters* eventStatsRegisterThread();
+
+#if X265_ARCH_X86
+inline uint64_t eventStatsTicks() { return __rdtsc(); }
+#else
+uint64_t eventStatsTicks();
+#endif
+
+struct EventStatsScope
+{
+    int      event;
+    uint64_t start;
+
+    EventStatsScope(int e) : event(e), start(eventStatsTicks()) {}
+    ~EventStatsScope()
+    {
+        EventCounters* c = g_eventCounters ? g_eventCounters : eventStatsRegisterThread();
+        uint64_t elapsed = eventStatsTicks() - start;
+        EVENT_STATS_STORE(&c->count[event], EVENT_STATS_LOAD(&c->count[event]) + 1);
+        EVENT_STATS_STORE(&c->ticks[event], EVENT_STATS_LOAD(&c->ticks[event]) + elapsed);
+    }
+};
+
+}
+
+#endif // ifndef X265_EVENTSTATS_H
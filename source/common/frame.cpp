@@ -26,6 +26,7 @@
 #include "frame.h"
 #include "picyuv.h"
 #include "framedata.h"
+#include "framearena.h"
 
 using namespace X265_NS;
 
@@ -49,6 +50,7 @@ Frame::Frame()
     memset(&m_lowres, 0, sizeof(m_lowres));
     m_rcData = NULL;
     m_encodeStartTime = 0;
+    m_decidedTime = 0;
     m_reconfigureRc = false;
     m_ctuInfo = NULL;
     m_prevCtuInfoChange = NULL;
@@ -70,21 +72,21 @@ bool Frame::create(x265_param *param, float* quantOffsets)
 {
     m_fencPic = new PicYuv;
     m_param = param;
-    CHECKED_MALLOC_ZERO(m_rcData, RcStats, 1);
+    CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_rcData, RcStats, 1);
 
     if (param->bCTUInfo)
     {
         uint32_t widthInCTU = (m_param->sourceWidth + param->maxCUSize - 1) >> m_param->maxLog2CUSize;
         uint32_t heightInCTU = (m_param->sourceHeight +  param->maxCUSize - 1) >> m_param->maxLog2CUSize;
         uint32_t numCTUsInFrame = widthInCTU * heightInCTU;
-        CHECKED_MALLOC_ZERO(m_addOnDepth, uint8_t *, numCTUsInFrame);
-        CHECKED_MALLOC_ZERO(m_addOnCtuInfo, uint8_t *, numCTUsInFrame);
-        CHECKED_MALLOC_ZERO(m_addOnPrevChange, int *, numCTUsInFrame);
+        CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_addOnDepth, uint8_t *, numCTUsInFrame);
+        CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_addOnCtuInfo, uint8_t *, numCTUsInFrame);
+        CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_addOnPrevChange, int *, numCTUsInFrame);
         for (uint32_t i = 0; i < numCTUsInFrame; i++)
         {
-            CHECKED_MALLOC_ZERO(m_addOnDepth[i], uint8_t, uint32_t(param->num4x4Partitions));
-            CHECKED_MALLOC_ZERO(m_addOnCtuInfo[i], uint8_t, uint32_t(param->num4x4Partitions));
-            CHECKED_MALLOC_ZERO(m_addOnPrevChange[i], int, uint32_t(param->num4x4Partitions));
+            CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_addOnDepth[i], uint8_t, uint32_t(param->num4x4Partitions));
+            CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_addOnCtuInfo[i], uint8_t, uint32_t(param->num4x4Partitions));
+            CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_addOnPrevChange[i], int, uint32_t(param->num4x4Partitions));
         }
     }
 
@@ -99,9 +101,9 @@ bool Frame::create(x265_param *param, float* quantOffsets)
     if (param->bDynamicRefine)
     {
         int size = m_param->maxCUDepth * X265_REFINE_INTER_LEVELS;
-        CHECKED_MALLOC_ZERO(m_classifyRd, uint64_t, size);
-        CHECKED_MALLOC_ZERO(m_classifyVariance, uint64_t, size);
-        CHECKED_MALLOC_ZERO(m_classifyCount, uint32_t, size);
+        CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_classifyRd, uint64_t, size);
+        CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_classifyVariance, uint64_t, size);
+        CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_classifyCount, uint32_t, size);
     }
 
     if (param->rc.aqMode == X265_AQ_EDGE || (param->rc.zonefileCount && param->rc.aqMode != 0))
@@ -113,9 +115,9 @@ bool Frame::create(x265_param *param, float* quantOffsets)
         intptr_t m_stride = (numCuInWidth * param->maxCUSize) + (m_lumaMarginX << 1);
         int maxHeight = numCuInHeight * param->maxCUSize;
 
-        m_edgePic = X265_MALLOC(pixel, m_stride * (maxHeight + (m_lumaMarginY * 2)));
-        m_gaussianPic = X265_MALLOC(pixel, m_stride * (maxHeight + (m_lumaMarginY * 2)));
-        m_thetaPic = X265_MALLOC(pixel, m_stride * (maxHeight + (m_lumaMarginY * 2)));
+        m_edgePic = ARENA_MALLOC(param->bFrameArena, pixel, m_stride * (maxHeight + (m_lumaMarginY * 2)));
+        m_gaussianPic = ARENA_MALLOC(param->bFrameArena, pixel, m_stride * (maxHeight + (m_lumaMarginY * 2)));
+        m_thetaPic = ARENA_MALLOC(param->bFrameArena, pixel, m_stride * (maxHeight + (m_lumaMarginY * 2)));
     }
 
     if (param->recursionSkipMode == EDGE_BASED_RSKIP)
@@ -127,7 +129,7 @@ bool Frame::create(x265_param *param, float* quantOffsets)
         uint32_t stride = (numCuInWidth * param->maxCUSize) + (lumaMarginX << 1);
         uint32_t maxHeight = numCuInHeight * param->maxCUSize;
         uint32_t bitPlaneSize = stride * (maxHeight + (lumaMarginY * 2));
-        CHECKED_MALLOC_ZERO(m_edgeBitPlane, pixel, bitPlaneSize);
+        CHECKED_ARENA_MALLOC_ZERO(param->bFrameArena, m_edgeBitPlane, pixel, bitPlaneSize);
         m_edgeBitPic = m_edgeBitPlane + lumaMarginY * stride + lumaMarginX;
     }
 
@@ -247,11 +249,11 @@ void Frame::destroy()
         {
             X265_FREE((*m_ctuInfo + i)->ctuInfo);
             (*m_ctuInfo + i)->ctuInfo = NULL;
-            X265_FREE(m_addOnDepth[i]);
+            ARENA_FREE(m_param->bFrameArena, m_addOnDepth[i]);
             m_addOnDepth[i] = NULL;
-            X265_FREE(m_addOnCtuInfo[i]);
+            ARENA_FREE(m_param->bFrameArena, m_addOnCtuInfo[i]);
             m_addOnCtuInfo[i] = NULL;
-            X265_FREE(m_addOnPrevChange[i]);
+            ARENA_FREE(m_param->bFrameArena, m_addOnPrevChange[i]);
             m_addOnPrevChange[i] = NULL;
         }
         X265_FREE(*m_ctuInfo);
@@ -260,33 +262,33 @@ void Frame::destroy()
         m_ctuInfo = NULL;
         X265_FREE(m_prevCtuInfoChange);
         m_prevCtuInfoChange = NULL;
-        X265_FREE(m_addOnDepth);
+        ARENA_FREE(m_param->bFrameArena, m_addOnDepth);
         m_addOnDepth = NULL;
-        X265_FREE(m_addOnCtuInfo);
+        ARENA_FREE(m_param->bFrameArena, m_addOnCtuInfo);
         m_addOnCtuInfo = NULL;
-        X265_FREE(m_addOnPrevChange);
+        ARENA_FREE(m_param->bFrameArena, m_addOnPrevChange);
         m_addOnPrevChange = NULL;
     }
     m_lowres.destroy();
-    X265_FREE(m_rcData);
+    ARENA_FREE(m_param->bFrameArena, m_rcData);
 
     if (m_param->bDynamicRefine)
     {
-        X265_FREE_ZERO(m_classifyRd);
-        X265_FREE_ZERO(m_classifyVariance);
-        X265_FREE_ZERO(m_classifyCount);
+        ARENA_FREE_ZERO(m_param->bFrameArena, m_classifyRd);
+        ARENA_FREE_ZERO(m_param->bFrameArena, m_classifyVariance);
+        ARENA_FREE_ZERO(m_param->bFrameArena, m_classifyCount);
     }
 
     if (m_param->rc.aqMode == X265_AQ_EDGE || (m_param->rc.zonefileCount && m_param->rc.aqMode != 0))
     {
-        X265_FREE(m_edgePic);
-        X265_FREE(m_gaussianPic);
-        X265_FREE(m_thetaPic);
+        ARENA_FREE(m_param->bFrameArena, m_edgePic);
+        ARENA_FREE(m_param->bFrameArena, m_gaussianPic);
+        ARENA_FREE(m_param->bFrameArena, m_thetaPic);
     }
 
     if (m_param->recursionSkipMode == EDGE_BASED_RSKIP)
     {
-        X265_FREE_ZERO(m_edgeBitPlane);
+        ARENA_FREE_ZERO(m_param->bFrameArena, m_edgeBitPlane);
         m_edgeBitPic = NULL;
     }
 }
@@ -119,6 +119,7 @@ public:
     Event                  m_copied;
     int*                   m_prevCtuInfoChange;
     int64_t                m_encodeStartTime;
+    int64_t                m_decidedTime;      // slice type decided by the lookahead
 
     uint8_t**              m_addOnDepth;
     uint8_t**              m_addOnCtuInfo;
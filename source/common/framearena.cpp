@@ -0,0 +1,211 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "framearena.h"
+#include "cudata.h"
+#include "mv.h"
+
+using namespace X265_NS;
+
+namespace {
+/* the block header is padded to the allocation alignment so the pointer
+ * handed out keeps the alignment of x265_malloc() */
+const size_t ARENA_HEADER_SIZE = 64;
+const size_t ARENA_GRANULE = 64;
+}
+
+FrameArena::Bin FrameArena::s_bins[FrameArena::MAX_BINS];
+int      FrameArena::s_numBins;
+int      FrameArena::s_refCount;
+uint64_t FrameArena::s_liveBudget;
+uint64_t FrameArena::s_retainLimit;
+uint64_t FrameArena::s_cachedBytes;
+uint64_t FrameArena::s_numAllocs;
+uint64_t FrameArena::s_numReused;
+Lock     FrameArena::s_lock;
+
+uint64_t FrameArena::acquire(const x265_param& param)
+{
+    uint64_t footprint = estimateFootprint(param);
+
+    ScopedLock lock(s_lock);
+    s_refCount++;
+    s_liveBudget += footprint;
+    /* keep enough to re-open every encoder that was live at the same time */
+    s_retainLimit = X265_MAX(s_retainLimit, s_liveBudget);
+    return footprint;
+}
+
+void FrameArena::release(uint64_t footprint)
+{
+    ScopedLock lock(s_lock);
+    X265_CHECK(s_refCount > 0, "frame arena released more often than acquired\n");
+    s_refCount--;
+    s_liveBudget = s_liveBudget > footprint ? s_liveBudget - footprint : 0;
+}
+
+void* FrameArena::alloc(size_t size, bool bArena)
+{
+    if (!bArena)
+        return x265_malloc(size);
+
+    size_t blockSize = (size + ARENA_GRANULE - 1) & ~(ARENA_GRANULE - 1);
+
+    {
+        ScopedLock lock(s_lock);
+        s_numAllocs++;
+        for (int i = 0; i < s_numBins; i++)
+        {
+            if (s_bins[i].size == blockSize && s_bins[i].head)
+            {
+                Block* block = s_bins[i].head;
+                s_bins[i].head = block->next;
+                s_cachedBytes -= blockSize;
+                s_numReused++;
+                return (uint8_t*)block + ARENA_HEADER_SIZE;
+            }
+        }
+    }
+
+    Block* block = (Block*)x265_malloc(blockSize + ARENA_HEADER_SIZE);
+    if (!block)
+        return NULL;
+    block->size = blockSize;
+    block->next = NULL;
+    return (uint8_t*)block + ARENA_HEADER_SIZE;
+}
+
+void FrameArena::free(void* ptr, bool bArena)
+{
+    if (!bArena)
+    {
+        x265_free(ptr);
+        return;
+    }
+    if (!ptr)
+        return;
+
+    Block* block = (Block*)((uint8_t*)ptr - ARENA_HEADER_SIZE);
+    size_t blockSize = block->size;
+
+    {
+        ScopedLock lock(s_lock);
+        if (s_cachedBytes + blockSize <= s_retainLimit)
+        {
+            int bin = 0;
+            while (bin < s_numBins && s_bins[bin].size != blockSize)
+                bin++;
+            if (bin == s_numBins && s_numBins < MAX_BINS)
+            {
+                s_bins[bin].size = blockSize;
+                s_bins[bin].head = NULL;
+                s_numBins++;
+            }
+            if (bin < s_numBins)
+            {
+                block->next = s_bins[bin].head;
+                s_bins[bin].head = block;
+                s_cachedBytes += blockSize;
+                return;
+            }
+        }
+    }
+
+    x265_free(block);
+}
+
+void FrameArena::trim()
+{
+    ScopedLock lock(s_lock);
+    freeBins();
+    /* with no live encoders there is nothing left to budget for; the next
+     * encoder opened with the arena enabled sets a fresh limit */
+    if (!s_refCount)
+        s_retainLimit = 0;
+}
+
+void FrameArena::freeBins()
+{
+    for (int i = 0; i < s_numBins; i++)
+    {
+        while (s_bins[i].head)
+        {
+            Block* block = s_bins[i].head;
+            s_bins[i].head = block->next;
+            x265_free(block);
+        }
+    }
+    s_numBins = 0;
+    s_cachedBytes = 0;
+}
+
+void FrameArena::getStats(Stats& stats)
+{
+    ScopedLock lock(s_lock);
+    stats.numAllocs = s_numAllocs;
+    stats.numReused = s_numReused;
+    stats.cachedBytes = s_cachedBytes;
+    stats.retainLimit = s_retainLimit;
+}
+
+uint64_t FrameArena::estimateFootprint(const x265_param& param)
+{
+    uint32_t maxCUSize = param.maxCUSize;
+    uint64_t numCuInWidth = (param.sourceWidth + maxCUSize - 1) / maxCUSize;
+    uint64_t numCuInHeight = (param.sourceHeight + maxCUSize - 1) / maxCUSize;
+    uint64_t numCTUs = numCuInWidth * numCuInHeight;
+    int csp = param.internalCsp;
+
+    /* chroma samples per luma sample, in quarters */
+    uint64_t chromaQuarters = csp == X265_CSP_I400 ? 0 : 8 >> (CHROMA_H_SHIFT(csp) + CHROMA_V_SHIFT(csp));
+
+    /* PicYuv planes, including the search margins (see PicYuv::create) */
+    uint64_t marginX = maxCUSize + 32, marginY = maxCUSize + 16;
+    uint64_t lumaPlane = (numCuInWidth * maxCUSize + 2 * marginX) * (numCuInHeight * maxCUSize + 2 * marginY);
+    uint64_t picBytes = (lumaPlane + ((lumaPlane * chromaQuarters) >> 2)) * sizeof(pixel);
+
+    /* lowres planes and lookahead cost arrays (see Lowres::create) */
+    uint64_t lowresCus = ((param.sourceWidth / 2 + X265_LOWRES_CU_SIZE - 1) >> X265_LOWRES_CU_BITS) *
+                         ((param.sourceHeight / 2 + X265_LOWRES_CU_SIZE - 1) >> X265_LOWRES_CU_BITS);
+    uint64_t refs = param.bframes + 2;
+    uint64_t lowresBytes = 4 * (param.sourceWidth / 2 + 2 * marginX) * (param.sourceHeight / 2 + 2 * marginY) * sizeof(pixel);
+    if (param.bEnableHME)
+        lowresBytes += lowresBytes / 2;
+    lowresBytes += lowresCus * (refs * refs * sizeof(uint16_t) + refs * 2 * (sizeof(MV) + sizeof(int32_t)) +
+                                sizeof(int32_t) + sizeof(uint8_t) + sizeof(uint16_t));
+    if (param.rc.aqMode || param.rc.hevcAq || param.bAQMotion)
+        lowresBytes += 4 * lowresCus * (2 * sizeof(double) + 2 * sizeof(int));
+
+    /* CTU data of the reconstructed frame (see FrameData::create) */
+    uint64_t coeffBytes = (uint64_t)maxCUSize * maxCUSize * sizeof(coeff_t);
+    coeffBytes += (coeffBytes * chromaQuarters) >> 2;
+    uint64_t cuBytes = numCTUs * (coeffBytes + param.num4x4Partitions * (CUData::BytesPerPartition + 4 * sizeof(MV) + sizeof(sse_t)));
+
+    /* every picture held by the lookahead, DPB and frame encoders */
+    uint64_t numFrames = param.lookaheadDepth + param.bframes + param.maxNumReferences + param.frameNumThreads + 4;
+    uint64_t perFrame = 2 * picBytes + lowresBytes + cuBytes;
+
+    /* the per-thread analysis pools and smaller add-on arrays are left to
+     * the slack */
+    uint64_t footprint = numFrames * perFrame;
+    return footprint + footprint / 8;
+}
@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_FRAMEARENA_H
+#define X265_FRAMEARENA_H
+
+#include "common.h"
+#include "threading.h"
+
+namespace X265_NS {
+// private x265 namespace
+
+/* Process-wide cache of the large per-frame buffers (picture planes, lowres
+ * planes and cost arrays, CU data pools, frame add-on arrays). Blocks are
+ * bucketed by exact size, so the next encoder instance opened in the same
+ * process with a compatible configuration is served from the free lists
+ * instead of the system allocator.
+ *
+ * Every encoder with bFrameArena enabled holds a reference on the arena for
+ * its lifetime, and its estimated footprint (derived once from x265_param)
+ * raises the number of bytes the arena is allowed to retain. Cached blocks
+ * outlive the encoders and are only returned to the system by trim(), which
+ * x265_cleanup() calls. Buffers allocated from the arena must be released
+ * to the arena; all arena blocks keep X265_ALIGNBYTES alignment.
+ *
+ * Allocations of encoders without bFrameArena bypass the arena and go
+ * straight to x265_malloc() and x265_free(), without a block header and
+ * without taking the arena lock, so the caller must free a buffer with the
+ * bArena flag it was allocated with. */
+class FrameArena
+{
+public:
+
+    struct Stats
+    {
+        uint64_t numAllocs;
+        uint64_t numReused;
+        uint64_t cachedBytes;
+        uint64_t retainLimit;
+    };
+
+    /* acquire returns the footprint the caller added to the budget, which
+     * must be handed back to release */
+    static uint64_t acquire(const x265_param& param);
+    static void     release(uint64_t footprint);
+
+    static void* alloc(size_t size, bool bArena);
+    static void  free(void* ptr, bool bArena);
+
+    /* return all cached blocks to the system allocator */
+    static void  trim();
+
+    static void  getStats(Stats& stats);
+
+    /* approximate number of bytes of per-frame buffers an encoder configured
+     * with param keeps allocated at steady state */
+    static uint64_t estimateFootprint(const x265_param& param);
+
+protected:
+
+    enum { MAX_BINS = 128 };
+
+    struct Block
+    {
+        size_t size;
+        Block* next;
+    };
+
+    struct Bin
+    {
+        size_t size;
+        Block* head;
+    };
+
+    static Bin      s_bins[MAX_BINS];
+    static int      s_numBins;
+    static int      s_refCount;
+    static uint64_t s_liveBudget;
+    static uint64_t s_retainLimit;
+    static uint64_t s_cachedBytes;
+    static uint64_t s_numAllocs;
+    static uint64_t s_numReused;
+    static Lock     s_lock;
+
+    static void freeBins();
+};
+}
+
+#define ARENA_MALLOC(bArena, type, count) (type*)X265_NS::FrameArena::alloc(sizeof(type) * (count), !!(bArena))
+#define ARENA_FREE(bArena, ptr)      X265_NS::FrameArena::free(ptr, !!(bArena))
+#define ARENA_FREE_ZERO(bArena, ptr) do { X265_NS::FrameArena::free(ptr, !!(bArena)); (ptr) = NULL; } while (0)
+#define CHECKED_ARENA_MALLOC(bArena, var, type, count) \
+    { \
+        var = (type*)X265_NS::FrameArena::alloc(sizeof(type) * (count), !!(bArena)); \
+        if (!var) \
+        { \
+            x265_log(NULL, X265_LOG_ERROR, "malloc of size " X265_LL " failed\n", (uint64_t)(sizeof(type) * (count))); \
+            goto fail; \
+        } \
+    }
+#define CHECKED_ARENA_MALLOC_ZERO(bArena, var, type, count) \
+    { \
+        var = (type*)X265_NS::FrameArena::alloc(sizeof(type) * (count), !!(bArena)); \
+        if (var) \
+            memset((void*)var, 0, sizeof(type) * (count)); \
+        else \
+        { \
+            x265_log(NULL, X265_LOG_ERROR, "malloc of size " X265_LL " failed\n", (uint64_t)(sizeof(type) * (count))); \
+            goto fail; \
+        } \
+    }
+
+#endif // ifndef X265_FRAMEARENA_H
@@ -23,6 +23,7 @@
 
 #include "framedata.h"
 #include "picyuv.h"
+#include "lowres.h"
 
 using namespace X265_NS;
 
@@ -43,9 +44,9 @@ bool FrameData::create(const x265_param& param, const SPS& sps, int csp)
     bool isallocated = m_cuMemPool.create(0, param.internalCsp, sps.numCUsInFrame, param);
     if (m_param->bDynamicRefine)
     {
-        CHECKED_MALLOC_ZERO(m_cuMemPool.dynRefineRdBlock, uint64_t, MAX_NUM_DYN_REFINE * sps.numCUsInFrame);
-        CHECKED_MALLOC_ZERO(m_cuMemPool.dynRefCntBlock, uint32_t, MAX_NUM_DYN_REFINE * sps.numCUsInFrame);
-        CHECKED_MALLOC_ZERO(m_cuMemPool.dynRefVarBlock, uint32_t, MAX_NUM_DYN_REFINE * sps.numCUsInFrame);
+        CHECKED_ARENA_MALLOC_ZERO(param.bFrameArena, m_cuMemPool.dynRefineRdBlock, uint64_t, MAX_NUM_DYN_REFINE * sps.numCUsInFrame);
+        CHECKED_ARENA_MALLOC_ZERO(param.bFrameArena, m_cuMemPool.dynRefCntBlock, uint32_t, MAX_NUM_DYN_REFINE * sps.numCUsInFrame);
+        CHECKED_ARENA_MALLOC_ZERO(param.bFrameArena, m_cuMemPool.dynRefVarBlock, uint32_t, MAX_NUM_DYN_REFINE * sps.numCUsInFrame);
     }
     if (isallocated)
     {
@@ -62,8 +63,20 @@ bool FrameData::create(const x265_param& param, const SPS& sps, int csp)
     }
     else
         return false;
-    CHECKED_MALLOC_ZERO(m_cuStat, RCStatCU, sps.numCUsInFrame);
-    CHECKED_MALLOC(m_rowStat, RCStatRow, sps.numCuInHeight);
+    CHECKED_ARENA_MALLOC_ZERO(param.bFrameArena, m_cuStat, RCStatCU, sps.numCUsInFrame);
+    CHECKED_ARENA_MALLOC(param.bFrameArena, m_rowStat, RCStatRow, sps.numCuInHeight);
+    if (param.ctuStatsFile)
+        CHECKED_ARENA_MALLOC(param.bFrameArena, m_ctuCost, CTUCost, sps.numCUsInFrame);
+    if (param.bMVField)
+    {
+        /* the block grid of the lowres picture, see Lowres::create() */
+        uint32_t blocksInRow = (sps.picWidthInLumaSamples / 2 + X265_LOWRES_CU_SIZE - 1) >> X265_LOWRES_CU_BITS;
+        uint32_t blocksInCol = (sps.picHeightInLumaSamples / 2 + X265_LOWRES_CU_SIZE - 1) >> X265_LOWRES_CU_BITS;
+        m_mvFieldBlocks = blocksInRow * blocksInCol;
+        CHECKED_ARENA_MALLOC(param.bFrameArena, m_mvField, MV, 2 * (param.bframes + 2) * m_mvFieldBlocks * MV_FIELD_SEEDS);
+    }
+    if (param.subpelCacheSize && !m_subpelCache.create(param, sps.numCuInHeight))
+        goto fail;
     reinit(sps);
     
     for (int i = 0; i < INTEGRAL_PLANE_NUM; i++)
@@ -81,6 +94,9 @@ void FrameData::reinit(const SPS& sps)
 {
     memset(m_cuStat, 0, sps.numCUsInFrame * sizeof(*m_cuStat));
     memset(m_rowStat, 0, sps.numCuInHeight * sizeof(*m_rowStat));
+    if (m_ctuCost)
+        memset(m_ctuCost, 0, sps.numCUsInFrame * sizeof(*m_ctuCost));
+    memset(m_mvFieldValid, 0, sizeof(m_mvFieldValid));
     if (m_param->bDynamicRefine)
     {
         memset(m_picCTU->m_collectCURd, 0, MAX_NUM_DYN_REFINE * sps.numCUsInFrame * sizeof(uint64_t));
@@ -99,12 +115,15 @@ void FrameData::destroy()
 
     if (m_param->bDynamicRefine)
     {
-        X265_FREE(m_cuMemPool.dynRefineRdBlock);
-        X265_FREE(m_cuMemPool.dynRefCntBlock);
-        X265_FREE(m_cuMemPool.dynRefVarBlock);
+        ARENA_FREE(m_param->bFrameArena, m_cuMemPool.dynRefineRdBlock);
+        ARENA_FREE(m_param->bFrameArena, m_cuMemPool.dynRefCntBlock);
+        ARENA_FREE(m_param->bFrameArena, m_cuMemPool.dynRefVarBlock);
     }
-    X265_FREE(m_cuStat);
-    X265_FREE(m_rowStat);
+    ARENA_FREE(m_param->bFrameArena, m_cuStat);
+    ARENA_FREE(m_param->bFrameArena, m_rowStat);
+    ARENA_FREE(m_param->bFrameArena, m_ctuCost);
+    ARENA_FREE(m_param->bFrameArena, m_mvField);
+    m_subpelCache.destroy();
     for (int i = 0; i < INTEGRAL_PLANE_NUM; i++)
     {
         if (m_meBuffer[i] != NULL)
@@ -114,3 +133,74 @@ void FrameData::destroy()
         }
     }
 }
+
+static inline int16_t median3(int16_t a, int16_t b, int16_t c)
+{
+    return X265_MAX(X265_MIN(a, b), X265_MIN(X265_MAX(a, b), c));
+}
+
+/* Upsample the lookahead motion field of the frame into full-res motion
+ * search candidates. Each 16x16 block is seeded with the MV of its lowres
+ * block, the component-wise median of the 3x3 lowres neighbourhood, which
+ * follows the motion of the area rather than of an outlier block, and with
+ * HME the MV of the lower resolution level. Candidates equal to an earlier
+ * one, or zero, are left out */
+void FrameData::buildMVField(const Lowres& lowres)
+{
+    const int width = lowres.maxBlocksInRow;
+    const int height = lowres.maxBlocksInCol;
+    const int lowerWidth = (width + 1) / 2;
+    X265_CHECK((uint32_t)(width * height) <= m_mvFieldBlocks, "motion field is too small\n");
+
+    for (int list = 0; list < 2; list++)
+    {
+        for (int dist = 1; dist <= m_param->bframes + 1; dist++)
+        {
+            const MV* mvs = lowres.lowresMvs[list][dist];
+            m_mvFieldValid[list][dist] = mvs[0].x != 0x7FFF;
+            if (!m_mvFieldValid[list][dist])
+                continue;
+
+            const MV* lowerMvs = lowres.bEnableHME ? lowres.lowerResMvs[list][dist] : NULL;
+            const int32_t* lowerCosts = lowres.bEnableHME ? lowres.lowerResMvCosts[list][dist] : NULL;
+            MV* field = m_mvField + (list * (m_param->bframes + 2) + dist) * m_mvFieldBlocks * MV_FIELD_SEEDS;
+
+            for (int y = 0; y < height; y++)
+            {
+                const int y0 = X265_MAX(y - 1, 0), y1 = X265_MIN(y + 1, height - 1);
+                for (int x = 0; x < width; x++, field += MV_FIELD_SEEDS)
+                {
+                    const int x0 = X265_MAX(x - 1, 0), x1 = X265_MIN(x + 1, width - 1);
+                    int num = 0;
+
+                    MV seed = mvs[y * width + x];
+                    if (seed.notZero())
+                        field[num++] = seed << 1;
+
+                    /* median of the rows, then of the three row medians */
+                    int16_t mx[3], my[3];
+                    for (int r = y0, i = 0; i < 3; i++, r = X265_MIN(r + 1, y1))
+                    {
+                        const MV* row = mvs + r * width;
+                        mx[i] = median3(row[x0].x, row[x].x, row[x1].x);
+                        my[i] = median3(row[x0].y, row[x].y, row[x1].y);
+                    }
+                    MV median(median3(mx[0], mx[1], mx[2]), median3(my[0], my[1], my[2]));
+                    if (median.notZero() && median != seed)
+                        field[num++] = median << 1;
+
+                    if (lowerMvs)
+                    {
+                        int idx = (y / 2) * lowerWidth + x / 2;
+                        MV lower = lowerMvs[idx] << 1;
+                        if (lowerCosts[idx] > 0 && lower.notZero() && lower != seed && lower != median)
+                            field[num++] = lower << 1;
+                    }
+
+                    for (; num < MV_FIELD_SEEDS; num++)
+                        field[num] = 0;
+                }
+            }
+        }
+    }
+}
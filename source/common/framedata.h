@@ -27,12 +27,14 @@
 #include "common.h"
 #include "slice.h"
 #include "cudata.h"
+#include "subpelcache.h"
 
 namespace X265_NS {
 // private namespace
 
 class PicYuv;
 class JobProvider;
+struct Lowres;
 
 #define INTER_MODES 4 // 2Nx2N, 2NxN, Nx2N, AMP modes
 #define INTRA_MODES 3 // DC, Planar, Angular modes
@@ -85,6 +87,10 @@ struct FrameStats
     uint64_t    cntIntraPu[NUM_CU_DEPTH];
     uint64_t    cntAmp[NUM_CU_DEPTH];
     uint64_t    cnt4x4;
+    uint64_t    meSearches;       /* motion searches (PU and reference) */
+    uint64_t    meSearchSteps;    /* integer pattern search steps of those searches */
+    uint64_t    specSubCUs;       /* sub-CUs analysed speculatively, see param.bSpeculativeSplit */
+    uint64_t    specRetries;      /* of those, sub-CUs analysed again */
     uint64_t    cntInterPu[NUM_CU_DEPTH][INTER_MODES - 1];
     uint64_t    cntMergePu[NUM_CU_DEPTH][INTER_MODES - 1];
 
@@ -151,9 +157,31 @@ public:
         double   sumQpAq;
     };
 
+    /* Analysis effort of each CTU, only kept when param.ctuStatsFile is set */
+    struct CTUCost
+    {
+        uint32_t elapsedTime;   /* worker time in compressCTU, in microseconds */
+        uint32_t rdEvals;       /* RD mode evaluations, including those of pmode slaves */
+        uint32_t meSearches;    /* motion searches (PU and reference), including pme slaves */
+        uint8_t  minDepth;      /* shallowest and deepest CU of the chosen partitioning */
+        uint8_t  maxDepth;
+        uint8_t  numEncodes;    /* times the CTU was compressed, more than one after VBV row re-encodes */
+    };
+
     RCStatCU*      m_cuStat;
     RCStatRow*     m_rowStat;
+    CTUCost*       m_ctuCost;
     FrameStats     m_frameStats; // stats of current frame for multi-pass encodes
+
+    /* Motion search candidates upsampled from the lookahead motion field of
+     * the frame, only kept when param.bMVField is set. MV_FIELD_SEEDS full-res
+     * MVs per 16x16 block (8x8 lowres block) for each list and POC distance,
+     * zero where absent */
+    enum { MV_FIELD_SEEDS = 3 };
+    MV*            m_mvField;
+    uint32_t       m_mvFieldBlocks;  /* blocks per list and distance */
+    bool           m_mvFieldValid[2][X265_BFRAME_MAX + 2];
+
     /* data needed for periodic intra refresh */
     struct PeriodicIR
     {
@@ -171,12 +199,21 @@ public:
     uint32_t*              m_meIntegral[INTEGRAL_PLANE_NUM];       // 12 integral planes for 32x32, 32x24, 32x8, 24x32, 16x16, 16x12, 16x4, 12x16, 8x32, 8x8, 4x16 and 4x4.
     uint32_t*              m_meBuffer[INTEGRAL_PLANE_NUM];
 
+    /* sub-pel luma planes of the reconstructed picture shared by the motion
+     * searches referencing it, only used when param.subpelCacheSize is set */
+    SubpelCache            m_subpelCache;
+
     FrameData();
 
     bool create(const x265_param& param, const SPS& sps, int csp);
     void reinit(const SPS& sps);
     void destroy();
+    void buildMVField(const Lowres& lowres);
     inline CUData* getPicCTU(uint32_t ctuAddr) { return &m_picCTU[ctuAddr]; }
+    inline const MV* getMVField(int list, int dist, uint32_t block) const
+    {
+        return m_mvField + ((list * (m_param->bframes + 2) + dist) * m_mvFieldBlocks + block) * MV_FIELD_SEEDS;
+    }
 };
 
 }
@@ -26,6 +26,10 @@
 
 using namespace X265_NS;
 
+namespace X265_NS {
+int sa8d_square_c(int log2Size, const pixel* pix1, intptr_t stride_pix1, const pixel* pix2, intptr_t stride_pix2); // pixel.cpp
+}
+
 namespace {
 
 template<int tuSize>
@@ -232,6 +236,47 @@ void all_angs_pred_c(pixel *dest, pixel *refPix, pixel *filtPix, int bLuma)
         }
     }
 }
+
+/* each angle is predicted into a single block and measured immediately,
+ * the horizontal modes in their final (flipped) orientation */
+template<int log2Size>
+void all_angs_sa8d_c(int* costs, const pixel* fenc, intptr_t fencStride, pixel* refPix, pixel* filtPix, int bLuma)
+{
+    const int size = 1 << log2Size;
+    ALIGN_VAR_32(pixel, pred[size * size]);
+
+    for (int mode = 2; mode <= 34; mode++)
+    {
+        pixel *srcPix = (g_intraFilterFlags[mode] & size ? filtPix : refPix);
+
+        intra_pred_ang_c<size>(pred, size, srcPix, mode, bLuma);
+        costs[mode - 2] = sa8d_square_c(log2Size, fenc, fencStride, pred, size);
+    }
+}
+
+/* composed of the optimized all-angle predictor of the global primitives,
+ * which stores the horizontal modes transposed; those are measured against
+ * a transposed fenc, which gives the same sa8d */
+template<int log2Size>
+void all_angs_sa8d_composed(int* costs, const pixel* fenc, intptr_t fencStride, pixel* refPix, pixel* filtPix, int bLuma)
+{
+    const int size = 1 << log2Size;
+    const int sizeIdx = log2Size - 2;
+    ALIGN_VAR_32(pixel, fencTransposed[size * size]);
+    ALIGN_VAR_32(pixel, preds[33 * size * size]);
+
+    primitives.cu[sizeIdx].transpose(fencTransposed, fenc, fencStride);
+    primitives.cu[sizeIdx].intra_pred_allangs(preds, refPix, filtPix, bLuma);
+
+    for (int mode = 2; mode <= 34; mode++)
+    {
+        const pixel* pred = preds + (mode - 2) * size * size;
+        if (mode < 18)
+            costs[mode - 2] = primitives.cu[sizeIdx].sa8d(fencTransposed, size, pred, size);
+        else
+            costs[mode - 2] = primitives.cu[sizeIdx].sa8d(fenc, fencStride, pred, size);
+    }
+}
 }
 
 namespace X265_NS {
@@ -266,5 +311,26 @@ void setupIntraPrimitives_c(EncoderPrimitives& p)
     p.cu[BLOCK_8x8].intra_pred_allangs = all_angs_pred_c<3>;
     p.cu[BLOCK_16x16].intra_pred_allangs = all_angs_pred_c<4>;
     p.cu[BLOCK_32x32].intra_pred_allangs = all_angs_pred_c<5>;
+
+    p.cu[BLOCK_4x4].intra_allangs_sa8d = all_angs_sa8d_c<2>;
+    p.cu[BLOCK_8x8].intra_allangs_sa8d = all_angs_sa8d_c<3>;
+    p.cu[BLOCK_16x16].intra_allangs_sa8d = all_angs_sa8d_c<4>;
+    p.cu[BLOCK_32x32].intra_allangs_sa8d = all_angs_sa8d_c<5>;
+}
+
+/* Where p has optimized all-angle predictors, the all-angle sa8d uses them
+ * instead of predicting one angle at a time. x265_setup_primitives() clears
+ * the C all-angle predictors, so C-only builds keep the fused C kernel.
+ * Called after the architecture primitives are set up */
+void setupAllAnglesSa8dPrimitives(EncoderPrimitives& p)
+{
+    if (p.cu[BLOCK_4x4].intra_pred_allangs && p.cu[BLOCK_4x4].transpose && p.cu[BLOCK_4x4].sa8d)
+        p.cu[BLOCK_4x4].intra_allangs_sa8d = all_angs_sa8d_composed<2>;
+    if (p.cu[BLOCK_8x8].intra_pred_allangs && p.cu[BLOCK_8x8].transpose && p.cu[BLOCK_8x8].sa8d)
+        p.cu[BLOCK_8x8].intra_allangs_sa8d = all_angs_sa8d_composed<3>;
+    if (p.cu[BLOCK_16x16].intra_pred_allangs && p.cu[BLOCK_16x16].transpose && p.cu[BLOCK_16x16].sa8d)
+        p.cu[BLOCK_16x16].intra_allangs_sa8d = all_angs_sa8d_composed<4>;
+    if (p.cu[BLOCK_32x32].intra_pred_allangs && p.cu[BLOCK_32x32].transpose && p.cu[BLOCK_32x32].sa8d)
+        p.cu[BLOCK_32x32].intra_allangs_sa8d = all_angs_sa8d_composed<5>;
 }
 }
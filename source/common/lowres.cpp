@@ -25,22 +25,23 @@
 #include "picyuv.h"
 #include "lowres.h"
 #include "mv.h"
+#include "framearena.h"
 
 using namespace X265_NS;
 
-bool PicQPAdaptationLayer::create(uint32_t width, uint32_t height, uint32_t partWidth, uint32_t partHeight, uint32_t numAQPartInWidthExt, uint32_t numAQPartInHeightExt)
+bool PicQPAdaptationLayer::create(uint32_t width, uint32_t height, uint32_t partWidth, uint32_t partHeight, uint32_t numAQPartInWidthExt, uint32_t numAQPartInHeightExt, bool bArena)
 {
     aqPartWidth = partWidth;
     aqPartHeight = partHeight;
     numAQPartInWidth = (width + partWidth - 1) / partWidth;
     numAQPartInHeight = (height + partHeight - 1) / partHeight;
 
-    CHECKED_MALLOC_ZERO(dActivity, double, numAQPartInWidthExt * numAQPartInHeightExt);
-    CHECKED_MALLOC_ZERO(dQpOffset, double, numAQPartInWidthExt * numAQPartInHeightExt);
-    CHECKED_MALLOC_ZERO(dCuTreeOffset, double, numAQPartInWidthExt * numAQPartInHeightExt);
+    CHECKED_ARENA_MALLOC_ZERO(bArena, dActivity, double, numAQPartInWidthExt * numAQPartInHeightExt);
+    CHECKED_ARENA_MALLOC_ZERO(bArena, dQpOffset, double, numAQPartInWidthExt * numAQPartInHeightExt);
+    CHECKED_ARENA_MALLOC_ZERO(bArena, dCuTreeOffset, double, numAQPartInWidthExt * numAQPartInHeightExt);
 
     if (bQpSize)
-        CHECKED_MALLOC_ZERO(dCuTreeOffset8x8, double, numAQPartInWidthExt * numAQPartInHeightExt);
+        CHECKED_ARENA_MALLOC_ZERO(bArena, dCuTreeOffset8x8, double, numAQPartInWidthExt * numAQPartInHeightExt);
 
     return true;
 fail:
@@ -50,6 +51,7 @@ fail:
 bool Lowres::create(x265_param* param, PicYuv *origPic, uint32_t qgSize)
 {
     isLowres = true;
+    bArena = !!param->bFrameArena;
     bframes = param->bframes;
     widthFullRes = origPic->m_picWidth;
     heightFullRes = origPic->m_picHeight;
@@ -75,18 +77,18 @@ bool Lowres::create(x265_param* param, PicYuv *origPic, uint32_t qgSize)
     size_t padoffset = lumaStride * origPic->m_lumaMarginY + origPic->m_lumaMarginX;
     if (!!param->rc.aqMode || !!param->rc.hevcAq || !!param->bAQMotion)
     {
-        CHECKED_MALLOC_ZERO(qpAqOffset, double, cuCountFullRes);
-        CHECKED_MALLOC_ZERO(invQscaleFactor, int, cuCountFullRes);
-        CHECKED_MALLOC_ZERO(qpCuTreeOffset, double, cuCountFullRes);
+        CHECKED_ARENA_MALLOC_ZERO(bArena, qpAqOffset, double, cuCountFullRes);
+        CHECKED_ARENA_MALLOC_ZERO(bArena, invQscaleFactor, int, cuCountFullRes);
+        CHECKED_ARENA_MALLOC_ZERO(bArena, qpCuTreeOffset, double, cuCountFullRes);
         if (qgSize == 8)
-            CHECKED_MALLOC_ZERO(invQscaleFactor8x8, int, cuCount);
-        CHECKED_MALLOC_ZERO(edgeInclined, int, cuCountFullRes);
+            CHECKED_ARENA_MALLOC_ZERO(bArena, invQscaleFactor8x8, int, cuCount);
+        CHECKED_ARENA_MALLOC_ZERO(bArena, edgeInclined, int, cuCountFullRes);
     }
 
     if (origPic->m_param->bAQMotion)
-        CHECKED_MALLOC_ZERO(qpAqMotionOffset, double, cuCountFullRes);
+        CHECKED_ARENA_MALLOC_ZERO(bArena, qpAqMotionOffset, double, cuCountFullRes);
     if (origPic->m_param->bDynamicRefine || origPic->m_param->bEnableFades)
-        CHECKED_MALLOC_ZERO(blockVariance, uint32_t, cuCountFullRes);
+        CHECKED_ARENA_MALLOC_ZERO(bArena, blockVariance, uint32_t, cuCountFullRes);
 
     if (!!param->rc.hevcAq)
     {
@@ -123,13 +125,13 @@ bool Lowres::create(x265_param* param, PicYuv *origPic, uint32_t qgSize)
 
             maxAQDepth++;
 
-            pAQLayer[d].create(origPic->m_picWidth, origPic->m_picHeight, partWidth, partHeight, nAQPartInWidth, nAQPartInHeight);
+            pAQLayer[d].create(origPic->m_picWidth, origPic->m_picHeight, partWidth, partHeight, nAQPartInWidth, nAQPartInHeight, bArena);
         }
     }
-    CHECKED_MALLOC(propagateCost, uint16_t, cuCount);
+    CHECKED_ARENA_MALLOC(bArena, propagateCost, uint16_t, cuCount);
 
     /* allocate lowres buffers */
-    CHECKED_MALLOC_ZERO(buffer[0], pixel, 4 * planesize);
+    CHECKED_ARENA_MALLOC_ZERO(bArena, buffer[0], pixel, 4 * planesize);
 
     buffer[1] = buffer[0] + planesize;
     buffer[2] = buffer[1] + planesize;
@@ -148,7 +150,7 @@ bool Lowres::create(x265_param* param, PicYuv *origPic, uint32_t qgSize)
         size_t planesizeHalf = planesize / 2;
         size_t padoffsetHalf = padoffset / 2;
         /* allocate lower-res buffers */
-        CHECKED_MALLOC_ZERO(lowerResBuffer[0], pixel, 4 * planesizeHalf);
+        CHECKED_ARENA_MALLOC_ZERO(bArena, lowerResBuffer[0], pixel, 4 * planesizeHalf);
 
         lowerResBuffer[1] = lowerResBuffer[0] + planesizeHalf;
         lowerResBuffer[2] = lowerResBuffer[1] + planesizeHalf;
@@ -160,33 +162,33 @@ bool Lowres::create(x265_param* param, PicYuv *origPic, uint32_t qgSize)
         lowerResPlane[3] = lowerResBuffer[3] + padoffsetHalf;
     }
 
-    CHECKED_MALLOC(intraCost, int32_t, cuCount);
-    CHECKED_MALLOC(intraMode, uint8_t, cuCount);
+    CHECKED_ARENA_MALLOC(bArena, intraCost, int32_t, cuCount);
+    CHECKED_ARENA_MALLOC(bArena, intraMode, uint8_t, cuCount);
 
     for (int i = 0; i < bframes + 2; i++)
     {
         for (int j = 0; j < bframes + 2; j++)
         {
-            CHECKED_MALLOC(rowSatds[i][j], int32_t, maxBlocksInCol);
-            CHECKED_MALLOC(lowresCosts[i][j], uint16_t, cuCount);
+            CHECKED_ARENA_MALLOC(bArena, rowSatds[i][j], int32_t, maxBlocksInCol);
+            CHECKED_ARENA_MALLOC(bArena, lowresCosts[i][j], uint16_t, cuCount);
         }
     }
 
     for (int i = 0; i < bframes + 2; i++)
     {
-        CHECKED_MALLOC(lowresMvs[0][i], MV, cuCount);
-        CHECKED_MALLOC(lowresMvs[1][i], MV, cuCount);
-        CHECKED_MALLOC(lowresMvCosts[0][i], int32_t, cuCount);
-        CHECKED_MALLOC(lowresMvCosts[1][i], int32_t, cuCount);
+        CHECKED_ARENA_MALLOC(bArena, lowresMvs[0][i], MV, cuCount);
+        CHECKED_ARENA_MALLOC(bArena, lowresMvs[1][i], MV, cuCount);
+        CHECKED_ARENA_MALLOC(bArena, lowresMvCosts[0][i], int32_t, cuCount);
+        CHECKED_ARENA_MALLOC(bArena, lowresMvCosts[1][i], int32_t, cuCount);
         if (bEnableHME)
         {
             int maxBlocksInRowLowerRes = ((width/2) + X265_LOWRES_CU_SIZE - 1) >> X265_LOWRES_CU_BITS;
             int maxBlocksInColLowerRes = ((lines/2) + X265_LOWRES_CU_SIZE - 1) >> X265_LOWRES_CU_BITS;
             int cuCountLowerRes = maxBlocksInRowLowerRes * maxBlocksInColLowerRes;
-            CHECKED_MALLOC(lowerResMvs[0][i], MV, cuCountLowerRes);
-            CHECKED_MALLOC(lowerResMvs[1][i], MV, cuCountLowerRes);
-            CHECKED_MALLOC(lowerResMvCosts[0][i], int32_t, cuCountLowerRes);
-            CHECKED_MALLOC(lowerResMvCosts[1][i], int32_t, cuCountLowerRes);
+            CHECKED_ARENA_MALLOC(bArena, lowerResMvs[0][i], MV, cuCountLowerRes);
+            CHECKED_ARENA_MALLOC(bArena, lowerResMvs[1][i], MV, cuCountLowerRes);
+            CHECKED_ARENA_MALLOC(bArena, lowerResMvCosts[0][i], int32_t, cuCountLowerRes);
+            CHECKED_ARENA_MALLOC(bArena, lowerResMvCosts[1][i], int32_t, cuCountLowerRes);
         }
     }
 
@@ -198,43 +200,43 @@ fail:
 
 void Lowres::destroy()
 {
-    X265_FREE(buffer[0]);
+    ARENA_FREE(bArena, buffer[0]);
     if(bEnableHME)
-        X265_FREE(lowerResBuffer[0]);
-    X265_FREE(intraCost);
-    X265_FREE(intraMode);
+        ARENA_FREE(bArena, lowerResBuffer[0]);
+    ARENA_FREE(bArena, intraCost);
+    ARENA_FREE(bArena, intraMode);
 
     for (int i = 0; i < bframes + 2; i++)
     {
         for (int j = 0; j < bframes + 2; j++)
         {
-            X265_FREE(rowSatds[i][j]);
-            X265_FREE(lowresCosts[i][j]);
+            ARENA_FREE(bArena, rowSatds[i][j]);
+            ARENA_FREE(bArena, lowresCosts[i][j]);
         }
     }
 
     for (int i = 0; i < bframes + 2; i++)
     {
-        X265_FREE(lowresMvs[0][i]);
-        X265_FREE(lowresMvs[1][i]);
-        X265_FREE(lowresMvCosts[0][i]);
-        X265_FREE(lowresMvCosts[1][i]);
+        ARENA_FREE(bArena, lowresMvs[0][i]);
+        ARENA_FREE(bArena, lowresMvs[1][i]);
+        ARENA_FREE(bArena, lowresMvCosts[0][i]);
+        ARENA_FREE(bArena, lowresMvCosts[1][i]);
         if (bEnableHME)
         {
-            X265_FREE(lowerResMvs[0][i]);
-            X265_FREE(lowerResMvs[1][i]);
-            X265_FREE(lowerResMvCosts[0][i]);
-            X265_FREE(lowerResMvCosts[1][i]);
+            ARENA_FREE(bArena, lowerResMvs[0][i]);
+            ARENA_FREE(bArena, lowerResMvs[1][i]);
+            ARENA_FREE(bArena, lowerResMvCosts[0][i]);
+            ARENA_FREE(bArena, lowerResMvCosts[1][i]);
         }
     }
-    X265_FREE(qpAqOffset);
-    X265_FREE(invQscaleFactor);
-    X265_FREE(qpCuTreeOffset);
-    X265_FREE(propagateCost);
-    X265_FREE(invQscaleFactor8x8);
-    X265_FREE(edgeInclined);
-    X265_FREE(qpAqMotionOffset);
-    X265_FREE(blockVariance);
+    ARENA_FREE(bArena, qpAqOffset);
+    ARENA_FREE(bArena, invQscaleFactor);
+    ARENA_FREE(bArena, qpCuTreeOffset);
+    ARENA_FREE(bArena, propagateCost);
+    ARENA_FREE(bArena, invQscaleFactor8x8);
+    ARENA_FREE(bArena, edgeInclined);
+    ARENA_FREE(bArena, qpAqMotionOffset);
+    ARENA_FREE(bArena, blockVariance);
     if (maxAQDepth > 0)
     {
         for (uint32_t d = 0; d < 4; d++)
@@ -244,12 +246,12 @@ void Lowres::destroy()
             if (!aqLayerDepth[ctuSizeIdx][aqDepth][d])
                 continue;
 
-            X265_FREE(pAQLayer[d].dActivity);
-            X265_FREE(pAQLayer[d].dQpOffset);
-            X265_FREE(pAQLayer[d].dCuTreeOffset);
+            ARENA_FREE(bArena, pAQLayer[d].dActivity);
+            ARENA_FREE(bArena, pAQLayer[d].dQpOffset);
+            ARENA_FREE(bArena, pAQLayer[d].dCuTreeOffset);
 
             if (pAQLayer[d].bQpSize == true)
-                X265_FREE(pAQLayer[d].dCuTreeOffset8x8);
+                ARENA_FREE(bArena, pAQLayer[d].dCuTreeOffset8x8);
         }
 
         delete[] pAQLayer;
@@ -266,6 +268,7 @@ void Lowres::init(PicYuv *origPic, int poc)
     indB = 0;
     memset(costEst, -1, sizeof(costEst));
     memset(weightedCostDelta, 0, sizeof(weightedCostDelta));
+    memset(weightEstimate, 0, sizeof(weightEstimate));
     interPCostPercDiff = 0.0;
     intraCostPercDiff = 0.0;
     m_bIsMaxThres = false;
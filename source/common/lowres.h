@@ -32,6 +32,8 @@
 namespace X265_NS {
 // private namespace
 
+class SubpelCache;
+
 struct ReferencePlanes
 {
     ReferencePlanes() { memset(this, 0, sizeof(ReferencePlanes)); }
@@ -39,6 +41,7 @@ struct ReferencePlanes
     pixel*   fpelPlane[3];
     pixel*   lowresPlane[4];
     PicYuv*  reconPic;
+    SubpelCache* subpelCache;  /* cached sub-pel luma of an unweighted full-res reference, or NULL */
 
     /* 1/16th resolution : Level-0 HME planes */
     pixel*   fpelLowerResPlane[3];
@@ -159,7 +162,7 @@ struct PicQPAdaptationLayer
     double   dAvgActivity;
     bool     bQpSize;
 
-    bool  create(uint32_t width, uint32_t height, uint32_t aqPartWidth, uint32_t aqPartHeight, uint32_t numAQPartInWidthExt, uint32_t numAQPartInHeightExt);
+    bool  create(uint32_t width, uint32_t height, uint32_t aqPartWidth, uint32_t aqPartHeight, uint32_t numAQPartInWidthExt, uint32_t numAQPartInHeightExt, bool bArena);
     void  destroy();
 };
 
@@ -179,6 +182,7 @@ struct Lowres : public ReferencePlanes
     bool   bKeyframe;
     bool   bLastMiniGopBFrame;
     bool   bIsFadeEnd;
+    bool   bArena;           // buffers allocated from the frame arena
 
     double ipCostRatio;
 
@@ -234,6 +238,14 @@ struct Lowres : public ReferencePlanes
     uint16_t* propagateCost;
     double    weightedCostDelta[X265_BFRAME_MAX + 2];
     ReferencePlanes weightedRef[X265_BFRAME_MAX + 2];
+
+    /* luma weights found by the lookahead for the reference at each distance,
+     * refined by the frame encoder's weight analysis, see param.bWeightpRefine */
+    struct {
+        bool     bWeighted;
+        int      weight;
+        int      denom;
+    } weightEstimate[X265_BFRAME_MAX + 2];
     /* For hist-based scenecut */
     bool   m_bIsMaxThres;
     double interPCostPercDiff;
@@ -121,12 +121,22 @@ void x265_param_default(x265_param* param)
     param->cpuid = X265_NS::cpu_detect(false);
     param->bEnableWavefront = 1;
     param->frameNumThreads = 0;
+    param->filterLag = 0;
+    param->bFrameArena = 0;
+    param->context = NULL;
+    param->poolWeight = 1;
+    param->bDeadlineSched = 0;
+    param->deadlineLatency = 0;
 
     param->logLevel = X265_LOG_INFO;
     param->logfn = NULL;
     param->logfLevel = X265_LOG_INFO;
     param->csvLogLevel = 0;
     param->csvfn = NULL;
+    param->latencyTraceFile = NULL;
+    param->latencyTraceFrames = 0;
+    param->ctuStatsFile = NULL;
+    param->bCtuHeatmap = 0;
     param->rc.lambdaFileName = NULL;
     param->bLogCuStats = 0;
     param->decodedPictureHashSEI = 0;
@@ -218,6 +228,11 @@ void x265_param_default(x265_param* param)
     param->maxNumReferences = 3;
     param->bEnableTemporalMvp = 1;
     param->bEnableHME = 0;
+    param->bMultiRefME = 0;
+    param->bMVField = 0;
+    param->bSpeculativeSplit = 0;
+    param->bWeightpRefine = 0;
+    param->subpelCacheSize = 0;
     param->hmeSearchMethod[0] = X265_HEX_SEARCH;
     param->hmeSearchMethod[1] = param->hmeSearchMethod[2] = X265_UMH_SEARCH;
     param->hmeRange[0] = 16;
@@ -951,6 +966,11 @@ int x265_param_parse(x265_param* p, const char* name, const char* value)
     OPT("frame-threads") p->frameNumThreads = atoi(value);
     OPT("pmode") p->bDistributeModeAnalysis = atobool(value);
     OPT("pme") p->bDistributeMotionEstimation = atobool(value);
+    OPT("filter-lag") p->filterLag = atoi(value);
+    OPT("frame-arena") p->bFrameArena = atobool(value);
+    OPT("pool-weight") p->poolWeight = atoi(value);
+    OPT("deadline-sched") p->bDeadlineSched = atobool(value);
+    OPT("deadline-latency") p->deadlineLatency = atoi(value);
     OPT2("level-idc", "level")
     {
         /* allow "5.1" or "51", both converted to integer 51 */
@@ -1280,6 +1300,15 @@ int x265_param_parse(x265_param* p, const char* name, const char* value)
         OPT("stylish") p->bStylish = atobool(value);
         OPT("csv") p->csvfn = strdup(value);
         OPT("csv-log-level") p->csvLogLevel = atoi(value);
+        OPT("latency-trace")
+        {
+            p->latencyTraceFile = strdup(value);
+            if (!p->latencyTraceFrames)
+                p->latencyTraceFrames = X265_LATENCY_TRACE_FRAMES;
+        }
+        OPT("latency-trace-frames") p->latencyTraceFrames = atoi(value);
+        OPT("ctu-stats") p->ctuStatsFile = strdup(value);
+        OPT("ctu-heatmap") p->bCtuHeatmap = atobool(value);
         OPT("qpmin") p->rc.qpMin = atoi(value);
         OPT("analyze-src-pics") p->bSourceReferenceEstimation = atobool(value);
         OPT("log2-max-poc-lsb") p->log2MaxPocLsb = atoi(value);
@@ -1493,6 +1522,11 @@ int x265_param_parse(x265_param* p, const char* name, const char* value)
         OPT("frame-dup") p->bEnableFrameDuplication = atobool(value);
         OPT("dup-threshold") p->dupThreshold = atoi(value);
         OPT("hme") p->bEnableHME = atobool(value);
+        OPT("multi-ref-me") p->bMultiRefME = atobool(value);
+        OPT("mv-field") p->bMVField = atobool(value);
+        OPT("speculative-split") p->bSpeculativeSplit = atobool(value);
+        OPT("weightp-refine") p->bWeightpRefine = atobool(value);
+        OPT("subpel-cache") p->subpelCacheSize = atoi(value);
         OPT("hme-search")
         {
             char search[3][5];
@@ -1709,6 +1743,16 @@ int x265_check_params(x265_param* param)
           "limitRectAmp must be 0, 1");
     CHECK(param->frameNumThreads < 0 || param->frameNumThreads > X265_MAX_FRAME_THREADS,
           "frameNumThreads (--frame-threads) must be [0 .. X265_MAX_FRAME_THREADS)");
+    CHECK(param->filterLag < 0,
+          "filterLag (--filter-lag) must be 0 or greater");
+    CHECK(param->poolWeight < 1 || param->poolWeight > 1000,
+          "poolWeight (--pool-weight) must be between 1 and 1000");
+    CHECK(param->deadlineLatency < 0,
+          "deadlineLatency (--deadline-latency) must be 0 or greater");
+    CHECK(param->latencyTraceFrames < 0 || param->latencyTraceFrames > 1000000,
+          "latencyTraceFrames (--latency-trace-frames) must be between 0 and 1000000");
+    CHECK(param->subpelCacheSize < 0,
+          "subpelCacheSize (--subpel-cache) must be 0 or greater");
     CHECK(param->cbQpOffset < -12, "Min. Chroma Cb QP Offset is -12");
     CHECK(param->cbQpOffset >  12, "Max. Chroma Cb QP Offset is  12");
     CHECK(param->crQpOffset < -12, "Min. Chroma Cr QP Offset is -12");
@@ -2294,6 +2338,7 @@ char *x265_param2string(x265_param* p, int padx, int pady)
 
     s += sprintf(s, " cpuid=%d", p->cpuid);
     s += sprintf(s, " frame-threads=%d", p->frameNumThreads);
+    s += sprintf(s, " filter-lag=%d", p->filterLag);
     if (p->numaPools)
         s += sprintf(s, " numa-pools=%s", p->numaPools);
 
@@ -2336,6 +2381,11 @@ char *x265_param2string(x265_param* p, int padx, int pady)
         s += sprintf(s, " Level 0,1,2=%d,%d,%d", p->hmeSearchMethod[0], p->hmeSearchMethod[1], p->hmeSearchMethod[2]);
         s += sprintf(s, " merange L0,L1,L2=%d,%d,%d", p->hmeRange[0], p->hmeRange[1], p->hmeRange[2]);
     }
+    BOOL(p->bMultiRefME, "multi-ref-me");
+    BOOL(p->bMVField, "mv-field");
+    BOOL(p->bSpeculativeSplit, "speculative-split");
+    BOOL(p->bWeightpRefine, "weightp-refine");
+    s += sprintf(s, " subpel-cache=%d", p->subpelCacheSize);
     BOOL(p->bSourceReferenceEstimation, "analyze-src-pics");
     BOOL(p->bSaoNonDeblocked, "sao-non-deblock");
     s += sprintf(s, " selective-sao=%d", p->selectiveSAO);
@@ -2519,6 +2569,12 @@ void x265_copy_params(x265_param* dst, x265_param* src)
     dst->bEnableWavefront = src->bEnableWavefront;
     dst->bDistributeModeAnalysis = src->bDistributeModeAnalysis;
     dst->bDistributeMotionEstimation = src->bDistributeMotionEstimation;
+    dst->filterLag = src->filterLag;
+    dst->bFrameArena = src->bFrameArena;
+    dst->context = src->context;
+    dst->poolWeight = src->poolWeight;
+    dst->bDeadlineSched = src->bDeadlineSched;
+    dst->deadlineLatency = src->deadlineLatency;
     dst->bLogCuStats = src->bLogCuStats;
     dst->bEnablePsnr = src->bEnablePsnr;
     dst->bEnableSsim = src->bEnableSsim;
@@ -2526,6 +2582,12 @@ void x265_copy_params(x265_param* dst, x265_param* src)
     dst->csvLogLevel = src->csvLogLevel;
     if (src->csvfn) dst->csvfn = strdup(src->csvfn);
     else dst->csvfn = NULL;
+    if (src->latencyTraceFile) dst->latencyTraceFile = strdup(src->latencyTraceFile);
+    else dst->latencyTraceFile = NULL;
+    dst->latencyTraceFrames = src->latencyTraceFrames;
+    if (src->ctuStatsFile) dst->ctuStatsFile = strdup(src->ctuStatsFile);
+    else dst->ctuStatsFile = NULL;
+    dst->bCtuHeatmap = src->bCtuHeatmap;
     dst->internalBitDepth = src->internalBitDepth;
     dst->sourceBitDepth = src->sourceBitDepth;
     dst->internalCsp = src->internalCsp;
@@ -2586,6 +2648,11 @@ void x265_copy_params(x265_param* dst, x265_param* src)
     dst->bEnableFrameDuplication = src->bEnableFrameDuplication;
     dst->dupThreshold = src->dupThreshold;
     dst->bEnableHME = src->bEnableHME;
+    dst->bMultiRefME = src->bMultiRefME;
+    dst->bMVField = src->bMVField;
+    dst->bSpeculativeSplit = src->bSpeculativeSplit;
+    dst->bWeightpRefine = src->bWeightpRefine;
+    dst->subpelCacheSize = src->subpelCacheSize;
     if (src->bEnableHME)
     {
         for (int level = 0; level < 3; level++)
@@ -26,6 +26,7 @@
 #include "picyuv.h"
 #include "slice.h"
 #include "primitives.h"
+#include "framearena.h"
 
 using namespace X265_NS;
 
@@ -95,7 +96,7 @@ bool PicYuv::create(x265_param* param, bool picAlloc, pixel *pixelbuf)
     {
         if (picAlloc)
         {
-            CHECKED_MALLOC(m_picBuf[0], pixel, m_stride * (maxHeight + (m_lumaMarginY * 2)));
+            CHECKED_ARENA_MALLOC(param->bFrameArena, m_picBuf[0], pixel, m_stride * (maxHeight + (m_lumaMarginY * 2)));
             m_picOrg[0] = m_picBuf[0] + m_lumaMarginY * m_stride + m_lumaMarginX;
         }
     }
@@ -107,8 +108,8 @@ bool PicYuv::create(x265_param* param, bool picAlloc, pixel *pixelbuf)
         m_strideC = ((numCuInWidth * m_param->maxCUSize) >> m_hChromaShift) + (m_chromaMarginX * 2);
         if (picAlloc)
         {
-            CHECKED_MALLOC(m_picBuf[1], pixel, m_strideC * ((maxHeight >> m_vChromaShift) + (m_chromaMarginY * 2)));
-            CHECKED_MALLOC(m_picBuf[2], pixel, m_strideC * ((maxHeight >> m_vChromaShift) + (m_chromaMarginY * 2)));
+            CHECKED_ARENA_MALLOC(param->bFrameArena, m_picBuf[1], pixel, m_strideC * ((maxHeight >> m_vChromaShift) + (m_chromaMarginY * 2)));
+            CHECKED_ARENA_MALLOC(param->bFrameArena, m_picBuf[2], pixel, m_strideC * ((maxHeight >> m_vChromaShift) + (m_chromaMarginY * 2)));
 
             m_picOrg[1] = m_picBuf[1] + m_chromaMarginY * m_strideC + m_chromaMarginX;
             m_picOrg[2] = m_picBuf[2] + m_chromaMarginY * m_strideC + m_chromaMarginX;
@@ -199,9 +200,9 @@ fail:
 
 void PicYuv::destroy()
 {
-    X265_FREE(m_picBuf[0]);
-    X265_FREE(m_picBuf[1]);
-    X265_FREE(m_picBuf[2]);
+    ARENA_FREE(m_param->bFrameArena, m_picBuf[0]);
+    ARENA_FREE(m_param->bFrameArena, m_picBuf[1]);
+    ARENA_FREE(m_param->bFrameArena, m_picBuf[2]);
 }
 
 /* Copy pixels from an x265_picture into internal PicYuv instance.
@@ -54,6 +54,27 @@ int sad(const pixel* pix1, intptr_t stride_pix1, const pixel* pix2, intptr_t str
     return sum;
 }
 
+template<int lx, int ly>
+// sad checked against bound after every 4 rows
+int sad_bounded(const pixel* pix1, intptr_t stride_pix1, const pixel* pix2, intptr_t stride_pix2, int bound)
+{
+    int sum = 0;
+
+    for (int y = 0; y < ly; y++)
+    {
+        for (int x = 0; x < lx; x++)
+            sum += abs(pix1[x] - pix2[x]);
+
+        pix1 += stride_pix1;
+        pix2 += stride_pix2;
+
+        if ((y & 3) == 3 && sum > bound)
+            break;
+    }
+
+    return sum;
+}
+
 template<int lx, int ly>
 int sad(const int16_t* pix1, intptr_t stride_pix1, const int16_t* pix2, intptr_t stride_pix2)
 {
@@ -129,8 +150,8 @@ int ads_x4(int encDC[4], uint32_t *sums, int delta, uint16_t *costMvX, int16_t *
             + abs(encDC[2] - long(sums[delta]))
             + abs(encDC[3] - long(sums[delta + (lx >> 1)]))
             + costMvX[i];
-        if (ads < thresh)
-            mvs[nmv++] = i;
+        mvs[nmv] = i;
+        nmv += ads < thresh;
     }
     return nmv;
 }
@@ -144,8 +165,8 @@ int ads_x2(int encDC[2], uint32_t *sums, int delta, uint16_t *costMvX, int16_t *
         int ads = abs(encDC[0] - long(sums[0]))
             + abs(encDC[1] - long(sums[delta]))
             + costMvX[i];
-        if (ads < thresh)
-            mvs[nmv++] = i;
+        mvs[nmv] = i;
+        nmv += ads < thresh;
     }
     return nmv;
 }
@@ -158,8 +179,8 @@ int ads_x1(int encDC[1], uint32_t *sums, int, uint16_t *costMvX, int16_t *mvs, i
     {
         int ads = abs(encDC[0] - long(sums[0]))
             + costMvX[i];
-        if (ads < thresh)
-            mvs[nmv++] = i;
+        mvs[nmv] = i;
+        nmv += ads < thresh;
     }
     return nmv;
 }
@@ -296,6 +317,35 @@ int satd8(const pixel* pix1, intptr_t stride_pix1, const pixel* pix2, intptr_t s
     return satd;
 }
 
+template<int w, int h>
+// satd in blocks of 8x4 (4x4 for widths not a multiple of 8), checked
+// against bound after every row of blocks
+int satd_bounded(const pixel* pix1, intptr_t stride_pix1, const pixel* pix2, intptr_t stride_pix2, int bound)
+{
+    int satd = 0;
+
+    for (int row = 0; row < h; row += 4)
+    {
+        if (w & 7)
+        {
+            for (int col = 0; col < w; col += 4)
+                satd += satd_4x4(pix1 + row * stride_pix1 + col, stride_pix1,
+                                 pix2 + row * stride_pix2 + col, stride_pix2);
+        }
+        else
+        {
+            for (int col = 0; col < w; col += 8)
+                satd += satd_8x4(pix1 + row * stride_pix1 + col, stride_pix1,
+                                 pix2 + row * stride_pix2 + col, stride_pix2);
+        }
+
+        if (satd > bound)
+            break;
+    }
+
+    return satd;
+}
+
 inline int _sa8d_8x8(const pixel* pix1, intptr_t i_pix1, const pixel* pix2, intptr_t i_pix2)
 {
     sum2_t tmp[8][4];
@@ -1021,6 +1071,19 @@ static pixel planeClipAndMax_c(pixel *src, intptr_t stride, int width, int heigh
 namespace X265_NS {
 // x265 private namespace
 
+/* sa8d of a square block (satd for 4x4), for the fused intra mode decision
+ * kernels of intrapred.cpp */
+int sa8d_square_c(int log2Size, const pixel* pix1, intptr_t stride_pix1, const pixel* pix2, intptr_t stride_pix2)
+{
+    switch (log2Size)
+    {
+    case 2:  return satd_4x4(pix1, stride_pix1, pix2, stride_pix2);
+    case 3:  return sa8d_8x8(pix1, stride_pix1, pix2, stride_pix2);
+    case 4:  return sa8d_16x16(pix1, stride_pix1, pix2, stride_pix2);
+    default: return sa8d16<32, 32>(pix1, stride_pix1, pix2, stride_pix2);
+    }
+}
+
 /* Extend the edges of a picture so that it may safely be used for motion
  * compensation. This function assumes the picture is stored in a buffer with
  * sufficient padding for the X and Y margins */
@@ -1050,6 +1113,8 @@ void setupPixelPrimitives_c(EncoderPrimitives &p)
     p.pu[LUMA_ ## W ## x ## H].sad = sad<W, H>; \
     p.pu[LUMA_ ## W ## x ## H].sad_x3 = sad_x3<W, H>; \
     p.pu[LUMA_ ## W ## x ## H].sad_x4 = sad_x4<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].sad_bounded = sad_bounded<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].satd_bounded = satd_bounded<W, H>; \
     p.pu[LUMA_ ## W ## x ## H].pixelavg_pp[NONALIGNED] = pixelavg_pp<W, H>; \
     p.pu[LUMA_ ## W ## x ## H].pixelavg_pp[ALIGNED] = pixelavg_pp<W, H>;
 #define LUMA_CU(W, H) \
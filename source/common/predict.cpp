@@ -777,8 +777,13 @@ void Predict::fillReferenceSamples(const pixel* adiOrigin, intptr_t picStride, c
         // Fill left & below-left samples
         adiTemp += picStride;
         adi--;
-        // NOTE: over copy here, but reduce condition operators
-        for (int j = 0; j < leftUnits * unitHeight; j++)
+        // NOTE: over copy here, but reduce condition operators. Unavailable
+        // units at the ends are not read, another thread may be coding them
+        // (see param.bSpeculativeSplit)
+        int numLeft = leftUnits;
+        while (numLeft && !bNeighborFlags[leftUnits - numLeft])
+            numLeft--;
+        for (int j = 0; j < numLeft * unitHeight; j++)
         {
             adi[-j] = adiTemp[j * picStride];
         }
@@ -786,8 +791,10 @@ void Predict::fillReferenceSamples(const pixel* adiOrigin, intptr_t picStride, c
         // Fill above & above-right samples
         adiTemp = adiOrigin - picStride;
         adi = adiLineBuffer + (leftUnits * unitHeight) + unitWidth;
-        // NOTE: over copy here, but reduce condition operators
-        memcpy(adi, adiTemp, aboveUnits * unitWidth * sizeof(*adiTemp));
+        int numAbove = aboveUnits;
+        while (numAbove && !bNeighborFlags[leftUnits + numAbove])
+            numAbove--;
+        memcpy(adi, adiTemp, numAbove * unitWidth * sizeof(*adiTemp));
 
         // Pad reference samples when necessary
         int curr = 0;
@@ -59,6 +59,7 @@ void setupLoopFilterPrimitives_c(EncoderPrimitives &p);
 void setupSaoPrimitives_c(EncoderPrimitives &p);
 void setupSeaIntegralPrimitives_c(EncoderPrimitives &p);
 void setupLowPassPrimitives_c(EncoderPrimitives& p);
+void setupBitstreamPrimitives_c(EncoderPrimitives &p);
 
 void setupCPrimitives(EncoderPrimitives &p)
 {
@@ -70,6 +71,7 @@ void setupCPrimitives(EncoderPrimitives &p)
     setupLoopFilterPrimitives_c(p); // loopfilter.cpp
     setupSaoPrimitives_c(p);        // sao.cpp
     setupSeaIntegralPrimitives_c(p);  // framefilter.cpp
+    setupBitstreamPrimitives_c(p);  // bitstream.cpp
 }
 
 void enableLowpassDCTPrimitives(EncoderPrimitives &p)
@@ -273,6 +275,7 @@ void x265_setup_primitives(x265_param *param)
         }
 #endif
 
+        setupAllAnglesSa8dPrimitives(primitives);
         setupAliasPrimitives(primitives);
 
         if (param->bLowPassDct)
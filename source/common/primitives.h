@@ -132,6 +132,9 @@ enum IntegralSize
 
 typedef int  (*pixelcmp_t)(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride); // fenc is aligned
 typedef int  (*pixelcmp_ss_t)(const int16_t* fenc, intptr_t fencstride, const int16_t* fref, intptr_t frefstride);
+/* returns the same cost as pixelcmp_t when it is not above bound, else any
+ * value above bound; the rows of the block may be abandoned once they are */
+typedef int  (*pixelcmp_bounded_t)(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride, int bound);
 typedef sse_t (*pixel_sse_t)(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride); // fenc is aligned
 typedef sse_t (*pixel_sse_ss_t)(const int16_t* fenc, intptr_t fencstride, const int16_t* fref, intptr_t frefstride);
 typedef sse_t (*pixel_ssd_s_t)(const int16_t* fenc, intptr_t fencstride);
@@ -142,6 +145,7 @@ typedef void (*blockfill_s_t)(int16_t* dst, intptr_t dstride, int16_t val);
 
 typedef void (*intra_pred_t)(pixel* dst, intptr_t dstStride, const pixel *srcPix, int dirMode, int bFilter);
 typedef void (*intra_allangs_t)(pixel *dst, pixel *refPix, pixel *filtPix, int bLuma);
+typedef void (*intra_allangs_cost_t)(int* costs, const pixel* fenc, intptr_t fencStride, pixel *refPix, pixel *filtPix, int bLuma);
 typedef void (*intra_filter_t)(const pixel* references, pixel* filtered);
 
 typedef void (*cpy2Dto1D_shl_t)(int16_t* dst, const int16_t* src, intptr_t srcStride, int shift);
@@ -217,6 +221,9 @@ typedef void (*cutree_fix8_pack)(uint16_t *dst, double *src, int count);
 typedef int (*scanPosLast_t)(const uint16_t *scan, const coeff_t *coeff, uint16_t *coeffSign, uint16_t *coeffFlag, uint8_t *coeffNum, int numSig, const uint16_t* scanCG4x4, const int trSize);
 typedef uint32_t (*findPosFirstLast_t)(const int16_t *dstCoeff, const intptr_t trSize, const uint16_t scanTbl[16]);
 
+/* returns the offset of the first two consecutive zero bytes, or size if there are none */
+typedef uint32_t (*findZeroPair_t)(const uint8_t* src, uint32_t size);
+
 typedef uint32_t (*costCoeffNxN_t)(const uint16_t *scan, const coeff_t *coeff, intptr_t trSize, uint16_t *absCoeff, const uint8_t *tabSigCtx, uint32_t scanFlagMask, uint8_t *baseCtx, int offset, int scanPosSigOff, int subPosBase);
 typedef uint32_t (*costCoeffRemain_t)(uint16_t *absCoeff, int numNonZero, int idx);
 typedef uint32_t (*costC1C2Flag_t)(uint16_t *absCoeff, intptr_t numC1Flag, uint8_t *baseCtxMod, intptr_t ctxOffset);
@@ -249,6 +256,8 @@ struct EncoderPrimitives
         pixelcmp_x4_t  sad_x4;      // Sum of Absolute Differences, 4 mv offsets at once
         pixelcmp_ads_t ads;         // Absolute Differences sum
         pixelcmp_t     satd;        // Sum of Absolute Transformed Differences (4x4 Hadamard)
+        pixelcmp_bounded_t sad_bounded;  // sad and satd, early terminating once a bound is exceeded
+        pixelcmp_bounded_t satd_bounded;
 
         filter_pp_t    luma_hpp;    // 8-tap luma motion compensation interpolation filters
         filter_hps_t   luma_hps;
@@ -302,6 +311,7 @@ struct EncoderPrimitives
         pixelcmp_t      sa8d;          // Sum of Transformed Differences (8x8 Hadamard), uses satd for 4x4 intra TU
         transpose_t     transpose;     // transpose pixel block; for use with intra all-angs
         intra_allangs_t intra_pred_allangs;
+        intra_allangs_cost_t intra_allangs_sa8d; // sa8d of fenc against each angular prediction (modes 2..34 in costs[0..32]), no predictions are stored
         intra_filter_t  intra_filter;
         intra_pred_t    intra_pred[NUM_INTRA_MODE];
         nonPsyRdoQuant_t nonPsyRdoQuant;
@@ -371,6 +381,8 @@ struct EncoderPrimitives
     scanPosLast_t         scanPosLast;
     findPosFirstLast_t    findPosFirstLast;
 
+    findZeroPair_t        findZeroPair; // NAL emulation prevention scan
+
     costCoeffNxN_t        costCoeffNxN;
     costCoeffRemain_t     costCoeffRemain;
     costC1C2Flag_t        costC1C2Flag;
@@ -469,6 +481,7 @@ void setupCPrimitives(EncoderPrimitives &p);
 void setupInstrinsicPrimitives(EncoderPrimitives &p, int cpuMask);
 void setupAssemblyPrimitives(EncoderPrimitives &p, int cpuMask);
 void setupAliasPrimitives(EncoderPrimitives &p);
+void setupAllAnglesSa8dPrimitives(EncoderPrimitives &p);
 #if X265_ARCH_ARM64
 void setupAliasCPrimitives(EncoderPrimitives &cp, EncoderPrimitives &asmp, int cpuMask);
 #endif
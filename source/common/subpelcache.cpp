@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include "picyuv.h"
+#include "subpelcache.h"
+
+using namespace X265_NS;
+
+SubpelCache::SubpelCache()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+bool SubpelCache::create(const x265_param& param, uint32_t numCuInHeight)
+{
+    /* the interpolated rows span the picture and its margins less 8 rows on
+     * each side, see bind(), the last band may be partial */
+    m_ctuSize = param.maxCUSize;
+    m_bandHeight = param.maxCUSize;
+    m_maxBands = numCuInHeight + 3;
+    m_bandState = X265_MALLOC(int32_t, NUM_PHASES * m_maxBands);
+    if (!m_bandState)
+        return false;
+    memset(m_bandState, 0, NUM_PHASES * m_maxBands * sizeof(int32_t));
+    return true;
+}
+
+void SubpelCache::destroy()
+{
+    release();
+    X265_FREE(m_bandState);
+    m_bandState = NULL;
+}
+
+void SubpelCache::bind(const PicYuv& reconPic, ThreadSafeInteger* reconRowFlag, Budget& budget)
+{
+    X265_CHECK(!m_planeBuf[1] && !m_planeBuf[NUM_PHASES - 1], "sub-pel cache bound twice\n");
+
+    m_reconPic = &reconPic;
+    m_reconRowFlag = reconRowFlag;
+    m_budget = &budget;
+    m_numCuRows = (reconPic.m_picHeight + m_ctuSize - 1) / m_ctuSize;
+    m_stride = reconPic.m_stride;
+    m_originOffset = reconPic.m_lumaMarginY * m_stride + reconPic.m_lumaMarginX;
+    m_planeSize = m_stride * (m_numCuRows * m_ctuSize + 2 * reconPic.m_lumaMarginY);
+
+    /* the 8-tap filters read 3 pixels before and 4 after each position, keep
+     * 8 pixels (a multiple of the smallest interpolated block) inside the
+     * extended picture on every side */
+    m_xBegin = 8;
+    m_xEnd = reconPic.m_picWidth + 2 * reconPic.m_lumaMarginX - 8;
+    m_yBegin = 8;
+    m_yEnd = reconPic.m_picHeight + 2 * reconPic.m_lumaMarginY - 8;
+    X265_CHECK(!((m_xEnd - m_xBegin) & 7) && !((m_yEnd - m_yBegin) & 7), "sub-pel cache region is not a multiple of 8\n");
+    X265_CHECK((m_yEnd - m_yBegin + m_bandHeight - 1) / m_bandHeight <= m_maxBands, "sub-pel cache band count overflow\n");
+}
+
+void SubpelCache::release()
+{
+    for (int phase = 1; phase < NUM_PHASES; phase++)
+    {
+        if (m_planeBuf[phase])
+        {
+            X265_FREE(m_planeBuf[phase]);
+            m_planeBuf[phase] = NULL;
+            ATOMIC_ADD64(&m_budget->bytesLeft, (int64_t)(m_planeSize * sizeof(pixel)));
+        }
+        m_planeState[phase] = 0;
+    }
+    if (m_bandState)
+        memset(m_bandState, 0, NUM_PHASES * m_maxBands * sizeof(int32_t));
+    m_reconPic = NULL;
+    m_reconRowFlag = NULL;
+}
+
+/* allocate the plane of a phase on first use, if the budget allows; the
+ * thread which claims the plane allocates it, others find it not cached
+ * until it is ready */
+bool SubpelCache::claimPlane(int phase)
+{
+    int32_t state = ATOMIC_OR(&m_planeState[phase], 0);
+    if (state & PLANE_READY)
+        return true;
+    if (state || ATOMIC_OR(&m_planeState[phase], PLANE_CLAIMED))
+        return false;
+
+    int64_t bytes = (int64_t)(m_planeSize * sizeof(pixel));
+    if (ATOMIC_ADD64(&m_budget->bytesLeft, -bytes) < bytes)
+    {
+        /* refused, the plane stays claimed until the picture is released */
+        ATOMIC_ADD64(&m_budget->bytesLeft, bytes);
+        return false;
+    }
+    m_planeBuf[phase] = X265_MALLOC(pixel, m_planeSize);
+    if (!m_planeBuf[phase])
+    {
+        ATOMIC_ADD64(&m_budget->bytesLeft, bytes);
+        return false;
+    }
+    ATOMIC_OR(&m_planeState[phase], PLANE_READY);
+    return true;
+}
+
+/* returns true once the band of the phase plane is interpolated, which the
+ * calling thread does if the band is not claimed and the reference rows the
+ * band reads are reconstructed and extended */
+bool SubpelCache::bandReady(int phase, int band)
+{
+    int32_t* state = &m_bandState[phase * m_maxBands + band];
+    int32_t s = ATOMIC_OR(state, 0);
+    if (s & BAND_READY)
+        return true;
+    if (s)
+        return false;
+
+    int yBegin = m_yBegin + band * m_bandHeight;
+    int yEnd = X265_MIN(yBegin + m_bandHeight, m_yEnd);
+
+    /* the CTU row holding the last picture row the vertical filter reads;
+     * rows of the bottom margin are extended with the last CTU row */
+    int lastRow = yEnd + 3 - m_reconPic->m_lumaMarginY;
+    int cuRow = lastRow >= (int)m_reconPic->m_picHeight ? m_numCuRows - 1 : X265_MAX(lastRow, 0) / m_ctuSize;
+    if (!m_reconRowFlag[cuRow].get())
+        return false;
+
+    s = ATOMIC_OR(state, BAND_CLAIMED);
+    if (s)
+        return !!(s & BAND_READY);
+
+    interpolateBand(phase, yBegin, yEnd);
+    ATOMIC_OR(state, BAND_READY);
+    return true;
+}
+
+void SubpelCache::interpolateBand(int phase, int yBegin, int yEnd)
+{
+    int xFrac = phase & 3;
+    int yFrac = phase >> 2;
+    intptr_t stride = m_stride;
+    const pixel* src = m_reconPic->m_picOrg[0] - m_originOffset;
+    pixel* dst = m_planeBuf[phase];
+
+    for (int y = yBegin; y < yEnd;)
+    {
+        int height = yEnd - y >= 32 ? 32 : yEnd - y >= 16 ? 16 : 8;
+        for (int x = m_xBegin; x < m_xEnd;)
+        {
+            int width = m_xEnd - x >= 32 ? 32 : 8;
+            int part = partitionFromSizes(width, height);
+            const pixel* s = src + y * stride + x;
+            pixel* d = dst + y * stride + x;
+
+            if (!yFrac)
+                primitives.pu[part].luma_hpp(s, stride, d, stride, xFrac);
+            else if (!xFrac)
+                primitives.pu[part].luma_vpp(s, stride, d, stride, yFrac);
+            else
+                primitives.pu[part].luma_hvpp(s, stride, d, stride, xFrac, yFrac);
+            x += width;
+        }
+        y += height;
+    }
+}
+
+const pixel* SubpelCache::getBlock(intptr_t offset, int width, int height, int xFrac, int yFrac)
+{
+    int phase = (yFrac << 2) | xFrac;
+    if (!claimPlane(phase))
+        return NULL;
+
+    intptr_t pos = offset + m_originOffset;
+    int y = (int)(pos / m_stride);
+    int x = (int)(pos - y * m_stride);
+    if (x < m_xBegin || x + width > m_xEnd || y < m_yBegin || y + height > m_yEnd)
+        return NULL;
+
+    int lastBand = (y + height - 1 - m_yBegin) / m_bandHeight;
+    for (int band = (y - m_yBegin) / m_bandHeight; band <= lastBand; band++)
+        if (!bandReady(phase, band))
+            return NULL;
+
+    return m_planeBuf[phase] + pos;
+}
@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_SUBPELCACHE_H
+#define X265_SUBPELCACHE_H
+
+#include "common.h"
+#include "threading.h"
+
+namespace X265_NS {
+// private x265 namespace
+
+class PicYuv;
+
+/* Luma sub-pel planes of a reconstructed picture for the sub-pel refinement
+ * of motion searches, see param.subpelCacheSize. Each of the 15 fractional
+ * phases is a plane with the layout of the reconstructed picture, allocated
+ * on first use while the encoder's memory budget allows. A phase plane is
+ * interpolated one band of CTU height at a time, by the first motion search
+ * which needs the band once the reference rows it reads are reconstructed,
+ * and is then shared by all frame encoders referencing the picture. The
+ * planes are interpolated with the same primitives as the motion search, so
+ * a cached block is identical to one interpolated on the fly.
+ *
+ * getBlock() never waits: it returns NULL for a block whose band is not yet
+ * available, or being interpolated by another thread, and the caller
+ * interpolates the block itself. */
+class SubpelCache
+{
+public:
+
+    /* memory the cached planes of all frames of an encoder may hold */
+    struct Budget
+    {
+        int64_t bytesLeft;
+    };
+
+    SubpelCache();
+
+    bool create(const x265_param& param, uint32_t numCuInHeight);
+    void destroy();
+
+    /* attach the cache to the reconstructed picture of a frame which is
+     * starting its encode, no phase is cached until release() */
+    void bind(const PicYuv& reconPic, ThreadSafeInteger* reconRowFlag, Budget& budget);
+
+    /* free the phase planes and return their memory to the budget, once the
+     * picture is no longer referenced */
+    void release();
+
+    /* interpolated luma of the width x height block at offset from the luma
+     * origin of the picture, at phase (xFrac, yFrac), in a plane with the
+     * stride of the picture. NULL if the block is not cached */
+    const pixel* getBlock(intptr_t offset, int width, int height, int xFrac, int yFrac);
+
+protected:
+
+    enum { NUM_PHASES = 16 };                     /* indexed by yFrac * 4 + xFrac, 0 unused */
+    enum { PLANE_CLAIMED = 1, PLANE_READY = 2 };  /* plane states, CLAIMED only: refused by the budget */
+    enum { BAND_CLAIMED = 1, BAND_READY = 2 };
+
+    pixel*    m_planeBuf[NUM_PHASES];
+    int32_t   m_planeState[NUM_PHASES];
+    int32_t*  m_bandState;                        /* [NUM_PHASES][m_maxBands] */
+
+    const PicYuv*      m_reconPic;
+    ThreadSafeInteger* m_reconRowFlag;
+    Budget*            m_budget;
+
+    int       m_maxBands;
+    int       m_bandHeight;
+    int       m_ctuSize;
+    int       m_numCuRows;
+    size_t    m_planeSize;                        /* in pixels */
+    intptr_t  m_stride;
+    intptr_t  m_originOffset;                     /* of the picture origin in the plane buffers */
+
+    /* interpolated region, in plane buffer coordinates */
+    int       m_xBegin, m_xEnd;
+    int       m_yBegin, m_yEnd;
+
+    bool      claimPlane(int phase);
+    bool      bandReady(int phase, int band);
+    void      interpolateBand(int phase, int yBegin, int yEnd);
+};
+}
+
+#endif // ifndef X265_SUBPELCACHE_H
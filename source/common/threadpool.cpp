@@ -89,6 +89,52 @@ static int popCount(uint64_t x)
 namespace X265_NS {
 // x265 private namespace
 
+/* serializes job provider (de)registration on all pools */
+static Lock s_providerLock;
+
+/* Workers which are not associated with any job provider are parked on this
+ * provider, it never has work to offer */
+class IdleJobProvider : public JobProvider
+{
+public:
+
+    void findJob(int /*workerThreadId*/) {}
+};
+
+/* Should a worker move from best (NULL if no provider wants help yet) to jp?
+ * Between the groups of different encoders sharing the pool, the group which
+ * lags furthest behind its weighted share wins once the gap exceeds the
+ * switching slice, so workers do not bounce between encoders after every
+ * job. Between two providers with deadlines, the one holding up the most
+ * rows of other providers wins, then the one with the earliest deadline (the
+ * frame next in output order). Otherwise the lower slice type has priority.
+ * The virtual times and counts are read without synchronization; they are
+ * only a scheduling hint */
+static inline bool preferProvider(const JobProvider& jp, const JobProvider* best)
+{
+    if (!best)
+        return true;
+
+    if (jp.m_group && best->m_group && jp.m_group != best->m_group)
+    {
+        const int64_t slice = (int64_t)JobProviderGroup::SWITCH_SLICE * JobProviderGroup::TIME_SCALE;
+        int64_t gap = best->m_group->m_virtualTime - jp.m_group->m_virtualTime;
+        if (gap > slice)
+            return true;
+        if (gap < -slice)
+            return false;
+    }
+
+    if (jp.m_deadline >= 0 && best->m_deadline >= 0)
+    {
+        if (jp.m_numBlockedRows != best->m_numBlockedRows)
+            return jp.m_numBlockedRows > best->m_numBlockedRows;
+        return jp.m_deadline < best->m_deadline;
+    }
+
+    return jp.m_sliceType < best->m_sliceType;
+}
+
 class WorkerThread : public Thread
 {
 private:
@@ -103,8 +149,9 @@ public:
 
     JobProvider*     m_curJobProvider;
     BondedTaskGroup* m_bondMaster;
+    volatile int32_t m_scanCount; // odd while the job provider table is being scanned
 
-    WorkerThread(ThreadPool& pool, int id) : m_pool(pool), m_id(id) {}
+    WorkerThread(ThreadPool& pool, int id) : m_pool(pool), m_id(id), m_scanCount(0) {}
     virtual ~WorkerThread() {}
 
     void threadMain();
@@ -124,7 +171,9 @@ void WorkerThread::threadMain()
     m_pool.setCurrentThreadAffinity();
 
     sleepbitmap_t idBit = (sleepbitmap_t)1 << m_id;
-    m_curJobProvider = m_pool.m_jpTable[0];
+    ATOMIC_INC(&m_scanCount);
+    m_curJobProvider = m_pool.m_numProviders ? m_pool.m_jpTable[0] : m_pool.m_idleProvider;
+    ATOMIC_INC(&m_scanCount);
     m_bondMaster = NULL;
 
     SLEEPBITMAP_OR(&m_curJobProvider->m_ownerBitmap, idBit);
@@ -142,30 +191,44 @@ void WorkerThread::threadMain()
 
         do
         {
-            /* do pending work for current job provider */
+            /* the jobs of open task groups come first, their master threads
+             * wait for them before they can continue */
+            while (m_pool.m_numOpenGroups)
+            {
+                BondedTaskGroup* taskGroup = m_pool.tryJoinOpenGroup(*m_curJobProvider);
+                if (!taskGroup)
+                    break;
+                taskGroup->processTasks(m_id);
+                taskGroup->m_exitedPeerCount.incr();
+            }
+
+            /* do pending work for current job provider, charging the time to
+             * its group if the pool is shared between encoders */
+            JobProviderGroup* group = m_curJobProvider->m_group;
+            int64_t startTime = group ? x265_mdate() : 0;
             m_curJobProvider->findJob(m_id);
+            if (group)
+                m_pool.charge(*group, x265_mdate() - startTime);
 
             /* if the current job provider still wants help, only switch to a
-             * higher priority provider (lower slice type). Else take the first
-             * available job provider with the highest priority */
-            int curPriority = (m_curJobProvider->m_helpWanted) ? m_curJobProvider->m_sliceType :
-                                                                 INVALID_SLICE_PRIORITY + 1;
-            int nextProvider = -1;
+             * higher priority provider (lower slice type, or an encoder which
+             * is behind its share of the pool). Else take the first available
+             * job provider with the highest priority */
+            JobProvider* nextProvider = m_curJobProvider->m_helpWanted ? m_curJobProvider : NULL;
+            ATOMIC_INC(&m_scanCount);
             for (int i = 0; i < m_pool.m_numProviders; i++)
             {
-                if (m_pool.m_jpTable[i]->m_helpWanted &&
-                    m_pool.m_jpTable[i]->m_sliceType < curPriority)
-                {
-                    nextProvider = i;
-                    curPriority = m_pool.m_jpTable[i]->m_sliceType;
-                }
+                JobProvider* jp = m_pool.m_jpTable[i];
+                if (jp->m_helpWanted && jp != nextProvider && preferProvider(*jp, nextProvider))
+                    nextProvider = jp;
             }
-            if (nextProvider != -1 && m_curJobProvider != m_pool.m_jpTable[nextProvider])
+            if (nextProvider && m_curJobProvider != nextProvider)
             {
                 SLEEPBITMAP_AND(&m_curJobProvider->m_ownerBitmap, ~idBit);
-                m_curJobProvider = m_pool.m_jpTable[nextProvider];
+                m_curJobProvider = nextProvider;
                 SLEEPBITMAP_OR(&m_curJobProvider->m_ownerBitmap, idBit);
             }
+            ATOMIC_INC(&m_scanCount);
         }
         while (m_curJobProvider->m_helpWanted);
 
@@ -247,7 +310,54 @@ int ThreadPool::tryBondPeers(int maxPeers, sleepbitmap_t peerBitmap, BondedTaskG
 
     return bondCount;
 }
-ThreadPool* ThreadPool::allocThreadPools(x265_param* p, int& numPools, bool isThreadsReserved)
+
+void ThreadPool::openGroup(BondedTaskGroup& group)
+{
+    ScopedLock lock(*m_openGroupLock);
+
+    X265_CHECK(!group.m_openPool, "task group opened twice\n");
+    group.m_openPool = this;
+    group.m_nextOpen = m_openGroups;
+    m_openGroups = &group;
+    ATOMIC_INC(&m_numOpenGroups);
+}
+
+void ThreadPool::closeGroup(BondedTaskGroup& group)
+{
+    ScopedLock lock(*m_openGroupLock);
+
+    BondedTaskGroup** link = &m_openGroups;
+    while (*link != &group)
+        link = &(*link)->m_nextOpen;
+    *link = group.m_nextOpen;
+    group.m_openPool = NULL;
+    group.m_nextOpen = NULL;
+    ATOMIC_DEC(&m_numOpenGroups);
+}
+
+/* Bond the calling worker, currently serving job provider cur, to the most
+ * recently opened group of the same encoder with unacquired jobs. The job
+ * counts are read without the group's lock, processTasks() must cope with
+ * finding no job left */
+BondedTaskGroup* ThreadPool::tryJoinOpenGroup(const JobProvider& cur)
+{
+    ScopedLock lock(*m_openGroupLock);
+
+    for (BondedTaskGroup* group = m_openGroups; group; group = group->m_nextOpen)
+    {
+        if (group->m_openOwner && group->m_openOwner != cur.m_group)
+            continue;
+        if (group->m_jobAcquired < group->m_jobTotal)
+        {
+            group->m_bondedPeerCount++;
+            return group;
+        }
+    }
+
+    return NULL;
+}
+
+ThreadPool* ThreadPool::allocThreadPools(x265_param* p, int& numPools, bool isThreadsReserved, bool isShared)
 {
     enum { MAX_NODE_NUM = 127 };
     int cpusPerNode[MAX_NODE_NUM + 1];
@@ -420,6 +530,10 @@ ThreadPool* ThreadPool::allocThreadPools(x265_param* p, int& numPools, bool isTh
     if (pools)
     {
         int maxProviders = (p->frameNumThreads + numPools - 1) / numPools + !isThreadsReserved; /* +1 is Lookahead, always assigned to threadpool 0 */
+        if (p->filterLag)
+            maxProviders += (p->frameNumThreads + numPools - 1) / numPools; /* one loop filter stage per frame encoder */
+        if (isShared)
+            maxProviders = SHARED_POOL_PROVIDERS; /* providers of all attached encoders, grown on demand */
         int node = 0;
         for (int i = 0; i < numPools; i++)
         {
@@ -511,10 +625,127 @@ bool ThreadPool::create(int numThreads, int maxProviders, uint64_t nodeMask)
 
     m_jpTable = X265_MALLOC(JobProvider*, maxProviders);
     m_numProviders = 0;
+    m_maxProviders = maxProviders;
+
+    m_idleProvider = new IdleJobProvider;
+    m_idleProvider->m_pool = this;
+
+    m_openGroupLock = new Lock;
 
     return m_workers && m_jpTable;
 }
 
+bool ThreadPool::attach(JobProvider& jp)
+{
+    ScopedLock lock(s_providerLock);
+
+    if (m_numProviders >= m_maxProviders)
+    {
+        /* the table is full; publish a larger copy, the old table is freed
+         * once no worker can be scanning it any longer */
+        int maxProviders = m_maxProviders * 2;
+        JobProvider** table = X265_MALLOC(JobProvider*, maxProviders);
+        if (!table)
+            return false;
+        memcpy(table, m_jpTable, sizeof(JobProvider*) * m_numProviders);
+        JobProvider** old = m_jpTable;
+        m_jpTable = table;
+        m_maxProviders = maxProviders;
+        waitForScans();
+        X265_FREE(old);
+    }
+
+    jp.m_pool = this;
+    if (jp.m_group && !jp.m_group->m_numAttached++)
+    {
+        /* a group joining the pool starts level with the group which is
+         * furthest behind, it cannot claim the time it was not attached */
+        bool found = false;
+        int64_t minTime = 0;
+        for (int i = 0; i < m_numProviders; i++)
+        {
+            JobProviderGroup* other = m_jpTable[i]->m_group;
+            if (other && other != jp.m_group && (!found || other->m_virtualTime < minTime))
+            {
+                minTime = other->m_virtualTime;
+                found = true;
+            }
+        }
+        if (found && minTime > jp.m_group->m_virtualTime)
+            jp.m_group->m_virtualTime = minTime;
+    }
+
+    /* the table entry must be valid before workers can scan it */
+    m_jpTable[m_numProviders] = &jp;
+    ATOMIC_INC(&m_numProviders);
+    return true;
+}
+
+/* wait until the table scans in progress on the worker threads complete */
+void ThreadPool::waitForScans()
+{
+    for (int i = 0; i < m_numWorkers; i++)
+    {
+        int32_t scan = m_workers[i].m_scanCount;
+        while ((scan & 1) && m_workers[i].m_scanCount == scan)
+            GIVE_UP_TIME();
+    }
+}
+
+void ThreadPool::detach(JobProvider& jp)
+{
+    {
+        ScopedLock lock(s_providerLock);
+
+        jp.m_helpWanted = false;
+        for (int i = 0; i < m_numProviders; i++)
+        {
+            if (m_jpTable[i] == &jp)
+            {
+                m_jpTable[i] = m_jpTable[m_numProviders - 1];
+                ATOMIC_DEC(&m_numProviders);
+                if (jp.m_group)
+                    jp.m_group->m_numAttached--;
+                break;
+            }
+        }
+    }
+
+    /* wait for table scans which may have read the old entry to complete */
+    waitForScans();
+
+    /* A worker still associated with the provider either runs out of work
+     * and goes to sleep, or switches to another provider. Sleeping workers
+     * are reserved by taking their sleep bit, then parked */
+    for (int i = 0; i < m_numWorkers; i++)
+    {
+        WorkerThread& worker = m_workers[i];
+        sleepbitmap_t bit = (sleepbitmap_t)1 << i;
+        while (worker.m_curJobProvider == &jp)
+        {
+            if (SLEEPBITMAP_AND(&m_sleepBitmap, ~bit) & bit)
+            {
+                if (worker.m_curJobProvider == &jp)
+                {
+                    SLEEPBITMAP_AND(&jp.m_ownerBitmap, ~bit);
+                    worker.m_curJobProvider = m_idleProvider;
+                    SLEEPBITMAP_OR(&m_idleProvider->m_ownerBitmap, bit);
+                }
+                SLEEPBITMAP_OR(&m_sleepBitmap, bit);
+            }
+            else
+                GIVE_UP_TIME();
+        }
+    }
+}
+
+void ThreadPool::charge(JobProviderGroup& group, int64_t elapsed)
+{
+    ATOMIC_ADD64(&group.m_workerTime, elapsed);
+    ATOMIC_ADD64(&group.m_virtualTime, elapsed * JobProviderGroup::TIME_SCALE / group.m_weight);
+    ATOMIC_ADD64(&m_workerTime, elapsed);
+}
+
 bool ThreadPool::start()
 {
     m_isActive = true;
@@ -554,6 +785,8 @@ ThreadPool::~ThreadPool()
 
     X265_FREE(m_workers);
     X265_FREE(m_jpTable);
+    delete m_idleProvider;
+    delete m_openGroupLock;
 
 #if HAVE_LIBNUMA
     if(m_numaMask)
@@ -43,6 +43,31 @@ typedef uint32_t sleepbitmap_t;
 static const sleepbitmap_t ALL_POOL_THREADS = (sleepbitmap_t)-1;
 enum { MAX_POOL_THREADS = sizeof(sleepbitmap_t) * 8 };
 enum { INVALID_SLICE_PRIORITY = 10 }; // a value larger than any X265_TYPE_* macro
+enum { SHARED_POOL_PROVIDERS = 256 }; // initial job provider slots of a pool shared by several encoders
+
+// The job providers of one encoder attached to shared pools form a group.
+// Worker threads charge the time spent in the group's jobs to it, and
+// prefer the group which has received the least worker time relative to
+// its weight (see ThreadPool::attach)
+class JobProviderGroup
+{
+public:
+
+    enum { TIME_SCALE = 1024 };       // virtual time per microsecond at weight 1
+    enum { SWITCH_SLICE = 2000 };     // microseconds (weight 1) a group may lead before workers switch
+
+    int              m_weight;
+    int              m_numAttached; // attached providers, protected by the pool's provider lock
+    volatile int64_t m_workerTime;  // microseconds of worker time received
+    volatile int64_t m_virtualTime; // worker time scaled by TIME_SCALE / m_weight, plus the start offset
+
+    JobProviderGroup(int weight = 1)
+        : m_weight(X265_MAX(weight, 1))
+        , m_numAttached(0)
+        , m_workerTime(0)
+        , m_virtualTime(0)
+    {}
+};
 
 // Frame level job providers. FrameEncoder and Lookahead derive from
 // this class and implement findJob()
@@ -50,18 +75,24 @@ class JobProvider
 {
 public:
 
-    ThreadPool*   m_pool;
-    sleepbitmap_t m_ownerBitmap;
-    int           m_jpId;
-    int           m_sliceType;
-    bool          m_helpWanted;
-    bool          m_isFrameEncoder; /* rather ugly hack, but nothing better presents itself */
+    ThreadPool*       m_pool;
+    JobProviderGroup* m_group; // set for providers of encoders sharing a pool, else NULL
+    sleepbitmap_t     m_ownerBitmap;
+    int               m_jpId;
+    int               m_sliceType;
+    int64_t           m_deadline;       // output order of the provider's work for deadline scheduling, else -1
+    volatile int32_t  m_numBlockedRows; // rows of other providers waiting on this provider's output
+    bool              m_helpWanted;
+    bool              m_isFrameEncoder; /* rather ugly hack, but nothing better presents itself */
 
     JobProvider()
         : m_pool(NULL)
+        , m_group(NULL)
         , m_ownerBitmap(0)
         , m_jpId(-1)
         , m_sliceType(INVALID_SLICE_PRIORITY)
+        , m_deadline(-1)
+        , m_numBlockedRows(0)
         , m_helpWanted(false)
         , m_isFrameEncoder(false)
     {}
@@ -88,9 +119,16 @@ public:
     GROUP_AFFINITY m_groupAffinity;
 #endif
     bool          m_isActive;
+    int           m_maxProviders;
+    volatile int64_t m_workerTime; // microseconds charged to job provider groups
 
     JobProvider** m_jpTable;
     WorkerThread* m_workers;
+    JobProvider*  m_idleProvider; // parks workers which have no provider
+
+    BondedTaskGroup* m_openGroups;     // task groups any idle worker may join, see BondedTaskGroup::open()
+    volatile int32_t m_numOpenGroups;  // read without the lock, workers skip the list while it is zero
+    Lock*            m_openGroupLock;  // protects m_openGroups and the bonded peer counts of its groups
 
     ThreadPool();
     ~ThreadPool();
@@ -98,11 +136,25 @@ public:
     bool create(int numThreads, int maxProviders, uint64_t nodeMask);
     bool start();
     void stopWorkers();
+
+    /* Add a job provider to the pool's job provider table, or remove it. A
+     * provider may only be detached once it has no more work to offer; on
+     * return no worker thread references the provider any longer, so it is
+     * safe to destroy. This allows several encoders to come and go on a pool
+     * which outlives them. The table grows when it is full; attach() only
+     * fails when the larger table cannot be allocated */
+    bool attach(JobProvider& jp);
+    void detach(JobProvider& jp);
+    void waitForScans();
+    void charge(JobProviderGroup& group, int64_t elapsed);
     void setCurrentThreadAffinity();
     void setThreadNodeAffinity(void *numaMask);
     int  tryAcquireSleepingThread(sleepbitmap_t firstTryBitmap, sleepbitmap_t secondTryBitmap);
     int  tryBondPeers(int maxPeers, sleepbitmap_t peerBitmap, BondedTaskGroup& master);
-    static ThreadPool* allocThreadPools(x265_param* p, int& numPools, bool isThreadsReserved);
+    void openGroup(BondedTaskGroup& group);
+    void closeGroup(BondedTaskGroup& group);
+    BondedTaskGroup* tryJoinOpenGroup(const JobProvider& cur);
+    static ThreadPool* allocThreadPools(x265_param* p, int& numPools, bool isThreadsReserved, bool isShared = false);
     static int  getCpuCount();
     static int  getNumaNodeCount();
     static void getFrameThreadsCount(x265_param* p,int cpuCount);
@@ -117,7 +169,13 @@ public:
  * thread should participate and call processTasks() itself. When
  * waitForExit() returns, all bonded peer threads are guaranteed to have
  * exitied processTasks(). Since the thread count is small, it uses explicit
- * locking instead of atomic counters and bitmasks */
+ * locking instead of atomic counters and bitmasks.
+ *
+ * Bonding only recruits the threads which are idle when tryBondPeers() is
+ * called. A group may additionally be opened to its pool, from then until it
+ * is closed any worker thread of the pool which runs out of work of its own
+ * bonds itself to the group while it has unacquired jobs (m_jobAcquired <
+ * m_jobTotal) */
 class BondedTaskGroup
 {
 public:
@@ -128,11 +186,15 @@ public:
     int               m_jobTotal;
     int               m_jobAcquired;
 
-    BondedTaskGroup()  { m_bondedPeerCount = m_jobTotal = m_jobAcquired = 0; }
+    ThreadPool*       m_openPool;  // set while the group is open, see open()
+    BondedTaskGroup*  m_nextOpen;
+    JobProviderGroup* m_openOwner; // on a shared pool, the group of the encoder which opened it
+
+    BondedTaskGroup()  { m_bondedPeerCount = m_jobTotal = m_jobAcquired = 0; m_openPool = NULL; m_nextOpen = NULL; m_openOwner = NULL; }
 
     /* Do not allow the instance to be destroyed before all bonded peers have
      * exited processTasks() */
-    ~BondedTaskGroup() { waitForExit(); }
+    ~BondedTaskGroup() { close(); waitForExit(); }
 
     /* Try to enlist the help of idle worker threads on most recently associated
      * with the given job provider and "bond" them to work on your tasks. Up to
@@ -154,6 +216,17 @@ public:
         return count;
     }
 
+    /* Offer the remaining jobs to the worker threads of the job provider's
+     * pool which become idle later, in addition to the ones bonded by
+     * tryBondPeers(). On a pool shared by several encoders only the workers
+     * serving a provider of the same encoder join, since the peers index that
+     * encoder's thread local data. The group must be closed before
+     * waitForExit() */
+    void open(JobProvider& jp)  { m_openOwner = jp.m_group; jp.m_pool->openGroup(*this); }
+
+    /* No more peers join the group once close() returns */
+    void close()                { if (m_openPool) m_openPool->closeGroup(*this); }
+
     /* Returns when all bonded peers have exited processTasks(). It does *NOT*
      * ensure all tasks are completed (but this is generally implied). */
     void waitForExit()
@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include "threading.h"
+#include <immintrin.h> // AVX2
+
+using namespace X265_NS;
+
+namespace {
+/* 64 bytes per iteration, see the SSE2 version */
+uint32_t findZeroPair(const uint8_t* src, uint32_t size)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    uint32_t i = 0;
+
+    for (; i + 65 <= size; i += 64)
+    {
+        __m256i a0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)(src + i + 1));
+        __m256i a1 = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+        __m256i b1 = _mm256_loadu_si256((const __m256i*)(src + i + 33));
+        __m256i pair0 = _mm256_and_si256(_mm256_cmpeq_epi8(a0, zero), _mm256_cmpeq_epi8(b0, zero));
+        __m256i pair1 = _mm256_and_si256(_mm256_cmpeq_epi8(a1, zero), _mm256_cmpeq_epi8(b1, zero));
+        uint32_t mask0 = (uint32_t)_mm256_movemask_epi8(pair0);
+        uint32_t mask1 = (uint32_t)_mm256_movemask_epi8(pair1);
+        unsigned long pos;
+        if (mask0)
+        {
+            CTZ(pos, mask0);
+            return i + (uint32_t)pos;
+        }
+        if (mask1)
+        {
+            CTZ(pos, mask1);
+            return i + 32 + (uint32_t)pos;
+        }
+    }
+
+    for (; i + 1 < size; i++)
+    {
+        if (!src[i] && !src[i + 1])
+            return i;
+    }
+
+    return size;
+}
+}
+
+namespace X265_NS {
+void setupIntrinsicBitstream_avx2(EncoderPrimitives &p)
+{
+    p.findZeroPair = findZeroPair;
+}
+}
@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include "threading.h"
+#include <emmintrin.h> // SSE2
+
+using namespace X265_NS;
+
+namespace {
+/* 32 bytes per iteration. Each byte is and-ed with its successor's zero
+ * test, so the second load is offset by one and a pair straddling the two
+ * halves, or the end of the block, is still found */
+uint32_t findZeroPair(const uint8_t* src, uint32_t size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t i = 0;
+
+    for (; i + 33 <= size; i += 32)
+    {
+        __m128i a0 = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(src + i + 1));
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(src + i + 16));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(src + i + 17));
+        __m128i pair0 = _mm_and_si128(_mm_cmpeq_epi8(a0, zero), _mm_cmpeq_epi8(b0, zero));
+        __m128i pair1 = _mm_and_si128(_mm_cmpeq_epi8(a1, zero), _mm_cmpeq_epi8(b1, zero));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(pair0) | ((uint32_t)_mm_movemask_epi8(pair1) << 16);
+        if (mask)
+        {
+            unsigned long pos;
+            CTZ(pos, mask);
+            return i + (uint32_t)pos;
+        }
+    }
+
+    for (; i + 1 < size; i++)
+    {
+        if (!src[i] && !src[i + 1])
+            return i;
+    }
+
+    return size;
+}
+}
+
+namespace X265_NS {
+void setupIntrinsicBitstream_sse2(EncoderPrimitives &p)
+{
+    p.findZeroPair = findZeroPair;
+}
+}
@@ -0,0 +1,230 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+/* Successive elimination (--me sea) primitives: the horizontal sums of the
+ * integral planes that have no assembly, and the ADS candidate gathers */
+
+#include "common.h"
+#include "primitives.h"
+#include "threading.h"
+#include <immintrin.h> // AVX2
+
+using namespace X265_NS;
+
+namespace {
+#if !HIGH_BIT_DEPTH
+/* integral_inith for the widths of 24 and 32: the sums of 8 consecutive
+ * pixels are computed for a chunk of the row, 16 positions at a time, and
+ * the window sums of 16 positions are the sums of three or four of them */
+template<int width>
+void integral_init_h(uint32_t *sum, pixel *pix, intptr_t stride)
+{
+    enum { CHUNK = 256 };
+    ALIGN_VAR_32(uint16_t, sum8[CHUNK + width - 8]);
+    const int count = (int)stride - width;
+    int x = 0;
+
+    while (x + 16 <= count)
+    {
+        int len = X265_MIN(CHUNK, (count - x) & ~15);
+
+        /* the last block overlaps its predecessor rather than read beyond the row */
+        int num8 = len + width - 8;
+        for (int i = 0; i < num8; i += 16)
+        {
+            int j = X265_MIN(i, num8 - 16);
+            const pixel* p = pix + x + j;
+            __m256i s = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)p));
+            for (int k = 1; k < 8; k++)
+                s = _mm256_add_epi16(s, _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(p + k))));
+            _mm256_storeu_si256((__m256i*)(sum8 + j), s);
+        }
+
+        for (int i = 0; i < len; i += 16)
+        {
+            __m256i s = _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(sum8 + i)),
+                                         _mm256_loadu_si256((const __m256i*)(sum8 + i + 8)));
+            s = _mm256_add_epi16(s, _mm256_loadu_si256((const __m256i*)(sum8 + i + 16)));
+            if (width == 32)
+                s = _mm256_add_epi16(s, _mm256_loadu_si256((const __m256i*)(sum8 + i + 24)));
+
+            uint32_t* dst = sum + x + i;
+            __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(s));
+            __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(s, 1));
+            lo = _mm256_add_epi32(lo, _mm256_loadu_si256((const __m256i*)(dst - stride)));
+            hi = _mm256_add_epi32(hi, _mm256_loadu_si256((const __m256i*)(dst - stride + 8)));
+            _mm256_storeu_si256((__m256i*)dst, lo);
+            _mm256_storeu_si256((__m256i*)(dst + 8), hi);
+        }
+
+        x += len;
+    }
+
+    for (; x < count; x++)
+    {
+        uint32_t v = 0;
+        for (int k = 0; k < width; k++)
+            v += pix[x + k];
+        sum[x] = v + sum[x - stride];
+    }
+}
+#endif
+
+/* 8 candidates per iteration; the candidates passing the threshold are
+ * appended in order, as by the C primitives */
+inline int adsGather(__m256i ads, __m256i thresh, int16_t* mvs, int nmv, int i)
+{
+    uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(thresh, ads)));
+    while (mask)
+    {
+        unsigned long pos;
+        CTZ(pos, mask);
+        mvs[nmv++] = (int16_t)(i + pos);
+        mask &= mask - 1;
+    }
+    return nmv;
+}
+
+inline __m256i adsTerm(__m256i dc, const uint32_t* sums)
+{
+    return _mm256_abs_epi32(_mm256_sub_epi32(dc, _mm256_loadu_si256((const __m256i*)sums)));
+}
+
+inline __m256i adsCost(const uint16_t* costMvX)
+{
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)costMvX));
+}
+
+template<int lx>
+int ads_x4(int encDC[4], uint32_t *sums, int delta, uint16_t *costMvX, int16_t *mvs, int width, int thresh)
+{
+    const __m256i dc0 = _mm256_set1_epi32(encDC[0]);
+    const __m256i dc1 = _mm256_set1_epi32(encDC[1]);
+    const __m256i dc2 = _mm256_set1_epi32(encDC[2]);
+    const __m256i dc3 = _mm256_set1_epi32(encDC[3]);
+    const __m256i th = _mm256_set1_epi32(thresh);
+    int nmv = 0;
+    int i = 0;
+
+    for (; i + 8 <= width; i += 8)
+    {
+        __m256i ads = _mm256_add_epi32(adsTerm(dc0, sums + i), adsTerm(dc1, sums + i + (lx >> 1)));
+        ads = _mm256_add_epi32(ads, adsTerm(dc2, sums + i + delta));
+        ads = _mm256_add_epi32(ads, adsTerm(dc3, sums + i + delta + (lx >> 1)));
+        ads = _mm256_add_epi32(ads, adsCost(costMvX + i));
+        nmv = adsGather(ads, th, mvs, nmv, i);
+    }
+
+    for (; i < width; i++)
+    {
+        int ads = abs(encDC[0] - (int)sums[i]) + abs(encDC[1] - (int)sums[i + (lx >> 1)]) +
+                  abs(encDC[2] - (int)sums[i + delta]) + abs(encDC[3] - (int)sums[i + delta + (lx >> 1)]) + costMvX[i];
+        mvs[nmv] = (int16_t)i;
+        nmv += ads < thresh;
+    }
+
+    return nmv;
+}
+
+int ads_x2(int encDC[2], uint32_t *sums, int delta, uint16_t *costMvX, int16_t *mvs, int width, int thresh)
+{
+    const __m256i dc0 = _mm256_set1_epi32(encDC[0]);
+    const __m256i dc1 = _mm256_set1_epi32(encDC[1]);
+    const __m256i th = _mm256_set1_epi32(thresh);
+    int nmv = 0;
+    int i = 0;
+
+    for (; i + 8 <= width; i += 8)
+    {
+        __m256i ads = _mm256_add_epi32(adsTerm(dc0, sums + i), adsTerm(dc1, sums + i + delta));
+        ads = _mm256_add_epi32(ads, adsCost(costMvX + i));
+        nmv = adsGather(ads, th, mvs, nmv, i);
+    }
+
+    for (; i < width; i++)
+    {
+        int ads = abs(encDC[0] - (int)sums[i]) + abs(encDC[1] - (int)sums[i + delta]) + costMvX[i];
+        mvs[nmv] = (int16_t)i;
+        nmv += ads < thresh;
+    }
+
+    return nmv;
+}
+
+int ads_x1(int encDC[1], uint32_t *sums, int, uint16_t *costMvX, int16_t *mvs, int width, int thresh)
+{
+    const __m256i dc0 = _mm256_set1_epi32(encDC[0]);
+    const __m256i th = _mm256_set1_epi32(thresh);
+    int nmv = 0;
+    int i = 0;
+
+    for (; i + 8 <= width; i += 8)
+    {
+        __m256i ads = _mm256_add_epi32(adsTerm(dc0, sums + i), adsCost(costMvX + i));
+        nmv = adsGather(ads, th, mvs, nmv, i);
+    }
+
+    for (; i < width; i++)
+    {
+        int ads = abs(encDC[0] - (int)sums[i]) + costMvX[i];
+        mvs[nmv] = (int16_t)i;
+        nmv += ads < thresh;
+    }
+
+    return nmv;
+}
+}
+
+namespace X265_NS {
+void setupIntrinsicSEA_avx2(EncoderPrimitives &p)
+{
+#if !HIGH_BIT_DEPTH
+    p.integral_inith[INTEGRAL_24] = integral_init_h<24>;
+    p.integral_inith[INTEGRAL_32] = integral_init_h<32>;
+#endif
+
+    p.pu[LUMA_4x4].ads = ads_x1;
+    p.pu[LUMA_8x8].ads = ads_x1;
+    p.pu[LUMA_8x4].ads = ads_x2;
+    p.pu[LUMA_4x8].ads = ads_x2;
+    p.pu[LUMA_16x16].ads = ads_x4<16>;
+    p.pu[LUMA_16x8].ads = ads_x2;
+    p.pu[LUMA_8x16].ads = ads_x2;
+    p.pu[LUMA_16x12].ads = ads_x1;
+    p.pu[LUMA_12x16].ads = ads_x1;
+    p.pu[LUMA_16x4].ads = ads_x1;
+    p.pu[LUMA_4x16].ads = ads_x1;
+    p.pu[LUMA_32x32].ads = ads_x4<32>;
+    p.pu[LUMA_32x16].ads = ads_x2;
+    p.pu[LUMA_16x32].ads = ads_x2;
+    p.pu[LUMA_32x24].ads = ads_x4<32>;
+    p.pu[LUMA_24x32].ads = ads_x4<24>;
+    p.pu[LUMA_32x8].ads = ads_x4<32>;
+    p.pu[LUMA_8x32].ads = ads_x4<8>;
+    p.pu[LUMA_64x64].ads = ads_x4<64>;
+    p.pu[LUMA_64x32].ads = ads_x2;
+    p.pu[LUMA_32x64].ads = ads_x2;
+    p.pu[LUMA_64x48].ads = ads_x4<64>;
+    p.pu[LUMA_48x64].ads = ads_x4<48>;
+    p.pu[LUMA_64x16].ads = ads_x4<64>;
+    p.pu[LUMA_16x64].ads = ads_x4<16>;
+}
+}
@@ -27,6 +27,7 @@
 /* The #if logic here must match the file lists in CMakeLists.txt */
 #if X265_ARCH_X86
 #if defined(__INTEL_COMPILER)
+#define HAVE_SSE2
 #define HAVE_SSE3
 #define HAVE_SSSE3
 #define HAVE_SSE4
@@ -34,6 +35,7 @@
 #elif defined(__GNUC__)
 #define GCC_VERSION (__GNUC__ * 10000 + __GNUC_MINOR__ * 100 + __GNUC_PATCHLEVEL__)
 #if __clang__ || GCC_VERSION >= 40300 /* gcc_version >= gcc-4.3.0 */
+#define HAVE_SSE2
 #define HAVE_SSE3
 #define HAVE_SSSE3
 #define HAVE_SSE4
@@ -42,6 +44,7 @@
 #define HAVE_AVX2
 #endif
 #elif defined(_MSC_VER)
+#define HAVE_SSE2
 #define HAVE_SSE3
 #define HAVE_SSSE3
 #define HAVE_SSE4
@@ -57,10 +60,19 @@ namespace X265_NS {
 void setupIntrinsicDCT_sse3(EncoderPrimitives&);
 void setupIntrinsicDCT_ssse3(EncoderPrimitives&);
 void setupIntrinsicDCT_sse41(EncoderPrimitives&);
+void setupIntrinsicBitstream_sse2(EncoderPrimitives&);
+void setupIntrinsicBitstream_avx2(EncoderPrimitives&);
+void setupIntrinsicSEA_avx2(EncoderPrimitives&);
 
 /* Use primitives for the best available vector architecture */
 void setupInstrinsicPrimitives(EncoderPrimitives &p, int cpuMask)
 {
+#ifdef HAVE_SSE2
+    if (cpuMask & X265_CPU_SSE2)
+    {
+        setupIntrinsicBitstream_sse2(p);
+    }
+#endif
 #ifdef HAVE_SSE3
     if (cpuMask & X265_CPU_SSE3)
     {
@@ -78,6 +90,13 @@ void setupInstrinsicPrimitives(EncoderPrimitives &p, int cpuMask)
     {
         setupIntrinsicDCT_sse41(p);
     }
+#endif
+#ifdef HAVE_AVX2
+    if (cpuMask & X265_CPU_AVX2)
+    {
+        setupIntrinsicBitstream_avx2(p);
+        setupIntrinsicSEA_avx2(p);
+    }
 #endif
     (void)p;
     (void)cpuMask;
@@ -61,6 +61,8 @@ public:
     WaveFront()
         : m_internalDependencyBitmap(NULL)
         , m_externalDependencyBitmap(NULL)
+        , m_row_to_idx(NULL)
+        , m_idx_to_row(NULL)
     {}
 
     virtual ~WaveFront();
@@ -904,6 +904,69 @@ void interp_8tap_hv_pp_cpu(const pixel* src, intptr_t srcStride, pixel* dst, int
     primitives.pu[size].luma_vsp(immed + (halfFilterSize - 1) * immedStride, immedStride, dst, dstStride, idxY);
 }
 
+/* bounded sad and satd of a block as the sum of the costs of its horizontal
+ * strips, checked against the bound after each strip */
+template<int strip, int stripHeight, int numStrips>
+int sad_bounded_cpu(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride, int bound)
+{
+    int cost = 0;
+    for (int i = 0; i < numStrips; i++)
+    {
+        cost += primitives.pu[strip].sad(fenc + i * stripHeight * fencstride, fencstride, fref + i * stripHeight * frefstride, frefstride);
+        if (cost > bound)
+            break;
+    }
+    return cost;
+}
+
+template<int strip, int stripHeight, int numStrips>
+int satd_bounded_cpu(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride, int bound)
+{
+    int cost = 0;
+    for (int i = 0; i < numStrips; i++)
+    {
+        cost += primitives.pu[strip].satd(fenc + i * stripHeight * fencstride, fencstride, fref + i * stripHeight * frefstride, frefstride);
+        if (cost > bound)
+            break;
+    }
+    return cost;
+}
+
+/* the strips must have assembly of their own in p; the block sizes without
+ * a partition of their width use a single strip */
+#define LUMA_PU_BOUNDED(W, H, S) \
+    if (p.pu[LUMA_ ## W ## x ## S].sad) \
+        p.pu[LUMA_ ## W ## x ## H].sad_bounded = sad_bounded_cpu<LUMA_ ## W ## x ## S, S, H / S>; \
+    if (p.pu[LUMA_ ## W ## x ## S].satd) \
+        p.pu[LUMA_ ## W ## x ## H].satd_bounded = satd_bounded_cpu<LUMA_ ## W ## x ## S, S, H / S>
+
+#define ALL_LUMA_PU_BOUNDED() \
+    LUMA_PU_BOUNDED(4, 4, 4); \
+    LUMA_PU_BOUNDED(4, 8, 4); \
+    LUMA_PU_BOUNDED(4, 16, 4); \
+    LUMA_PU_BOUNDED(8, 4, 4); \
+    LUMA_PU_BOUNDED(8, 8, 4); \
+    LUMA_PU_BOUNDED(8, 16, 8); \
+    LUMA_PU_BOUNDED(8, 32, 8); \
+    LUMA_PU_BOUNDED(12, 16, 16); \
+    LUMA_PU_BOUNDED(16, 4, 4); \
+    LUMA_PU_BOUNDED(16, 8, 4); \
+    LUMA_PU_BOUNDED(16, 12, 4); \
+    LUMA_PU_BOUNDED(16, 16, 8); \
+    LUMA_PU_BOUNDED(16, 32, 8); \
+    LUMA_PU_BOUNDED(16, 64, 8); \
+    LUMA_PU_BOUNDED(24, 32, 32); \
+    LUMA_PU_BOUNDED(32, 8, 8); \
+    LUMA_PU_BOUNDED(32, 16, 8); \
+    LUMA_PU_BOUNDED(32, 24, 8); \
+    LUMA_PU_BOUNDED(32, 32, 8); \
+    LUMA_PU_BOUNDED(32, 64, 8); \
+    LUMA_PU_BOUNDED(48, 64, 64); \
+    LUMA_PU_BOUNDED(64, 16, 16); \
+    LUMA_PU_BOUNDED(64, 32, 16); \
+    LUMA_PU_BOUNDED(64, 48, 16); \
+    LUMA_PU_BOUNDED(64, 64, 16)
+
 #if HIGH_BIT_DEPTH
 
 void setupAssemblyPrimitives(EncoderPrimitives &p, int cpuMask) // Main10
@@ -3193,6 +3256,8 @@ void setupAssemblyPrimitives(EncoderPrimitives &p, int cpuMask) // Main10
 
     }
 #endif
+
+    ALL_LUMA_PU_BOUNDED();
 }
 #else // if HIGH_BIT_DEPTH
 
@@ -5434,6 +5499,8 @@ void setupAssemblyPrimitives(EncoderPrimitives &p, int cpuMask) // Main
 
     }
 #endif
+
+    ALL_LUMA_PU_BOUNDED();
 }
 #endif // if HIGH_BIT_DEPTH
 
@@ -70,6 +70,58 @@ using namespace X265_NS;
  * rd-level 5,6 does RDO for each inter mode
  */
 
+namespace {
+// file private namespace
+
+/* Configurations of compressInterCU_rd0_4. The generic configuration reads
+ * the param of the CTU; a preset configuration makes the rd-level and the
+ * inter mode decisions of the presets compile-time constants and drops the
+ * analysis reuse, refinement, CTU info, SEA, lossless and speculative split
+ * paths, and AMP, which are never enabled by the presets up to slow. */
+struct InterCUGeneric
+{
+    static int  rdLevel(const x265_param& p)       { return p.rdLevel; }
+    static bool rect(const x265_param& p)          { return !!p.bEnableRectInter; }
+    static bool amp(const x265_param&)             { return true; }  /* if the SPS allows AMP */
+    static bool limitModes(const x265_param& p)    { return !!p.limitModes; }
+    static int  limitRefs(const x265_param& p)     { return p.limitReferences; }
+    static int  recursionSkip(const x265_param& p) { return p.recursionSkipMode; }
+    static bool extended(const x265_param&)        { return true; }
+};
+
+template<int RD, bool RECT, bool LIMIT_MODES, int LIMIT_REFS>
+struct InterCUPreset
+{
+    static int  rdLevel(const x265_param&)         { return RD; }
+    static bool rect(const x265_param&)            { return RECT; }
+    static bool amp(const x265_param&)             { return false; }
+    static bool limitModes(const x265_param&)      { return LIMIT_MODES; }
+    static int  limitRefs(const x265_param&)       { return LIMIT_REFS; }
+    static int  recursionSkip(const x265_param&)   { return RDCOST_BASED_RSKIP; }
+    static bool extended(const x265_param&)        { return false; }
+
+    static bool matches(const x265_param& p)
+    {
+        return p.rdLevel == RD && !!p.bEnableRectInter == RECT && !!p.limitModes == LIMIT_MODES &&
+               p.limitReferences == LIMIT_REFS && p.recursionSkipMode == RDCOST_BASED_RSKIP;
+    }
+};
+
+typedef InterCUPreset<2, false, false, 0> InterCUUltrafast;  /* ultrafast, superfast */
+typedef InterCUPreset<2, false, false, 3> InterCUVeryfast;   /* veryfast, faster, fast */
+typedef InterCUPreset<3, false, false, 1> InterCUMedium;
+typedef InterCUPreset<4, true,  true,  3> InterCUSlow;
+
+/* features of the generic configuration only */
+bool extendedInterCU(const x265_param& p)
+{
+    return p.bAnalysisType == AVC_INFO || p.analysisLoadReuseLevel > 1 || p.analysisMultiPassRefine ||
+           p.bCTUInfo || p.interRefine || p.bDynamicRefine || p.searchMethod == X265_SEA ||
+           p.limitTU >= 3 || p.bCULossless || p.bSpeculativeSplit;
+}
+
+}
+
 Analysis::Analysis()
 {
     m_reuseInterDataCTU = NULL;
@@ -80,6 +132,9 @@ Analysis::Analysis()
     m_checkMergeAndSkipOnly[0] = false;
     m_checkMergeAndSkipOnly[1] = false;
     m_evaluateInter = 0;
+    m_refineLevel = 0;
+    m_bSpeculative = false;
+    m_compressInterCU = &Analysis::compressInterCU<InterCUGeneric>;
 }
 
 bool Analysis::create(ThreadLocalData *tld)
@@ -141,6 +196,7 @@ Mode& Analysis::compressCTU(CUData& ctu, Frame& frame, const CUGeom& cuGeom, con
     m_frame = &frame;
     m_bChromaSa8d = m_param->rdLevel >= 3;
     m_param = m_frame->m_param;
+    selectInterCU();
 
 #if _DEBUG || CHECKED_BUILD
     invalidateContexts(0);
@@ -675,11 +731,59 @@ void Analysis::PMODE::processTasks(int workerThreadId)
     ScopedElapsedTime pmodeTime(master.m_stats[fe].pmodeTime);
 #endif
     ProfileScopeEvent(pmode);
-    master.processPmode(*this, master.m_tld[workerThreadId].analysis);
+    Analysis& slave = master.m_tld[workerThreadId].analysis;
+    CTUWork before = slave.m_ctuWork;
+    master.processPmode(*this, slave);
+    master.addSlaveWork(slave, before);
+}
+
+void Analysis::initPmodeIntra(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp)
+{
+    ModeDepth& md = m_modeDepth[cuGeom.depth];
+
+    md.pred[PRED_INTRA].cu.initSubCU(parentCTU, cuGeom, qp);
+    if (cuGeom.log2CUSize == 3 && m_slice->m_sps->quadtreeTULog2MinSize < 3 && m_param->rdLevel >= 5)
+        md.pred[PRED_INTRA_NxN].cu.initSubCU(parentCTU, cuGeom, qp);
+}
+
+/* initialize the prediction CUs of the modes to be analysed in parallel, and
+ * offer their jobs to idle worker threads: those idle now are bonded, those
+ * which become idle later join the open group until it is closed */
+void Analysis::startPmode(PMODE& pmode, const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp, bool bTryIntra, bool bTryAmp, const uint32_t splitRefs[4])
+{
+    ModeDepth& md = m_modeDepth[cuGeom.depth];
+
+    if (bTryIntra)
+    {
+        initPmodeIntra(parentCTU, cuGeom, qp);
+        pmode.modes[pmode.m_jobTotal++] = PRED_INTRA;
+    }
+    md.pred[PRED_2Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2Nx2N;
+    md.pred[PRED_BIDIR].cu.initSubCU(parentCTU, cuGeom, qp);
+    if (m_param->bEnableRectInter)
+    {
+        md.pred[PRED_2NxN].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxN;
+        md.pred[PRED_Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_Nx2N;
+    }
+    if (bTryAmp)
+    {
+        md.pred[PRED_2NxnU].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxnU;
+        md.pred[PRED_2NxnD].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxnD;
+        md.pred[PRED_nLx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_nLx2N;
+        md.pred[PRED_nRx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_nRx2N;
+    }
+
+    pmode.qp = m_rdCost.m_qp;
+    memcpy(pmode.splitRefs, splitRefs, sizeof(pmode.splitRefs));
+
+    JobProvider& jp = *m_frame->m_encData->m_jobProvider;
+    pmode.tryBondPeers(jp, pmode.m_jobTotal);
+    pmode.open(jp);
 }
 
 /* process pmode jobs until none remain; may be called by the master thread or by
- * a bonded peer (slave) thread via pmodeTasks() */
+ * a peer (slave) thread via processTasks(), either bonded by tryBondPeers() or
+ * having joined the open group once it ran out of work */
 void Analysis::processPmode(PMODE& pmode, Analysis& slave)
 {
     /* acquire a mode task, else exit early */
@@ -705,7 +809,7 @@ void Analysis::processPmode(PMODE& pmode, Analysis& slave)
         slave.m_frame = m_frame;
         slave.m_param = m_param;
         slave.m_bChromaSa8d = m_param->rdLevel >= 3;
-        slave.setLambdaFromQP(md.pred[PRED_2Nx2N].cu, m_rdCost.m_qp);
+        slave.setLambdaFromQP(md.pred[PRED_2Nx2N].cu, pmode.qp);
         slave.invalidateContexts(0);
         slave.m_rqt[pmode.cuGeom.depth].cur.load(m_rqt[pmode.cuGeom.depth].cur);
     }
@@ -726,7 +830,7 @@ void Analysis::processPmode(PMODE& pmode, Analysis& slave)
                 break;
 
             case PRED_2Nx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3];
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3];
 
                 slave.checkInter_rd0_4(md.pred[PRED_2Nx2N], pmode.cuGeom, SIZE_2Nx2N, refMasks);
                 if (m_slice->m_sliceType == B_SLICE)
@@ -734,43 +838,43 @@ void Analysis::processPmode(PMODE& pmode, Analysis& slave)
                 break;
 
             case PRED_Nx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[2]; /* left */
-                refMasks[1] = m_splitRefIdx[1] | m_splitRefIdx[3]; /* right */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[2]; /* left */
+                refMasks[1] = pmode.splitRefs[1] | pmode.splitRefs[3]; /* right */
 
                 slave.checkInter_rd0_4(md.pred[PRED_Nx2N], pmode.cuGeom, SIZE_Nx2N, refMasks);
                 break;
 
             case PRED_2NxN:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1]; /* top */
-                refMasks[1] = m_splitRefIdx[2] | m_splitRefIdx[3]; /* bot */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1]; /* top */
+                refMasks[1] = pmode.splitRefs[2] | pmode.splitRefs[3]; /* bot */
 
                 slave.checkInter_rd0_4(md.pred[PRED_2NxN], pmode.cuGeom, SIZE_2NxN, refMasks);
                 break;
 
             case PRED_2NxnU:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1]; /* 25% top */
-                refMasks[1] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% bot */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1]; /* 25% top */
+                refMasks[1] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3]; /* 75% bot */
 
                 slave.checkInter_rd0_4(md.pred[PRED_2NxnU], pmode.cuGeom, SIZE_2NxnU, refMasks);
                 break;
 
             case PRED_2NxnD:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% top */
-                refMasks[1] = m_splitRefIdx[2] | m_splitRefIdx[3]; /* 25% bot */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3]; /* 75% top */
+                refMasks[1] = pmode.splitRefs[2] | pmode.splitRefs[3]; /* 25% bot */
 
                 slave.checkInter_rd0_4(md.pred[PRED_2NxnD], pmode.cuGeom, SIZE_2NxnD, refMasks);
                 break;
 
             case PRED_nLx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[2]; /* 25% left */
-                refMasks[1] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% right */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[2]; /* 25% left */
+                refMasks[1] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3]; /* 75% right */
 
                 slave.checkInter_rd0_4(md.pred[PRED_nLx2N], pmode.cuGeom, SIZE_nLx2N, refMasks);
                 break;
 
             case PRED_nRx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% left */
-                refMasks[1] = m_splitRefIdx[1] | m_splitRefIdx[3]; /* 25% right */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3]; /* 75% left */
+                refMasks[1] = pmode.splitRefs[1] | pmode.splitRefs[3]; /* 25% right */
 
                 slave.checkInter_rd0_4(md.pred[PRED_nRx2N], pmode.cuGeom, SIZE_nRx2N, refMasks);
                 break;
@@ -791,7 +895,7 @@ void Analysis::processPmode(PMODE& pmode, Analysis& slave)
                 break;
 
             case PRED_2Nx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3];
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3];
 
                 slave.checkInter_rd5_6(md.pred[PRED_2Nx2N], pmode.cuGeom, SIZE_2Nx2N, refMasks);
                 md.pred[PRED_BIDIR].rdCost = MAX_INT64;
@@ -804,42 +908,42 @@ void Analysis::processPmode(PMODE& pmode, Analysis& slave)
                 break;
 
             case PRED_Nx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[2]; /* left */
-                refMasks[1] = m_splitRefIdx[1] | m_splitRefIdx[3]; /* right */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[2]; /* left */
+                refMasks[1] = pmode.splitRefs[1] | pmode.splitRefs[3]; /* right */
 
                 slave.checkInter_rd5_6(md.pred[PRED_Nx2N], pmode.cuGeom, SIZE_Nx2N, refMasks);
                 break;
 
             case PRED_2NxN:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1]; /* top */
-                refMasks[1] = m_splitRefIdx[2] | m_splitRefIdx[3]; /* bot */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1]; /* top */
+                refMasks[1] = pmode.splitRefs[2] | pmode.splitRefs[3]; /* bot */
 
                 slave.checkInter_rd5_6(md.pred[PRED_2NxN], pmode.cuGeom, SIZE_2NxN, refMasks);
                 break;
 
             case PRED_2NxnU:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1]; /* 25% top */
-                refMasks[1] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% bot */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1]; /* 25% top */
+                refMasks[1] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3]; /* 75% bot */
 
                 slave.checkInter_rd5_6(md.pred[PRED_2NxnU], pmode.cuGeom, SIZE_2NxnU, refMasks);
                 break;
 
             case PRED_2NxnD:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% top */
-                refMasks[1] = m_splitRefIdx[2] | m_splitRefIdx[3]; /* 25% bot */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3]; /* 75% top */
+                refMasks[1] = pmode.splitRefs[2] | pmode.splitRefs[3]; /* 25% bot */
                 slave.checkInter_rd5_6(md.pred[PRED_2NxnD], pmode.cuGeom, SIZE_2NxnD, refMasks);
                 break;
 
             case PRED_nLx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[2]; /* 25% left */
-                refMasks[1] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% right */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[2]; /* 25% left */
+                refMasks[1] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3]; /* 75% right */
 
                 slave.checkInter_rd5_6(md.pred[PRED_nLx2N], pmode.cuGeom, SIZE_nLx2N, refMasks);
                 break;
 
             case PRED_nRx2N:
-                refMasks[0] = m_splitRefIdx[0] | m_splitRefIdx[1] | m_splitRefIdx[2] | m_splitRefIdx[3]; /* 75% left */
-                refMasks[1] = m_splitRefIdx[1] | m_splitRefIdx[3]; /* 25% right */
+                refMasks[0] = pmode.splitRefs[0] | pmode.splitRefs[1] | pmode.splitRefs[2] | pmode.splitRefs[3]; /* 75% left */
+                refMasks[1] = pmode.splitRefs[1] | pmode.splitRefs[3]; /* 25% right */
                 slave.checkInter_rd5_6(md.pred[PRED_nRx2N], pmode.cuGeom, SIZE_nRx2N, refMasks);
                 break;
 
@@ -858,6 +962,209 @@ void Analysis::processPmode(PMODE& pmode, Analysis& slave)
     while (task >= 0);
 }
 
+void Analysis::SplitSpec::processTasks(int workerThreadId)
+{
+    ProfileScopeEvent(splitSpec);
+    Analysis& slave = master.m_tld[workerThreadId].analysis;
+    CTUWork before = slave.m_ctuWork;
+    master.processSplitSpec(*this, slave);
+    master.addSlaveWork(slave, before);
+}
+
+/* add the early-out statistics a speculative analysis gathered after fork */
+static void addSpeculatedStat(FrameData::RCStatCU& stat, const FrameData::RCStatCU& spec, const FrameData::RCStatCU& fork)
+{
+    for (int depth = 0; depth < 4; depth++)
+    {
+        uint32_t count = spec.count[depth] - fork.count[depth];
+        if (!count)
+            continue;
+        uint64_t cost = spec.avgCost[depth] * spec.count[depth] - fork.avgCost[depth] * fork.count[depth];
+        uint64_t temp = stat.avgCost[depth] * stat.count[depth];
+        stat.count[depth] += count;
+        stat.avgCost[depth] = (temp + cost) / stat.count[depth];
+    }
+}
+
+/* Step 2 of compressInterCU_rd0_4 for the first split of a CTU. Sub-CU 0 is
+ * analysed here while sub-CUs 1..3 are analysed by other workers as if the
+ * sub-CUs before them were not available. The sub-CUs are then coded in order
+ * with their final neighbours and contexts; a speculative decision which
+ * cannot be coded that way is analysed again. Returns splitIntra */
+bool Analysis::speculateSplit(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp, SplitData splitData[4])
+{
+    ModeDepth& md = m_modeDepth[cuGeom.depth];
+    Mode* splitPred = &md.pred[PRED_SPLIT];
+    splitPred->initCosts();
+    CUData* splitCU = &splitPred->cu;
+    splitCU->initSubCU(parentCTU, cuGeom, qp);
+
+    uint32_t nextDepth = cuGeom.depth + 1;
+    ModeDepth& nd = m_modeDepth[nextDepth];
+    invalidateContexts(nextDepth);
+    bool bUseDQP = m_slice->m_pps->bUseDQP && nextDepth <= m_slice->m_pps->maxCuDQPDepth;
+
+    FrameData::RCStatCU& stat = m_frame->m_encData->m_cuStat[parentCTU.m_cuAddr];
+    FrameData::RCStatCU fork = stat;
+
+    SplitSpec spec(*this, cuGeom);
+    spec.qp = qp;
+    spec.rdQp = m_rdCost.m_qp;
+    spec.maxTUDepth = m_maxTUDepth;
+    for (uint32_t subPartIdx = 1; subPartIdx < 4; subPartIdx++)
+    {
+        const CUGeom& childGeom = *(&cuGeom + cuGeom.childOffset + subPartIdx);
+        if (childGeom.flags & CUGeom::PRESENT)
+        {
+            spec.ctu[subPartIdx] = parentCTU;
+            spec.ctu[subPartIdx].m_firstAvailIdx = childGeom.absPartIdx;
+            spec.stat[subPartIdx] = fork;
+            spec.children[spec.m_jobTotal++] = subPartIdx;
+        }
+    }
+    if (spec.m_jobTotal)
+    {
+        m_ctuWork.specSubCUs += spec.m_jobTotal;
+        JobProvider& jp = *m_frame->m_encData->m_jobProvider;
+        spec.tryBondPeers(jp, spec.m_jobTotal);
+        spec.open(jp);
+    }
+
+    /* sub-CU 0 is always present */
+    const CUGeom& child0 = *(&cuGeom + cuGeom.childOffset);
+    int nextQP = qp;
+    m_modeDepth[0].fencYuv.copyPartToYuv(nd.fencYuv, child0.absPartIdx);
+    m_rqt[nextDepth].cur.load(m_rqt[cuGeom.depth].cur);
+    if (bUseDQP)
+        nextQP = setLambdaFromQP(parentCTU, calculateQpforCuSize(parentCTU, child0));
+
+    splitData[0] = compressInterCU_rd0_4(parentCTU, child0, nextQP);
+
+    bool splitIntra = nd.bestMode->cu.isIntra(0);
+    splitCU->copyPartFrom(nd.bestMode->cu, child0, 0);
+    splitPred->addSubCosts(*nd.bestMode);
+    nd.bestMode->reconYuv.copyToPartYuv(splitPred->reconYuv, 0);
+    /* nd is reused below, park the contexts of sub-CU 0 */
+    splitPred->contexts.load(nd.bestMode->contexts);
+
+    /* help with the remaining sub-CUs, then wait for the workers */
+    processSplitSpec(spec, *this);
+    spec.close();
+    spec.waitForExit();
+
+    setLambdaFromQP(parentCTU, spec.rdQp);
+    m_maxTUDepth = spec.maxTUDepth;
+
+    Entropy* nextContext = &splitPred->contexts;
+    for (uint32_t subPartIdx = 1; subPartIdx < 4; subPartIdx++)
+    {
+        const CUGeom& childGeom = *(&cuGeom + cuGeom.childOffset + subPartIdx);
+        if (childGeom.flags & CUGeom::PRESENT)
+        {
+            m_modeDepth[0].fencYuv.copyPartToYuv(nd.fencYuv, childGeom.absPartIdx);
+            m_rqt[nextDepth].cur.load(*nextContext);
+            if (bUseDQP)
+                nextQP = setLambdaFromQP(parentCTU, calculateQpforCuSize(parentCTU, childGeom));
+
+            if (recodeSpeculated(parentCTU, childGeom, nextQP))
+            {
+                splitData[subPartIdx] = spec.splitData[subPartIdx];
+                addSpeculatedStat(stat, spec.stat[subPartIdx], fork);
+            }
+            else
+            {
+                m_ctuWork.specRetries++;
+                m_rqt[nextDepth].cur.load(*nextContext);
+                setLambdaFromQP(parentCTU, bUseDQP ? nextQP : spec.rdQp);
+                splitData[subPartIdx] = compressInterCU_rd0_4(parentCTU, childGeom, nextQP);
+            }
+
+            splitIntra |= nd.bestMode->cu.isIntra(0);
+            splitCU->copyPartFrom(nd.bestMode->cu, childGeom, subPartIdx);
+            splitPred->addSubCosts(*nd.bestMode);
+            nd.bestMode->reconYuv.copyToPartYuv(splitPred->reconYuv, childGeom.numPartitions * subPartIdx);
+            nextContext = &nd.bestMode->contexts;
+        }
+        else
+            splitCU->setEmptyPart(childGeom, subPartIdx);
+    }
+    if (nextContext != &splitPred->contexts)
+        nextContext->store(splitPred->contexts);
+
+    if (!(cuGeom.flags & CUGeom::SPLIT_MANDATORY))
+        addSplitFlagCost(*splitPred, cuGeom.depth);
+    else
+        updateModeCost(*splitPred);
+
+    return splitIntra;
+}
+
+void Analysis::processSplitSpec(SplitSpec& spec, Analysis& slave)
+{
+    /* acquire a sub-CU task, else exit early */
+    int task;
+    spec.m_lock.acquire();
+    if (spec.m_jobTotal > spec.m_jobAcquired)
+    {
+        task = spec.m_jobAcquired++;
+        spec.m_lock.release();
+    }
+    else
+    {
+        spec.m_lock.release();
+        return;
+    }
+
+    /* setup slave Analysis */
+    if (&slave != this)
+    {
+        slave.m_slice = m_slice;
+        slave.m_frame = m_frame;
+        slave.m_param = m_param;
+        slave.m_bChromaSa8d = m_param->rdLevel >= 3;
+        slave.m_refineLevel = m_refineLevel;
+        slave.m_compressInterCU = m_compressInterCU;
+        slave.m_sliceMinY = m_sliceMinY;
+        slave.m_sliceMaxY = m_sliceMaxY;
+        slave.invalidateContexts(0);
+        slave.m_modeDepth[0].fencYuv.copyFromPicYuv(*m_frame->m_fencPic, spec.ctu[spec.children[task]].m_cuAddr, 0);
+    }
+
+    uint32_t nextDepth = spec.cuGeom.depth + 1;
+    ModeDepth& nd = slave.m_modeDepth[nextDepth];
+    bool bUseDQP = m_slice->m_pps->bUseDQP && nextDepth <= m_slice->m_pps->maxCuDQPDepth;
+
+    /* perform sub-CU task, repeat until no more work is available */
+    do
+    {
+        int subPartIdx = spec.children[task];
+        const CUData& ctu = spec.ctu[subPartIdx];
+        const CUGeom& childGeom = *(&spec.cuGeom + spec.cuGeom.childOffset + subPartIdx);
+
+        slave.m_maxTUDepth = spec.maxTUDepth;
+        slave.setLambdaFromQP(ctu, spec.rdQp);
+        int nextQP = spec.qp;
+        if (bUseDQP)
+            nextQP = slave.setLambdaFromQP(ctu, slave.calculateQpforCuSize(ctu, childGeom));
+
+        slave.m_modeDepth[0].fencYuv.copyPartToYuv(nd.fencYuv, childGeom.absPartIdx);
+        slave.m_rqt[nextDepth].cur.load(m_rqt[spec.cuGeom.depth].cur);
+
+        slave.m_bSpeculative = true;
+        slave.m_specStat = spec.stat[subPartIdx];
+        spec.splitData[subPartIdx] = slave.compressInterCU_rd0_4(ctu, childGeom, nextQP);
+        spec.stat[subPartIdx] = slave.m_specStat;
+        slave.m_bSpeculative = false;
+
+        task = -1;
+        spec.m_lock.acquire();
+        if (spec.m_jobTotal > spec.m_jobAcquired)
+            task = spec.m_jobAcquired++;
+        spec.m_lock.release();
+    }
+    while (task >= 0);
+}
+
 uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp)
 {
     uint32_t depth = cuGeom.depth;
@@ -895,6 +1202,22 @@ uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& c
             bNoSplit = recursionDepthCheck(parentCTU, cuGeom, *md.bestMode);
     }
 
+    int bTryAmp = m_slice->m_sps->maxAMPDepth > depth;
+
+    /* Without reference limits the inter modes of this depth do not depend
+     * on the analysis of the sub-CUs. Their jobs are then started before the
+     * recursion, so that idle workers analyse them while this thread analyses
+     * the sub-CUs. Intra analysis reconstructs into the picture, within the
+     * area of the sub-CUs, so its job is only added after the recursion */
+    bool bEarlyPmode = mightNotSplit && depth >= minDepth && mightSplit && !bNoSplit && !m_param->limitReferences;
+    if (bEarlyPmode)
+    {
+        if (m_slice->m_pps->bUseDQP && depth <= m_slice->m_pps->maxCuDQPDepth && m_slice->m_pps->maxCuDQPDepth != 0)
+            setLambdaFromQP(parentCTU, qp);
+
+        startPmode(pmode, parentCTU, cuGeom, qp, false, !!bTryAmp, splitRefs);
+    }
+
     if (mightSplit && !bNoSplit)
     {
         Mode* splitPred = &md.pred[PRED_SPLIT];
@@ -945,40 +1268,24 @@ uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& c
 
     if (mightNotSplit && depth >= minDepth)
     {
-        int bTryAmp = m_slice->m_sps->maxAMPDepth > depth;
         int bTryIntra = (m_slice->m_sliceType != B_SLICE || m_param->bIntraInBFrames) && (!m_param->limitReferences || splitIntra) && (cuGeom.log2CUSize != MAX_LOG2_CU_SIZE);
 
         if (m_slice->m_pps->bUseDQP && depth <= m_slice->m_pps->maxCuDQPDepth && m_slice->m_pps->maxCuDQPDepth != 0)
             setLambdaFromQP(parentCTU, qp);
 
-        if (bTryIntra)
+        if (!bEarlyPmode)
+            startPmode(pmode, parentCTU, cuGeom, qp, !!bTryIntra, !!bTryAmp, splitRefs);
+        else if (bTryIntra)
         {
-            md.pred[PRED_INTRA].cu.initSubCU(parentCTU, cuGeom, qp);
-            if (cuGeom.log2CUSize == 3 && m_slice->m_sps->quadtreeTULog2MinSize < 3 && m_param->rdLevel >= 5)
-                md.pred[PRED_INTRA_NxN].cu.initSubCU(parentCTU, cuGeom, qp);
+            initPmodeIntra(parentCTU, cuGeom, qp);
+            pmode.m_lock.acquire();
             pmode.modes[pmode.m_jobTotal++] = PRED_INTRA;
+            pmode.m_lock.release();
         }
-        md.pred[PRED_2Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2Nx2N;
-        md.pred[PRED_BIDIR].cu.initSubCU(parentCTU, cuGeom, qp);
-        if (m_param->bEnableRectInter)
-        {
-            md.pred[PRED_2NxN].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxN;
-            md.pred[PRED_Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_Nx2N;
-        }
-        if (bTryAmp)
-        {
-            md.pred[PRED_2NxnU].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxnU;
-            md.pred[PRED_2NxnD].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxnD;
-            md.pred[PRED_nLx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_nLx2N;
-            md.pred[PRED_nRx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_nRx2N;
-        }
-
-        m_splitRefIdx[0] = splitRefs[0]; m_splitRefIdx[1] = splitRefs[1]; m_splitRefIdx[2] = splitRefs[2]; m_splitRefIdx[3] = splitRefs[3];
-
-        pmode.tryBondPeers(*m_frame->m_encData->m_jobProvider, pmode.m_jobTotal);
 
         /* participate in processing jobs, until all are distributed */
         processPmode(pmode, *this);
+        pmode.close();
 
         /* the master worker thread (this one) does merge analysis. By doing
          * merge after all the other jobs are at least started, we usually avoid
@@ -1143,17 +1450,45 @@ uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& c
     return refMask;
 }
 
-SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp)
+void Analysis::selectInterCU()
+{
+    const x265_param& p = *m_param;
+
+    if (extendedInterCU(p) || m_slice->m_sps->maxAMPDepth)
+        m_compressInterCU = &Analysis::compressInterCU<InterCUGeneric>;
+    else if (InterCUUltrafast::matches(p))
+        m_compressInterCU = &Analysis::compressInterCU<InterCUUltrafast>;
+    else if (InterCUVeryfast::matches(p))
+        m_compressInterCU = &Analysis::compressInterCU<InterCUVeryfast>;
+    else if (InterCUMedium::matches(p))
+        m_compressInterCU = &Analysis::compressInterCU<InterCUMedium>;
+    else if (InterCUSlow::matches(p))
+        m_compressInterCU = &Analysis::compressInterCU<InterCUSlow>;
+    else
+        m_compressInterCU = &Analysis::compressInterCU<InterCUGeneric>;
+}
+
+template<class Cfg>
+SplitData Analysis::compressInterCU(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp)
 {
     if (parentCTU.m_vbvAffected && calculateQpforCuSize(parentCTU, cuGeom, 1))
         return compressInterCU_rd5_6(parentCTU, cuGeom, qp);
 
+    /* compile-time constants in the preset configurations */
+    const int  rdLevel = Cfg::rdLevel(*m_param);
+    const bool bRect = Cfg::rect(*m_param);
+    const bool bAmp = Cfg::amp(*m_param);
+    const bool bLimitModes = Cfg::limitModes(*m_param);
+    const int  limitRefs = Cfg::limitRefs(*m_param);
+    const int  recursionSkip = Cfg::recursionSkip(*m_param);
+    const bool bExtended = Cfg::extended(*m_param);
+
     uint32_t depth = cuGeom.depth;
     uint32_t cuAddr = parentCTU.m_cuAddr;
     ModeDepth& md = m_modeDepth[depth];
 
 
-    if (m_param->searchMethod == X265_SEA)
+    if (bExtended && m_param->searchMethod == X265_SEA)
     {
         int numPredDir = m_slice->isInterP() ? 1 : 2;
         int offset = (int)(m_frame->m_reconPic->m_cuOffsetY[parentCTU.m_cuAddr] + m_frame->m_reconPic->m_buOffsetY[cuGeom.absPartIdx]);
@@ -1166,9 +1501,9 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
     PicYuv& reconPic = *m_frame->m_reconPic;
     SplitData splitCUData;
 
-    bool bHEVCBlockAnalysis = (m_param->bAnalysisType == AVC_INFO && cuGeom.numPartitions > 16);
-    bool bRefineAVCAnalysis = (m_param->analysisLoadReuseLevel == 7 && (m_modeFlag[0] || m_modeFlag[1]));
-    bool bNooffloading = !(m_param->bAnalysisType == AVC_INFO);
+    bool bHEVCBlockAnalysis = bExtended && (m_param->bAnalysisType == AVC_INFO && cuGeom.numPartitions > 16);
+    bool bRefineAVCAnalysis = bExtended && (m_param->analysisLoadReuseLevel == 7 && (m_modeFlag[0] || m_modeFlag[1]));
+    bool bNooffloading = !(bExtended && m_param->bAnalysisType == AVC_INFO);
 
     if (bHEVCBlockAnalysis || bRefineAVCAnalysis || bNooffloading)
     {
@@ -1185,7 +1520,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
         bool bCtuInfoCheck = false;
         int sameContentRef = 0;
 
-        if (m_evaluateInter)
+        if (bExtended && m_evaluateInter)
         {
             if (m_refineLevel == 2)
             {
@@ -1198,7 +1533,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
             minDepth = depth;
         }
 
-        if ((m_limitTU & X265_TU_LIMIT_NEIGH) && cuGeom.log2CUSize >= 4)
+        if (bExtended && (m_limitTU & X265_TU_LIMIT_NEIGH) && cuGeom.log2CUSize >= 4)
             m_maxTUDepth = loadTUDepth(cuGeom, parentCTU);
 
         SplitData splitData[4];
@@ -1208,14 +1543,14 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
         splitData[3].initSplitCUData();
 
         // avoid uninitialize value in below reference
-        if (m_param->limitModes)
+        if (bLimitModes)
         {
             md.pred[PRED_2Nx2N].bestME[0][0].mvCost = 0; // L0
             md.pred[PRED_2Nx2N].bestME[0][1].mvCost = 0; // L1
             md.pred[PRED_2Nx2N].sa8dCost = 0;
         }
 
-        if (m_param->bCTUInfo && depth <= parentCTU.m_cuDepth[cuGeom.absPartIdx])
+        if (bExtended && m_param->bCTUInfo && depth <= parentCTU.m_cuDepth[cuGeom.absPartIdx])
         {
             if (bDecidedDepth && m_additionalCtuInfo[cuGeom.absPartIdx])
                 sameContentRef = findSameContentRefCount(parentCTU, cuGeom);
@@ -1245,7 +1580,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                     }
                     if (sameContentRef || (!sameContentRef && !(m_param->bCTUInfo & 4)))
                     {
-                        if (m_param->rdLevel)
+                        if (rdLevel)
                             skipModes = m_param->bEnableEarlySkip && md.bestMode && md.bestMode->cu.isSkipped(0);
                         if ((m_param->bCTUInfo & 4) && sameContentRef)
                             skipModes = md.bestMode && true;
@@ -1256,13 +1591,13 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                     md.pred[PRED_MERGE].cu.initSubCU(parentCTU, cuGeom, qp);
                     md.pred[PRED_SKIP].cu.initSubCU(parentCTU, cuGeom, qp);
                     checkMerge2Nx2N_rd0_4(md.pred[PRED_SKIP], md.pred[PRED_MERGE], cuGeom);
-                    if (m_param->rdLevel)
+                    if (rdLevel)
                         skipModes = m_param->bEnableEarlySkip && md.bestMode && md.bestMode->cu.isSkipped(0);
                 }
                 mightSplit &= !bDecidedDepth;
             }
         }
-        if ((m_param->analysisLoadReuseLevel > 1 && m_param->analysisLoadReuseLevel != 10))
+        if (bExtended && (m_param->analysisLoadReuseLevel > 1 && m_param->analysisLoadReuseLevel != 10))
         {
             if (mightNotSplit && depth == m_reuseDepth[cuGeom.absPartIdx])
             {
@@ -1272,8 +1607,8 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                     md.pred[PRED_SKIP].cu.initSubCU(parentCTU, cuGeom, qp);
                     checkMerge2Nx2N_rd0_4(md.pred[PRED_SKIP], md.pred[PRED_MERGE], cuGeom);
 
-                    skipRecursion = !!m_param->recursionSkipMode && md.bestMode;
-                    if (m_param->rdLevel)
+                    skipRecursion = !!recursionSkip && md.bestMode;
+                    if (rdLevel)
                         skipModes = m_param->bEnableEarlySkip && md.bestMode;
                 }
                 if (m_param->analysisLoadReuseLevel > 4 && m_reusePartSize[cuGeom.absPartIdx] == SIZE_2Nx2N)
@@ -1286,7 +1621,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                 }
             }
         }
-        if (m_param->analysisMultiPassRefine && m_param->rc.bStatRead && m_reuseInterDataCTU)
+        if (bExtended && m_param->analysisMultiPassRefine && m_param->rc.bStatRead && m_reuseInterDataCTU)
         {
             if (mightNotSplit && depth == m_reuseDepth[cuGeom.absPartIdx])
             {
@@ -1296,47 +1631,49 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                     md.pred[PRED_SKIP].cu.initSubCU(parentCTU, cuGeom, qp);
                     checkMerge2Nx2N_rd0_4(md.pred[PRED_SKIP], md.pred[PRED_MERGE], cuGeom);
 
-                    skipRecursion = !!m_param->recursionSkipMode && md.bestMode;
-                    if (m_param->rdLevel)
+                    skipRecursion = !!recursionSkip && md.bestMode;
+                    if (rdLevel)
                         skipModes = m_param->bEnableEarlySkip && md.bestMode;
                 }
             }
         }
         /* Step 1. Evaluate Merge/Skip candidates for likely early-outs, if skip mode was not set above */
-        if ((mightNotSplit && depth >= minDepth && !md.bestMode && !bCtuInfoCheck) || (m_param->bAnalysisType == AVC_INFO && m_param->analysisLoadReuseLevel == 7 && (m_modeFlag[0] || m_modeFlag[1])))
+        if ((mightNotSplit && depth >= minDepth && !md.bestMode && !bCtuInfoCheck) || (bExtended && m_param->bAnalysisType == AVC_INFO && m_param->analysisLoadReuseLevel == 7 && (m_modeFlag[0] || m_modeFlag[1])))
             /* TODO: Re-evaluate if analysis load/save still works */
         {
             /* Compute Merge Cost */
             md.pred[PRED_MERGE].cu.initSubCU(parentCTU, cuGeom, qp);
             md.pred[PRED_SKIP].cu.initSubCU(parentCTU, cuGeom, qp);
             checkMerge2Nx2N_rd0_4(md.pred[PRED_SKIP], md.pred[PRED_MERGE], cuGeom);
-            if (m_param->rdLevel)
-                skipModes = (m_param->bEnableEarlySkip || m_refineLevel == 2)
+            if (rdLevel)
+                skipModes = (m_param->bEnableEarlySkip || (bExtended && m_refineLevel == 2))
                 && md.bestMode && md.bestMode->cu.isSkipped(0); // TODO: sa8d threshold per depth
         }
-        if (md.bestMode && m_param->recursionSkipMode && !bCtuInfoCheck && !(m_param->bAnalysisType == AVC_INFO && m_param->analysisLoadReuseLevel == 7 && (m_modeFlag[0] || m_modeFlag[1])))
+        if (md.bestMode && recursionSkip && !bCtuInfoCheck && !(bExtended && m_param->bAnalysisType == AVC_INFO && m_param->analysisLoadReuseLevel == 7 && (m_modeFlag[0] || m_modeFlag[1])))
         {
             skipRecursion = md.bestMode->cu.isSkipped(0);
             if (mightSplit && !skipRecursion)
             {
-                if (depth >= minDepth && m_param->recursionSkipMode == RDCOST_BASED_RSKIP)
+                if (depth >= minDepth && recursionSkip == RDCOST_BASED_RSKIP)
                 {
                     if (depth)
                         skipRecursion = recursionDepthCheck(parentCTU, cuGeom, *md.bestMode);
-                    if (m_bHD && !skipRecursion && m_param->rdLevel == 2 && md.fencYuv.m_size != MAX_CU_SIZE)
+                    if (m_bHD && !skipRecursion && rdLevel == 2 && md.fencYuv.m_size != MAX_CU_SIZE)
                         skipRecursion = complexityCheckCU(*md.bestMode);
                 }
-                else if (cuGeom.log2CUSize >= MAX_LOG2_CU_SIZE - 1 && m_param->recursionSkipMode == EDGE_BASED_RSKIP)
+                else if (cuGeom.log2CUSize >= MAX_LOG2_CU_SIZE - 1 && recursionSkip == EDGE_BASED_RSKIP)
                 {
                     skipRecursion = complexityCheckCU(*md.bestMode);
                 }
 
             }
         }
-        if (m_param->bAnalysisType == AVC_INFO && md.bestMode && cuGeom.numPartitions <= 16 && m_param->analysisLoadReuseLevel == 7)
+        if (bExtended && m_param->bAnalysisType == AVC_INFO && md.bestMode && cuGeom.numPartitions <= 16 && m_param->analysisLoadReuseLevel == 7)
             skipRecursion = true;
         /* Step 2. Evaluate each of the 4 split sub-blocks in series */
-        if (mightSplit && !skipRecursion)
+        if (bExtended && mightSplit && !skipRecursion && !depth && m_param->bSpeculativeSplit)
+            splitIntra = speculateSplit(parentCTU, cuGeom, qp, splitData);
+        else if (mightSplit && !skipRecursion)
         {
             if (bCtuInfoCheck && m_param->bCTUInfo & 2)
                 qp = int((1 / 0.96) * qp + 0.5);
@@ -1363,18 +1700,18 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                     if (m_slice->m_pps->bUseDQP && nextDepth <= m_slice->m_pps->maxCuDQPDepth)
                         nextQP = setLambdaFromQP(parentCTU, calculateQpforCuSize(parentCTU, childGeom));
 
-                    splitData[subPartIdx] = compressInterCU_rd0_4(parentCTU, childGeom, nextQP);
+                    splitData[subPartIdx] = compressInterCU<Cfg>(parentCTU, childGeom, nextQP);
 
                     // Save best CU and pred data for this sub CU
                     splitIntra |= nd.bestMode->cu.isIntra(0);
                     splitCU->copyPartFrom(nd.bestMode->cu, childGeom, subPartIdx);
                     splitPred->addSubCosts(*nd.bestMode);
 
-                    if (m_param->rdLevel)
+                    if (rdLevel)
                         nd.bestMode->reconYuv.copyToPartYuv(splitPred->reconYuv, childGeom.numPartitions * subPartIdx);
                     else
                         nd.bestMode->predYuv.copyToPartYuv(splitPred->predYuv, childGeom.numPartitions * subPartIdx);
-                    if (m_param->rdLevel > 1)
+                    if (rdLevel > 1)
                         nextContext = &nd.bestMode->contexts;
                 }
                 else
@@ -1384,13 +1721,13 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
 
             if (mightNotSplit)
                 addSplitFlagCost(*splitPred, cuGeom.depth);
-            else if (m_param->rdLevel > 1)
+            else if (rdLevel > 1)
                 updateModeCost(*splitPred);
             else
                 splitPred->sa8dCost = m_rdCost.calcRdSADCost((uint32_t)splitPred->distortion, splitPred->sa8dBits);
         }
         /* If analysis mode is simple do not Evaluate other modes */
-        if (m_param->bAnalysisType == AVC_INFO && m_param->analysisLoadReuseLevel == 7)
+        if (bExtended && m_param->bAnalysisType == AVC_INFO && m_param->analysisLoadReuseLevel == 7)
         {
             if (m_slice->m_sliceType == P_SLICE)
             {
@@ -1408,7 +1745,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
          *   2  3 */
         uint32_t allSplitRefs = splitData[0].splitRefs | splitData[1].splitRefs | splitData[2].splitRefs | splitData[3].splitRefs;
         /* Step 3. Evaluate ME (2Nx2N, rect, amp) and intra modes at current depth */
-        if (mightNotSplit && (depth >= minDepth || (m_param->bCTUInfo && !md.bestMode)))
+        if (mightNotSplit && (depth >= minDepth || (bExtended && m_param->bCTUInfo && !md.bestMode)))
         {
             if (m_slice->m_pps->bUseDQP && depth <= m_slice->m_pps->maxCuDQPDepth && m_slice->m_pps->maxCuDQPDepth != 0)
                 setLambdaFromQP(parentCTU, qp);
@@ -1420,7 +1757,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                 md.pred[PRED_2Nx2N].cu.initSubCU(parentCTU, cuGeom, qp);
                 checkInter_rd0_4(md.pred[PRED_2Nx2N], cuGeom, SIZE_2Nx2N, refMasks);
 
-                if (m_param->limitReferences & X265_REF_LIMIT_CU)
+                if (limitRefs & X265_REF_LIMIT_CU)
                 {
                     CUData& cu = md.pred[PRED_2Nx2N].cu;
                     uint32_t refMask = cu.getBestRefIdx(0);
@@ -1436,7 +1773,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                 Mode *bestInter = &md.pred[PRED_2Nx2N];
                 if (!skipRectAmp)
                 {
-                    if (m_param->bEnableRectInter)
+                    if (bRect)
                     {
                         uint64_t splitCost = splitData[0].sa8dCost + splitData[1].sa8dCost + splitData[2].sa8dCost + splitData[3].sa8dCost;
                         uint32_t threshold_2NxN, threshold_Nx2N;
@@ -1486,7 +1823,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                         }
                     }
 
-                    if (m_slice->m_sps->maxAMPDepth > depth)
+                    if (bAmp && m_slice->m_sps->maxAMPDepth > depth)
                     {
                         uint64_t splitCost = splitData[0].sa8dCost + splitData[1].sa8dCost + splitData[2].sa8dCost + splitData[3].sa8dCost;
                         uint32_t threshold_2NxnU, threshold_2NxnD, threshold_nLx2N, threshold_nRx2N;
@@ -1593,7 +1930,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                     }
                 }
                 bool bTryIntra = (m_slice->m_sliceType != B_SLICE || m_param->bIntraInBFrames) && cuGeom.log2CUSize != MAX_LOG2_CU_SIZE && !((m_param->bCTUInfo & 4) && bCtuInfoCheck);
-                if (m_param->rdLevel >= 3)
+                if (rdLevel >= 3)
                 {
                     /* Calculate RD cost of best inter option */
                     if ((!m_bChromaSa8d && (m_csp != X265_CSP_I400)) || (m_frame->m_fencPic->m_picCsp == X265_CSP_I400 && m_csp != X265_CSP_I400)) /* When m_bChromaSa8d is enabled, chroma MC has already been done */
@@ -1630,7 +1967,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                     if ((bTryIntra && md.bestMode->cu.getQtRootCbf(0)) ||
                         md.bestMode->sa8dCost == MAX_INT64)
                     {
-                        if (!m_param->limitReferences || splitIntra)
+                        if (!limitRefs || splitIntra)
                         {
                             ProfileCounter(parentCTU, totalIntraCU[cuGeom.depth]);
                             md.pred[PRED_INTRA].cu.initSubCU(parentCTU, cuGeom, qp);
@@ -1656,7 +1993,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
 
                     if (bTryIntra || md.bestMode->sa8dCost == MAX_INT64)
                     {
-                        if (!m_param->limitReferences || splitIntra)
+                        if (!limitRefs || splitIntra)
                         {
                             ProfileCounter(parentCTU, totalIntraCU[cuGeom.depth]);
                             md.pred[PRED_INTRA].cu.initSubCU(parentCTU, cuGeom, qp);
@@ -1690,9 +2027,9 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                                 motionCompensation(md.bestMode->cu, pu, md.bestMode->predYuv, false, true);
                             }
                         }
-                        if (m_param->rdLevel == 2)
+                        if (rdLevel == 2)
                             encodeResAndCalcRdInterCU(*md.bestMode, cuGeom);
-                        else if (m_param->rdLevel == 1)
+                        else if (rdLevel == 1)
                         {
                             /* generate recon pixels with no rate distortion considerations */
                             CUData& cu = md.bestMode->cu;
@@ -1713,9 +2050,9 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                     }
                     else
                     {
-                        if (m_param->rdLevel == 2)
+                        if (rdLevel == 2)
                             encodeIntraInInter(*md.bestMode, cuGeom);
-                        else if (m_param->rdLevel == 1)
+                        else if (rdLevel == 1)
                         {
                             /* generate recon pixels with no rate distortion considerations */
                             CUData& cu = md.bestMode->cu;
@@ -1735,7 +2072,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                 }
             } // !earlyskip
 
-            if (m_bTryLossless)
+            if (bExtended && m_bTryLossless)
                 tryLossless(cuGeom);
 
             if (mightSplit)
@@ -1747,7 +2084,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
             Mode* splitPred = &md.pred[PRED_SPLIT];
             if (!md.bestMode)
                 md.bestMode = splitPred;
-            else if (m_param->rdLevel > 1)
+            else if (rdLevel > 1)
                 checkBestMode(*splitPred, cuGeom.depth);
             else if (splitPred->sa8dCost < md.bestMode->sa8dCost)
                 md.bestMode = splitPred;
@@ -1758,7 +2095,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
         /* determine which motion references the parent CU should search */
         splitCUData.initSplitCUData();
 
-        if (m_param->limitReferences & X265_REF_LIMIT_DEPTH)
+        if (limitRefs & X265_REF_LIMIT_DEPTH)
         {
             if (md.bestMode == &md.pred[PRED_SPLIT])
                 splitCUData.splitRefs = allSplitRefs;
@@ -1772,7 +2109,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
             }
         }
 
-        if (m_param->limitModes)
+        if (bLimitModes)
         {
             splitCUData.mvCost[0] = md.pred[PRED_2Nx2N].bestME[0][0].mvCost; // L0
             splitCUData.mvCost[1] = md.pred[PRED_2Nx2N].bestME[0][1].mvCost; // L1
@@ -1781,8 +2118,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
 
         if (mightNotSplit && md.bestMode->cu.isSkipped(0))
         {
-            FrameData& curEncData = *m_frame->m_encData;
-            FrameData::RCStatCU& cuStat = curEncData.m_cuStat[parentCTU.m_cuAddr];
+            FrameData::RCStatCU& cuStat = ctuStat(parentCTU);
             uint64_t temp = cuStat.avgCost[depth] * cuStat.count[depth];
             cuStat.count[depth] += 1;
             cuStat.avgCost[depth] = (temp + md.bestMode->rdCost) / cuStat.count[depth];
@@ -1790,10 +2126,10 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
 
         /* Copy best data to encData CTU and recon */
         md.bestMode->cu.copyToPic(depth);
-        if (m_param->rdLevel)
+        if (rdLevel)
             md.bestMode->reconYuv.copyToPicYuv(reconPic, cuAddr, cuGeom.absPartIdx);
 
-        if ((m_limitTU & X265_TU_LIMIT_NEIGH) && cuGeom.log2CUSize >= 4)
+        if (bExtended && (m_limitTU & X265_TU_LIMIT_NEIGH) && cuGeom.log2CUSize >= 4)
         {
             if (mightNotSplit)
             {
@@ -1821,7 +2157,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
 
             splitCUData.initSplitCUData();
 
-            if (m_param->limitReferences & X265_REF_LIMIT_DEPTH)
+            if (limitRefs & X265_REF_LIMIT_DEPTH)
             {
                 if (md.bestMode == &md.pred[PRED_SPLIT])
                     splitCUData.splitRefs = allSplitRefs;
@@ -1835,7 +2171,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
                 }
             }
 
-            if (m_param->limitModes)
+            if (bLimitModes)
             {
                 splitCUData.mvCost[0] = md.pred[PRED_2Nx2N].bestME[0][0].mvCost; // L0
                 splitCUData.mvCost[1] = md.pred[PRED_2Nx2N].bestME[0][1].mvCost; // L1
@@ -2665,6 +3001,166 @@ void Analysis::recodeCU(const CUData& parentCTU, const CUGeom& cuGeom, int32_t q
         trainCU(parentCTU, cuGeom, *md.bestMode, td);
 }
 
+bool Analysis::recodeSpeculated(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp)
+{
+    uint32_t depth = cuGeom.depth;
+    ModeDepth& md = m_modeDepth[depth];
+
+    bool mightSplit = !(cuGeom.flags & CUGeom::LEAF);
+    bool mightNotSplit = !(cuGeom.flags & CUGeom::SPLIT_MANDATORY);
+    bool bDecidedDepth = parentCTU.m_cuDepth[cuGeom.absPartIdx] == depth;
+
+    if ((m_limitTU & X265_TU_LIMIT_NEIGH) && cuGeom.log2CUSize >= 4)
+        m_maxTUDepth = loadTUDepth(cuGeom, parentCTU);
+
+    if (bDecidedDepth && mightNotSplit)
+    {
+        Mode& mode = md.pred[0];
+        md.bestMode = &mode;
+        mode.cu.initSubCU(parentCTU, cuGeom, qp);
+        PartSize size = (PartSize)parentCTU.m_partSize[cuGeom.absPartIdx];
+        if (parentCTU.isIntra(cuGeom.absPartIdx))
+        {
+            memcpy(mode.cu.m_lumaIntraDir, parentCTU.m_lumaIntraDir + cuGeom.absPartIdx, cuGeom.numPartitions);
+            memcpy(mode.cu.m_chromaIntraDir, parentCTU.m_chromaIntraDir + cuGeom.absPartIdx, cuGeom.numPartitions);
+            checkIntra(mode, cuGeom, size);
+        }
+        else
+        {
+            bool bSkipped = parentCTU.isSkipped(cuGeom.absPartIdx);
+            mode.cu.copyFromPic(parentCTU, cuGeom, m_csp, false);
+            uint32_t numPU = parentCTU.getNumPartInter(cuGeom.absPartIdx);
+            for (uint32_t part = 0; part < numPU; part++)
+            {
+                PredictionUnit pu(mode.cu, cuGeom, part);
+                uint32_t interDir = mode.cu.m_interDir[pu.puAbsPartIdx];
+                if (mode.cu.m_mergeFlag[pu.puAbsPartIdx])
+                {
+                    /* the speculated motion must still be a merge candidate */
+                    MVField candMvField[MRG_MAX_NUM_CANDS][2]; // double length for mv of both lists
+                    uint8_t candDir[MRG_MAX_NUM_CANDS];
+                    uint32_t numMergeCand = mode.cu.getInterMergeCandidates(pu.puAbsPartIdx, part, candMvField, candDir);
+                    int mergeIdx = -1;
+                    for (uint32_t i = 0; i < numMergeCand && mergeIdx < 0; i++)
+                    {
+                        if (mode.cu.isBipredRestriction() && candDir[i] == 3)
+                        {
+                            candDir[i] = 1;
+                            candMvField[i][1].refIdx = REF_NOT_VALID;
+                        }
+                        if (candDir[i] != interDir)
+                            continue;
+                        bool bMatch = true;
+                        for (int list = 0; list < 2; list++)
+                        {
+                            if (interDir & (1 << list))
+                                bMatch &= candMvField[i][list].mv == mode.cu.m_mv[list][pu.puAbsPartIdx] &&
+                                          candMvField[i][list].refIdx == mode.cu.m_refIdx[list][pu.puAbsPartIdx];
+                        }
+                        if (bMatch)
+                            mergeIdx = i;
+                    }
+                    if (mergeIdx < 0)
+                        return false;
+                    mode.cu.m_mvpIdx[0][pu.puAbsPartIdx] = (uint8_t)mergeIdx;
+                }
+                else
+                {
+                    /* AMVP, code the same motion against the final predictors */
+                    MV mvc[(MD_ABOVE_LEFT + 1) * 2 + 2];
+                    mode.cu.getNeighbourMV(part, pu.puAbsPartIdx, mode.interNeighbours);
+                    for (int list = 0; list < m_slice->isInterB() + 1; list++)
+                    {
+                        int ref = mode.cu.m_refIdx[list][pu.puAbsPartIdx];
+                        if (ref == -1)
+                            continue;
+                        mode.cu.getPMV(mode.interNeighbours, list, ref, mode.amvpCand[list][ref], mvc);
+                        const MV& mv = mode.cu.m_mv[list][pu.puAbsPartIdx];
+                        int mvpIdx = 0;
+                        uint32_t bits = 0, cost = 0;
+                        MV mvp = checkBestMVP(mode.amvpCand[list][ref], mv, mvpIdx, bits, cost);
+                        mode.cu.m_mvpIdx[list][pu.puAbsPartIdx] = (uint8_t)mvpIdx;
+                        mode.cu.m_mvd[list][pu.puAbsPartIdx] = mv - mvp;
+                    }
+                }
+                motionCompensation(mode.cu, pu, mode.predYuv, true, (m_csp != X265_CSP_I400 && m_frame->m_fencPic->m_picCsp != X265_CSP_I400));
+            }
+            if (bSkipped)
+                encodeResAndCalcRdSkipCU(mode);
+            else
+                encodeResAndCalcRdInterCU(mode, cuGeom);
+
+            /* checkMerge2Nx2N function performs checkDQP after encoding residual, do the same */
+            if (bSkipped || (size == SIZE_2Nx2N && mode.cu.m_mergeFlag[0]))
+                checkDQP(mode, cuGeom);
+        }
+
+        if (mightSplit)
+        {
+            addSplitFlagCost(mode, depth);
+            checkDQPForSplitPred(mode, cuGeom);
+        }
+    }
+    else
+    {
+        Mode* splitPred = &md.pred[PRED_SPLIT];
+        md.bestMode = splitPred;
+        splitPred->initCosts();
+        CUData* splitCU = &splitPred->cu;
+        splitCU->initSubCU(parentCTU, cuGeom, qp);
+
+        uint32_t nextDepth = depth + 1;
+        ModeDepth& nd = m_modeDepth[nextDepth];
+        invalidateContexts(nextDepth);
+        Entropy* nextContext = &m_rqt[depth].cur;
+        int nextQP = qp;
+
+        for (uint32_t subPartIdx = 0; subPartIdx < 4; subPartIdx++)
+        {
+            const CUGeom& childGeom = *(&cuGeom + cuGeom.childOffset + subPartIdx);
+            if (childGeom.flags & CUGeom::PRESENT)
+            {
+                m_modeDepth[0].fencYuv.copyPartToYuv(nd.fencYuv, childGeom.absPartIdx);
+                m_rqt[nextDepth].cur.load(*nextContext);
+
+                if (m_slice->m_pps->bUseDQP && nextDepth <= m_slice->m_pps->maxCuDQPDepth)
+                    nextQP = setLambdaFromQP(parentCTU, calculateQpforCuSize(parentCTU, childGeom));
+
+                if (!recodeSpeculated(parentCTU, childGeom, nextQP))
+                    return false;
+
+                splitCU->copyPartFrom(nd.bestMode->cu, childGeom, subPartIdx);
+                splitPred->addSubCosts(*nd.bestMode);
+                nd.bestMode->reconYuv.copyToPartYuv(splitPred->reconYuv, childGeom.numPartitions * subPartIdx);
+                nextContext = &nd.bestMode->contexts;
+            }
+            else
+                splitCU->setEmptyPart(childGeom, subPartIdx);
+        }
+        nextContext->store(splitPred->contexts);
+        if (mightNotSplit)
+            addSplitFlagCost(*splitPred, depth);
+        else
+            updateModeCost(*splitPred);
+
+        checkDQPForSplitPred(*splitPred, cuGeom);
+    }
+
+    /* Copy best data to encData CTU and recon */
+    md.bestMode->cu.copyToPic(depth);
+    md.bestMode->reconYuv.copyToPicYuv(*m_frame->m_reconPic, parentCTU.m_cuAddr, cuGeom.absPartIdx);
+
+    if ((m_limitTU & X265_TU_LIMIT_NEIGH) && cuGeom.log2CUSize >= 4 && mightNotSplit)
+    {
+        CUData* ctu = md.bestMode->cu.m_encData->getPicCTU(parentCTU.m_cuAddr);
+        int8_t maxTUDepth = -1;
+        for (uint32_t i = 0; i < cuGeom.numPartitions; i++)
+            maxTUDepth = X265_MAX(maxTUDepth, md.bestMode->cu.m_tuDepth[i]);
+        ctu->m_refTuDepth[cuGeom.geomRecurId] = maxTUDepth;
+    }
+    return true;
+}
+
 void Analysis::classifyCU(const CUData& ctu, const CUGeom& cuGeom, const Mode& bestMode, TrainingData& trainData)
 {
     uint32_t depth = cuGeom.depth;
@@ -3428,8 +3924,9 @@ void Analysis::addSplitFlagCost(Mode& mode, uint32_t depth)
 uint32_t Analysis::topSkipMinDepth(const CUData& parentCTU, const CUGeom& cuGeom)
 {
     /* Do not attempt to code a block larger than the largest block in the
-     * co-located CTUs in L0 and L1 */
-    int currentQP = parentCTU.m_qp[0];
+     * co-located CTUs in L0 and L1. A speculative sub-CU analysis must not
+     * look at QPs the sub-CUs before it are still writing */
+    int currentQP = parentCTU.m_qp[parentCTU.m_firstAvailIdx];
     int previousQP = currentQP;
     uint32_t minDepth0 = 4, minDepth1 = 4;
     uint32_t sum = 0;
@@ -3485,7 +3982,7 @@ bool Analysis::recursionDepthCheck(const CUData& parentCTU, const CUGeom& cuGeom
 
     uint32_t depth = cuGeom.depth;
     FrameData& curEncData = *m_frame->m_encData;
-    FrameData::RCStatCU& cuStat = curEncData.m_cuStat[parentCTU.m_cuAddr];
+    FrameData::RCStatCU& cuStat = ctuStat(parentCTU);
     uint64_t cuCost = cuStat.avgCost[depth] * cuStat.count[depth];
     uint64_t cuCount = cuStat.count[depth];
 
@@ -93,6 +93,8 @@ public:
         Analysis&     master;
         const CUGeom& cuGeom;
         int           modes[MAX_PRED_TYPES];
+        int           qp;            // rd cost QP of the master when the jobs were started
+        uint32_t      splitRefs[4];  // references of the sub-CUs, see X265_REF_LIMIT_DEPTH
 
         PMODE(Analysis& m, const CUGeom& g) : master(m), cuGeom(g) {}
 
@@ -103,8 +105,38 @@ public:
         PMODE operator=(const PMODE&);
     };
 
+    void initPmodeIntra(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp);
+    void startPmode(PMODE& pmode, const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp, bool bTryIntra, bool bTryAmp, const uint32_t splitRefs[4]);
     void processPmode(PMODE& pmode, Analysis& slave);
 
+    /* speculative analysis of the sub-CUs 1..3 of the first split of a CTU,
+     * see param.bSpeculativeSplit */
+    class SplitSpec : public BondedTaskGroup
+    {
+    public:
+
+        Analysis&     master;
+        const CUGeom& cuGeom;
+        CUData        ctu[4];        // copies of the picture CTU, available from the start of each sub-CU
+        int           children[3];
+        int           qp;            // QP of the split CU
+        int           rdQp;          // rd cost QP of the master when the jobs were started
+        int32_t       maxTUDepth;
+        SplitData     splitData[4];
+        FrameData::RCStatCU stat[4]; // early-out statistics gathered by each sub-CU analysis
+
+        SplitSpec(Analysis& m, const CUGeom& g) : master(m), cuGeom(g) {}
+
+        void processTasks(int workerThreadId);
+
+    protected:
+
+        SplitSpec operator=(const SplitSpec&);
+    };
+
+    bool speculateSplit(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp, SplitData splitData[4]);
+    void processSplitSpec(SplitSpec& spec, Analysis& slave);
+
     ModeDepth m_modeDepth[NUM_CU_DEPTH];
     bool      m_bTryLossless;
     bool      m_bChromaSa8d;
@@ -113,6 +145,9 @@ public:
     bool      m_modeFlag[2];
     bool      m_checkMergeAndSkipOnly[2];
 
+    bool                m_bSpeculative;  // analysing a sub-CU of a SplitSpec, see ctuStat()
+    FrameData::RCStatCU m_specStat;
+
     Analysis();
 
     bool create(ThreadLocalData* tld);
@@ -131,12 +166,21 @@ protected:
     x265_analysis_MV*          m_reuseMv[2];
     uint8_t*             m_reuseMvpIdx[2];
 
-    uint32_t             m_splitRefIdx[4];
     uint64_t*            cacheCost;
 
     uint8_t                 m_evaluateInter;
     int32_t                 m_refineLevel;
 
+    /* compressInterCU_rd0_4 instance for the param of the current CTU, the
+     * param values of the preset configurations are compile-time constants
+     * of their instances, see selectInterCU() */
+    typedef SplitData (Analysis::*CompressInterCU)(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp);
+    CompressInterCU         m_compressInterCU;
+
+    template<class Cfg>
+    SplitData compressInterCU(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp);
+    void selectInterCU();
+
     uint8_t*                m_additionalCtuInfo;
     int*                    m_prevCtuInfoChange;
 
@@ -166,11 +210,18 @@ protected:
 
     /* full analysis for a P or B slice CU */
     uint32_t compressInterCU_dist(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp);
-    SplitData compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp);
+    SplitData compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp)
+    {
+        return (this->*m_compressInterCU)(parentCTU, cuGeom, qp);
+    }
     SplitData compressInterCU_rd5_6(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp);
 
     void recodeCU(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp, int32_t origqp = -1);
 
+    /* code the decisions of a speculative sub-CU analysis with the final
+     * neighbours and contexts, returns false if they are no longer valid */
+    bool recodeSpeculated(const CUData& parentCTU, const CUGeom& cuGeom, int32_t qp);
+
     /* measure merge and skip */
     void checkMerge2Nx2N_rd0_4(Mode& skip, Mode& merge, const CUGeom& cuGeom);
     void checkMerge2Nx2N_rd5_6(Mode& skip, Mode& merge, const CUGeom& cuGeom);
@@ -207,6 +258,12 @@ protected:
 
     void collectPUStatistics(const CUData& ctu, const CUGeom& cuGeom);
 
+    /* early-out statistics of the CTU; a speculative analysis keeps its own */
+    FrameData::RCStatCU& ctuStat(const CUData& ctu)
+    {
+        return m_bSpeculative ? m_specStat : m_frame->m_encData->m_cuStat[ctu.m_cuAddr];
+    }
+
     /* check whether current mode is the new best */
     inline void checkBestMode(Mode& mode, uint32_t depth)
     {
@@ -26,7 +26,9 @@
 #include "param.h"
 
 #include "encoder.h"
+#include "encodercontext.h"
 #include "entropy.h"
+#include "latencytrace.h"
 #include "level.h"
 #include "nal.h"
 #include "bitcost.h"
@@ -232,6 +234,8 @@ x265_encoder *x265_encoder_open(x265_param *p)
     return encoder;
 
 fail:
+    if (encoder)
+        encoder->releaseContext();
     delete encoder;
     PARAM_NS::x265_param_free(param);
     PARAM_NS::x265_param_free(latestParam);
@@ -967,6 +971,32 @@ void x265_free_analysis_data(x265_param *param, x265_analysis_data* analysis)
 void x265_cleanup(void)
 {
     BitCost::destroy();
+    FrameArena::trim();
+}
+
+x265_context *x265_context_create(x265_param *p)
+{
+    if (!p)
+        return NULL;
+
+    return EncoderContext::create(p);
+}
+
+void x265_context_free(x265_context *ctx)
+{
+    if (ctx)
+        static_cast<EncoderContext*>(ctx)->release();
+}
+
+int x265_encoder_latency_trace(x265_encoder *enc, const char *filename)
+{
+    if (!enc || !filename)
+        return -1;
+
+    Encoder *encoder = static_cast<Encoder*>(enc);
+    if (!encoder->m_latencyTrace)
+        return -1;
+    return encoder->m_latencyTrace->write(filename) ? 0 : -1;
 }
 
 x265_picture *x265_picture_alloc()
@@ -1073,7 +1103,10 @@ static const x265_api libapi =
     &x265_calculate_vmaf_framelevelscore,
     &x265_vmaf_encoder_log,
 #endif
-    &PARAM_NS::x265_zone_param_parse
+    &PARAM_NS::x265_zone_param_parse,
+    &x265_context_create,
+    &x265_context_free,
+    &x265_encoder_latency_trace
 };
 
 typedef const x265_api* (*api_get_func)(int bitDepth);
@@ -1370,7 +1403,7 @@ FILE* x265_csvlog_open(const x265_param* param)
 
                     /* detailed performance statistics */
                     fprintf(csvfp, ", DecideWait (ms), Row0Wait (ms), Wall time (ms), Ref Wait Wall (ms), Total CTU time (ms),"
-                        "Stall Time (ms), Total frame time (ms), Avg WPP, Row Blocks");
+                        "Stall Time (ms), Total frame time (ms), Avg WPP, Row Blocks, Filter Time (ms), Filter Row Latency (ms)");
 #if ENABLE_LIBVMAF
                     fprintf(csvfp, ", VMAF Frame Score");
 #endif
@@ -1495,7 +1528,8 @@ void x265_csvlog_frame(const x265_param* param, const x265_picture* pic)
                                                                                      frameStats->totalCTUTime, frameStats->stallTime,
                                                                                      frameStats->totalFrameTime);
 
-        fprintf(param->csvfpt, " %.3lf, %d", frameStats->avgWPP, frameStats->countRowBlocks);
+        fprintf(param->csvfpt, " %.3lf, %d, %.1lf, %.1lf", frameStats->avgWPP, frameStats->countRowBlocks,
+                                                           frameStats->filterTime, frameStats->filterRowLatency);
 #if ENABLE_LIBVMAF
         fprintf(param->csvfpt, ", %lf", frameStats->vmafFrameScore);
 #endif
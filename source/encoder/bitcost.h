@@ -57,6 +57,9 @@ public:
                           s_bitsizes[mv.y - mvp.y] + 0.5f);
     }
 
+    /* compute the process-wide cost tables of qp ahead of its first use */
+    static void prepare(unsigned int qp)            { BitCost bc; bc.setQP(qp); }
+
     static void destroy();
 
 protected:
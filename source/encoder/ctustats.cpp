@@ -0,0 +1,135 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "frame.h"
+#include "framedata.h"
+#include "ctustats.h"
+
+using namespace X265_NS;
+
+namespace {
+
+#define CTU_RECORD_SIZE 16
+
+inline uint8_t* putLE32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+}
+
+CTUStatsWriter::CTUStatsWriter()
+{
+    m_file = NULL;
+    m_filename = NULL;
+    m_bHeatmap = false;
+    m_numCols = m_numRows = 0;
+    m_buf = NULL;
+}
+
+CTUStatsWriter::~CTUStatsWriter()
+{
+    if (m_file)
+        fclose(m_file);
+    X265_FREE(m_buf);
+}
+
+bool CTUStatsWriter::open(const x265_param& param, uint32_t numCols, uint32_t numRows)
+{
+    m_filename = param.ctuStatsFile;
+    m_bHeatmap = !!param.bCtuHeatmap;
+    m_numCols = numCols;
+    m_numRows = numRows;
+
+    m_buf = X265_MALLOC(uint8_t, X265_MAX(numCols * numRows * CTU_RECORD_SIZE, 32));
+    m_file = x265_fopen(m_filename, "wb");
+    if (!m_buf || !m_file)
+    {
+        x265_log_file(&param, X265_LOG_ERROR, "unable to open CTU statistics file <%s>\n", m_filename);
+        return false;
+    }
+
+    uint8_t* p = m_buf;
+    memcpy(p, "x265ctu1", 8);
+    p = putLE32(p + 8, param.sourceWidth);
+    p = putLE32(p, param.sourceHeight);
+    p = putLE32(p, param.maxCUSize);
+    p = putLE32(p, numCols);
+    p = putLE32(p, numRows);
+    return fwrite(m_buf, p - m_buf, 1, m_file) == 1;
+}
+
+void CTUStatsWriter::writeFrame(const Frame& frame, int encodeOrder)
+{
+    const FrameData::CTUCost* cost = frame.m_encData->m_ctuCost;
+    uint32_t numCUs = m_numCols * m_numRows;
+
+    uint8_t* p = m_buf;
+    p = putLE32(p, frame.m_poc);
+    p = putLE32(p, encodeOrder);
+    p = putLE32(p, frame.m_lowres.sliceType);
+    fwrite(m_buf, p - m_buf, 1, m_file);
+
+    p = m_buf;
+    for (uint32_t i = 0; i < numCUs; i++)
+    {
+        p = putLE32(p, cost[i].elapsedTime);
+        p = putLE32(p, cost[i].rdEvals);
+        p = putLE32(p, cost[i].meSearches);
+        p = putLE32(p, cost[i].minDepth | (cost[i].maxDepth << 8) | (cost[i].numEncodes << 16));
+    }
+    fwrite(m_buf, p - m_buf, 1, m_file);
+
+    if (m_bHeatmap)
+        writeHeatmap(frame);
+}
+
+/* one pixel per CTU, the slowest CTU of the frame is white */
+void CTUStatsWriter::writeHeatmap(const Frame& frame)
+{
+    const FrameData::CTUCost* cost = frame.m_encData->m_ctuCost;
+    uint32_t numCUs = m_numCols * m_numRows;
+
+    uint32_t maxTime = 1;
+    for (uint32_t i = 0; i < numCUs; i++)
+        maxTime = X265_MAX(maxTime, cost[i].elapsedTime);
+    for (uint32_t i = 0; i < numCUs; i++)
+        m_buf[i] = (uint8_t)(((uint64_t)cost[i].elapsedTime * 255 + maxTime / 2) / maxTime);
+
+    char* name = X265_MALLOC(char, strlen(m_filename) + 16);
+    if (!name)
+        return;
+    sprintf(name, "%s.%d.pgm", m_filename, frame.m_poc);
+    FILE* fp = x265_fopen(name, "wb");
+    if (fp)
+    {
+        fprintf(fp, "P5\n%u %u\n255\n", m_numCols, m_numRows);
+        fwrite(m_buf, numCUs, 1, fp);
+        fclose(fp);
+    }
+    else
+        x265_log_file(NULL, X265_LOG_ERROR, "unable to open CTU heatmap file <%s>\n", name);
+    X265_FREE(name);
+}
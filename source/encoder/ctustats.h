@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_CTUSTATS_H
+#define X265_CTUSTATS_H
+
+#include "common.h"
+
+namespace X265_NS {
+// private namespace
+
+class Frame;
+
+/* Writes the analysis effort of every CTU of every output frame
+ * (FrameData::CTUCost) to param.ctuStatsFile, and optionally one PGM heatmap
+ * of the CTU compression times per frame. The file starts with the magic
+ * "x265ctu1" and the little-endian 32bit words: picture width, height, CTU
+ * size, CTU columns and rows. Each frame follows in output order as POC,
+ * encode order, slice type (X265_TYPE_*) and then one record per CTU in
+ * raster order: compression time in microseconds, RD evaluations, motion
+ * searches, and the minimum CU depth in the low byte, maximum depth in the
+ * second byte and number of compressions in the third byte of the last word.
+ * The first three words add up all compressions of a CTU which VBV re-encoded */
+class CTUStatsWriter
+{
+public:
+
+    CTUStatsWriter();
+    ~CTUStatsWriter();
+
+    bool open(const x265_param& param, uint32_t numCols, uint32_t numRows);
+
+    void writeFrame(const Frame& frame, int encodeOrder);
+
+protected:
+
+    FILE*       m_file;
+    const char* m_filename;
+    bool        m_bHeatmap;
+    uint32_t    m_numCols;
+    uint32_t    m_numRows;
+    uint8_t*    m_buf;       // one frame of records, or one heatmap
+
+    void writeHeatmap(const Frame& frame);
+};
+}
+
+#endif // ifndef X265_CTUSTATS_H
@@ -100,6 +100,7 @@ void DPB::recycleUnreferenced()
                     curFrame->m_encData->m_meBuffer[i] = NULL;
                 }
             }
+            curFrame->m_encData->m_subpelCache.release();
             if (curFrame->m_ctuInfo != NULL)
             {
                 uint32_t widthInCU = (curFrame->m_param->sourceWidth + curFrame->m_param->maxCUSize - 1) >> curFrame->m_param->maxLog2CUSize;
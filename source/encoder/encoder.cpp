@@ -39,6 +39,8 @@
 #include "ratecontrol.h"
 #include "dpb.h"
 #include "nal.h"
+#include "latencytrace.h"
+#include "ctustats.h"
 
 #include "x265.h"
 
@@ -98,6 +100,10 @@ Encoder::Encoder()
     m_numChromaWPFrames = 0;
     m_numLumaWPBiFrames = 0;
     m_numChromaWPBiFrames = 0;
+    m_meSearches = 0;
+    m_meSearchSteps = 0;
+    m_specSubCUs = 0;
+    m_specRetries = 0;
     m_lookahead = NULL;
     m_rateControl = NULL;
     m_dpb = NULL;
@@ -107,6 +113,12 @@ Encoder::Encoder()
     m_param = NULL;
     m_latestParam = NULL;
     m_threadPool = NULL;
+    m_context = NULL;
+    m_latencyTrace = NULL;
+    m_ctuStats = NULL;
+    m_bAttached = false;
+    m_poolTimeStart = 0;
+    m_deadlineBudget = 0;
     m_analysisFileIn = NULL;
     m_analysisFileOut = NULL;
     m_naluFile = NULL;
@@ -135,6 +147,9 @@ Encoder::Encoder()
     m_startPoint = 0;
     m_saveCTUSize = 0;
     m_edgePic = NULL;
+    m_arenaFootprint = 0;
+    memset(&m_arenaStats, 0, sizeof(m_arenaStats));
+    m_subpelBudget.bytesLeft = 0;
     m_edgeHistThreshold = 0;
     m_chromaHistThreshold = 0.0;
     m_scaledEdgeThreshold = 0.0;
@@ -254,11 +269,24 @@ void Encoder::create()
     bool allowPools = !p->numaPools || strcmp(p->numaPools, "none");
 
     // Trim the thread pool if --wpp, --pme, and --pmode are disabled
-    if (!p->bEnableWavefront && !p->bDistributeModeAnalysis && !p->bDistributeMotionEstimation && !p->lookaheadSlices)
+    if (!p->bEnableWavefront && !p->bDistributeModeAnalysis && !p->bDistributeMotionEstimation && !p->lookaheadSlices && !p->bSpeculativeSplit)
         allowPools = false;
 
     m_numPools = 0;
-    if (allowPools)
+    if (p->context)
+    {
+        /* borrow the worker threads of the shared context */
+        m_context = static_cast<EncoderContext*>(p->context);
+        m_context->acquire();
+        if (allowPools && m_context->m_numPools)
+        {
+            m_threadPool = m_context->m_threadPool;
+            m_numPools = m_context->m_numPools;
+        }
+        if (!p->frameNumThreads)
+            ThreadPool::getFrameThreadsCount(p, m_numPools ? m_context->m_numWorkers : ThreadPool::getCpuCount());
+    }
+    else if (allowPools)
         m_threadPool = ThreadPool::allocThreadPools(p, m_numPools, 0);
     else
     {
@@ -281,9 +309,17 @@ void Encoder::create()
             x265_log(p, X265_LOG_WARNING, "No thread pool allocated, --pmode disabled\n");
         if (p->lookaheadSlices)
             x265_log(p, X265_LOG_WARNING, "No thread pool allocated, --lookahead-slices disabled\n");
+        if (p->bSpeculativeSplit)
+            x265_log(p, X265_LOG_WARNING, "No thread pool allocated, --speculative-split disabled\n");
 
         // disable all pool features if the thread pool is disabled or unusable.
-        p->bEnableWavefront = p->bDistributeModeAnalysis = p->bDistributeMotionEstimation = p->lookaheadSlices = 0;
+        p->bEnableWavefront = p->bDistributeModeAnalysis = p->bDistributeMotionEstimation = p->lookaheadSlices = p->bSpeculativeSplit = 0;
+    }
+
+    if (p->filterLag && !p->bEnableWavefront)
+    {
+        x265_log(p, X265_LOG_WARNING, "--filter-lag requires WPP, disabled\n");
+        p->filterLag = 0;
     }
 
     x265_log(p, X265_LOG_INFO, "Slices                              : %d\n", p->maxSlices);
@@ -296,28 +332,50 @@ void Encoder::create()
         len += sprintf(buf + len, "%spmode", len ? "+" : "");
     if (p->bDistributeMotionEstimation)
         len += sprintf(buf + len, "%spme ", len ? "+" : "");
+    if (p->bSpeculativeSplit)
+        len += sprintf(buf + len, "%sspeculative-split", len ? "+" : "");
     if (!len)
         strcpy(buf, "none");
 
     x265_log(p, X265_LOG_INFO, "frame threads / pool features       : %d / %s\n", p->frameNumThreads, buf);
 
+    /* the per-frame buffers are first allocated below (analysis pools) and
+     * when the first pictures are queued, so the arena must be sized now */
+    if (p->bFrameArena)
+    {
+        m_arenaFootprint = FrameArena::acquire(*p);
+        FrameArena::getStats(m_arenaStats);
+    }
+    m_subpelBudget.bytesLeft = (int64_t)p->subpelCacheSize << 20;
+
     for (int i = 0; i < m_param->frameNumThreads; i++)
     {
         m_frameEncoder[i] = new FrameEncoder;
         m_frameEncoder[i]->m_nalList.m_annexB = !!m_param->bAnnexB;
     }
 
+    /* on shared pools all job providers of this encoder are scheduled as
+     * one group, weighted against the other encoders */
+    JobProviderGroup* group = m_context ? &m_providerGroup : NULL;
+    m_providerGroup.m_weight = p->poolWeight;
+    bool bAttachFailed = false;
     if (m_numPools)
     {
+        m_bAttached = true;
         for (int i = 0; i < m_param->frameNumThreads; i++)
         {
             int pool = i % m_numPools;
+            m_frameEncoder[i]->m_group = group;
             m_frameEncoder[i]->m_pool = &m_threadPool[pool];
-            m_frameEncoder[i]->m_jpId = m_threadPool[pool].m_numProviders++;
-            m_threadPool[pool].m_jpTable[m_frameEncoder[i]->m_jpId] = m_frameEncoder[i];
+            m_frameEncoder[i]->m_jpId = i / m_numPools;
+            if (!m_threadPool[pool].attach(*m_frameEncoder[i]))
+                bAttachFailed = true;
+        }
+        if (!m_context)
+        {
+            for (int i = 0; i < m_numPools; i++)
+                m_threadPool[i].start();
         }
-        for (int i = 0; i < m_numPools; i++)
-            m_threadPool[i].start();
     }
     else
     {
@@ -349,13 +407,38 @@ void Encoder::create()
     m_lookahead = new Lookahead(m_param, lookAheadThreadPool);
     if (pools)
     {
-        m_lookahead->m_jpId = lookAheadThreadPool[0].m_numProviders++;
-        lookAheadThreadPool[0].m_jpTable[m_lookahead->m_jpId] = m_lookahead;
+        if (lookAheadThreadPool == m_threadPool)
+            m_lookahead->m_group = group;
+        m_lookahead->m_jpId = lookAheadThreadPool[0].m_numProviders;
+        if (!lookAheadThreadPool[0].attach(*m_lookahead))
+            bAttachFailed = true;
     }
     if (m_param->lookaheadThreads > 0)
         for (int i = 0; i < pools; i++)
             lookAheadThreadPool[i].start();
     m_lookahead->m_numPools = pools;
+
+    if (m_numPools && m_param->filterLag)
+    {
+        /* loop filter stages are registered after the frame encoders and the
+         * lookahead so they do not disturb the jpId indexed frame encoder data */
+        for (int i = 0; i < m_param->frameNumThreads; i++)
+        {
+            FrameFilter::FilterStage& stage = m_frameEncoder[i]->m_frameFilter.m_stage;
+            ThreadPool* pool = m_frameEncoder[i]->m_pool;
+            stage.m_group = group;
+            stage.m_jpId = pool->m_numProviders;
+            if (!pool->attach(stage))
+                bAttachFailed = true;
+        }
+    }
+
+    if (bAttachFailed)
+    {
+        x265_log(m_param, X265_LOG_ERROR, "unable to attach to the thread pools\n");
+        m_aborted = true;
+    }
+    m_poolTimeStart = getPoolWorkerTime();
     m_dpb = new DPB(m_param);
     m_rateControl = new RateControl(*m_param, this);
     if (!m_param->bResetZoneConfig)
@@ -521,7 +604,36 @@ void Encoder::create()
     m_bZeroLatency = !m_param->bframes && !m_param->lookaheadDepth && m_param->frameNumThreads == 1 && m_param->maxSlices == 1;
     m_aborted |= parseLambdaFile(m_param);
 
+    if (m_param->deadlineLatency)
+        m_deadlineBudget = (int64_t)m_param->deadlineLatency * 1000;
+    else
+    {
+        /* the frames the encoder holds before it can output a picture */
+        int frames = m_param->lookaheadDepth + m_param->bframes + m_param->frameNumThreads + 1;
+        m_deadlineBudget = (int64_t)frames * 1000000 * m_param->fpsDenom / m_param->fpsNum;
+    }
+
     m_encodeStartTime = x265_mdate();
+#if ENABLE_EVENT_STATS
+    m_eventStatsStart.get();
+#endif
+
+    if (m_param->latencyTraceFrames)
+    {
+        m_latencyTrace = new LatencyTrace;
+        if (!m_latencyTrace->init(m_param->latencyTraceFrames, m_encodeStartTime))
+        {
+            x265_log(m_param, X265_LOG_ERROR, "unable to allocate latency trace\n");
+            m_aborted = true;
+        }
+    }
+
+    if (m_param->ctuStatsFile)
+    {
+        m_ctuStats = new CTUStatsWriter;
+        if (!m_ctuStats->open(*m_param, numCols, numRows))
+            m_aborted = true;
+    }
 
     m_nalList.m_annexB = !!m_param->bAnnexB;
 
@@ -575,13 +687,47 @@ void Encoder::stopJobs()
         }
     }
 
-    if (m_threadPool)
+    if (m_context)
+        detachJobProviders();
+    else if (m_threadPool)
     {
         for (int i = 0; i < m_numPools; i++)
             m_threadPool[i].stopWorkers();
     }
 }
 
+/* Remove this encoder's job providers from the shared thread pools. They
+ * must have no pending work, the pools keep running for other encoders */
+void Encoder::detachJobProviders()
+{
+    if (!m_bAttached)
+        return;
+
+    for (int i = 0; i < m_param->frameNumThreads; i++)
+    {
+        if (!m_frameEncoder[i] || !m_frameEncoder[i]->m_pool)
+            continue;
+        m_frameEncoder[i]->m_pool->detach(*m_frameEncoder[i]);
+        if (m_frameEncoder[i]->m_frameFilter.m_stage.m_pool)
+            m_frameEncoder[i]->m_frameFilter.m_stage.m_pool->detach(m_frameEncoder[i]->m_frameFilter.m_stage);
+    }
+    if (m_lookahead && m_lookahead->m_pool && m_param->lookaheadThreads <= 0)
+        m_lookahead->m_pool->detach(*m_lookahead);
+    m_bAttached = false;
+}
+
+void Encoder::releaseContext()
+{
+    if (!m_context)
+        return;
+
+    detachJobProviders();
+    m_context->release();
+    m_context = NULL;
+    m_threadPool = NULL;
+    m_numPools = 0;
+}
+
 int Encoder::copySlicetypePocAndSceneCut(int *slicetype, int *poc, int *sceneCut)
 {
     Frame *FramePtr = m_dpb->m_picList.getCurFrame();
@@ -852,6 +998,16 @@ void Encoder::destroy()
         m_exportedPic = NULL;
     }
 
+    if (m_latencyTrace)
+    {
+        if (m_param->latencyTraceFile)
+            m_latencyTrace->write(m_param->latencyTraceFile);
+        delete m_latencyTrace;
+        m_latencyTrace = NULL;
+    }
+    delete m_ctuStats;
+    m_ctuStats = NULL;
+
     if (m_param->bEnableFrameDuplication)
     {
         for (uint32_t i = 0; i < DUP_BUFFER; i++)
@@ -910,7 +1066,10 @@ void Encoder::destroy()
 
     // thread pools can be cleaned up now that all the JobProviders are
     // known to be shutdown
-    delete [] m_threadPool;
+    if (m_context)
+        releaseContext();
+    else
+        delete [] m_threadPool;
 
     if (m_lookahead)
     {
@@ -967,6 +1126,10 @@ void Encoder::destroy()
 #ifdef SVT_HEVC
     X265_FREE(m_svtAppData);
 #endif
+
+    /* all frames and frame encoders are gone, their buffers are cached */
+    if (m_arenaFootprint)
+        FrameArena::release(m_arenaFootprint);
     if (m_param)
     {
         if (m_param->csvfpt)
@@ -977,6 +1140,8 @@ void Encoder::destroy()
         free((char*)m_param->analysisReuseFileName);
         free((char*)m_param->scalingLists);
         free((char*)m_param->csvfn);
+        free((char*)m_param->latencyTraceFile);
+        free((char*)m_param->ctuStatsFile);
         free((char*)m_param->numaPools);
         free((char*)m_param->masteringDisplayColorVolume);
         free((char*)m_param->toneMapFile);
@@ -1985,6 +2150,7 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
     else
         m_lookahead->flush();
 
+    int curEncoderIdx = m_curEncoder;
     FrameEncoder *curEncoder = m_frameEncoder[m_curEncoder];
     m_curEncoder = (m_curEncoder + 1) % m_param->frameNumThreads;
     int ret = 0;
@@ -2164,8 +2330,17 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
             if (m_aborted)
                 return -1;
 
+            m_meSearches += outFrame->m_encData->m_frameStats.meSearches;
+            m_meSearchSteps += outFrame->m_encData->m_frameStats.meSearchSteps;
+            m_specSubCUs += outFrame->m_encData->m_frameStats.specSubCUs;
+            m_specRetries += outFrame->m_encData->m_frameStats.specRetries;
+
             if ((m_outputCount + 1)  >= m_param->chunkStart)
                 finishFrameStats(outFrame, curEncoder, frameData, m_pocLast);
+            if (m_latencyTrace)
+                m_latencyTrace->record(*outFrame, *curEncoder, curEncoderIdx, m_outputCount);
+            if (m_ctuStats)
+                m_ctuStats->writeFrame(*outFrame, m_outputCount);
             if (m_param->analysisSave)
             {
                 pic_out->analysisData.frameBits = frameData->bits;
@@ -2358,6 +2533,8 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
                         x265_log(m_param, X265_LOG_ERROR, "SEA motion search: POC %d Integral buffer[%d] unallocated\n", frameEnc->m_poc, i);
                 }
             }
+            if (m_param->subpelCacheSize)
+                frameEnc->m_encData->m_subpelCache.bind(*frameEnc->m_reconPic, frameEnc->m_reconRowFlag, m_subpelBudget);
 
             if (m_param->bOptQpPPS && frameEnc->m_lowres.bKeyframe && m_param->bRepeatHeaders)
             {
@@ -2741,6 +2918,15 @@ void Encoder::printSummary()
 
         x265_log(m_param, X265_LOG_INFO, "consecutive B-frames: %s\n", buffer);
     }
+    if (m_meSearches && (m_param->bMVField || m_param->logLevel >= X265_LOG_FULL))
+    {
+        /* compare against an encode without --mv-field for the steps saved */
+        x265_log(m_param, X265_LOG_INFO, "motion search: " X265_LL " searches, %.2f integer search steps per search%s\n",
+                 m_meSearches, (double)m_meSearchSteps / m_meSearches, m_param->bMVField ? " (mv-field)" : "");
+    }
+    if (m_specSubCUs)
+        x265_log(m_param, X265_LOG_INFO, "speculative split: " X265_LL " sub-CUs, %.1f%% analysed again\n",
+                 m_specSubCUs, 100. * m_specRetries / m_specSubCUs);
     if (m_param->bLossless)
     {
         float frameSize = (float)(m_param->sourceWidth - m_sps.conformanceWindow.rightOffset) *
@@ -2757,6 +2943,29 @@ void Encoder::printSummary()
             (float)100.0 * (m_rateControl->m_numEntries - m_rpsInSpsCount) / m_rateControl->m_numEntries);
     }
 
+    if (m_arenaFootprint)
+    {
+        FrameArena::Stats stats;
+        FrameArena::getStats(stats);
+        uint64_t allocs = stats.numAllocs - m_arenaStats.numAllocs;
+        uint64_t reused = stats.numReused - m_arenaStats.numReused;
+        x265_log(m_param, X265_LOG_INFO, "frame arena: %.1f%% of %u buffers reused, limit %.1f MB\n",
+                 allocs ? 100.0 * reused / allocs : 0.0, (uint32_t)allocs, (double)stats.retainLimit / (1024 * 1024));
+    }
+
+    if (m_param->bDeadlineSched)
+    {
+        uint32_t misses = 0;
+        for (int i = 0; i < m_param->frameNumThreads; i++)
+            misses += m_frameEncoder[i]->m_deadlineMisses;
+        x265_log(m_param, X265_LOG_INFO, "deadline scheduling: %u of %u frames missed their output deadline\n",
+                 misses, m_analyzeAll.m_numPics);
+    }
+
+    if (m_context && m_numPools)
+        x265_log(m_param, X265_LOG_INFO, "shared pool: %.1f%% of worker time (%.2f s) at weight %d\n",
+                 100.0 * getPoolShare(), (double)m_providerGroup.m_workerTime / 1000000, m_providerGroup.m_weight);
+
     if (m_param->totalFrames && (uint32_t)m_param->totalFrames > m_analyzeAll.m_numPics)
         x265_log(m_param, X265_LOG_ERROR, "not all %d frames encoded.\n", m_param->totalFrames);
     if (m_analyzeAll.m_numPics)
@@ -2784,6 +2993,22 @@ void Encoder::printSummary()
     else
         general_log(m_param, NULL, X265_LOG_INFO, "\nencoded 0 frames\n");
 
+#if ENABLE_EVENT_STATS
+    /* Counted over the lifetime of this encoder, but in all threads of the
+     * process; the times of nested events are included in their parents */
+    EventStats eventStats;
+    eventStats.get();
+    for (int i = 0; i < NUM_EVENT_STATS; i++)
+    {
+        uint64_t calls = eventStats.count[i] - m_eventStatsStart.count[i];
+        if (!calls)
+            continue;
+        double secs = eventStats.seconds(m_eventStatsStart, i);
+        x265_log(m_param, X265_LOG_INFO, "event %-18s " X265_LL " calls, %.3fs %.2fus/call\n",
+                 EventStats::name(i), calls, secs, secs * 1000000 / calls);
+    }
+#endif
+
 #if DETAILED_CU_STATS
     /* Summarize stats from all frame encoders */
     CUStats cuStats;
@@ -2994,6 +3219,32 @@ void Encoder::fetchStats(x265_stats *stats, size_t statsSizeBytes)
     /* If new statistics are added to x265_stats, we must check here whether the
      * structure provided by the user is the new structure or an older one (for
      * future safety) */
+    if (statsSizeBytes >= sizeof(x265_stats))
+    {
+        stats->workerTime = (double)m_providerGroup.m_workerTime / 1000000;
+        stats->poolShare = m_context && m_numPools ? getPoolShare() : 0;
+        stats->deadlineMisses = 0;
+        for (int i = 0; i < m_param->frameNumThreads; i++)
+            stats->deadlineMisses += m_frameEncoder[i]->m_deadlineMisses;
+    }
+}
+
+/* worker microseconds charged on all pools this encoder uses, by any
+ * encoder attached to them */
+int64_t Encoder::getPoolWorkerTime() const
+{
+    int64_t total = 0;
+    for (int i = 0; i < m_numPools; i++)
+        total += m_threadPool[i].m_workerTime;
+    return total;
+}
+
+/* fraction of the shared pools' worker time this encoder received since it
+ * was opened */
+double Encoder::getPoolShare() const
+{
+    int64_t poolTime = getPoolWorkerTime() - m_poolTimeStart;
+    return poolTime > 0 ? (double)m_providerGroup.m_workerTime / poolTime : 0;
 }
 
 void Encoder::finishFrameStats(Frame* curFrame, FrameEncoder *curEncoder, x265_frame_stats* frameStats, int inPoc)
@@ -3126,6 +3377,8 @@ void Encoder::finishFrameStats(Frame* curFrame, FrameEncoder *curEncoder, x265_f
             else
                 frameStats->avgWPP = 1;
             frameStats->countRowBlocks = curEncoder->m_countRowBlocks;
+            frameStats->filterTime = ELAPSED_MSEC(0, curEncoder->m_frameFilter.filterElapsedTime());
+            frameStats->filterRowLatency = ELAPSED_MSEC(0, curEncoder->m_frameFilter.rowLatencySum()) / curEncoder->m_numRows;
 
             frameStats->avgChromaDistortion = curFrame->m_encData->m_frameStats.avgChromaDistortion;
             frameStats->avgLumaDistortion = curFrame->m_encData->m_frameStats.avgLumaDistortion;
@@ -3904,6 +4157,26 @@ void Encoder::configure(x265_param *p)
         p->bDistributeModeAnalysis = 0;
     }
 
+    if (p->bSpeculativeSplit)
+    {
+        const char* conflict = NULL;
+        if (p->rdLevel < 2 || p->rdLevel > 4)
+            conflict = "rd levels other than 2 to 4";
+        else if (p->bDistributeModeAnalysis)
+            conflict = "--pmode";
+        else if (p->bLossless || p->bCULossless)
+            conflict = "lossless coding";
+        else if (p->analysisLoad || p->analysisSave || p->analysisMultiPassRefine || p->analysisMultiPassDistortion)
+            conflict = "analysis reuse";
+        else if (p->bCTUInfo || p->bDynamicRefine)
+            conflict = "--ctu-info and --dynamic-refine";
+        if (conflict)
+        {
+            x265_log(p, X265_LOG_WARNING, "--speculative-split is not supported with %s, disabled\n", conflict);
+            p->bSpeculativeSplit = 0;
+        }
+    }
+
     if (!p->rc.bStatWrite && !p->rc.bStatRead && (p->analysisMultiPassRefine || p->analysisMultiPassDistortion))
     {
         x265_log(p, X265_LOG_WARNING, "analysis-multi-pass/distortion is enabled only when rc multi pass is enabled. Disabling multi-pass-opt-analysis and multi-pass-opt-distortion\n");
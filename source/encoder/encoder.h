@@ -31,6 +31,8 @@
 #include "x265.h"
 #include "nal.h"
 #include "framedata.h"
+#include "framearena.h"
+#include "encodercontext.h"
 #include "svt.h"
 #ifdef ENABLE_HDR10_PLUS
     #include "dynamicHDR10/hdr10plus.h"
@@ -161,6 +163,8 @@ class DPB;
 class Lookahead;
 class RateControl;
 class ThreadPool;
+class LatencyTrace;
+class CTUStatsWriter;
 class FrameData;
 
 #define MAX_SCENECUT_THRESHOLD 1.0
@@ -181,6 +185,9 @@ public:
     int64_t            m_bframeDelayTime;
     int64_t            m_prevReorderedPts[2];
     int64_t            m_encodeStartTime;
+#if ENABLE_EVENT_STATS
+    EventStats         m_eventStatsStart;
+#endif
 
     int                m_pocLast;         // time index (POC)
     int                m_encodedFrameNum;
@@ -194,12 +201,24 @@ public:
     int                m_numChromaWPFrames;  // number of P frames with weighted chroma reference
     int                m_numLumaWPBiFrames;  // number of B frames with weighted luma reference
     int                m_numChromaWPBiFrames; // number of B frames with weighted chroma reference
+
+    uint64_t           m_meSearches;         // motion searches of all output frames
+    uint64_t           m_meSearchSteps;      // integer pattern search steps of those searches
+    uint64_t           m_specSubCUs;         // sub-CUs analysed speculatively, see param.bSpeculativeSplit
+    uint64_t           m_specRetries;        // of those, sub-CUs analysed again
     int                m_conformanceMode;
     int                m_lastBPSEI;
     uint32_t           m_numDelayedPic;
 
     ThreadPool*        m_threadPool;
+    EncoderContext*    m_context;          // shared context owning m_threadPool, or NULL
+    bool               m_bAttached;        // job providers are attached to the shared pools
+    JobProviderGroup   m_providerGroup;    // weight and worker time of this encoder on shared pools
+    int64_t            m_poolTimeStart;    // pool worker time when this encoder was opened
+    int64_t            m_deadlineBudget;   // output latency budget of deadline scheduling, in us
     FrameEncoder*      m_frameEncoder[X265_MAX_FRAME_THREADS];
+    LatencyTrace*      m_latencyTrace;     // per-frame stage timestamps, or NULL
+    CTUStatsWriter*    m_ctuStats;         // per-CTU analysis effort file, or NULL
     DPB*               m_dpb;
     Frame*             m_exportedPic;
     FILE*              m_analysisFileIn;
@@ -256,6 +275,13 @@ public:
     int                m_bToneMap; // Enables tone-mapping
     int                m_enableNal;
 
+    /* Frame arena reference held by this encoder (bFrameArena) */
+    uint64_t           m_arenaFootprint;
+    FrameArena::Stats  m_arenaStats;
+
+    /* memory left for the sub-pel caches of the frames (subpelCacheSize) */
+    SubpelCache::Budget m_subpelBudget;
+
     /* For histogram based scene-cut detection */
     pixel*             m_edgePic;
     pixel*             m_inputPic[3];
@@ -308,6 +334,10 @@ public:
     void create();
     void stopJobs();
     void destroy();
+    void detachJobProviders();
+    void releaseContext();
+    int64_t getPoolWorkerTime() const;
+    double getPoolShare() const;
 
     int encode(const x265_picture* pic, x265_picture *pic_out);
 
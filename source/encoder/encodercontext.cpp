@@ -0,0 +1,104 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include "param.h"
+#include "bitcost.h"
+#include "encodercontext.h"
+
+using namespace X265_NS;
+
+EncoderContext::EncoderContext()
+{
+    m_threadPool = NULL;
+    m_numPools = 0;
+    m_numWorkers = 0;
+    m_refCount = 1;
+    m_param = NULL;
+}
+
+EncoderContext::~EncoderContext()
+{
+    if (m_threadPool)
+    {
+        for (int i = 0; i < m_numPools; i++)
+            m_threadPool[i].stopWorkers();
+        delete [] m_threadPool;
+    }
+
+    if (m_param)
+    {
+        free((char*)m_param->numaPools);
+        PARAM_NS::x265_param_free(m_param);
+    }
+}
+
+EncoderContext* EncoderContext::create(x265_param* p)
+{
+    EncoderContext* ctx = new EncoderContext;
+    x265_param* param = PARAM_NS::x265_param_alloc();
+    if (!param)
+    {
+        delete ctx;
+        return NULL;
+    }
+
+    /* the pool allocator may adjust thread counts, work on a private copy */
+    PARAM_NS::x265_param_default(param);
+    param->cpuid = p->cpuid;
+    param->logLevel = p->logLevel;
+    param->logfn = p->logfn;
+    param->numaPools = p->numaPools ? strdup(p->numaPools) : NULL;
+    param->frameNumThreads = p->frameNumThreads;
+    param->lookaheadThreads = 0;
+    ctx->m_param = param;
+
+    x265_setup_primitives(param);
+
+    /* the MV cost logs and the lookahead's lambda table are used by every
+     * encoder; the per-QP tables of the frame encoders remain lazy but are
+     * equally retained for the lifetime of the process */
+    BitCost::prepare(X265_LOOKAHEAD_QP);
+
+    if (!param->numaPools || strcmp(param->numaPools, "none"))
+    {
+        ctx->m_threadPool = ThreadPool::allocThreadPools(param, ctx->m_numPools, 0, true);
+        for (int i = 0; i < ctx->m_numPools; i++)
+        {
+            if (!ctx->m_threadPool[i].start())
+            {
+                x265_log(param, X265_LOG_ERROR, "unable to start shared thread pool\n");
+                delete ctx;
+                return NULL;
+            }
+            ctx->m_numWorkers += ctx->m_threadPool[i].m_numWorkers;
+        }
+    }
+
+    return ctx;
+}
+
+void EncoderContext::release()
+{
+    if (!ATOMIC_DEC(&m_refCount))
+        delete this;
+}
@@ -0,0 +1,61 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_ENCODERCONTEXT_H
+#define X265_ENCODERCONTEXT_H
+
+#include "common.h"
+#include "threadpool.h"
+#include "x265.h"
+
+struct x265_context {};
+namespace X265_NS {
+// private namespace
+
+/* Process-wide state shared by every encoder opened with param->context.
+ * The context is reference counted; the application holds one reference
+ * from x265_context_create() until x265_context_free() and each encoder
+ * holds one from create() until destroy(). The thread pools are stopped and
+ * released with the last reference, at which point no job provider can be
+ * attached to them any longer */
+class EncoderContext : public x265_context
+{
+public:
+
+    ThreadPool*  m_threadPool;
+    int          m_numPools;
+    int          m_numWorkers;  // total worker threads of all pools
+    int          m_refCount;
+    x265_param*  m_param;
+
+    static EncoderContext* create(x265_param* p);
+
+    void acquire()  { ATOMIC_INC(&m_refCount); }
+    void release();
+
+protected:
+
+    EncoderContext();
+    ~EncoderContext();
+};
+}
+
+#endif // ifndef X265_ENCODERCONTEXT_H
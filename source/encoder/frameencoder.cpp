@@ -45,6 +45,7 @@ FrameEncoder::FrameEncoder()
     m_isFrameEncoder = true;
     m_threadActive = true;
     m_slicetypeWaitTime = 0;
+    m_deadlineMisses = 0;
     m_activeWorkerCount = 0;
     m_completionCount = 0;
     m_outStreams = NULL;
@@ -70,7 +71,7 @@ void FrameEncoder::destroy()
         {
             int numTLD = m_pool->m_numWorkers;
             if (!m_param->bEnableWavefront)
-                numTLD += m_pool->m_numProviders;
+                numTLD += m_param->frameNumThreads;
             for (int i = 0; i < numTLD; i++)
                 m_tld[i].destroy();
             delete [] m_tld;
@@ -170,7 +171,14 @@ bool FrameEncoder::init(Encoder *top, int numRows, int numCols)
         m_pool = NULL;
     }
 
-    m_frameFilter.init(top, this, numRows, numCols);
+    ok &= m_frameFilter.init(top, this, numRows, numCols);
+
+    /* the pipelined filter stage trails CTU compression by the filter lag */
+    if (m_frameFilter.m_bPipelined)
+    {
+        m_filterRowDelay = X265_MAX(m_filterRowDelay, (uint32_t)m_param->filterLag);
+        m_filterRowDelayCus = m_filterRowDelay * numCols;
+    }
 
     // initialize HRD parameters of SPS
     if (m_param->bEmitHRDSEI || !!m_param->interlaceMode)
@@ -266,6 +274,7 @@ bool FrameEncoder::startCompressFrame(Frame* curFrame)
     m_slicetypeWaitTime = x265_mdate() - m_prevOutputTime;
     m_frame = curFrame;
     m_sliceType = curFrame->m_lowres.sliceType;
+    m_deadline = m_param->bDeadlineSched ? curFrame->m_encodeOrder : -1;
     curFrame->m_encData->m_frameEncoderID = m_jpId;
     curFrame->m_encData->m_jobProvider = this;
     curFrame->m_encData->m_slice->m_mref = m_mref;
@@ -290,12 +299,15 @@ void FrameEncoder::threadMain()
 
         /* the first FE on each NUMA node is responsible for allocating thread
          * local data for all worker threads in that pool. If WPP is disabled, then
-         * each FE also needs a TLD instance */
+         * each FE also needs a TLD instance, at m_numWorkers + m_jpId. m_jpId
+         * is the FE's index among this encoder's FEs on the pool, which is
+         * below frameNumThreads; the pool's provider count also includes the
+         * lookahead, the filter stages and the providers of other encoders */
         if (!m_jpId)
         {
             int numTLD = m_pool->m_numWorkers;
             if (!m_param->bEnableWavefront)
-                numTLD += m_pool->m_numProviders;
+                numTLD += m_param->frameNumThreads;
 
             m_tld = new ThreadLocalData[numTLD];
             for (int i = 0; i < numTLD; i++)
@@ -304,13 +316,13 @@ void FrameEncoder::threadMain()
                 m_tld[i].analysis.create(m_tld);
             }
 
-            for (int i = 0; i < m_pool->m_numProviders; i++)
+            /* the pool may be shared with the job providers of other
+             * encoders, so the peers are found through our own encoder */
+            for (int i = 0; i < m_param->frameNumThreads; i++)
             {
-                if (m_pool->m_jpTable[i]->m_isFrameEncoder) /* ugh; over-allocation and other issues here */
-                {
-                    FrameEncoder *peer = dynamic_cast<FrameEncoder*>(m_pool->m_jpTable[i]);
+                FrameEncoder *peer = m_top->m_frameEncoder[i];
+                if (peer->m_pool == m_pool)
                     peer->m_tld = m_tld;
-                }
             }
         }
 
@@ -552,7 +564,8 @@ void FrameEncoder::compressFrame()
             if ((bUseWeightP || bUseWeightB) && slice->m_weightPredTable[l][ref][0].wtPresent)
                 w = slice->m_weightPredTable[l][ref];
             slice->m_refReconPicList[l][ref] = slice->m_refFrameList[l][ref]->m_reconPic;
-            m_mref[l][ref].init(slice->m_refReconPicList[l][ref], w, *m_param);
+            SubpelCache* cache = m_param->subpelCacheSize ? &slice->m_refFrameList[l][ref]->m_encData->m_subpelCache : NULL;
+            m_mref[l][ref].init(slice->m_refReconPicList[l][ref], w, *m_param, cache);
         }
         if (m_param->analysisSave && (bUseWeightP || bUseWeightB))
         {
@@ -564,7 +577,7 @@ void FrameEncoder::compressFrame()
 
     int numTLD;
     if (m_pool)
-        numTLD = m_param->bEnableWavefront ? m_pool->m_numWorkers : m_pool->m_numWorkers + m_pool->m_numProviders;
+        numTLD = m_param->bEnableWavefront ? m_pool->m_numWorkers : m_pool->m_numWorkers + m_param->frameNumThreads;
     else
         numTLD = 1;
 
@@ -648,6 +661,8 @@ void FrameEncoder::compressFrame()
         if (!m_param->bEnableWavefront)
             m_backupStreams = new Bitstream[numSubstreams];
         m_substreamSizes = X265_MALLOC(uint32_t, numSubstreams);
+        if (m_substreamSizes)
+            memset(m_substreamSizes, 0, sizeof(uint32_t) * numSubstreams);
         if (!slice->m_bUseSao)
         {
             for (uint32_t i = 0; i < numSubstreams; i++)
@@ -658,7 +673,12 @@ void FrameEncoder::compressFrame()
     {
         for (uint32_t i = 0; i < numSubstreams; i++)
         {
+            /* size each row's stream for the escaped size of the same row of
+             * the previous frame plus some headroom, so high bitrate frames do
+             * not reallocate while the row is being coded */
             m_outStreams[i].resetBits();
+            if (m_substreamSizes)
+                m_outStreams[i].reserve(m_substreamSizes[i] + (m_substreamSizes[i] >> 2));
             if (!slice->m_bUseSao)
                 m_rows[i].rowGoOnCoder.setBitstream(&m_outStreams[i]);
             else
@@ -808,6 +828,9 @@ void FrameEncoder::compressFrame()
     if (m_param->bDynamicRefine)
         computeAvgTrainingData();
 
+    if (m_param->bMVField && !slice->isIntra())
+        m_frame->m_encData->buildMVField(m_frame->m_lowres);
+
     /* Analyze CTU rows, most of the hard work is done here.  Frame is
      * compressed in a wave-front pattern if WPP is enabled. Row based loop
      * filters runs behind the CTU compression and reconstruction */
@@ -859,8 +882,7 @@ void FrameEncoder::compressFrame()
                         // NOTE: we unnecessary wait row that beyond current slice boundary
                         const int rowIdx = X265_MIN(sliceEndRow, (row + m_refLagRows));
 
-                        while (refpic->m_reconRowFlag[rowIdx].get() == 0)
-                            refpic->m_reconRowFlag[rowIdx].waitForChange(0);
+                        waitForReferenceRow(*refpic, rowIdx, m_numRows - row);
 
                         if ((bUseWeightP || bUseWeightB) && m_mref[l][ref].isWeighted)
                             m_mref[l][ref].applyWeight(rowIdx, m_numRows, sliceEndRow, sliceId);
@@ -881,7 +903,11 @@ void FrameEncoder::compressFrame()
         tryWakeOne(); /* ensure one thread is active or help-wanted flag is set prior to blocking */
         static const int block_ms = 250;
         while (m_completionEvent.timedWait(block_ms))
+        {
             tryWakeOne();
+            if (m_frameFilter.m_bPipelined)
+                m_frameFilter.m_stage.tryWakeOne();
+        }
     }
     else
     {
@@ -899,8 +925,7 @@ void FrameEncoder::compressFrame()
                         Frame *refpic = slice->m_refFrameList[list][ref];
 
                         const int rowIdx = X265_MIN(m_numRows - 1, (i + m_refLagRows));
-                        while (refpic->m_reconRowFlag[rowIdx].get() == 0)
-                            refpic->m_reconRowFlag[rowIdx].waitForChange(0);
+                        waitForReferenceRow(*refpic, rowIdx, m_numRows - i);
 
                         if ((bUseWeightP || bUseWeightB) && m_mref[l][ref].isWeighted)
                             m_mref[list][ref].applyWeight(rowIdx, m_numRows, m_numRows, 0);
@@ -953,6 +978,14 @@ void FrameEncoder::compressFrame()
         m_frame->m_encData->m_frameStats.percent8x8Skip  = (double)totalSkip / totalCuCount;
     }
 
+    for (uint32_t i = 0; i < m_numRows; i++)
+    {
+        m_frame->m_encData->m_frameStats.meSearches += m_rows[i].rowStats.meSearches;
+        m_frame->m_encData->m_frameStats.meSearchSteps += m_rows[i].rowStats.meSearchSteps;
+        m_frame->m_encData->m_frameStats.specSubCUs += m_rows[i].rowStats.specSubCUs;
+        m_frame->m_encData->m_frameStats.specRetries += m_rows[i].rowStats.specRetries;
+    }
+
     if (m_param->csvLogLevel >= 1)
     {
         for (uint32_t i = 0; i < m_numRows; i++)
@@ -1517,9 +1550,18 @@ void FrameEncoder::processRowEncoder(int intRow, ThreadLocalData& tld)
         if (m_param->dynamicRd && (int32_t)(m_rce.qpaRc - m_rce.qpNoVbv) > 0)
             ctu->m_vbvAffected = true;
 
+        int64_t ctuStartTime = 0;
+        memset(&tld.analysis.m_ctuWork, 0, sizeof(tld.analysis.m_ctuWork));
+        memset(&tld.analysis.m_slaveWork, 0, sizeof(tld.analysis.m_slaveWork));
+        if (curEncData.m_ctuCost)
+            ctuStartTime = x265_mdate();
+
         // Does all the CU analysis, returns best top level mode decision
         Mode& best = tld.analysis.compressCTU(*ctu, *m_frame, m_cuGeoms[m_ctuGeomMap[cuAddr]], rowCoder);
 
+        if (curEncData.m_ctuCost)
+            collectCTUCost(*ctu, tld.analysis, curEncData.m_ctuCost[cuAddr], x265_mdate() - ctuStartTime);
+
         /* startPoint > encodeOrder is true when the start point changes for
         a new GOP but few frames from the previous GOP is still incomplete.
         The data of frames in this interval will not be used by any future frames. */
@@ -1546,7 +1588,8 @@ void FrameEncoder::processRowEncoder(int intRow, ThreadLocalData& tld)
         if (m_param->bEnableLoopFilter | slice->m_bUseSao)
         {
             // NOTE: in VBV mode, we may reencode anytime, so we can't do Deblock stage-Horizon and SAO
-            if (!bIsVbv)
+            //       with a pipelined filter stage, all filter work is left to that stage
+            if (!bIsVbv && !m_frameFilter.m_bPipelined)
             {
                 // Delay one row to avoid intra prediction conflict
                 if (m_pool && !bFirstRowInSlice)
@@ -1585,6 +1628,8 @@ void FrameEncoder::processRowEncoder(int intRow, ThreadLocalData& tld)
         }
 
         // Completed CU processing
+        if (col == numCols - 1)
+            curRow.endTime = x265_mdate();
         curRow.completed++;
 
         FrameStats frameLog;
@@ -1611,6 +1656,10 @@ void FrameEncoder::processRowEncoder(int intRow, ThreadLocalData& tld)
             }
         }
         curRow.rowStats.totalCtu++;
+        curRow.rowStats.meSearches       += tld.analysis.m_ctuWork.meSearches + tld.analysis.m_slaveWork.meSearches;
+        curRow.rowStats.meSearchSteps    += tld.analysis.m_ctuWork.meSearchSteps + tld.analysis.m_slaveWork.meSearchSteps;
+        curRow.rowStats.specSubCUs       += tld.analysis.m_ctuWork.specSubCUs;
+        curRow.rowStats.specRetries      += tld.analysis.m_ctuWork.specRetries;
         curRow.rowStats.lumaDistortion   += best.lumaDistortion;
         curRow.rowStats.chromaDistortion += best.chromaDistortion;
         curRow.rowStats.psyEnergy        += best.psyEnergy;
@@ -1862,7 +1911,7 @@ void FrameEncoder::processRowEncoder(int intRow, ThreadLocalData& tld)
 
 
     /* Processing left Deblock block with current threading */
-    if ((m_param->bEnableLoopFilter | slice->m_bUseSao) & (rowInSlice >= 2))
+    if ((m_param->bEnableLoopFilter | slice->m_bUseSao) & (rowInSlice >= 2) & !m_frameFilter.m_bPipelined)
     {
         /* Check conditional to start previous row process with current threading */
         if (m_frameFilter.m_parallelFilter[row - 2].m_lastDeblocked.get() == (int)numCols)
@@ -1874,7 +1923,28 @@ void FrameEncoder::processRowEncoder(int intRow, ThreadLocalData& tld)
     }
 
     /* trigger row-wise loop filters */
-    if (m_param->bEnableWavefront)
+    if (m_frameFilter.m_bPipelined)
+    {
+        FrameFilter::FilterStage& stage = m_frameFilter.m_stage;
+        const uint32_t sliceStartRow = m_sliceBaseRow[sliceId];
+
+        /* release the filter row trailing this row by the filter delay, the
+         * last row of a slice releases all remaining filter rows of the slice */
+        const uint32_t filterRow = rowInSlice >= m_filterRowDelay ? row - m_filterRowDelay : sliceStartRow;
+        if (bLastRowInSlice)
+        {
+            for (uint32_t i = filterRow; i <= row; i++)
+                stage.enableRow(i);
+        }
+        else if (rowInSlice >= m_filterRowDelay)
+            stage.enableRow(filterRow);
+
+        /* the first filter row of the slice starts the filter chain */
+        if (rowInSlice == m_filterRowDelay || (bLastRowInSlice && rowInSlice < m_filterRowDelay))
+            stage.enqueueRow(sliceStartRow);
+        stage.tryWakeOne();
+    }
+    else if (m_param->bEnableWavefront)
     {
         if (rowInSlice >= m_filterRowDelay)
         {
@@ -2005,6 +2075,32 @@ void FrameEncoder::computeAvgTrainingData()
     }
 }
 
+/* record the analysis effort of a CTU for the CTU statistics file; all pmode
+ * and pme slaves of the CTU have completed by the time compressCTU returns.
+ * The effort accumulates when VBV re-encodes the row, the depths are those
+ * of the final encode */
+void FrameEncoder::collectCTUCost(const CUData& ctu, const Analysis& analysis, FrameData::CTUCost& cost, int64_t elapsedTime)
+{
+    cost.elapsedTime = (uint32_t)X265_MIN(cost.elapsedTime + elapsedTime, (int64_t)0xffffffff);
+    cost.rdEvals += analysis.m_ctuWork.rdEvals + analysis.m_slaveWork.rdEvals;
+    cost.meSearches += analysis.m_ctuWork.meSearches + analysis.m_slaveWork.meSearches;
+    cost.numEncodes = (uint8_t)X265_MIN(cost.numEncodes + 1, 255);
+    cost.minDepth = NUM_CU_DEPTH;
+    cost.maxDepth = 0;
+
+    uint32_t depth = 0;
+    for (uint32_t absPartIdx = 0; absPartIdx < ctu.m_numPartitions; absPartIdx += ctu.m_numPartitions >> (depth * 2))
+    {
+        depth = ctu.m_cuDepth[absPartIdx];
+        if (ctu.m_predMode[absPartIdx] == MODE_NONE)
+            continue;
+        cost.minDepth = X265_MIN(cost.minDepth, (uint8_t)depth);
+        cost.maxDepth = X265_MAX(cost.maxDepth, (uint8_t)depth);
+    }
+    if (cost.minDepth > cost.maxDepth)
+        cost.minDepth = 0;
+}
+
 /* collect statistics about CU coding decisions, return total QP */
 int FrameEncoder::collectCTUStatistics(const CUData& ctu, FrameStats* log)
 {
@@ -2153,6 +2249,36 @@ void FrameEncoder::vmafFrameLevelScore()
 }
 #endif
 
+/* Block until the reference frame has reconstructed the given row. While
+ * blocked, the rows of this frame which cannot start are credited to the
+ * reference's frame encoder, which deadline scheduling favours */
+void FrameEncoder::waitForReferenceRow(Frame& refpic, int rowIdx, int blockedRows)
+{
+    if (refpic.m_reconRowFlag[rowIdx].get())
+        return;
+
+    /* credit the provider which publishes the reconstructed row: the filter
+     * stage of the reference when its loop filter is pipelined, otherwise
+     * its frame encoder */
+    JobProvider* owner = NULL;
+    if (m_param->bDeadlineSched && refpic.m_encData->m_jobProvider)
+    {
+        FrameEncoder* refEncoder = static_cast<FrameEncoder*>(refpic.m_encData->m_jobProvider);
+        if (refEncoder->m_frameFilter.m_bPipelined)
+            owner = &refEncoder->m_frameFilter.m_stage;
+        else
+            owner = refEncoder;
+    }
+    if (owner)
+        ATOMIC_ADD(&owner->m_numBlockedRows, blockedRows);
+
+    while (refpic.m_reconRowFlag[rowIdx].get() == 0)
+        refpic.m_reconRowFlag[rowIdx].waitForChange(0);
+
+    if (owner)
+        ATOMIC_ADD(&owner->m_numBlockedRows, -blockedRows);
+}
+
 Frame *FrameEncoder::getEncodedPicture(NALList& output)
 {
     if (m_frame)
@@ -2160,6 +2286,11 @@ Frame *FrameEncoder::getEncodedPicture(NALList& output)
         /* block here until worker thread completes */
         m_done.wait();
 
+        /* with deadline scheduling, count the frames output later than their
+         * input time plus the latency budget */
+        if (m_param->bDeadlineSched && x265_mdate() > m_frame->m_encodeStartTime + m_top->m_deadlineBudget)
+            m_deadlineMisses++;
+
         Frame *ret = m_frame;
         m_frame = NULL;
         output.takeContents(m_nalList);
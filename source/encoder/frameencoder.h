@@ -99,6 +99,8 @@ struct CTURow
 
     volatile int      reEncode;
 
+    int64_t           endTime;          /* timestamp when the row was last compressed */
+
     /* called at the start of each frame to initialize state */
     void init(Entropy& initContext, unsigned int sid)
     {
@@ -108,6 +110,7 @@ struct CTURow
         avgQPComputed = 0;
         sliceId = sid;
         reEncode = 0;
+        endTime = 0;
         memset(&rowStats, 0, sizeof(rowStats));
         rowGoOnCoder.load(initContext);
     }
@@ -180,6 +183,7 @@ public:
     int64_t                  m_stallStartTime;           // timestamp when worker count becomes 0
     int64_t                  m_prevOutputTime;           // timestamp when prev frame was retrieved by API thread
     int64_t                  m_slicetypeWaitTime;        // total elapsed time waiting for decided frame
+    uint32_t                 m_deadlineMisses;           // frames output later than their input time plus the latency budget
     int64_t                  m_totalWorkerElapsedTime;   // total elapsed time spent by worker threads processing CTUs
     int64_t                  m_totalNoWorkerTime;        // total elapsed time without any active worker threads
 #if DETAILED_CU_STATS
@@ -232,7 +236,9 @@ protected:
 
     void threadMain();
     int  collectCTUStatistics(const CUData& ctu, FrameStats* frameLog);
+    void collectCTUCost(const CUData& ctu, const Analysis& analysis, FrameData::CTUCost& cost, int64_t elapsedTime);
     void noiseReductionUpdate();
+    void waitForReferenceRow(Frame& refpic, int rowIdx, int blockedRows);
     void writeTrailingSEIMessages();
     bool writeToneMapInfo(x265_sei_payload *payload);
 
@@ -162,6 +162,9 @@ void FrameFilter::destroy()
 
     if (m_parallelFilter)
     {
+        for (int row = 0; row < m_numRows; row++)
+            X265_FREE(m_parallelFilter[row].m_integralRow);
+
         if (m_useSao)
         {
             for(int row = 0; row < m_numRows; row++)
@@ -173,7 +176,7 @@ void FrameFilter::destroy()
     }
 }
 
-void FrameFilter::init(Encoder *top, FrameEncoder *frame, int numRows, uint32_t numCols)
+bool FrameFilter::init(Encoder *top, FrameEncoder *frame, int numRows, uint32_t numCols)
 {
     m_param = frame->m_param;
     m_frameEncoder = frame;
@@ -192,7 +195,11 @@ void FrameFilter::init(Encoder *top, FrameEncoder *frame, int numRows, uint32_t
     if (m_param->bEnableSsim)
         m_ssimBuf = X265_MALLOC(int, 8 * (m_param->sourceWidth / 4 + 3));
 
+    m_stage.m_frameFilter = this;
+    m_bPipelined = m_param->filterLag && frame->m_pool && m_stage.m_pool && m_stage.init(numRows);
+
     m_parallelFilter = new ParallelFilter[numRows];
+    bool ok = !!m_parallelFilter;
 
     if (m_parallelFilter)
     {
@@ -222,14 +229,43 @@ void FrameFilter::init(Encoder *top, FrameEncoder *frame, int numRows, uint32_t
             if (row > 0)
                 m_parallelFilter[row].m_prevRow = &m_parallelFilter[row - 1];
         }
+
+        /* Rows of different slices compute their SEA integrals concurrently,
+         * so each row has its own zeroed line and line of sums, with the
+         * stride of the recon picture */
+        if (m_param->searchMethod == X265_SEA)
+        {
+            intptr_t stride = numCols * m_param->maxCUSize + 2 * (m_param->maxCUSize + 32);
+            for (int row = 0; row < numRows && ok; row++)
+            {
+                uint32_t* buf = X265_MALLOC(uint32_t, 2 * stride);
+                m_parallelFilter[row].m_integralRow = buf;
+                if (buf)
+                    memset(buf, 0, sizeof(uint32_t) * stride);
+                else
+                {
+                    x265_log(m_param, X265_LOG_ERROR, "unable to allocate SEA integral buffers\n");
+                    ok = false;
+                }
+            }
+        }
     }
 
+    return ok;
 }
 
 void FrameFilter::start(Frame *frame, Entropy& initState)
 {
     m_frame = frame;
 
+    if (m_bPipelined)
+    {
+        m_stage.clearEnabledRowMask();
+        /* other frame encoders block on the reconstructed rows of referenced
+         * frames, so their filters outrank every frame encoder */
+        m_stage.m_sliceType = IS_REFERENCED(frame) ? X265_TYPE_AUTO : frame->m_lowres.sliceType;
+    }
+
     // Reset Filter Data Struct
     if (m_parallelFilter)
     {
@@ -242,6 +278,8 @@ void FrameFilter::start(Frame *frame, Entropy& initState)
             m_parallelFilter[row].m_allowedCol.set(0);
             m_parallelFilter[row].m_lastDeblocked.set(-1);
             m_parallelFilter[row].m_encData = frame->m_encData;
+            m_parallelFilter[row].m_filterTime = 0;
+            m_parallelFilter[row].m_latency = 0;
         }
 
         // Reset SAO common statistics
@@ -561,9 +599,21 @@ void FrameFilter::ParallelFilter::processTasks(int /*workerThreadId*/)
     }
 }
 
+void FrameFilter::FilterStage::processRow(int row, int /*threadId*/)
+{
+    const FrameEncoder* frameEncoder = m_frameFilter->m_frameEncoder;
+
+    m_frameFilter->processRow(row);
+
+    // NOTE: filter rows of a slice are strictly sequential, active next row
+    if (row != (int)frameEncoder->m_sliceBaseRow[frameEncoder->m_rows[row].sliceId + 1] - 1)
+        enqueueRow(row + 1);
+}
+
 void FrameFilter::processRow(int row)
 {
     ProfileScopeEvent(filterCTURow);
+    ScopedElapsedTime filterScope(m_parallelFilter[row].m_filterTime);
 
 #if DETAILED_CU_STATS
     ScopedElapsedTime filterPerfScope(m_frameEncoder->m_cuStats.loopFilterElapsedTime);
@@ -651,6 +701,22 @@ void FrameFilter::processRow(int row)
         processPostRow(row);
 }
 
+int64_t FrameFilter::filterElapsedTime() const
+{
+    int64_t sum = 0;
+    for (int row = 0; row < m_numRows; row++)
+        sum += m_parallelFilter[row].m_filterTime;
+    return sum;
+}
+
+int64_t FrameFilter::rowLatencySum() const
+{
+    int64_t sum = 0;
+    for (int row = 0; row < m_numRows; row++)
+        sum += m_parallelFilter[row].m_latency;
+    return sum;
+}
+
 void FrameFilter::processPostRow(int row)
 {
     PicYuv *reconPic = m_frame->m_reconPic;
@@ -662,6 +728,7 @@ void FrameFilter::processPostRow(int row)
         computeMEIntegral(row);
     // Notify other FrameEncoders that this row of reconstructed pixels is available
     m_frame->m_reconRowFlag[row].set(1);
+    m_parallelFilter[row].m_latency = x265_mdate() - m_frameEncoder->m_rows[row].endTime;
 
     uint32_t cuAddr = lineStartCUAddr;
     if (m_param->bEnablePsnr)
@@ -761,64 +828,41 @@ void FrameFilter::computeMEIntegral(int row)
         if (lastRow)
             height += padY - 1;
 
+        /* The planes of one width share their horizontal sums: they are
+         * computed once per line and width into the second line of the
+         * row's m_integralRow, whose first line stays zero, and accumulated
+         * into the planes of that width. The planes are then completed by
+         * initv */
+        static const int widths[NUM_INTEGRAL_SIZE] = { 4, 8, 12, 16, 24, 32 };
+        static const struct { int plane, height, size; } planes[NUM_INTEGRAL_SIZE][3] =
+        {
+            { { 10, 16, INTEGRAL_16 }, { 11, 4, INTEGRAL_4 }, { -1, 0, 0 } },                   /* 4x16, 4x4 */
+            { { 8, 32, INTEGRAL_32 }, { 9, 8, INTEGRAL_8 }, { -1, 0, 0 } },                     /* 8x32, 8x8 */
+            { { 7, 16, INTEGRAL_16 }, { -1, 0, 0 }, { -1, 0, 0 } },                             /* 12x16 */
+            { { 4, 16, INTEGRAL_16 }, { 5, 12, INTEGRAL_12 }, { 6, 4, INTEGRAL_4 } },           /* 16x16, 16x12, 16x4 */
+            { { 3, 32, INTEGRAL_32 }, { -1, 0, 0 }, { -1, 0, 0 } },                             /* 24x32 */
+            { { 0, 32, INTEGRAL_32 }, { 1, 24, INTEGRAL_24 }, { 2, 8, INTEGRAL_8 } },           /* 32x32, 32x24, 32x8 */
+        };
+        uint32_t* hsum = m_parallelFilter[row].m_integralRow + stride;
+
         for (int y = startRow; y < height; y++)
         {
-            pixel    *pix = m_frame->m_reconPic->m_picOrg[0] + y * stride - padX;
-            uint32_t *sum32x32 = m_frame->m_encData->m_meIntegral[0] + (y + 1) * stride - padX;
-            uint32_t *sum32x24 = m_frame->m_encData->m_meIntegral[1] + (y + 1) * stride - padX;
-            uint32_t *sum32x8 = m_frame->m_encData->m_meIntegral[2] + (y + 1) * stride - padX;
-            uint32_t *sum24x32 = m_frame->m_encData->m_meIntegral[3] + (y + 1) * stride - padX;
-            uint32_t *sum16x16 = m_frame->m_encData->m_meIntegral[4] + (y + 1) * stride - padX;
-            uint32_t *sum16x12 = m_frame->m_encData->m_meIntegral[5] + (y + 1) * stride - padX;
-            uint32_t *sum16x4 = m_frame->m_encData->m_meIntegral[6] + (y + 1) * stride - padX;
-            uint32_t *sum12x16 = m_frame->m_encData->m_meIntegral[7] + (y + 1) * stride - padX;
-            uint32_t *sum8x32 = m_frame->m_encData->m_meIntegral[8] + (y + 1) * stride - padX;
-            uint32_t *sum8x8 = m_frame->m_encData->m_meIntegral[9] + (y + 1) * stride - padX;
-            uint32_t *sum4x16 = m_frame->m_encData->m_meIntegral[10] + (y + 1) * stride - padX;
-            uint32_t *sum4x4 = m_frame->m_encData->m_meIntegral[11] + (y + 1) * stride - padX;
-
-            /*For width = 32 */
-            primitives.integral_inith[INTEGRAL_32](sum32x32, pix, stride);
-            if (y >= 32 - padY)
-                primitives.integral_initv[INTEGRAL_32](sum32x32 - 32 * stride, stride);
-            primitives.integral_inith[INTEGRAL_32](sum32x24, pix, stride);
-            if (y >= 24 - padY)
-                primitives.integral_initv[INTEGRAL_24](sum32x24 - 24 * stride, stride);
-            primitives.integral_inith[INTEGRAL_32](sum32x8, pix, stride);
-            if (y >= 8 - padY)
-                primitives.integral_initv[INTEGRAL_8](sum32x8 - 8 * stride, stride);
-            /*For width = 24 */
-            primitives.integral_inith[INTEGRAL_24](sum24x32, pix, stride);
-            if (y >= 32 - padY)
-                primitives.integral_initv[INTEGRAL_32](sum24x32 - 32 * stride, stride);
-            /*For width = 16 */
-            primitives.integral_inith[INTEGRAL_16](sum16x16, pix, stride);
-            if (y >= 16 - padY)
-                primitives.integral_initv[INTEGRAL_16](sum16x16 - 16 * stride, stride);
-            primitives.integral_inith[INTEGRAL_16](sum16x12, pix, stride);
-            if (y >= 12 - padY)
-                primitives.integral_initv[INTEGRAL_12](sum16x12 - 12 * stride, stride);
-            primitives.integral_inith[INTEGRAL_16](sum16x4, pix, stride);
-            if (y >= 4 - padY)
-                primitives.integral_initv[INTEGRAL_4](sum16x4 - 4 * stride, stride);
-            /*For width = 12 */
-            primitives.integral_inith[INTEGRAL_12](sum12x16, pix, stride);
-            if (y >= 16 - padY)
-                primitives.integral_initv[INTEGRAL_16](sum12x16 - 16 * stride, stride);
-            /*For width = 8 */
-            primitives.integral_inith[INTEGRAL_8](sum8x32, pix, stride);
-            if (y >= 32 - padY)
-                primitives.integral_initv[INTEGRAL_32](sum8x32 - 32 * stride, stride);
-            primitives.integral_inith[INTEGRAL_8](sum8x8, pix, stride);
-            if (y >= 8 - padY)
-                primitives.integral_initv[INTEGRAL_8](sum8x8 - 8 * stride, stride);
-            /*For width = 4 */
-            primitives.integral_inith[INTEGRAL_4](sum4x16, pix, stride);
-            if (y >= 16 - padY)
-                primitives.integral_initv[INTEGRAL_16](sum4x16 - 16 * stride, stride);
-            primitives.integral_inith[INTEGRAL_4](sum4x4, pix, stride);
-            if (y >= 4 - padY)
-                primitives.integral_initv[INTEGRAL_4](sum4x4 - 4 * stride, stride);
+            pixel* pix = m_frame->m_reconPic->m_picOrg[0] + y * stride - padX;
+            for (int w = 0; w < NUM_INTEGRAL_SIZE; w++)
+            {
+                primitives.integral_inith[w](hsum, pix, stride);
+                for (int i = 0; i < 3 && planes[w][i].plane >= 0; i++)
+                {
+                    uint32_t* sum = m_frame->m_encData->m_meIntegral[planes[w][i].plane] + (y + 1) * stride - padX;
+                    const uint32_t* above = sum - stride;
+                    for (int x = 0; x < stride - widths[w]; x++)
+                        sum[x] = hsum[x] + above[x];
+
+                    int h = planes[w][i].height;
+                    if (y >= h - padY)
+                        primitives.integral_initv[planes[w][i].size](sum - h * stride, stride);
+                }
+            }
         }
         m_parallelFilter[row].m_frameFilter->integralCompleted.set(1);
     }
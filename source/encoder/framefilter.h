@@ -30,6 +30,7 @@
 #include "deblock.h"
 #include "sao.h"
 #include "threadpool.h" // class BondedTaskGroup
+#include "wavefront.h"
 
 namespace X265_NS {
 // private x265 namespace
@@ -76,6 +77,9 @@ public:
         ThreadSafeInteger   m_lastCol;          /* The column that next to process */
         ThreadSafeInteger   m_allowedCol;       /* The column that processed from Encode pipeline */
         ThreadSafeInteger   m_lastDeblocked;   /* The column that finished all of Deblock stages  */
+        int64_t             m_filterTime;      /* time spent filtering this row */
+        int64_t             m_latency;         /* delay between row compressed and row reconstructed */
+        uint32_t*           m_integralRow;     /* horizontal sums of a line of this row's SEA integral planes */
 
         ParallelFilter()
             : m_rowHeight(0)
@@ -84,6 +88,9 @@ public:
             , m_frameFilter(NULL)
             , m_encData(NULL)
             , m_prevRow(NULL)
+            , m_filterTime(0)
+            , m_latency(0)
+            , m_integralRow(NULL)
         {
         }
 
@@ -109,12 +116,30 @@ public:
 
     ParallelFilter*     m_parallelFilter;
 
+    /* Dedicated loop filter pipeline stage (--filter-lag). Filter rows are
+     * queued here instead of in the FrameEncoder's wavefront so the pool can
+     * schedule them with their own priority. Rows are indexed by CTU row */
+    class FilterStage : public WaveFront
+    {
+    public:
+
+        FrameFilter*        m_frameFilter;
+
+        FilterStage() : m_frameFilter(NULL) {}
+
+        void processRow(int row, int threadId);
+    };
+
+    FilterStage         m_stage;
+    bool                m_bPipelined;
+
     FrameFilter()
         : m_param(NULL)
         , m_frame(NULL)
         , m_frameEncoder(NULL)
         , m_ssimBuf(NULL)
         , m_parallelFilter(NULL)
+        , m_bPipelined(false)
     {
     }
 
@@ -123,13 +148,17 @@ public:
         return (colNum == (int)m_numCols - 1) ? m_lastWidth : m_param->maxCUSize;
     }
 
-    void init(Encoder *top, FrameEncoder *frame, int numRows, uint32_t numCols);
+    bool init(Encoder *top, FrameEncoder *frame, int numRows, uint32_t numCols);
     void destroy();
 
     void start(Frame *pic, Entropy& initState);
 
     void processRow(int row);
     void processPostRow(int row);
+
+    /* totals of the rows of the frame, once its filter rows are complete */
+    int64_t filterElapsedTime() const;
+    int64_t rowLatencySum() const;
     void computeMEIntegral(int row);
 };
 }
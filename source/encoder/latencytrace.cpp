@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "frame.h"
+#include "frameencoder.h"
+#include "latencytrace.h"
+
+using namespace X265_NS;
+
+namespace {
+
+const char* sliceTypeName(int type)
+{
+    switch (type)
+    {
+    case X265_TYPE_IDR:  return "IDR";
+    case X265_TYPE_I:    return "I";
+    case X265_TYPE_P:    return "P";
+    case X265_TYPE_BREF: return "b";
+    case X265_TYPE_B:    return "B";
+    default:             return "?";
+    }
+}
+
+/* the stages of a frame's latency, each lasting until the next timestamp */
+struct Stage
+{
+    const char* name;
+    int64_t FrameTrace::* begin;
+};
+
+const Stage stages[] =
+{
+    { "lookahead",  &FrameTrace::ingest },
+    { "queued",     &FrameTrace::decided },
+    { "row 0 wait", &FrameTrace::encodeStart },
+    { "compress",   &FrameTrace::row0Start },
+    { "finish",     &FrameTrace::encodeEnd },
+    { "output",     &FrameTrace::frameEnd },
+    { NULL,         &FrameTrace::output }
+};
+
+}
+
+LatencyTrace::LatencyTrace()
+{
+    m_ring = NULL;
+    m_size = 0;
+    m_count = 0;
+    m_timeBase = 0;
+}
+
+LatencyTrace::~LatencyTrace()
+{
+    X265_FREE(m_ring);
+}
+
+bool LatencyTrace::init(int numFrames, int64_t timeBase)
+{
+    m_size = numFrames;
+    m_timeBase = timeBase;
+    m_ring = X265_MALLOC(FrameTrace, m_size);
+    return !!m_ring;
+}
+
+void LatencyTrace::record(const Frame& frame, const FrameEncoder& frameEnc, int frameEncoderIdx, int encodeOrder)
+{
+    FrameTrace t;
+    t.poc = frame.m_poc;
+    t.encodeOrder = encodeOrder;
+    t.sliceType = frame.m_lowres.sliceType;
+    t.frameEncoder = frameEncoderIdx;
+    t.ingest = frame.m_encodeStartTime;
+    t.decided = frame.m_decidedTime;
+    t.encodeStart = frameEnc.m_startCompressTime;
+    t.row0Start = frameEnc.m_row0WaitTime;
+    t.encodeEnd = frameEnc.m_endCompressTime;
+    t.frameEnd = frameEnc.m_endFrameTime;
+    t.output = x265_mdate();
+
+    /* stages which were skipped (a decision loaded from analysis, a frame
+     * encoder which found all of its references complete) last no time */
+    int64_t prev = t.ingest;
+    for (int i = 1; i < (int)(sizeof(stages) / sizeof(stages[0])); i++)
+    {
+        int64_t& ts = t.*stages[i].begin;
+        ts = X265_MAX(ts, prev);
+        prev = ts;
+    }
+
+    ScopedLock lock(m_lock);
+    m_ring[m_count++ % m_size] = t;
+}
+
+bool LatencyTrace::write(const char* filename)
+{
+    FILE* fp = x265_fopen(filename, "wb");
+    if (!fp)
+    {
+        x265_log_file(NULL, X265_LOG_ERROR, "unable to open latency trace file <%s>\n", filename);
+        return false;
+    }
+
+    ScopedLock lock(m_lock);
+
+    /* one track per frame encoder, and one asynchronous track per frame
+     * with its stages nested under it */
+    int numFrameEncoders = 0;
+    uint64_t first = m_count > (uint64_t)m_size ? m_count - m_size : 0;
+    for (uint64_t i = first; i < m_count; i++)
+        numFrameEncoders = X265_MAX(numFrameEncoders, m_ring[i % m_size].frameEncoder + 1);
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"x265\"}}");
+    fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"frames\"}}");
+    for (int fe = 0; fe < numFrameEncoders; fe++)
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"frame encoder %d\"}}", fe + 1, fe);
+
+    for (uint64_t i = first; i < m_count; i++)
+    {
+        const FrameTrace& t = m_ring[i % m_size];
+        const char* type = sliceTypeName(t.sliceType);
+
+        fprintf(fp, ",\n{\"name\":\"POC %d %s\",\"cat\":\"frame\",\"ph\":\"b\",\"id\":%d,\"pid\":1,\"tid\":0,\"ts\":" X265_LL
+                ",\"args\":{\"poc\":%d,\"encodeOrder\":%d,\"type\":\"%s\",\"latency_ms\":%.3f}}",
+                t.poc, type, t.encodeOrder, (uint64_t)(t.ingest - m_timeBase), t.poc, t.encodeOrder, type, (t.output - t.ingest) / 1000.0);
+        for (int s = 0; stages[s].name; s++)
+        {
+            int64_t begin = t.*stages[s].begin;
+            int64_t end = t.*stages[s + 1].begin;
+            if (end == begin)
+                continue;
+            fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"b\",\"id\":%d,\"pid\":1,\"tid\":0,\"ts\":" X265_LL "}",
+                    stages[s].name, t.encodeOrder, (uint64_t)(begin - m_timeBase));
+            fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"e\",\"id\":%d,\"pid\":1,\"tid\":0,\"ts\":" X265_LL "}",
+                    stages[s].name, t.encodeOrder, (uint64_t)(end - m_timeBase));
+        }
+        fprintf(fp, ",\n{\"name\":\"POC %d %s\",\"cat\":\"frame\",\"ph\":\"e\",\"id\":%d,\"pid\":1,\"tid\":0,\"ts\":" X265_LL "}",
+                t.poc, type, t.encodeOrder, (uint64_t)(t.output - m_timeBase));
+
+        fprintf(fp, ",\n{\"name\":\"POC %d %s\",\"cat\":\"encode\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":" X265_LL ",\"dur\":" X265_LL "}",
+                t.poc, type, t.frameEncoder + 1, (uint64_t)(t.encodeStart - m_timeBase), (uint64_t)(t.frameEnd - t.encodeStart));
+    }
+    fprintf(fp, "\n]}\n");
+
+    bool ok = !ferror(fp);
+    ok &= !fclose(fp);
+    if (!ok)
+        x265_log_file(NULL, X265_LOG_ERROR, "failure writing latency trace file <%s>\n", filename);
+    return ok;
+}
@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_LATENCYTRACE_H
+#define X265_LATENCYTRACE_H
+
+#include "common.h"
+#include "threading.h"
+
+namespace X265_NS {
+// private namespace
+
+class Frame;
+class FrameEncoder;
+
+/* Timestamps (x265_mdate) of one frame's way through the encoder, from the
+ * API call which passed in its picture to the API call which returned its
+ * access unit */
+struct FrameTrace
+{
+    int      poc;
+    int      encodeOrder;
+    int      sliceType;
+    int      frameEncoder;   // index of the frame encoder which coded it
+    int64_t  ingest;         // picture accepted by x265_encoder_encode()
+    int64_t  decided;        // slice type decided, queued for a frame encoder
+    int64_t  encodeStart;    // frame encoder started on the frame
+    int64_t  row0Start;      // reference dependencies of row 0 resolved
+    int64_t  encodeEnd;      // all CTUs compressed
+    int64_t  frameEnd;       // rate control, filters and NALs finished
+    int64_t  output;         // access unit returned by x265_encoder_encode()
+};
+
+/* Ring of the traces of the most recently output frames. Recorded by the
+ * API thread as frames are output; the ring can be written out at any time
+ * in the Chrome trace event format (chrome://tracing, Perfetto) */
+class LatencyTrace
+{
+public:
+
+    LatencyTrace();
+    ~LatencyTrace();
+
+    bool init(int numFrames, int64_t timeBase);
+
+    void record(const Frame& frame, const FrameEncoder& frameEnc, int frameEncoderIdx, int encodeOrder);
+
+    bool write(const char* filename);
+
+protected:
+
+    FrameTrace* m_ring;
+    int         m_size;
+    uint64_t    m_count;       // frames recorded since open
+    int64_t     m_timeBase;    // encoder open, the origin of the trace
+    Lock        m_lock;
+};
+}
+
+#endif // ifndef X265_LATENCYTRACE_H
@@ -25,6 +25,7 @@
 #include "common.h"
 #include "primitives.h"
 #include "lowres.h"
+#include "subpelcache.h"
 #include "motion.h"
 #include "x265.h"
 
@@ -113,6 +114,10 @@ MotionEstimate::MotionEstimate()
     chromaSatd = NULL;
     for (int i = 0; i < INTEGRAL_PLANE_NUM; i++)
         integral[i] = NULL;
+    seaScratch = NULL;
+    seaScratchSize = 0;
+    searchStepSink = 0;
+    searchSteps = &searchStepSink;
 }
 
 void MotionEstimate::init(int csp)
@@ -161,6 +166,7 @@ int MotionEstimate::hpelIterationCount(int subme)
 MotionEstimate::~MotionEstimate()
 {
     fencPUYuv.destroy();
+    X265_FREE(seaScratch);
 }
 
 /* Called by lookahead, luma only, no use of PicYuv */
@@ -173,9 +179,12 @@ void MotionEstimate::setSourcePU(pixel *fencY, intptr_t stride, intptr_t offset,
     satd = primitives.pu[partEnum].satd;
     sad_x3 = primitives.pu[partEnum].sad_x3;
     sad_x4 = primitives.pu[partEnum].sad_x4;
+    sadBounded = primitives.pu[partEnum].sad_bounded;
+    satdBounded = primitives.pu[partEnum].satd_bounded;
 
 
     blockwidth = pwidth;
+    blockheight = pheight;
     blockOffset = offset;
     absPartIdx = ctuAddr = -1;
 
@@ -200,6 +209,8 @@ void MotionEstimate::setSourcePU(const Yuv& srcFencYuv, int _ctuAddr, int cuPart
     satd = primitives.pu[partEnum].satd;
     sad_x3 = primitives.pu[partEnum].sad_x3;
     sad_x4 = primitives.pu[partEnum].sad_x4;
+    sadBounded = primitives.pu[partEnum].sad_bounded;
+    satdBounded = primitives.pu[partEnum].satd_bounded;
 
     chromaSatd = primitives.chroma[fencPUYuv.m_csp].pu[partEnum].satd;
 
@@ -215,6 +226,7 @@ void MotionEstimate::setSourcePU(const Yuv& srcFencYuv, int _ctuAddr, int cuPart
     ctuAddr = _ctuAddr;
     absPartIdx = cuPartIdx + puPartIdx;
     blockwidth = pwidth;
+    blockheight = pheight;
     blockOffset = 0;
 
     /* copy PU from CU Yuv */
@@ -225,8 +237,8 @@ void MotionEstimate::setSourcePU(const Yuv& srcFencYuv, int _ctuAddr, int cuPart
     do \
     { \
         MV tmv(mx, my); \
-        int cost = sad(fenc, FENC_STRIDE, fref + mx + my * stride, stride); \
-        cost += mvcost(tmv << 2); \
+        int mvcst = mvcost(tmv << 2); \
+        int cost = sadBounded(fenc, FENC_STRIDE, fref + mx + my * stride, stride, bcost - mvcst) + mvcst; \
         if (cost < bcost) { \
             bcost = cost; \
             bmv = tmv; \
@@ -238,8 +250,8 @@ void MotionEstimate::setSourcePU(const Yuv& srcFencYuv, int _ctuAddr, int cuPart
 #define COST_MV(mx, my) \
     do \
     { \
-        int cost = sad(fenc, FENC_STRIDE, fref + (mx) + (my) * stride, stride); \
-        cost += mvcost(MV(mx, my) << 2); \
+        int mvcst = mvcost(MV(mx, my) << 2); \
+        int cost = sadBounded(fenc, FENC_STRIDE, fref + (mx) + (my) * stride, stride, bcost - mvcst) + mvcst; \
         COPY2_IF_LT(bcost, cost, bmv, MV(mx, my)); \
     } while (0)
 
@@ -371,6 +383,7 @@ void MotionEstimate::StarPatternSearch(ReferencePlanes *ref,
                                        int              hme)
 {
     ALIGN_VAR_16(int, costs[16]);
+    (*searchSteps)++;
     pixel* fenc = fencPUYuv.m_buf[0];
     pixel* fref = (hme? ref->fpelLowerResPlane[0] : ref->fpelPlane[0]) + blockOffset;
     intptr_t stride = hme? ref->lumaStride / 2 : ref->lumaStride;
@@ -747,7 +760,6 @@ int MotionEstimate::motionEstimate(ReferencePlanes *ref,
                                    uint32_t         maxSlices,
                                    pixel *          srcReferencePlane)
 {
-    ALIGN_VAR_16(int, costs[16]);
     bool hme = srcReferencePlane && srcReferencePlane == ref->fpelLowerResPlane[0];
     if (ctuAddr >= 0)
         blockOffset = ref->reconPic->getLumaAddr(ctuAddr, absPartIdx) - ref->reconPic->getLumaAddr(0);
@@ -767,10 +779,317 @@ int MotionEstimate::motionEstimate(ReferencePlanes *ref,
      * on video distortion cost (SSE/PSNR) plus lambda times all signaling bits
      * (mode + MVD bits). */
 
+    MV bmv, bestpre;
+    int bcost, bprecost;
+    measurePredictors(ref, fenc, fref, stride, mvmin, mvmax, qmvp, numCandidates, mvc, hme, bmv, bcost, bestpre, bprecost);
+
+    int search = ref->isHMELowres ? (hme ? searchMethodL0 : searchMethodL1) : searchMethod;
+    integerSearch(search, ref, fenc, fref, stride, mvmin, mvmax, qmvp, numCandidates, mvc, merange, hme, bmv, bcost);
+
+    if (bprecost < bcost)
+    {
+        bmv = bestpre;
+        bcost = bprecost;
+    }
+    else
+        bmv = bmv.toQPel(); // promote search bmv to qpel
+
+    bcost = refineSubpel(ref, fenc, hme, qmvmin, qmvmax, maxSlices, bmv, bcost);
+    outQMv = bmv;
+    return bcost;
+}
+
+/* Motion search of several references of the PU (--multi-ref-me). Every
+ * step of the DIA and HEX searches evaluates the same pattern offset around
+ * the current best vector of up to four references with a single sad_x4(),
+ * so the source PU is read once for all of them; each reference follows
+ * exactly the path of motionEstimate() and is then refined to sub-pel on its
+ * own, so the results are those of separate searches. Not for lowres or HME
+ * reference planes */
+void MotionEstimate::motionEstimateRefs(RefSearch* refs, int numRefs, int merange, uint32_t maxSlices)
+{
+    ReferencePlanes* ref0 = refs[0].ref;
+    if (ctuAddr >= 0)
+        blockOffset = ref0->reconPic->getLumaAddr(ctuAddr, absPartIdx) - ref0->reconPic->getLumaAddr(0);
+    intptr_t stride = ref0->lumaStride;
+    pixel* fenc = fencPUYuv.m_buf[0];
+
+    for (int i = 0; i < numRefs; i++)
+    {
+        RefSearch& rs = refs[i];
+        X265_CHECK(rs.ref->lumaStride == stride && !rs.ref->isLowres, "incompatible references in batched search\n");
+        rs.fref = rs.ref->fpelPlane[0] + blockOffset;
+        setMVP(rs.qmvp);
+        measurePredictors(rs.ref, fenc, rs.fref, stride, rs.mvmin, rs.mvmax, rs.qmvp, rs.numCandidates, rs.mvc,
+                          false, rs.bmv, rs.bcost, rs.bestpre, rs.bprecost);
+    }
+
+    if (searchMethod == X265_DIA_SEARCH || searchMethod == X265_HEX_SEARCH)
+    {
+        for (int g = 0; g < numRefs; g += 4)
+        {
+            RefSearch* group[4];
+            int n = X265_MIN(4, numRefs - g);
+            for (int i = 0; i < n; i++)
+                group[i] = &refs[g + i];
+            if (searchMethod == X265_DIA_SEARCH)
+                diaSearchRefs(group, n, merange, stride);
+            else
+                hexSearchRefs(group, n, merange, stride);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < numRefs; i++)
+        {
+            RefSearch& rs = refs[i];
+            setMVP(rs.qmvp);
+            integerSearch(searchMethod, rs.ref, fenc, rs.fref, stride, rs.mvmin, rs.mvmax, rs.qmvp,
+                          rs.numCandidates, rs.mvc, merange, false, rs.bmv, rs.bcost);
+        }
+    }
+
+    for (int i = 0; i < numRefs; i++)
+    {
+        RefSearch& rs = refs[i];
+        if (rs.bprecost < rs.bcost)
+        {
+            rs.bmv = rs.bestpre;
+            rs.bcost = rs.bprecost;
+        }
+        else
+            rs.bmv = rs.bmv.toQPel();
+
+        setMVP(rs.qmvp);
+        rs.cost = refineSubpel(rs.ref, fenc, false, rs.mvmin.toQPel(), rs.mvmax.toQPel(), maxSlices, rs.bmv, rs.bcost);
+        rs.outQMv = rs.bmv;
+    }
+    x265_emms();
+}
+
+/* SAD and MV cost of one candidate per reference, cand[i] being relative to
+ * the current best vector of reference i */
+void MotionEstimate::costRefs(RefSearch* const* refs, const MV* cand, int numRefs, intptr_t stride, int* costs)
+{
+    const pixel* pix[4];
+    MV mv[4];
+    for (int i = 0; i < numRefs; i++)
+    {
+        mv[i] = refs[i]->bmv + cand[i];
+        pix[i] = refs[i]->fref + mv[i].x + mv[i].y * stride;
+    }
+
+    pixel* fenc = fencPUYuv.m_buf[0];
+    if (numRefs == 4)
+        sad_x4(fenc, pix[0], pix[1], pix[2], pix[3], stride, costs);
+    else if (numRefs == 3)
+        sad_x3(fenc, pix[0], pix[1], pix[2], stride, costs);
+    else
+    {
+        for (int i = 0; i < numRefs; i++)
+            costs[i] = sad(fenc, FENC_STRIDE, pix[i], stride);
+    }
+
+    for (int i = 0; i < numRefs; i++)
+        costs[i] += mvcostFrom(mv[i] << 2, refs[i]->qmvp);
+}
+
+/* diamond search, radius 1, of each reference in lockstep */
+void MotionEstimate::diaSearchRefs(RefSearch* const* refs, int numRefs, int merange, intptr_t stride)
+{
+    ALIGN_VAR_16(int, costs[4][4]);
+    RefSearch* active[4];
+    int iters[4];
+    int numActive = numRefs;
+
+    for (int i = 0; i < numRefs; i++)
+    {
+        active[i] = refs[i];
+        iters[i] = merange;
+        refs[i]->bcost <<= 4;
+    }
+
+    while (numActive)
+    {
+        *searchSteps += numActive;
+        for (int d = 0; d < 4; d++)
+        {
+            MV cand[4];
+            for (int i = 0; i < numActive; i++)
+                cand[i] = square1[d + 1];
+            costRefs(active, cand, numActive, stride, costs[d]);
+        }
+
+        int next = 0;
+        for (int i = 0; i < numActive; i++)
+        {
+            RefSearch& rs = *active[i];
+            MV& bmv = rs.bmv;
+            int& bcost = rs.bcost;
+            if ((bmv.y - 1 >= rs.mvmin.y) & (bmv.y - 1 <= rs.mvmax.y))
+                COPY1_IF_LT(bcost, (costs[0][i] << 4) + 1);
+            if ((bmv.y + 1 >= rs.mvmin.y) & (bmv.y + 1 <= rs.mvmax.y))
+                COPY1_IF_LT(bcost, (costs[1][i] << 4) + 3);
+            COPY1_IF_LT(bcost, (costs[2][i] << 4) + 4);
+            COPY1_IF_LT(bcost, (costs[3][i] << 4) + 12);
+            if (!(bcost & 15))
+                continue;
+            bmv.x -= (bcost << 28) >> 30;
+            bmv.y -= (bcost << 30) >> 30;
+            bcost &= ~15;
+            if (--iters[i] && bmv.checkRange(rs.mvmin, rs.mvmax))
+            {
+                active[next] = active[i];
+                iters[next++] = iters[i];
+            }
+        }
+        numActive = next;
+    }
+
+    for (int i = 0; i < numRefs; i++)
+        refs[i]->bcost >>= 4;
+}
+
+/* hexagon search, radius 2, with square refinement of each reference in lockstep */
+void MotionEstimate::hexSearchRefs(RefSearch* const* refs, int numRefs, int merange, intptr_t stride)
+{
+    ALIGN_VAR_16(int, costs[8][4]);
+    MV cand[4];
+
+    /* the first hexagon, in the order of the two COST_MV_X3_DIR of motionEstimate() */
+    static const MV hex6[6] = { MV(-2, 0), MV(-1, 2), MV(1, 2), MV(2, 0), MV(1, -2), MV(-1, -2) };
+    *searchSteps += numRefs;
+    for (int p = 0; p < 6; p++)
+    {
+        for (int i = 0; i < numRefs; i++)
+            cand[i] = hex6[p];
+        costRefs(refs, cand, numRefs, stride, costs[p]);
+    }
+
+    RefSearch* active[4];
+    int dirs[4], iters[4];
+    int numActive = 0;
+    for (int i = 0; i < numRefs; i++)
+    {
+        RefSearch& rs = *refs[i];
+        MV& bmv = rs.bmv;
+        int& bcost = rs.bcost;
+        const MV& mvmin = rs.mvmin;
+        const MV& mvmax = rs.mvmax;
+
+        bcost <<= 3;
+        if ((bmv.y >= mvmin.y) & (bmv.y <= mvmax.y))
+            COPY1_IF_LT(bcost, (costs[0][i] << 3) + 2);
+        if ((bmv.y + 2 >= mvmin.y) & (bmv.y + 2 <= mvmax.y))
+        {
+            COPY1_IF_LT(bcost, (costs[1][i] << 3) + 3);
+            COPY1_IF_LT(bcost, (costs[2][i] << 3) + 4);
+        }
+        if ((bmv.y >= mvmin.y) & (bmv.y <= mvmax.y))
+            COPY1_IF_LT(bcost, (costs[3][i] << 3) + 5);
+        if ((bmv.y - 2 >= mvmin.y) & (bmv.y - 2 <= mvmax.y))
+        {
+            COPY1_IF_LT(bcost, (costs[4][i] << 3) + 6);
+            COPY1_IF_LT(bcost, (costs[5][i] << 3) + 7);
+        }
+
+        if (bcost & 7)
+        {
+            int dir = (bcost & 7) - 2;
+            if ((bmv.y + hex2[dir + 1].y >= mvmin.y) & (bmv.y + hex2[dir + 1].y <= mvmax.y))
+            {
+                bmv += hex2[dir + 1];
+                int iter = (merange >> 1) - 1;
+                if (iter > 0 && bmv.checkRange(mvmin, mvmax))
+                {
+                    active[numActive] = refs[i];
+                    dirs[numActive] = dir;
+                    iters[numActive++] = iter;
+                }
+            }
+        }
+    }
+
+    /* half hexagons, not overlapping the previous iteration */
+    while (numActive)
+    {
+        *searchSteps += numActive;
+        for (int p = 0; p < 3; p++)
+        {
+            for (int i = 0; i < numActive; i++)
+                cand[i] = hex2[dirs[i] + p];
+            costRefs(active, cand, numActive, stride, costs[p]);
+        }
+
+        int next = 0;
+        for (int i = 0; i < numActive; i++)
+        {
+            RefSearch& rs = *active[i];
+            MV& bmv = rs.bmv;
+            int& bcost = rs.bcost;
+            int dir = dirs[i];
+
+            bcost &= ~7;
+            for (int p = 0; p < 3; p++)
+            {
+                if ((bmv.y + hex2[dir + p].y >= rs.mvmin.y) & (bmv.y + hex2[dir + p].y <= rs.mvmax.y))
+                    COPY1_IF_LT(bcost, (costs[p][i] << 3) + p + 1);
+            }
+            if (!(bcost & 7))
+                continue;
+
+            dir += (bcost & 7) - 2;
+            dir = mod6m1[dir + 1];
+            bmv += hex2[dir + 1];
+            if (--iters[i] > 0 && bmv.checkRange(rs.mvmin, rs.mvmax))
+            {
+                active[next] = active[i];
+                dirs[next] = dir;
+                iters[next++] = iters[i];
+            }
+        }
+        numActive = next;
+    }
+
+    /* square refine */
+    for (int p = 0; p < 8; p++)
+    {
+        for (int i = 0; i < numRefs; i++)
+            cand[i] = square1[p + 1];
+        costRefs(refs, cand, numRefs, stride, costs[p]);
+    }
+    for (int i = 0; i < numRefs; i++)
+    {
+        RefSearch& rs = *refs[i];
+        MV& bmv = rs.bmv;
+        int bcost = rs.bcost >> 3;
+        int dir = 0;
+        for (int p = 0; p < 8; p++)
+        {
+            /* the vertical neighbours are bounded by the search window */
+            if (square1[p + 1].y && ((bmv.y + square1[p + 1].y < rs.mvmin.y) | (bmv.y + square1[p + 1].y > rs.mvmax.y)))
+                continue;
+            COPY2_IF_LT(bcost, costs[p][i], dir, p + 1);
+        }
+        bmv += square1[dir];
+        rs.bcost = bcost;
+    }
+}
+
+/* measure the predictors of a search: the clipped MVP, MV(0) and the MV
+ * candidates. Returns the full-pel start point of the integer search in
+ * bmv/bcost and the best QPEL predictor in bestpre/bprecost. Uses the MVP
+ * last given to setMVP() */
+void MotionEstimate::measurePredictors(ReferencePlanes* ref, pixel* fenc, pixel* fref, intptr_t stride,
+                                       const MV& mvmin, const MV& mvmax, const MV& qmvp, int numCandidates, const MV* mvc,
+                                       bool hme, MV& bmv, int& bcost, MV& bestpre, int& bprecost)
+{
+    MV qmvmin = mvmin.toQPel();
+    MV qmvmax = mvmax.toQPel();
+
     // measure SAD cost at clipped QPEL MVP
     MV pmv = qmvp.clipped(qmvmin, qmvmax);
-    MV bestpre = pmv;
-    int bprecost;
+    bestpre = pmv;
 
     if (ref->isLowres)
         bprecost = ref->lowresQPelCost(fenc, blockOffset, pmv, sad, hme);
@@ -778,8 +1097,8 @@ int MotionEstimate::motionEstimate(ReferencePlanes *ref,
         bprecost = subpelCompare(ref, pmv, sad);
 
     /* re-measure full pel rounded MVP with SAD as search start point */
-    MV bmv = pmv.roundToFPel();
-    int bcost = bprecost;
+    bmv = pmv.roundToFPel();
+    bcost = bprecost;
     if (pmv.isSubpel())
         bcost = sad(fenc, FENC_STRIDE, fref + bmv.x + bmv.y * stride, stride) + mvcost(bmv << 2);
 
@@ -810,11 +1129,17 @@ int MotionEstimate::motionEstimate(ReferencePlanes *ref,
             }
         }
     }
+}
 
-    pmv = pmv.roundToFPel();
+/* full-pel search from bmv with the given method */
+void MotionEstimate::integerSearch(int search, ReferencePlanes* ref, pixel* fenc, pixel* fref, intptr_t stride,
+                                   const MV& mvmin, const MV& mvmax, const MV& qmvp, int numCandidates, const MV* mvc,
+                                   int merange, bool hme, MV& bmv, int& bcost)
+{
+    ALIGN_VAR_16(int, costs[16]);
+    MV pmv = qmvp.clipped(mvmin.toQPel(), mvmax.toQPel()).roundToFPel();
     MV omv = bmv;  // current search origin or starting point
 
-    int search = ref->isHMELowres ? (hme ? searchMethodL0 : searchMethodL1) : searchMethod;
     switch (search)
     {
     case X265_DIA_SEARCH:
@@ -824,6 +1149,7 @@ int MotionEstimate::motionEstimate(ReferencePlanes *ref,
         int i = merange;
         do
         {
+            (*searchSteps)++;
             COST_MV_X4_DIR(0, -1, 0, 1, -1, 0, 1, 0, costs);
             if ((bmv.y - 1 >= mvmin.y) & (bmv.y - 1 <= mvmax.y))
                 COPY1_IF_LT(bcost, (costs[0] << 4) + 1);
@@ -864,6 +1190,7 @@ me_hex2:
 
 #else // if 0
       /* equivalent to the above, but eliminates duplicate candidates */
+        (*searchSteps)++;
         COST_MV_X3_DIR(-2, 0, -1, 2,  1, 2, costs);
         bcost <<= 3;
         if ((bmv.y >= mvmin.y) & (bmv.y <= mvmax.y))
@@ -894,6 +1221,7 @@ me_hex2:
                 /* half hexagon, not overlapping the previous iteration */
                 for (int i = (merange >> 1) - 1; i > 0 && bmv.checkRange(mvmin, mvmax); i--)
                 {
+                    (*searchSteps)++;
                     COST_MV_X3_DIR(hex2[dir + 0].x, hex2[dir + 0].y,
                         hex2[dir + 1].x, hex2[dir + 1].y,
                         hex2[dir + 2].x, hex2[dir + 2].y,
@@ -1051,6 +1379,7 @@ me_hex2:
         uint16_t i = 1;
         do
         {
+            (*searchSteps)++;
             if (4 * i > X265_MIN4(mvmax.x - omv.x, omv.x - mvmin.x,
                                   mvmax.y - omv.y, omv.y - mvmin.y))
             {
@@ -1248,18 +1577,19 @@ me_hex2:
         const int32_t maxY = X265_MIN(omv.y + (int32_t)merange, mvmax.y);
         const uint16_t *p_cost_mvx = m_cost_mvx - qmvp.x;
         const uint16_t *p_cost_mvy = m_cost_mvy - qmvp.y;
-        int16_t* meScratchBuffer = NULL;
         int scratchSize = merange * 2 + 4;
-        if (scratchSize)
+        if (scratchSize > seaScratchSize)
         {
-            meScratchBuffer = X265_MALLOC(int16_t, scratchSize);
-            memset(meScratchBuffer, 0, sizeof(int16_t)* scratchSize);
+            X265_FREE(seaScratch);
+            seaScratch = X265_MALLOC(int16_t, scratchSize);
+            seaScratchSize = seaScratch ? scratchSize : 0;
         }
+        int16_t* meScratchBuffer = seaScratch;
 
         /* SEA is fastest in multiples of 4 */
         int meRangeWidth = (maxX - minX + 3) & ~3;
         int w = 0, h = 0;                    // Width and height of the PU
-        ALIGN_VAR_32(pixel, zero[64 * FENC_STRIDE]) = { 0 };
+        static const ALIGN_VAR_32(pixel, zero[64 * FENC_STRIDE]) = { 0 };
         ALIGN_VAR_32(int, encDC[4]);
         uint16_t *fpelCostMvX = m_fpelMvCosts[-qmvp.x & 3] + (-qmvp.x >> 2);
         sizesFromPartition(partEnum, &w, &h);
@@ -1389,8 +1719,6 @@ me_hex2:
             for (; i < xn; i++)
                 COST_MV(minX + meScratchBuffer[i], tmv.y);
         }
-        if (meScratchBuffer)
-            x265_free(meScratchBuffer);
         break;
     }
 
@@ -1444,14 +1772,13 @@ me_hex2:
         X265_CHECK(0, "invalid motion estimate mode\n");
         break;
     }
+}
 
-    if (bprecost < bcost)
-    {
-        bmv = bestpre;
-        bcost = bprecost;
-    }
-    else
-        bmv = bmv.toQPel(); // promote search bmv to qpel
+/* sub-pel refinement of the QPEL vector bmv of cost bcost, returns the
+ * refined cost. Uses the MVP last given to setMVP() */
+int MotionEstimate::refineSubpel(ReferencePlanes* ref, pixel* fenc, bool hme, const MV& qmvmin, const MV& qmvmax,
+                                 uint32_t maxSlices, MV& bmv, int bcost)
+{
 
     const SubpelWorkload& wl = workload[this->subpelRefine];
 
@@ -1503,15 +1830,15 @@ me_hex2:
     }
     else
     {
-        pixelcmp_t hpelcomp;
+        pixelcmp_bounded_t hpelcomp;
 
         if (wl.hpel_satd)
         {
             bcost = subpelCompare(ref, bmv, satd) + mvcost(bmv);
-            hpelcomp = satd;
+            hpelcomp = satdBounded;
         }
         else
-            hpelcomp = sad;
+            hpelcomp = sadBounded;
 
         for (int iter = 0; iter < wl.hpel_iters; iter++)
         {
@@ -1524,7 +1851,8 @@ me_hex2:
                 if ((qmv.y < qmvmin.y) | (qmv.y > qmvmax.y))
                     continue;
 
-                int cost = subpelCompare(ref, qmv, hpelcomp) + mvcost(qmv);
+                int mvc = mvcost(qmv);
+                int cost = subpelCompare(ref, qmv, hpelcomp, bcost - mvc) + mvc;
                 COPY2_IF_LT(bcost, cost, bdir, i);
             }
 
@@ -1549,7 +1877,8 @@ me_hex2:
                 if ((qmv.y < qmvmin.y) | (qmv.y > qmvmax.y))
                     continue;
 
-                int cost = subpelCompare(ref, qmv, satd) + mvcost(qmv);
+                int mvc = mvcost(qmv);
+                int cost = subpelCompare(ref, qmv, satdBounded, bcost - mvc) + mvc;
                 COPY2_IF_LT(bcost, cost, bdir, i);
             }
 
@@ -1564,99 +1893,140 @@ me_hex2:
     X265_CHECK(((bmv.y >= qmvmin.y) & (bmv.y <= qmvmax.y)), "mv beyond range!");
 
     x265_emms();
-    outQMv = bmv;
     return bcost;
 }
 
-int MotionEstimate::subpelCompare(ReferencePlanes *ref, const MV& qmv, pixelcmp_t cmp)
+/* returns the luma reference block of the QPEL vector qmv, interpolated into
+ * subpelbuf when qmv is not full-pel */
+const pixel* MotionEstimate::subpelLuma(ReferencePlanes* ref, const MV& qmv, pixel* subpelbuf, intptr_t& stride)
 {
     intptr_t refStride = ref->lumaStride;
     const pixel* fref = ref->fpelPlane[0] + blockOffset + (qmv.x >> 2) + (qmv.y >> 2) * refStride;
     int xFrac = qmv.x & 0x3;
     int yFrac = qmv.y & 0x3;
-    int cost;
-    const intptr_t fencStride = FENC_STRIDE;
-    X265_CHECK(fencPUYuv.m_size == FENC_STRIDE, "fenc buffer is assumed to have FENC_STRIDE by sad_x3 and sad_x4\n");
 
-    ALIGN_VAR_32(pixel, subpelbuf[MAX_CU_SIZE * MAX_CU_SIZE]);
-    
     if (!(yFrac | xFrac))
-        cost = cmp(fencPUYuv.m_buf[0], fencStride, fref, refStride);
-    else
     {
-        /* we are taking a short-cut here if the reference is weighted. To be
-         * accurate we should be interpolating unweighted pixels and weighting
-         * the final 16bit values prior to rounding and down shifting. Instead we
-         * are simply interpolating the weighted full-pel pixels. Not 100%
-         * accurate but good enough for fast qpel ME */
-        if (!yFrac)
-            primitives.pu[partEnum].luma_hpp(fref, refStride, subpelbuf, blockwidth, xFrac);
-        else if (!xFrac)
-            primitives.pu[partEnum].luma_vpp(fref, refStride, subpelbuf, blockwidth, yFrac);
-        else
-            primitives.pu[partEnum].luma_hvpp(fref, refStride, subpelbuf, blockwidth, xFrac, yFrac);
-        cost = cmp(fencPUYuv.m_buf[0], fencStride, subpelbuf, blockwidth);
+        stride = refStride;
+        return fref;
     }
 
-    if (bChromaSATD)
+    if (ref->subpelCache)
     {
-        int csp    = fencPUYuv.m_csp;
-        int hshift = fencPUYuv.m_hChromaShift;
-        int vshift = fencPUYuv.m_vChromaShift;
-        int mvx = qmv.x << (1 - hshift);
-        int mvy = qmv.y << (1 - vshift);
-        intptr_t fencStrideC = fencPUYuv.m_csize;
+        const pixel* cached = ref->subpelCache->getBlock(fref - ref->fpelPlane[0], blockwidth, blockheight, xFrac, yFrac);
+        if (cached)
+        {
+            stride = refStride;
+            return cached;
+        }
+    }
+
+    /* we are taking a short-cut here if the reference is weighted. To be
+     * accurate we should be interpolating unweighted pixels and weighting
+     * the final 16bit values prior to rounding and down shifting. Instead we
+     * are simply interpolating the weighted full-pel pixels. Not 100%
+     * accurate but good enough for fast qpel ME */
+    if (!yFrac)
+        primitives.pu[partEnum].luma_hpp(fref, refStride, subpelbuf, blockwidth, xFrac);
+    else if (!xFrac)
+        primitives.pu[partEnum].luma_vpp(fref, refStride, subpelbuf, blockwidth, yFrac);
+    else
+        primitives.pu[partEnum].luma_hvpp(fref, refStride, subpelbuf, blockwidth, xFrac, yFrac);
+    stride = blockwidth;
+    return subpelbuf;
+}
 
-        intptr_t refStrideC = ref->reconPic->m_strideC;
-        intptr_t refOffset = (mvx >> 3) + (mvy >> 3) * refStrideC;
+int MotionEstimate::subpelCompare(ReferencePlanes *ref, const MV& qmv, pixelcmp_t cmp)
+{
+    X265_CHECK(fencPUYuv.m_size == FENC_STRIDE, "fenc buffer is assumed to have FENC_STRIDE by sad_x3 and sad_x4\n");
 
-        const pixel* refCb = ref->getCbAddr(ctuAddr, absPartIdx) + refOffset;
-        const pixel* refCr = ref->getCrAddr(ctuAddr, absPartIdx) + refOffset;
+    ALIGN_VAR_32(pixel, subpelbuf[MAX_CU_SIZE * MAX_CU_SIZE]);
+    intptr_t stride;
+    const pixel* fref = subpelLuma(ref, qmv, subpelbuf, stride);
+    int cost = cmp(fencPUYuv.m_buf[0], FENC_STRIDE, fref, stride);
 
-        X265_CHECK((hshift == 0) || (hshift == 1), "hshift must be 0 or 1\n");
-        X265_CHECK((vshift == 0) || (vshift == 1), "vshift must be 0 or 1\n");
+    if (bChromaSATD)
+        cost += subpelCompareChroma(ref, qmv);
+
+    return cost;
+}
+
+/* subpelCompare() with a bounded luma cost; the chroma cost is not measured
+ * once the luma cost alone exceeds bound */
+int MotionEstimate::subpelCompare(ReferencePlanes *ref, const MV& qmv, pixelcmp_bounded_t cmp, int bound)
+{
+    ALIGN_VAR_32(pixel, subpelbuf[MAX_CU_SIZE * MAX_CU_SIZE]);
+    intptr_t stride;
+    const pixel* fref = subpelLuma(ref, qmv, subpelbuf, stride);
+    int cost = cmp(fencPUYuv.m_buf[0], FENC_STRIDE, fref, stride, bound);
+
+    if (bChromaSATD && cost <= bound)
+        cost += subpelCompareChroma(ref, qmv);
+
+    return cost;
+}
+
+int MotionEstimate::subpelCompareChroma(ReferencePlanes *ref, const MV& qmv)
+{
+    ALIGN_VAR_32(pixel, subpelbuf[MAX_CU_SIZE * MAX_CU_SIZE]);
+    int cost = 0;
 
-        xFrac = mvx & 7;
-        yFrac = mvy & 7;
+    int csp    = fencPUYuv.m_csp;
+    int hshift = fencPUYuv.m_hChromaShift;
+    int vshift = fencPUYuv.m_vChromaShift;
+    int mvx = qmv.x << (1 - hshift);
+    int mvy = qmv.y << (1 - vshift);
+    intptr_t fencStrideC = fencPUYuv.m_csize;
 
-        if (!(yFrac | xFrac))
+    intptr_t refStrideC = ref->reconPic->m_strideC;
+    intptr_t refOffset = (mvx >> 3) + (mvy >> 3) * refStrideC;
+
+    const pixel* refCb = ref->getCbAddr(ctuAddr, absPartIdx) + refOffset;
+    const pixel* refCr = ref->getCrAddr(ctuAddr, absPartIdx) + refOffset;
+
+    X265_CHECK((hshift == 0) || (hshift == 1), "hshift must be 0 or 1\n");
+    X265_CHECK((vshift == 0) || (vshift == 1), "vshift must be 0 or 1\n");
+
+    int xFrac = mvx & 7;
+    int yFrac = mvy & 7;
+
+    if (!(yFrac | xFrac))
+    {
+        cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, refCb, refStrideC);
+        cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, refCr, refStrideC);
+    }
+    else
+    {
+        int blockwidthC = blockwidth >> hshift;
+
+        if (!yFrac)
         {
-            cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, refCb, refStrideC);
-            cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, refCr, refStrideC);
+            primitives.chroma[csp].pu[partEnum].filter_hpp(refCb, refStrideC, subpelbuf, blockwidthC, xFrac);
+            cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
+
+            primitives.chroma[csp].pu[partEnum].filter_hpp(refCr, refStrideC, subpelbuf, blockwidthC, xFrac);
+            cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
         }
-        else
+        else if (!xFrac)
         {
-            int blockwidthC = blockwidth >> hshift;
-
-            if (!yFrac)
-            {
-                primitives.chroma[csp].pu[partEnum].filter_hpp(refCb, refStrideC, subpelbuf, blockwidthC, xFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
+            primitives.chroma[csp].pu[partEnum].filter_vpp(refCb, refStrideC, subpelbuf, blockwidthC, yFrac);
+            cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
 
-                primitives.chroma[csp].pu[partEnum].filter_hpp(refCr, refStrideC, subpelbuf, blockwidthC, xFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
-            }
-            else if (!xFrac)
-            {
-                primitives.chroma[csp].pu[partEnum].filter_vpp(refCb, refStrideC, subpelbuf, blockwidthC, yFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
-
-                primitives.chroma[csp].pu[partEnum].filter_vpp(refCr, refStrideC, subpelbuf, blockwidthC, yFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
-            }
-            else
-            {
-                ALIGN_VAR_32(int16_t, immed[MAX_CU_SIZE * (MAX_CU_SIZE + NTAPS_LUMA - 1)]);
-                const int halfFilterSize = (NTAPS_CHROMA >> 1);
+            primitives.chroma[csp].pu[partEnum].filter_vpp(refCr, refStrideC, subpelbuf, blockwidthC, yFrac);
+            cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
+        }
+        else
+        {
+            ALIGN_VAR_32(int16_t, immed[MAX_CU_SIZE * (MAX_CU_SIZE + NTAPS_LUMA - 1)]);
+            const int halfFilterSize = (NTAPS_CHROMA >> 1);
 
-                primitives.chroma[csp].pu[partEnum].filter_hps(refCb, refStrideC, immed, blockwidthC, xFrac, 1);
-                primitives.chroma[csp].pu[partEnum].filter_vsp(immed + (halfFilterSize - 1) * blockwidthC, blockwidthC, subpelbuf, blockwidthC, yFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
+            primitives.chroma[csp].pu[partEnum].filter_hps(refCb, refStrideC, immed, blockwidthC, xFrac, 1);
+            primitives.chroma[csp].pu[partEnum].filter_vsp(immed + (halfFilterSize - 1) * blockwidthC, blockwidthC, subpelbuf, blockwidthC, yFrac);
+            cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
 
-                primitives.chroma[csp].pu[partEnum].filter_hps(refCr, refStrideC, immed, blockwidthC, xFrac, 1);
-                primitives.chroma[csp].pu[partEnum].filter_vsp(immed + (halfFilterSize - 1) * blockwidthC, blockwidthC, subpelbuf, blockwidthC, yFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
-            }
+            primitives.chroma[csp].pu[partEnum].filter_hps(refCr, refStrideC, immed, blockwidthC, xFrac, 1);
+            primitives.chroma[csp].pu[partEnum].filter_vsp(immed + (halfFilterSize - 1) * blockwidthC, blockwidthC, subpelbuf, blockwidthC, yFrac);
+            cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
         }
     }
 
@@ -57,6 +57,13 @@ protected:
     pixelcmp_ads_t ads;
     pixelcmp_t satd;
     pixelcmp_t chromaSatd;
+    pixelcmp_bounded_t sadBounded;  // early terminating sad and satd, see COST_MV
+    pixelcmp_bounded_t satdBounded;
+
+    int16_t*   seaScratch;      // SEA candidate list, grown on demand
+    int        seaScratchSize;
+
+    int32_t    searchStepSink;
 
     MotionEstimate& operator =(const MotionEstimate&);
 
@@ -69,6 +76,10 @@ public:
     int partEnum;
     bool bChromaSATD;
 
+    /* steps of the integer pattern searches (DIA, HEX, UMH and STAR; the
+     * exhaustive searches are not counted) are added to *searchSteps */
+    int32_t* searchSteps;
+
     MotionEstimate();
     ~MotionEstimate();
 
@@ -94,13 +105,52 @@ public:
                chromaSatd(refYuv.getCrAddr(puPartIdx), refYuv.m_csize, fencPUYuv.m_buf[2], fencPUYuv.m_csize);
     }
 
+    /* One reference of a batched search of the PU, see motionEstimateRefs() */
+    struct RefSearch
+    {
+        ReferencePlanes* ref;
+        MV         mvmin;          // full-pel search window
+        MV         mvmax;
+        MV         qmvp;
+        int        numCandidates;
+        const MV*  mvc;
+
+        MV         outQMv;         // results, as returned by motionEstimate()
+        int        cost;
+
+        pixel*     fref;           // state of the search
+        MV         bmv;
+        MV         bestpre;
+        int        bcost;
+        int        bprecost;
+    };
+
     void refineMV(ReferencePlanes* ref, const MV& mvmin, const MV& mvmax, const MV& qmvp, MV& outQMv);
     int motionEstimate(ReferencePlanes* ref, const MV & mvmin, const MV & mvmax, const MV & qmvp, int numCandidates, const MV * mvc, int merange, MV & outQMv, uint32_t maxSlices, pixel *srcReferencePlane = 0);
 
+    void motionEstimateRefs(RefSearch* refs, int numRefs, int merange, uint32_t maxSlices);
+
     int subpelCompare(ReferencePlanes* ref, const MV &qmv, pixelcmp_t);
 
 protected:
 
+    int subpelCompare(ReferencePlanes* ref, const MV &qmv, pixelcmp_bounded_t, int bound);
+    int subpelCompareChroma(ReferencePlanes* ref, const MV &qmv);
+    const pixel* subpelLuma(ReferencePlanes* ref, const MV &qmv, pixel* subpelbuf, intptr_t& stride);
+
+    // bit cost of motion vector difference against a predictor other than the one of setMVP()
+    inline uint16_t mvcostFrom(const MV& mv, const MV& mvp) const { return m_cost[mv.x - mvp.x] + m_cost[mv.y - mvp.y]; }
+
+    void costRefs(RefSearch* const* refs, const MV* cand, int numRefs, intptr_t stride, int* costs);
+    void diaSearchRefs(RefSearch* const* refs, int numRefs, int merange, intptr_t stride);
+    void hexSearchRefs(RefSearch* const* refs, int numRefs, int merange, intptr_t stride);
+
+    void measurePredictors(ReferencePlanes* ref, pixel* fenc, pixel* fref, intptr_t stride, const MV& mvmin, const MV& mvmax,
+                           const MV& qmvp, int numCandidates, const MV* mvc, bool hme, MV& bmv, int& bcost, MV& bestpre, int& bprecost);
+    void integerSearch(int search, ReferencePlanes* ref, pixel* fenc, pixel* fref, intptr_t stride, const MV& mvmin, const MV& mvmax,
+                       const MV& qmvp, int numCandidates, const MV* mvc, int merange, bool hme, MV& bmv, int& bcost);
+    int  refineSubpel(ReferencePlanes* ref, pixel* fenc, bool hme, const MV& qmvmin, const MV& qmvmax, uint32_t maxSlices, MV& bmv, int bcost);
+
     inline void StarPatternSearch(ReferencePlanes *ref,
                                   const MV &       mvmin,
                                   const MV &       mvmax,
@@ -23,11 +23,58 @@
 *****************************************************************************/
 
 #include "common.h"
+#include "primitives.h"
 #include "bitstream.h"
 #include "nal.h"
 
 using namespace X265_NS;
 
+/* 7.4.1 ...
+ * Within the NAL unit, the following three-byte sequences shall not occur at
+ * any byte-aligned position:
+ *  - 0x000000
+ *  - 0x000001
+ *  - 0x000002
+ * Copies size bytes from src to out, injecting an 0x03 byte wherever two zero
+ * bytes of the output would otherwise be followed by a byte <= 0x03. zeros is
+ * the number of zero bytes the output ended with (0..2) and is updated, so a
+ * stream can be escaped in several pieces. Spans which cannot contain such a
+ * sequence are located by the findZeroPair primitive and copied in bulk.
+ * Returns the number of bytes written */
+uint32_t NALList::escapeBytes(uint8_t* out, const uint8_t* src, uint32_t size, uint32_t& zeros)
+{
+    uint8_t* start = out;
+    uint32_t i = 0;
+
+    while (i < size)
+    {
+        if (!zeros)
+        {
+            /* nothing can be escaped before the next pair of zero bytes */
+            uint32_t run = primitives.findZeroPair(src + i, size - i);
+            memcpy(out, src + i, run);
+            out += run;
+            i += run;
+            if (run)
+                zeros = !src[i - 1];
+            if (i == size)
+                break;
+        }
+
+        uint8_t val = src[i++];
+        if (zeros >= 2 && val <= 0x03)
+        {
+            /* inject 0x03 to prevent emulating a start code */
+            *out++ = 0x03;
+            zeros = 0;
+        }
+        *out++ = val;
+        zeros = val ? 0 : zeros + 1;
+    }
+
+    return (uint32_t)(out - start);
+}
+
 NALList::NALList()
     : m_numNal(0)
     , m_buffer(NULL)
@@ -57,7 +104,7 @@ void NALList::takeContents(NALList& other)
     other.m_buffer = X265_MALLOC(uint8_t, m_allocSize);
 }
 
-void NALList::serialize(NalUnitType nalUnitType, const Bitstream& bs)
+void NALList::serialize(NalUnitType nalUnitType, Bitstream& bs)
 {
     static const char startCodePrefix[] = { 0, 0, 0, 1 };
 
@@ -116,23 +163,18 @@ void NALList::serialize(NalUnitType nalUnitType, const Bitstream& bs)
     out[bytes++] = (uint8_t)nalUnitType << 1;
     out[bytes++] = 1 + (nalUnitType == NAL_UNIT_CODED_SLICE_TSA_N);
 
-    /* 7.4.1 ...
-     * Within the NAL unit, the following three-byte sequences shall not occur at
-     * any byte-aligned position:
-     *  - 0x000000
-     *  - 0x000001
-     *  - 0x000002 */
-    for (uint32_t i = 0; i < payloadSize; i++)
+    /* the final payload byte, which holds the rbsp stop bit, is copied
+     * without being checked */
+    if (nalUnitType == NAL_UNIT_UNSPECIFIED)
     {
-        if (i > 2 && !out[bytes - 2] && !out[bytes - 3] && out[bytes - 1] <= 0x03 && nalUnitType != NAL_UNIT_UNSPECIFIED)
-        {
-            /* inject 0x03 to prevent emulating a start code */
-            out[bytes] = out[bytes - 1];
-            out[bytes - 1] = 0x03;
-            bytes++;
-        }
-
-        out[bytes++] = bpayload[i];
+        memcpy(out + bytes, bpayload, payloadSize);
+        bytes += payloadSize;
+    }
+    else if (payloadSize)
+    {
+        uint32_t zeros = 0;
+        bytes += escapeBytes(out + bytes, bpayload, payloadSize - 1, zeros);
+        out[bytes++] = bpayload[payloadSize - 1];
     }
 
     X265_CHECK(bytes <= 4 + 2 + payloadSize + (payloadSize >> 1), "NAL buffer overflow\n");
@@ -171,9 +213,10 @@ void NALList::serialize(NalUnitType nalUnitType, const Bitstream& bs)
     nal.payload = out;
 }
 
-/* concatenate and escape WPP sub-streams, return escaped row lengths.
+/* concatenate and escape WPP sub-streams, return escaped row lengths of
+ * all streams and the largest length of those signaled as entry points.
  * These streams will be appended to the next serialized NAL */
-uint32_t NALList::serializeSubstreams(uint32_t* streamSizeBytes, uint32_t streamCount, const Bitstream* streams)
+uint32_t NALList::serializeSubstreams(uint32_t* streamSizeBytes, uint32_t streamCount, Bitstream* streams)
 {
     uint32_t maxStreamSize = 0;
     uint32_t estSize = 0;
@@ -198,34 +241,24 @@ uint32_t NALList::serializeSubstreams(uint32_t* streamSizeBytes, uint32_t stream
     }
 
     uint32_t bytes = 0;
+    uint32_t zeros = 0;
     uint8_t *out = m_extraBuffer;
     for (uint32_t s = 0; s < streamCount; s++)
     {
-        const Bitstream& stream = streams[s];
+        Bitstream& stream = streams[s];
         uint32_t inSize = stream.getNumberOfWrittenBytes();
         const uint8_t *inBytes = stream.getFIFO();
         uint32_t prevBufSize = bytes;
 
+        /* escaping continues across substream boundaries */
         if (inBytes)
-        {
-            for (uint32_t i = 0; i < inSize; i++)
-            {
-                if (bytes >= 2 && !out[bytes - 2] && !out[bytes - 1] && inBytes[i] <= 0x03)
-                {
-                    /* inject 0x03 to prevent emulating a start code */
-                    out[bytes++] = 3;
-                }
-
-                out[bytes++] = inBytes[i];
-            }
-        }
+            bytes += escapeBytes(out + bytes, inBytes, inSize, zeros);
 
-        if (s < streamCount - 1)
-        {
-            streamSizeBytes[s] = bytes - prevBufSize;
-            if (streamSizeBytes[s] > maxStreamSize)
-                maxStreamSize = streamSizeBytes[s];
-        }
+        /* the size of the last stream is not signaled, but is reported
+         * so the caller can pre-size its buffers for the next frame */
+        streamSizeBytes[s] = bytes - prevBufSize;
+        if (s < streamCount - 1 && streamSizeBytes[s] > maxStreamSize)
+            maxStreamSize = streamSizeBytes[s];
     }
 
     m_extraOccupancy = bytes;
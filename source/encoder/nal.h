@@ -56,9 +56,11 @@ public:
 
     void takeContents(NALList& other);
 
-    void serialize(NalUnitType nalUnitType, const Bitstream& bs);
+    void serialize(NalUnitType nalUnitType, Bitstream& bs);
 
-    uint32_t serializeSubstreams(uint32_t* streamSizeBytes, uint32_t streamCount, const Bitstream* streams);
+    uint32_t serializeSubstreams(uint32_t* streamSizeBytes, uint32_t streamCount, Bitstream* streams);
+
+    static uint32_t escapeBytes(uint8_t* out, const uint8_t* src, uint32_t size, uint32_t& zeros);
 };
 
 }
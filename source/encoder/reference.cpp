@@ -48,7 +48,7 @@ MotionReference::~MotionReference()
     X265_FREE(weightBuffer[2]);
 }
 
-int MotionReference::init(PicYuv* recPic, WeightParam *wp, const x265_param& p)
+int MotionReference::init(PicYuv* recPic, WeightParam *wp, const x265_param& p, SubpelCache* cache)
 {
     reconPic = recPic;
     lumaStride = recPic->m_stride;
@@ -113,6 +113,9 @@ int MotionReference::init(PicYuv* recPic, WeightParam *wp, const x265_param& p)
         isWeighted = true;
     }
 
+    /* the cache holds unweighted sub-pel planes */
+    subpelCache = fpelPlane[0] == recPic->m_picOrg[0] ? cache : NULL;
+
     return 0;
 }
 
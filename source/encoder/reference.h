@@ -41,7 +41,7 @@ public:
 
     MotionReference();
     ~MotionReference();
-    int  init(PicYuv*, WeightParam* wp, const x265_param& p);
+    int  init(PicYuv*, WeightParam* wp, const x265_param& p, SubpelCache* cache);
     void applyWeight(uint32_t finishedRows, uint32_t maxNumRows, uint32_t maxNumRowsInSlice, uint32_t sliceId);
 
     pixel*      weightBuffer[3];
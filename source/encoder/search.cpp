@@ -58,9 +58,7 @@ Search::Search()
 
     m_numLayers = 0;
     m_intraPred = NULL;
-    m_intraPredAngs = NULL;
     m_fencScaled = NULL;
-    m_fencTransposed = NULL;
     m_tsCoeff = NULL;
     m_tsResidual = NULL;
     m_tsRecon = NULL;
@@ -68,6 +66,9 @@ Search::Search()
     m_slice = NULL;
     m_frame = NULL;
     m_maxTUDepth = -1;
+    memset(&m_ctuWork, 0, sizeof(m_ctuWork));
+    memset(&m_slaveWork, 0, sizeof(m_slaveWork));
+    m_me.searchSteps = &m_ctuWork.meSearchSteps;
 }
 
 bool Search::initSearch(const x265_param& param, ScalingList& scalingList)
@@ -162,10 +163,8 @@ bool Search::initSearch(const x265_param& param, ScalingList& scalingList)
         m_qtTempTransformSkipFlag[1] = m_qtTempTransformSkipFlag[2] = NULL;
     }
 
-    CHECKED_MALLOC(m_intraPred, pixel, (32 * 32) * (33 + 3));
+    CHECKED_MALLOC(m_intraPred, pixel, (32 * 32) * 2);
     m_fencScaled = m_intraPred + 32 * 32;
-    m_fencTransposed = m_fencScaled + 32 * 32;
-    m_intraPredAngs = m_fencTransposed + 32 * 32;
 
     CHECKED_MALLOC(m_tsCoeff,    coeff_t, MAX_TS_SIZE * MAX_TS_SIZE);
     CHECKED_MALLOC(m_tsResidual, int16_t, MAX_TS_SIZE * MAX_TS_SIZE);
@@ -1235,6 +1234,7 @@ void Search::residualQTIntraChroma(Mode& mode, const CUGeom& cuGeom, uint32_t ab
 
 void Search::checkIntra(Mode& intraMode, const CUGeom& cuGeom, PartSize partSize)
 {
+    m_ctuWork.rdEvals++;
     CUData& cu = intraMode.cu;
 
     cu.setPartSizeSubParts(partSize);
@@ -1342,7 +1342,6 @@ void Search::checkIntraInInter(Mode& intraMode, const CUGeom& cuGeom)
     }
 
     pixelcmp_t sa8d = primitives.cu[sizeIdx].sa8d;
-    int predsize = scaleTuSize * scaleTuSize;
 
     m_entropyCoder.loadIntraDirModeLuma(m_rqt[depth].cur);
 
@@ -1355,8 +1354,8 @@ void Search::checkIntraInInter(Mode& intraMode, const CUGeom& cuGeom)
     uint32_t rbits = getIntraRemModeBits(cu, absPartIdx, mpmModes, mpms);
 
     // DC
-    primitives.cu[sizeIdx].intra_pred[DC_IDX](m_intraPredAngs, scaleStride, intraNeighbourBuf[0], 0, (scaleTuSize <= 16));
-    bsad = sa8d(fenc, scaleStride, m_intraPredAngs, scaleStride) << costShift;
+    primitives.cu[sizeIdx].intra_pred[DC_IDX](m_intraPred, scaleStride, intraNeighbourBuf[0], 0, (scaleTuSize <= 16));
+    bsad = sa8d(fenc, scaleStride, m_intraPred, scaleStride) << costShift;
     bmode = mode = DC_IDX;
     bbits = (mpms & ((uint64_t)1 << mode)) ? m_entropyCoder.bitsIntraModeMPM(mpmModes, mode) : rbits;
     bcost = m_rdCost.calcRdSADCost(bsad, bbits);
@@ -1366,34 +1365,20 @@ void Search::checkIntraInInter(Mode& intraMode, const CUGeom& cuGeom)
     if (tuSize & (8 | 16 | 32))
         planar = intraNeighbourBuf[1];
 
-    primitives.cu[sizeIdx].intra_pred[PLANAR_IDX](m_intraPredAngs, scaleStride, planar, 0, 0);
-    sad = sa8d(fenc, scaleStride, m_intraPredAngs, scaleStride) << costShift;
+    primitives.cu[sizeIdx].intra_pred[PLANAR_IDX](m_intraPred, scaleStride, planar, 0, 0);
+    sad = sa8d(fenc, scaleStride, m_intraPred, scaleStride) << costShift;
     mode = PLANAR_IDX;
     bits = (mpms & ((uint64_t)1 << mode)) ? m_entropyCoder.bitsIntraModeMPM(mpmModes, mode) : rbits;
     cost = m_rdCost.calcRdSADCost(sad, bits);
     COPY4_IF_LT(bcost, cost, bmode, mode, bsad, sad, bbits, bits);
 
-    bool allangs = true;
-    if (primitives.cu[sizeIdx].intra_pred_allangs)
-    {
-        primitives.cu[sizeIdx].transpose(m_fencTransposed, fenc, scaleStride);
-        primitives.cu[sizeIdx].intra_pred_allangs(m_intraPredAngs, intraNeighbourBuf[0], intraNeighbourBuf[1], (scaleTuSize <= 16)); 
-    }
-    else
-        allangs = false;
-
+    /* the fast search measures a few angles one at a time, the full search
+     * measures all of them at once */
 #define TRY_ANGLE(angle) \
-    if (allangs) { \
-        if (angle < 18) \
-            sad = sa8d(m_fencTransposed, scaleTuSize, &m_intraPredAngs[(angle - 2) * predsize], scaleTuSize) << costShift; \
-        else \
-            sad = sa8d(fenc, scaleStride, &m_intraPredAngs[(angle - 2) * predsize], scaleTuSize) << costShift; \
-        bits = (mpms & ((uint64_t)1 << angle)) ? m_entropyCoder.bitsIntraModeMPM(mpmModes, angle) : rbits; \
-        cost = m_rdCost.calcRdSADCost(sad, bits); \
-    } else { \
+    { \
         int filter = !!(g_intraFilterFlags[angle] & scaleTuSize); \
-        primitives.cu[sizeIdx].intra_pred[angle](m_intraPredAngs, scaleTuSize, intraNeighbourBuf[filter], angle, scaleTuSize <= 16); \
-        sad = sa8d(fenc, scaleStride, m_intraPredAngs, scaleTuSize) << costShift; \
+        primitives.cu[sizeIdx].intra_pred[angle](m_intraPred, scaleTuSize, intraNeighbourBuf[filter], angle, scaleTuSize <= 16); \
+        sad = sa8d(fenc, scaleStride, m_intraPred, scaleTuSize) << costShift; \
         bits = (mpms & ((uint64_t)1 << angle)) ? m_entropyCoder.bitsIntraModeMPM(mpmModes, angle) : rbits; \
         cost = m_rdCost.calcRdSADCost(sad, bits); \
     }
@@ -1436,9 +1421,13 @@ void Search::checkIntraInInter(Mode& intraMode, const CUGeom& cuGeom)
     }
     else // calculate and search all intra prediction angles for lowest cost
     {
+        int angCosts[33];
+        primitives.cu[sizeIdx].intra_allangs_sa8d(angCosts, fenc, scaleStride, intraNeighbourBuf[0], intraNeighbourBuf[1], (scaleTuSize <= 16));
         for (mode = 2; mode < 35; mode++)
         {
-            TRY_ANGLE(mode);
+            sad = angCosts[mode - 2] << costShift;
+            bits = (mpms & ((uint64_t)1 << mode)) ? m_entropyCoder.bitsIntraModeMPM(mpmModes, mode) : rbits;
+            cost = m_rdCost.calcRdSADCost(sad, bits);
             COPY4_IF_LT(bcost, cost, bmode, mode, bsad, sad, bbits, bits);
         }
     }
@@ -1586,32 +1575,14 @@ sse_t Search::estIntraPredQT(Mode &intraMode, const CUGeom& cuGeom, const uint32
                 COPY1_IF_LT(bcost, modeCosts[PLANAR_IDX]);
 
                 // angular predictions
-                if (primitives.cu[sizeIdx].intra_pred_allangs)
+                int angCosts[33];
+                primitives.cu[sizeIdx].intra_allangs_sa8d(angCosts, fenc, scaleStride, intraNeighbourBuf[0], intraNeighbourBuf[1], (scaleTuSize <= 16));
+                for (int mode = 2; mode < 35; mode++)
                 {
-                    primitives.cu[sizeIdx].transpose(m_fencTransposed, fenc, scaleStride);
-                    primitives.cu[sizeIdx].intra_pred_allangs(m_intraPredAngs, intraNeighbourBuf[0], intraNeighbourBuf[1], (scaleTuSize <= 16));
-                    for (int mode = 2; mode < 35; mode++)
-                    {
-                        bits = (mpms & ((uint64_t)1 << mode)) ? m_entropyCoder.bitsIntraModeMPM(mpmModes, mode) : rbits;
-                        if (mode < 18)
-                            sad = sa8d(m_fencTransposed, scaleTuSize, &m_intraPredAngs[(mode - 2) * (scaleTuSize * scaleTuSize)], scaleTuSize) << costShift;
-                        else
-                            sad = sa8d(fenc, scaleStride, &m_intraPredAngs[(mode - 2) * (scaleTuSize * scaleTuSize)], scaleTuSize) << costShift;
-                        modeCosts[mode] = m_rdCost.calcRdSADCost(sad, bits);
-                        COPY1_IF_LT(bcost, modeCosts[mode]);
-                    }
-                }
-                else
-                {
-                    for (int mode = 2; mode < 35; mode++)
-                    {
-                        bits = (mpms & ((uint64_t)1 << mode)) ? m_entropyCoder.bitsIntraModeMPM(mpmModes, mode) : rbits;
-                        int filter = !!(g_intraFilterFlags[mode] & scaleTuSize);
-                        primitives.cu[sizeIdx].intra_pred[mode](m_intraPred, scaleTuSize, intraNeighbourBuf[filter], mode, scaleTuSize <= 16);
-                        sad = sa8d(fenc, scaleStride, m_intraPred, scaleTuSize) << costShift;
-                        modeCosts[mode] = m_rdCost.calcRdSADCost(sad, bits);
-                        COPY1_IF_LT(bcost, modeCosts[mode]);
-                    }
+                    bits = (mpms & ((uint64_t)1 << mode)) ? m_entropyCoder.bitsIntraModeMPM(mpmModes, mode) : rbits;
+                    sad = angCosts[mode - 2] << costShift;
+                    modeCosts[mode] = m_rdCost.calcRdSADCost(sad, bits);
+                    COPY1_IF_LT(bcost, modeCosts[mode]);
                 }
 
                 /* Find the top maxCandCount candidate modes with cost within 25% of best
@@ -1987,6 +1958,27 @@ MV Search::getLowresMV(const CUData& cu, const PredictionUnit& pu, int list, int
     return mvs[idx] << 1; /* scale up lowres mv */
 }
 
+/* append the candidates of the frame's upsampled lookahead motion field at
+ * the middle of the PU to mvc, see FrameData::buildMVField() */
+int Search::addMVFieldSeeds(const CUData& cu, const PredictionUnit& pu, int list, int ref, MV* mvc, int numMvc)
+{
+    int diffPoc = abs(m_slice->m_poc - m_slice->m_refPOCList[list][ref]);
+    if (diffPoc > m_param->bframes + 1 || !cu.m_encData->m_mvFieldValid[list][diffPoc])
+        return numMvc;
+
+    uint32_t block_x = (cu.m_cuPelX + g_zscanToPelX[pu.puAbsPartIdx] + pu.width / 2) >> 4;
+    uint32_t block_y = (cu.m_cuPelY + g_zscanToPelY[pu.puAbsPartIdx] + pu.height / 2) >> 4;
+    uint32_t idx = block_y * m_frame->m_lowres.maxBlocksInRow + block_x;
+
+    X265_CHECK(block_x < m_frame->m_lowres.maxBlocksInRow, "block_x is too high\n");
+    X265_CHECK(block_y < m_frame->m_lowres.maxBlocksInCol, "block_y is too high\n");
+
+    const MV* seeds = cu.m_encData->getMVField(list, diffPoc, idx);
+    for (int i = 0; i < FrameData::MV_FIELD_SEEDS && seeds[i].notZero(); i++)
+        mvc[numMvc++] = seeds[i];
+    return numMvc;
+}
+
 /* Pick between the two AMVP candidates which is the best one to use as
  * MVP for the motion search, based on SAD cost */
 int Search::selectMVP(const CUData& cu, const PredictionUnit& pu, const MV amvp[AMVP_NUM_CANDS], int list, int ref)
@@ -2030,7 +2022,27 @@ void Search::PME::processTasks(int workerThreadId)
     ScopedElapsedTime pmeTime(master.m_stats[fe].pmeTime);
 #endif
     ProfileScopeEvent(pme);
-    master.processPME(*this, master.m_tld[workerThreadId].analysis);
+    Search& slave = master.m_tld[workerThreadId].analysis;
+    CTUWork before = slave.m_ctuWork;
+    master.processPME(*this, slave);
+    master.addSlaveWork(slave, before);
+}
+
+/* credit the work a slave did since before to this master's CTU */
+void Search::addSlaveWork(Search& slave, const CTUWork& before)
+{
+    if (&slave == this)
+        return;
+    int32_t rdEvals = slave.m_ctuWork.rdEvals - before.rdEvals;
+    int32_t meSearches = slave.m_ctuWork.meSearches - before.meSearches;
+    int32_t meSearchSteps = slave.m_ctuWork.meSearchSteps - before.meSearchSteps;
+    slave.m_ctuWork = before;
+    if (rdEvals)
+        ATOMIC_ADD(&m_slaveWork.rdEvals, rdEvals);
+    if (meSearches)
+        ATOMIC_ADD(&m_slaveWork.meSearches, meSearches);
+    if (meSearchSteps)
+        ATOMIC_ADD(&m_slaveWork.meSearchSteps, meSearchSteps);
 }
 
 void Search::processPME(PME& pme, Search& slave)
@@ -2090,8 +2102,8 @@ void Search::singleMotionEstimation(Search& master, Mode& interMode, const Predi
 
     MotionData* bestME = interMode.bestME[part];
 
-    // 12 mv candidates including lowresMV
-    MV  mvc[(MD_ABOVE_LEFT + 1) * 2 + 2];
+    // 11 mv candidates plus lowresMV or the motion field seeds
+    MV  mvc[(MD_ABOVE_LEFT + 1) * 2 + 1 + FrameData::MV_FIELD_SEEDS];
     int numMvc = interMode.cu.getPMV(interMode.interNeighbours, list, ref, interMode.amvpCand[list][ref], mvc);
 
     const MV* amvp = interMode.amvpCand[list][ref];
@@ -2102,7 +2114,9 @@ void Search::singleMotionEstimation(Search& master, Mode& interMode, const Predi
     if (!m_param->analysisSave && !m_param->analysisLoad) /* Prevents load/save outputs from diverging if lowresMV is not available */
     {
         MV lmv = getLowresMV(interMode.cu, pu, list, ref);
-        if (lmv.notZero())
+        if (m_param->bMVField)
+            numMvc = addMVFieldSeeds(interMode.cu, pu, list, ref, mvc, numMvc);
+        else if (lmv.notZero())
             mvc[numMvc++] = lmv;
         if (m_param->bEnableHME)
             mvp_lowres = lmv;
@@ -2110,6 +2124,7 @@ void Search::singleMotionEstimation(Search& master, Mode& interMode, const Predi
 
     setSearchRange(interMode.cu, mvp, m_param->searchRange, mvmin, mvmax);
 
+    m_ctuWork.meSearches++;
     int satdCost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, m_param->searchRange, outmv, m_param->maxSlices, 
       m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
 
@@ -2117,6 +2132,7 @@ void Search::singleMotionEstimation(Search& master, Mode& interMode, const Predi
     {
         MV outmv_lowres;
         setSearchRange(interMode.cu, mvp_lowres, m_param->searchRange, mvmin, mvmax);
+        m_ctuWork.meSearches++;
         int lowresMvCost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mvp_lowres, numMvc, mvc, m_param->searchRange, outmv_lowres, m_param->maxSlices,
             m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
         if (lowresMvCost < satdCost)
@@ -2168,6 +2184,7 @@ void Search::searchMV(Mode& interMode, int list, int ref, MV& outmv, MV mvp[3],
         mv = mvp[cand++];
         cu.clipMv(mv);
         setSearchRange(cu, mv, m_param->searchRange, mvmin, mvmax);
+        m_ctuWork.meSearches++;
         int cost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mv, numMvc, mvc, m_param->searchRange, bestMV, m_param->maxSlices,
         m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
         if (bestcost > cost)
@@ -2177,6 +2194,95 @@ void Search::searchMV(Mode& interMode, int list, int ref, MV& outmv, MV mvp[3],
         }
     }
 }
+
+/* Uni-directional motion searches of all the references of one list, for
+ * the PU set up in m_me; the outcome is that of the per-reference loop of
+ * predInterSearch(), with the searches run by
+ * MotionEstimate::motionEstimateRefs(). bestME[list] is updated in reference
+ * order, so ties resolve the same way */
+void Search::searchRefsBatched(Mode& interMode, const PredictionUnit& pu, int puIdx, int list, uint32_t refMask)
+{
+    CUData& cu = interMode.cu;
+    MotionData* bestME = interMode.bestME[puIdx];
+    const int numRefs = m_slice->m_numRefIdx[list];
+
+    MV mvc[MAX_NUM_REF][(MD_ABOVE_LEFT + 1) * 2 + 1 + FrameData::MV_FIELD_SEEDS];
+    MotionEstimate::RefSearch refs[MAX_NUM_REF];
+    int refIdx[MAX_NUM_REF];
+    int mvpIdx[MAX_NUM_REF];
+    int numSearches = 0;
+
+    for (int ref = 0; ref < numRefs; ref++)
+    {
+        ProfileCounter(cu, totalMotionReferences[cu.m_cuDepth[0]]);
+
+        if (!(refMask & (1 << ref)))
+        {
+            ProfileCounter(cu, skippedMotionReferences[cu.m_cuDepth[0]]);
+            continue;
+        }
+
+        MotionEstimate::RefSearch& rs = refs[numSearches];
+        int numMvc = cu.getPMV(interMode.interNeighbours, list, ref, interMode.amvpCand[list][ref], mvc[numSearches]);
+        const MV* amvp = interMode.amvpCand[list][ref];
+        mvpIdx[numSearches] = selectMVP(cu, pu, amvp, list, ref);
+
+        if (!m_param->analysisSave && !m_param->analysisLoad) /* Prevents load/save outputs from diverging when lowresMV is not available */
+        {
+            if (m_param->bMVField)
+                numMvc = addMVFieldSeeds(cu, pu, list, ref, mvc[numSearches], numMvc);
+            else
+            {
+                MV lmv = getLowresMV(cu, pu, list, ref);
+                if (lmv.notZero())
+                    mvc[numSearches][numMvc++] = lmv;
+            }
+        }
+
+        rs.ref = &m_slice->m_mref[list][ref];
+        rs.qmvp = amvp[mvpIdx[numSearches]];
+        rs.numCandidates = numMvc;
+        rs.mvc = mvc[numSearches];
+        setSearchRange(cu, rs.qmvp, m_param->searchRange, rs.mvmin, rs.mvmax);
+        refIdx[numSearches++] = ref;
+    }
+
+    if (!numSearches)
+        return;
+
+    m_ctuWork.meSearches += numSearches;
+    m_me.motionEstimateRefs(refs, numSearches, m_param->searchRange, m_param->maxSlices);
+
+    for (int i = 0; i < numSearches; i++)
+    {
+        int ref = refIdx[i];
+        const MV& outmv = refs[i].outQMv;
+        const MV* amvp = interMode.amvpCand[list][ref];
+
+        uint32_t bits = m_listSelBits[list] + MVP_IDX_BITS;
+        bits += getTUBits(ref, numRefs);
+
+        /* Get total cost of partition, but only include MV bit cost once */
+        m_me.setMVP(refs[i].qmvp);
+        bits += m_me.bitcost(outmv);
+        uint32_t mvCost = m_me.mvcost(outmv);
+        uint32_t cost = (refs[i].cost - mvCost) + m_rdCost.getCost(bits);
+
+        /* Refine MVP selection, updates: mvpIdx, bits, cost */
+        MV mvp = checkBestMVP(amvp, outmv, mvpIdx[i], bits, cost);
+
+        if (cost < bestME[list].cost)
+        {
+            bestME[list].mv      = outmv;
+            bestME[list].mvp     = mvp;
+            bestME[list].mvpIdx  = mvpIdx[i];
+            bestME[list].ref     = ref;
+            bestME[list].cost    = cost;
+            bestME[list].bits    = bits;
+            bestME[list].mvCost  = mvCost;
+        }
+    }
+}
 /* find the best inter prediction for each PU of specified mode */
 void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChromaMC, uint32_t refMasks[2])
 {
@@ -2185,8 +2291,8 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
     CUData& cu = interMode.cu;
     Yuv* predYuv = &interMode.predYuv;
 
-    // 12 mv candidates including lowresMV
-    MV mvc[(MD_ABOVE_LEFT + 1) * 2 + 2];
+    // 11 mv candidates plus lowresMV or the motion field seeds
+    MV mvc[(MD_ABOVE_LEFT + 1) * 2 + 1 + FrameData::MV_FIELD_SEEDS];
 
     const Slice *slice = m_slice;
     int numPart     = cu.getNumPartInter(0);
@@ -2288,6 +2394,7 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
                         if (cand && (mvpSel[cand] == mvpSel[cand - 1] || (cand == 2 && mvpSel[cand] == mvpSel[cand - 2])))
                             continue;
                         setSearchRange(cu, mvpSel[cand], m_param->searchRange, mvmin, mvmax);
+                        m_ctuWork.meSearches++;
                         int bcost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mvpSel[cand], numMvc, mvc, m_param->searchRange, bestmv, m_param->maxSlices,
                             m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
                         if (satdCost > bcost)
@@ -2302,6 +2409,7 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
                 }
                 else
                 {
+                    m_ctuWork.meSearches++;
                     satdCost = m_me.motionEstimate(&slice->m_mref[list][ref], mvmin, mvmax, mvpIn, numMvc, mvc, m_param->searchRange, outmv, m_param->maxSlices,
                         m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
                 }
@@ -2388,8 +2496,15 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
             interMode.bestME[puIdx][0].ref = interMode.bestME[puIdx][1].ref = -1;
             uint32_t refMask = refMasks[puIdx] ? refMasks[puIdx] : (uint32_t)-1;
 
+            /* batched searches of the references of a list, see searchRefsBatched() */
+            bool bBatchRefs = m_param->bMultiRefME && m_param->searchMethod != X265_SEA && !m_param->bEnableHME &&
+                              !m_param->bSourceReferenceEstimation;
+
             for (int list = 0; list < numPredDir; list++)
             {
+                if (bBatchRefs && numRefIdx[list] > 1)
+                    searchRefsBatched(interMode, pu, puIdx, list, refMask);
+                else
                 for (int ref = 0; ref < numRefIdx[list]; ref++)
                 {
                     ProfileCounter(interMode.cu, totalMotionReferences[cuGeom.depth]);
@@ -2413,7 +2528,9 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
                     if (!m_param->analysisSave && !m_param->analysisLoad) /* Prevents load/save outputs from diverging when lowresMV is not available */
                     {
                         MV lmv = getLowresMV(cu, pu, list, ref);
-                        if (lmv.notZero())
+                        if (m_param->bMVField)
+                            numMvc = addMVFieldSeeds(cu, pu, list, ref, mvc, numMvc);
+                        else if (lmv.notZero())
                             mvc[numMvc++] = lmv;
                         if (m_param->bEnableHME)
                             mvp_lowres = lmv;
@@ -2426,6 +2543,7 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
                             m_me.integral[planes] = interMode.fencYuv->m_integral[list][ref][planes] + puX * pu.width + puY * pu.height * m_slice->m_refFrameList[list][ref]->m_reconPic->m_stride;
                     }
                     setSearchRange(cu, mvp, m_param->searchRange, mvmin, mvmax);
+                    m_ctuWork.meSearches++;
                     int satdCost = m_me.motionEstimate(&slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, m_param->searchRange, outmv, m_param->maxSlices, 
                       m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
 
@@ -2433,6 +2551,7 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
                     {
                         MV outmv_lowres;
                         setSearchRange(cu, mvp_lowres, m_param->searchRange, mvmin, mvmax);
+                        m_ctuWork.meSearches++;
                         int lowresMvCost = m_me.motionEstimate(&slice->m_mref[list][ref], mvmin, mvmax, mvp_lowres, numMvc, mvc, m_param->searchRange, outmv_lowres, m_param->maxSlices,
                             m_param->bSourceReferenceEstimation ? m_slice->m_refFrameList[list][ref]->m_fencPic->getLumaAddr(0) : 0);
                         if (lowresMvCost < satdCost)
@@ -2770,6 +2889,7 @@ void Search::setSearchRange(const CUData& cu, const MV& mvp, int merange, MV& mv
 /* Note: this function overwrites the RD cost variables of interMode, but leaves the sa8d cost unharmed */
 void Search::encodeResAndCalcRdSkipCU(Mode& interMode)
 {
+    m_ctuWork.rdEvals++;
     CUData& cu = interMode.cu;
     Yuv* reconYuv = &interMode.reconYuv;
     const Yuv* fencYuv = interMode.fencYuv;
@@ -2821,6 +2941,7 @@ void Search::encodeResAndCalcRdSkipCU(Mode& interMode)
  * Note: this function overwrites the RD cost variables of interMode, but leaves the sa8d cost unharmed */
 void Search::encodeResAndCalcRdInterCU(Mode& interMode, const CUGeom& cuGeom)
 {
+    m_ctuWork.rdEvals++;
     ProfileCUScope(interMode.cu, interRDOElapsedTime[cuGeom.depth], countInterRDO[cuGeom.depth]);
 
     CUData& cu = interMode.cu;
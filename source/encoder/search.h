@@ -268,9 +268,7 @@ public:
     uint8_t*        m_qtTempTransformSkipFlag[3];
 
     pixel*          m_fencScaled;     /* 32x32 buffer for down-scaled version of 64x64 CU fenc */
-    pixel*          m_fencTransposed; /* 32x32 buffer for transposed copy of fenc */
     pixel*          m_intraPred;      /* 32x32 buffer for individual intra predictions */
-    pixel*          m_intraPredAngs;  /* allocation for 33 consecutive (all angular) 32x32 intra predictions */
 
     coeff_t*        m_tsCoeff;        /* transform skip coeff 32x32 */
     int16_t*        m_tsResidual;     /* transform skip residual 32x32 */
@@ -286,6 +284,21 @@ public:
     int32_t         m_sliceMaxY;
     int32_t         m_sliceMinY;
 
+    /* Analysis effort of the CTU being compressed, for param.ctuStatsFile.
+     * Work done by pmode and pme slaves on behalf of this instance is moved
+     * atomically into m_slaveWork */
+    struct CTUWork
+    {
+        int32_t rdEvals;
+        int32_t meSearches;
+        int32_t meSearchSteps;  // integer search steps of m_me, see MotionEstimate::searchSteps
+        int32_t specSubCUs;     // sub-CUs analysed speculatively, see Analysis::SplitSpec
+        int32_t specRetries;    // speculated sub-CUs analysed again since their decisions could not be coded
+    };
+
+    CTUWork         m_ctuWork;
+    CTUWork         m_slaveWork;
+
 #if DETAILED_CU_STATS
     /* Accumulate CU statistics separately for each frame encoder */
     CUStats         m_stats[X265_MAX_FRAME_THREADS];
@@ -328,6 +341,7 @@ public:
     void checkDQPForSplitPred(Mode& mode, const CUGeom& cuGeom);
 
     MV getLowresMV(const CUData& cu, const PredictionUnit& pu, int list, int ref);
+    int addMVFieldSeeds(const CUData& cu, const PredictionUnit& pu, int list, int ref, MV* mvc, int numMvc);
 
     class PME : public BondedTaskGroup
     {
@@ -354,6 +368,7 @@ public:
     };
 
     void     processPME(PME& pme, Search& slave);
+    void     addSlaveWork(Search& slave, const CTUWork& before);
     void     singleMotionEstimation(Search& master, Mode& interMode, const PredictionUnit& pu, int part, int list, int ref);
 
 protected:
@@ -424,6 +439,7 @@ protected:
     const MV& checkBestMVP(const MV amvpCand[2], const MV& mv, int& mvpIdx, uint32_t& outBits, uint32_t& outCost) const;
     void     setSearchRange(const CUData& cu, const MV& mvp, int merange, MV& mvmin, MV& mvmax) const;
     uint32_t mergeEstimation(CUData& cu, const CUGeom& cuGeom, const PredictionUnit& pu, int puIdx, MergeData& m);
+    void     searchRefsBatched(Mode& interMode, const PredictionUnit& pu, int puIdx, int list, uint32_t refMask);
     static void getBlkBits(PartSize cuMode, bool bPSlice, int puIdx, uint32_t lastMode, uint32_t blockBit[3]);
     void      updateMVP(const MV amvp, const MV& mv, uint32_t& outBits, uint32_t& outCost, const MV& alterMVP);
 
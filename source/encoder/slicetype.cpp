@@ -708,7 +708,8 @@ void LookaheadTLD::lowresIntraEstimate(Lowres& fenc, uint32_t qgSize)
     const int cuSize2 = cuSize << 1;
     const int sizeIdx = X265_LOWRES_CU_BITS - 2;
 
-    pixelcmp_t satd = primitives.pu[sizeIdx].satd;
+    /* the costs of the modes are only ever compared against the best cost so far */
+    pixelcmp_bounded_t satd = primitives.pu[sizeIdx].satd_bounded;
     int planar = !!(cuSize >= 8);
 
     int costEst = 0, costEstAq = 0;
@@ -739,11 +740,11 @@ void LookaheadTLD::lowresIntraEstimate(Lowres& fenc, uint32_t qgSize)
 
             /* DC and planar */
             primitives.cu[sizeIdx].intra_pred[DC_IDX](prediction, cuSize, samples, 0, cuSize <= 16);
-            cost = satd(fencIntra, cuSize, prediction, cuSize);
+            cost = satd(fencIntra, cuSize, prediction, cuSize, icost);
             COPY2_IF_LT(icost, cost, ilowmode, DC_IDX);
 
             primitives.cu[sizeIdx].intra_pred[PLANAR_IDX](prediction, cuSize, neighbours[planar], 0, 0);
-            cost = satd(fencIntra, cuSize, prediction, cuSize);
+            cost = satd(fencIntra, cuSize, prediction, cuSize, icost);
             COPY2_IF_LT(icost, cost, ilowmode, PLANAR_IDX);
 
             /* scan angular predictions */
@@ -753,7 +754,7 @@ void LookaheadTLD::lowresIntraEstimate(Lowres& fenc, uint32_t qgSize)
             {
                 filter = !!(g_intraFilterFlags[mode] & cuSize);
                 primitives.cu[sizeIdx].intra_pred[mode](prediction, cuSize, neighbours[filter], mode, cuSize <= 16);
-                cost = satd(fencIntra, cuSize, prediction, cuSize);
+                cost = satd(fencIntra, cuSize, prediction, cuSize, acost);
                 COPY2_IF_LT(acost, cost, alowmode, mode);
             }
             for (uint32_t dist = 2; dist >= 1; dist--)
@@ -764,13 +765,13 @@ void LookaheadTLD::lowresIntraEstimate(Lowres& fenc, uint32_t qgSize)
                 mode = minusmode;
                 filter = !!(g_intraFilterFlags[mode] & cuSize);
                 primitives.cu[sizeIdx].intra_pred[mode](prediction, cuSize, neighbours[filter], mode, cuSize <= 16);
-                cost = satd(fencIntra, cuSize, prediction, cuSize);
+                cost = satd(fencIntra, cuSize, prediction, cuSize, acost);
                 COPY2_IF_LT(acost, cost, alowmode, mode);
 
                 mode = plusmode;
                 filter = !!(g_intraFilterFlags[mode] & cuSize);
                 primitives.cu[sizeIdx].intra_pred[mode](prediction, cuSize, neighbours[filter], mode, cuSize <= 16);
-                cost = satd(fencIntra, cuSize, prediction, cuSize);
+                cost = satd(fencIntra, cuSize, prediction, cuSize, acost);
                 COPY2_IF_LT(acost, cost, alowmode, mode);
             }
             COPY2_IF_LT(icost, acost, ilowmode, alowmode);
@@ -816,11 +817,13 @@ uint32_t LookaheadTLD::weightCostLuma(Lowres& fenc, Lowres& ref, WeightParam& wp
         int denom = wp.log2WeightDenom;
         int round = denom ? 1 << (denom - 1) : 0;
         int correction = IF_INTERNAL_PREC - X265_DEPTH; // intermediate interpolation depth
-        int widthHeight = (int)stride;
+        int padwidth = (fenc.width + 31) & ~31;         // weightp assembly needs even 32 byte widths
 
-        primitives.weight_pp(ref.buffer[0], wbuffer[0], stride, widthHeight, paddedLines,
-            scale, round << correction, denom + correction, offset);
+        /* only the rows and columns measured below are weighted, the borders
+         * are weighted once the final weights are known */
         src = fenc.weightedRef[fenc.frameNum - ref.frameNum].fpelPlane[0];
+        primitives.weight_pp(ref.fpelPlane[0], src, stride, padwidth, fenc.lines,
+            scale, round << correction, denom + correction, offset);
     }
 
     uint32_t cost = 0;
@@ -881,6 +884,7 @@ void LookaheadTLD::weightsAnalyse(Lowres& fenc, Lowres& ref)
     weightedRef.isLowres = true;
     weightedRef.isWeighted = false;
     weightedRef.isHMELowres = ref.bEnableHME;
+    fenc.weightEstimate[deltaIndex].bWeighted = false;
 
     /* epsilon is chosen to require at least a numerator of 127 (with denominator = 128) */
     float guessScale, fencMean, refMean;
@@ -941,6 +945,10 @@ void LookaheadTLD::weightsAnalyse(Lowres& fenc, Lowres& ref)
     {
         SET_WEIGHT(wp, true, minscale, mindenom, minoff);
 
+        fenc.weightEstimate[deltaIndex].bWeighted = true;
+        fenc.weightEstimate[deltaIndex].weight = minscale;
+        fenc.weightEstimate[deltaIndex].denom = mindenom;
+
         // set weighted delta cost
         fenc.weightedCostDelta[deltaIndex] = minscore / origscore;
 
@@ -1142,6 +1150,7 @@ void Lookahead::addPicture(Frame& curFrame, int sliceType)
     {
         if (!m_filled)
             m_filled = true;
+        curFrame.m_decidedTime = x265_mdate();
         m_outputLock.acquire();
         m_outputQueue.pushBack(curFrame);
         m_outputLock.release();
@@ -1721,6 +1730,10 @@ void Lookahead::slicetypeDecide()
     }
     m_inputLock.release();
 
+    int64_t decidedTime = x265_mdate();
+    for (int i = 0; i <= bframes; i++)
+        list[i]->m_decidedTime = decidedTime;
+
     m_outputLock.acquire();
     /* add non-B to output queue */
     int idx = 0;
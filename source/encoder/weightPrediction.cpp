@@ -320,6 +320,26 @@ void weightAnalyse(Slice& slice, Frame& frame, x265_param& param)
             int minscale = weights[plane].inputWeight;
             int minoff = 0;
 
+            /* x264 uses a table lookup here, selecting search range based on preset */
+            int scaleDist = 4;
+            int offsetDist = 2;
+
+            /* refine the luma weights the lookahead found for this reference
+             * rather than searching them again. The lookahead measures without
+             * motion compensation, so references it found no gain for are
+             * still searched in full */
+            if (!plane && !list && param.bWeightpRefine && diffPoc <= param.bframes + 1 && fenc.weightEstimate[diffPoc].bWeighted)
+            {
+                int estDenom = fenc.weightEstimate[diffPoc].denom;
+                int estScale = fenc.weightEstimate[diffPoc].weight;
+                if (estDenom <= mindenom)
+                    minscale = estScale << (mindenom - estDenom);
+                else
+                    minscale = estScale >> (estDenom - mindenom);
+                minscale = x265_clip3(0, 127, minscale);
+                scaleDist = offsetDist = 1;
+            }
+
             if (!plane && diffPoc <= param.bframes + 1)
             {
                 mvs = fenc.lowresMvs[list][diffPoc];
@@ -412,10 +432,6 @@ void weightAnalyse(Slice& slice, Frame& frame, x265_param& param)
             uint32_t minscore = origscore;
             bool bFound = false;
 
-            /* x264 uses a table lookup here, selecting search range based on preset */
-            static const int scaleDist = 4;
-            static const int offsetDist = 2;
-
             int startScale = x265_clip3(0, 127, minscale - scaleDist);
             int endScale   = x265_clip3(0, 127, minscale + scaleDist);
             for (int scale = startScale; scale <= endScale; scale++)
@@ -0,0 +1,192 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "asyncoutput.h"
+
+using namespace X265_NS;
+
+AsyncOutput::AsyncOutput(OutputFile* output, int queueSize)
+{
+    m_output = output;
+    m_queueSize = X265_MAX(queueSize, 2);
+    m_slots = new Slot[m_queueSize];
+    memset(m_slots, 0, sizeof(Slot) * m_queueSize);
+    m_bWriteFail = false;
+    m_bytesWritten = 0;
+    m_bytesReported = 0;
+    m_threadActive = start();
+}
+
+AsyncOutput::~AsyncOutput()
+{
+    for (int i = 0; i < m_queueSize; i++)
+    {
+        X265_FREE(m_slots[i].nal);
+        X265_FREE(m_slots[i].payload);
+    }
+    delete [] m_slots;
+}
+
+void AsyncOutput::release()
+{
+    if (m_threadActive)
+    {
+        Slot* slot = acquireSlot();
+        slot->bExit = true;
+        m_writeCount.incr();
+        stop();
+        m_threadActive = false;
+    }
+    m_output->release();
+    delete this;
+}
+
+AsyncOutput::Slot* AsyncOutput::acquireSlot()
+{
+    /* wait for room in the ring buffer, only the caller adds entries */
+    int written = m_writeCount.get();
+    int read = m_readCount.get();
+    while (written - read >= m_queueSize)
+        read = m_readCount.waitForChange(read);
+
+    return &m_slots[written % m_queueSize];
+}
+
+void AsyncOutput::drain()
+{
+    if (!m_threadActive)
+        return;
+
+    int written = m_writeCount.get();
+    int read = m_readCount.get();
+    while (read != written)
+        read = m_readCount.waitForChange(read);
+}
+
+int AsyncOutput::reportBytes()
+{
+    int64_t bytes = ATOMIC_ADD64(&m_bytesWritten, 0);
+    int ret = (int)(bytes - m_bytesReported);
+    m_bytesReported = bytes;
+    return ret;
+}
+
+int AsyncOutput::flush()
+{
+    drain();
+    return reportBytes();
+}
+
+int AsyncOutput::writeHeaders(const x265_nal* nal, uint32_t nalcount)
+{
+    /* headers are rare and must precede the frames queued after them */
+    drain();
+    return m_output->writeHeaders(nal, nalcount);
+}
+
+int AsyncOutput::writeFrame(const x265_nal* nal, uint32_t nalcount, x265_picture& pic)
+{
+    if (!m_threadActive)
+        return m_output->writeFrame(nal, nalcount, pic);
+
+    Slot* slot = acquireSlot();
+
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < nalcount; i++)
+        size += nal[i].sizeBytes;
+
+    /* the encoder reuses its NAL buffer on the next call, so the payloads are
+     * copied once into the slot; slot buffers only grow and are recycled */
+    if (nalcount > slot->nalAlloc)
+    {
+        X265_FREE(slot->nal);
+        slot->nal = X265_MALLOC(x265_nal, nalcount);
+        slot->nalAlloc = slot->nal ? nalcount : 0;
+    }
+    if (size > slot->payloadAlloc)
+    {
+        uint32_t allocSize = size + (size >> 2);
+        X265_FREE(slot->payload);
+        slot->payload = X265_MALLOC(uint8_t, allocSize);
+        slot->payloadAlloc = slot->payload ? allocSize : 0;
+    }
+    if (!slot->nal || !slot->payload)
+    {
+        x265_log(NULL, X265_LOG_WARNING, "unable to queue output frame, writing synchronously\n");
+        int ret = flush();
+        int bytes = m_output->writeFrame(nal, nalcount, pic);
+        return bytes < 0 ? bytes : ret + bytes;
+    }
+
+    uint8_t* out = slot->payload;
+    for (uint32_t i = 0; i < nalcount; i++)
+    {
+        slot->nal[i] = nal[i];
+        slot->nal[i].payload = out;
+        memcpy(out, nal[i].payload, nal[i].sizeBytes);
+        out += nal[i].sizeBytes;
+    }
+    slot->nalCount = nalcount;
+
+    /* muxers only read the timestamps and slice type of the picture */
+    slot->pic = pic;
+    slot->bExit = false;
+    m_writeCount.incr();
+
+    return reportBytes();
+}
+
+void AsyncOutput::closeFile(int64_t largest_pts, int64_t second_largest_pts)
+{
+    drain();
+    m_output->closeFile(largest_pts, second_largest_pts);
+}
+
+void AsyncOutput::threadMain()
+{
+    THREAD_NAME("Output", 0);
+
+    int read = m_readCount.get();
+    for (;;)
+    {
+        int written = m_writeCount.get();
+        while (read == written)
+            written = m_writeCount.waitForChange(written);
+
+        Slot& slot = m_slots[read % m_queueSize];
+        if (slot.bExit)
+            break;
+
+        /* after a failure the remaining frames are only dequeued */
+        if (!m_bWriteFail)
+        {
+            ProfileScopeEvent(frameWrite);
+            int ret = m_output->writeFrame(slot.nal, slot.nalCount, slot.pic);
+            if (ret < 0)
+                m_bWriteFail = true;
+            else
+                ATOMIC_ADD64(&m_bytesWritten, ret);
+        }
+
+        m_readCount.incr();
+        read++;
+    }
+}
@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_ASYNCOUTPUT_H
+#define X265_ASYNCOUTPUT_H
+
+#include "output.h"
+#include "common.h"
+#include "threading.h"
+
+namespace X265_NS {
+// private x265 namespace
+
+/* Wraps an OutputFile and performs its writeFrame() calls on a dedicated
+ * writer thread, so a slow disk or muxer flush does not stall the encoder.
+ * The encoded frames are held in a bounded ring of slots whose buffers are
+ * recycled; once the ring is full writeFrame() blocks until the writer has
+ * caught up. Bytes written and write errors are reported back with a delay
+ * of at most the queue depth */
+class AsyncOutput : public OutputFile, public Thread
+{
+protected:
+
+    struct Slot
+    {
+        x265_nal*    nal;
+        uint32_t     nalCount;
+        uint32_t     nalAlloc;
+        uint8_t*     payload;
+        uint32_t     payloadAlloc;
+        x265_picture pic;
+        bool         bExit;
+    };
+
+    OutputFile*       m_output;
+    Slot*             m_slots;
+    int               m_queueSize;
+    bool              m_threadActive;
+    volatile bool     m_bWriteFail;
+    int64_t           m_bytesWritten;   // updated by the writer thread
+    int64_t           m_bytesReported;
+
+    ThreadSafeInteger m_readCount;
+    ThreadSafeInteger m_writeCount;
+
+    virtual ~AsyncOutput();
+
+    Slot* acquireSlot();
+    void  drain();
+    int   reportBytes();
+    void  threadMain();
+
+public:
+
+    AsyncOutput(OutputFile* output, int queueSize);
+
+    bool isFail() const { return m_output->isFail() || m_bWriteFail; }
+
+    bool needPTS() const { return m_output->needPTS(); }
+
+    void release();
+
+    const char* getName() const { return m_output->getName(); }
+
+    void setParam(x265_param* param) { m_output->setParam(param); }
+
+    void setPS(x265_encoder* encoder) { drain(); m_output->setPS(encoder); }
+
+    void setChunkFrames(int frames) { m_output->setChunkFrames(frames); }
+
+    int writeHeaders(const x265_nal* nal, uint32_t nalcount);
+
+    int writeFrame(const x265_nal* nal, uint32_t nalcount, x265_picture& pic);
+
+    int flush();
+
+    void closeFile(int64_t largest_pts, int64_t second_largest_pts);
+};
+}
+
+#endif // ifndef X265_ASYNCOUTPUT_H
@@ -0,0 +1,575 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "cmaf.h"
+
+using namespace X265_NS;
+using namespace std;
+
+#define ERR(...) general_log(NULL, "cmaf", X265_LOG_ERROR, __VA_ARGS__)
+
+namespace {
+typedef vector<uint8_t> Buffer;
+
+void put8(Buffer& b, uint32_t v)   { b.push_back((uint8_t)v); }
+void put16(Buffer& b, uint32_t v)  { put8(b, v >> 8); put8(b, v); }
+void put32(Buffer& b, uint32_t v)  { put16(b, v >> 16); put16(b, v); }
+void put64(Buffer& b, uint64_t v)  { put32(b, (uint32_t)(v >> 32)); put32(b, (uint32_t)v); }
+void putTag(Buffer& b, const char* tag) { b.insert(b.end(), tag, tag + 4); }
+void putZeros(Buffer& b, size_t n) { b.insert(b.end(), n, 0); }
+
+void patch32(Buffer& b, size_t pos, uint32_t v)
+{
+    b[pos] = (uint8_t)(v >> 24);
+    b[pos + 1] = (uint8_t)(v >> 16);
+    b[pos + 2] = (uint8_t)(v >> 8);
+    b[pos + 3] = (uint8_t)v;
+}
+
+/* boxes are written with a placeholder size which is patched by endBox() */
+size_t beginBox(Buffer& b, const char* tag)
+{
+    size_t pos = b.size();
+    put32(b, 0);
+    putTag(b, tag);
+    return pos;
+}
+
+size_t beginFullBox(Buffer& b, const char* tag, uint32_t version, uint32_t flags)
+{
+    size_t pos = beginBox(b, tag);
+    put32(b, version << 24 | (flags & 0xffffff));
+    return pos;
+}
+
+void endBox(Buffer& b, size_t pos)
+{
+    patch32(b, pos, (uint32_t)(b.size() - pos));
+}
+
+void putMatrix(Buffer& b)
+{
+    static const uint32_t unity[9] = { 0x10000, 0, 0, 0, 0x10000, 0, 0, 0, 0x40000000 };
+    for (int i = 0; i < 9; i++)
+        put32(b, unity[i]);
+}
+
+/* sample_depends_on 2 for sync samples, else depends_on 1 and non-sync */
+uint32_t sampleFlags(bool bSync)
+{
+    return bSync ? 0x02000000 : 0x01010000;
+}
+}
+
+CMAFOutput::CMAFOutput(const char* fname, InputFileInfo& inputInfo)
+{
+    b_fail = false;
+    m_info = inputInfo;
+    m_segmentFile = NULL;
+    m_width = m_height = 0;
+    m_sarWidth = m_sarHeight = 0;
+    m_bitDepth = 8;
+    m_bWavefront = false;
+    m_chunkFrames = 0;
+    m_numSegments = 0;
+    m_sequence = 0;
+    m_bStarted = false;
+    m_dtsBase = m_segmentStart = 0;
+    m_targetDuration = 1;
+    memset(&m_ptl, 0, sizeof(m_ptl));
+    memset(&m_sps, 0, sizeof(m_sps));
+
+    m_indexFile = x265_fopen(fname, "wb");
+    if (!m_indexFile)
+    {
+        ERR("unable to open index file %s\n", fname);
+        b_fail = true;
+        return;
+    }
+
+    string name(fname);
+    size_t pos = name.find_last_of("/\\");
+    if (pos != string::npos)
+    {
+        m_dirPrefix = name.substr(0, pos + 1);
+        name = name.substr(pos + 1);
+    }
+    pos = name.rfind('.');
+    m_prefix = pos != string::npos ? name.substr(0, pos) : name;
+}
+
+void CMAFOutput::release()
+{
+    if (m_segmentFile)
+        fclose(m_segmentFile);
+    if (m_indexFile)
+        fclose(m_indexFile);
+    delete this;
+}
+
+void CMAFOutput::setParam(x265_param* param)
+{
+    param->bAnnexB = false;
+    param->bRepeatHeaders = false;
+    /* every segment must start with a random access point which does not
+     * reference the previous segment */
+    param->bOpenGOP = false;
+
+    m_width = param->sourceWidth;
+    m_height = param->sourceHeight;
+    m_sarWidth = param->vui.sarWidth;
+    m_sarHeight = param->vui.sarHeight;
+    m_bitDepth = param->internalBitDepth;
+    m_bWavefront = !!param->bEnableWavefront;
+
+    /* the target duration of a playlist may not change while it is live, so
+     * it is taken from the longest GOP rather than the segments seen so far */
+    if (param->keyframeMax > 0 && param->keyframeMax < INT_MAX && param->fpsNum)
+        m_targetDuration = (int)(((int64_t)param->keyframeMax * param->fpsDenom + param->fpsNum - 1) / param->fpsNum);
+}
+
+void CMAFOutput::setPS(x265_encoder* encoder)
+{
+    Encoder* enc = static_cast<Encoder*>(encoder);
+    m_ptl = enc->m_vps.ptl;
+    m_sps = enc->m_sps;
+}
+
+bool CMAFOutput::writeBuffer(FILE* fp, const Buffer& buf)
+{
+    if (fwrite(&buf[0], 1, buf.size(), fp) != buf.size() || fflush(fp))
+    {
+        ERR("write failure, error %d %s\n", errno, strerror(errno));
+        b_fail = true;
+        return false;
+    }
+    return true;
+}
+
+int CMAFOutput::writeHeaders(const x265_nal* nal, uint32_t nalcount)
+{
+    if (nalcount < 3)
+    {
+        ERR("header should contain 3+ nals\n");
+        b_fail = true;
+        return -1;
+    }
+
+    /* HEVCDecoderConfigurationRecord, see ISO/IEC 14496-15 8.3.3 */
+    Buffer& b = m_hvcC;
+    b.clear();
+    put8(b, 1);                                             // configurationVersion
+    put8(b, (m_ptl.tierFlag & 1) << 5 | (m_ptl.profileIdc & 0x1f));
+    uint32_t compat = 0;
+    for (int i = 0; i < 32; i++)
+        compat = compat << 1 | m_ptl.profileCompatibilityFlag[i];
+    put32(b, compat);
+    put8(b, (m_ptl.progressiveSourceFlag & 1) << 7 | (m_ptl.interlacedSourceFlag & 1) << 6 |
+            (m_ptl.nonPackedConstraintFlag & 1) << 5 | (m_ptl.frameOnlyConstraintFlag & 1) << 4);
+    putZeros(b, 5);                                         // remaining constraint flags
+    put8(b, m_ptl.levelIdc);
+    put16(b, 0xf000);                                       // min_spatial_segmentation_idc
+    put8(b, 0xfc | (m_bWavefront ? 3 : 0));                 // parallelismType
+    put8(b, 0xfc | (m_sps.chromaFormatIdc & 3));
+    put8(b, 0xf8 | (m_bitDepth - 8));                       // bitDepthLumaMinus8
+    put8(b, 0xf8 | (m_bitDepth - 8));                       // bitDepthChromaMinus8
+    put16(b, 0);                                            // avgFrameRate
+    /* numTemporalLayers and temporalIdNested are those signalled by the SPS,
+     * whose first byte after the NAL header is sps_video_parameter_set_id(4),
+     * sps_max_sub_layers_minus1(3) and sps_temporal_id_nesting_flag(1) */
+    uint32_t numTemporalLayers = m_sps.maxTempSubLayers;
+    uint32_t temporalIdNested = m_sps.maxTempSubLayers == 1;
+    for (uint32_t i = 0; i < nalcount; i++)
+    {
+        if (nal[i].type == NAL_UNIT_SPS && nal[i].sizeBytes > 6)
+        {
+            numTemporalLayers = ((nal[i].payload[6] >> 1) & 7) + 1;
+            temporalIdNested = nal[i].payload[6] & 1;
+        }
+    }
+    put8(b, (numTemporalLayers & 7) << 3 | temporalIdNested << 2 | 3); // lengthSizeMinusOne
+    put8(b, nalcount);                                      // numOfArrays
+
+    /* one array per NAL, parameter sets are only stored here (hvc1) */
+    int bytes = 0;
+    for (uint32_t i = 0; i < nalcount; i++)
+    {
+        uint32_t size = nal[i].sizeBytes - 4;
+        put8(b, 0x80 | (nal[i].type & 0x3f));               // array_completeness
+        put16(b, 1);                                        // numNalus
+        put16(b, size);
+        b.insert(b.end(), nal[i].payload + 4, nal[i].payload + 4 + size);
+        bytes += nal[i].sizeBytes;
+    }
+
+    return bytes;
+}
+
+bool CMAFOutput::writeInit(int64_t firstPts)
+{
+    uint32_t timescale = m_info.timebaseDenom;
+    uint32_t tick = m_info.timebaseNum;
+
+    Buffer b;
+    size_t box = beginBox(b, "ftyp");
+    putTag(b, "cmfc");
+    put32(b, 0);
+    putTag(b, "iso6");
+    putTag(b, "cmfc");
+    endBox(b, box);
+
+    size_t moov = beginBox(b, "moov");
+
+    box = beginFullBox(b, "mvhd", 0, 0);
+    put32(b, 0);                                            // creation_time
+    put32(b, 0);                                            // modification_time
+    put32(b, timescale);
+    put32(b, 0);                                            // duration, unknown
+    put32(b, 0x10000);                                      // rate
+    put16(b, 0x100);                                        // volume
+    putZeros(b, 10);
+    putMatrix(b);
+    putZeros(b, 24);
+    put32(b, 2);                                            // next_track_ID
+    endBox(b, box);
+
+    size_t trak = beginBox(b, "trak");
+    box = beginFullBox(b, "tkhd", 0, 3);                    // enabled, in movie
+    put32(b, 0);
+    put32(b, 0);
+    put32(b, 1);                                            // track_ID
+    put32(b, 0);
+    put32(b, 0);                                            // duration
+    putZeros(b, 8);
+    put16(b, 0);                                            // layer
+    put16(b, 0);                                            // alternate_group
+    put16(b, 0);                                            // volume
+    put16(b, 0);
+    putMatrix(b);
+    uint64_t displayWidth = m_width;
+    if (m_sarWidth && m_sarHeight)
+        displayWidth = displayWidth * m_sarWidth / m_sarHeight;
+    put32(b, (uint32_t)(displayWidth << 16));
+    put32(b, (uint32_t)m_height << 16);
+    endBox(b, box);
+
+    /* the decode timeline starts at the first DTS, shift the presentation of
+     * the first picture back to zero */
+    size_t edts = beginBox(b, "edts");
+    box = beginFullBox(b, "elst", 0, 0);
+    put32(b, 1);
+    put32(b, 0);                                            // segment_duration, unknown
+    put32(b, (uint32_t)((firstPts - m_dtsBase) * tick));    // media_time
+    put32(b, 0x10000);                                      // media_rate
+    endBox(b, box);
+    endBox(b, edts);
+
+    size_t mdia = beginBox(b, "mdia");
+    box = beginFullBox(b, "mdhd", 0, 0);
+    put32(b, 0);
+    put32(b, 0);
+    put32(b, timescale);
+    put32(b, 0);
+    put16(b, 0x55c4);                                       // 'und'
+    put16(b, 0);
+    endBox(b, box);
+
+    box = beginFullBox(b, "hdlr", 0, 0);
+    put32(b, 0);
+    putTag(b, "vide");
+    putZeros(b, 12);
+    const char handler[] = "x265 video";
+    b.insert(b.end(), handler, handler + sizeof(handler));
+    endBox(b, box);
+
+    size_t minf = beginBox(b, "minf");
+    box = beginFullBox(b, "vmhd", 0, 1);
+    putZeros(b, 8);
+    endBox(b, box);
+
+    size_t dinf = beginBox(b, "dinf");
+    size_t dref = beginFullBox(b, "dref", 0, 0);
+    put32(b, 1);
+    box = beginFullBox(b, "url ", 0, 1);                    // media in the same file
+    endBox(b, box);
+    endBox(b, dref);
+    endBox(b, dinf);
+
+    size_t stbl = beginBox(b, "stbl");
+    size_t stsd = beginFullBox(b, "stsd", 0, 0);
+    put32(b, 1);
+    size_t entry = beginBox(b, "hvc1");
+    putZeros(b, 6);
+    put16(b, 1);                                            // data_reference_index
+    putZeros(b, 16);
+    put16(b, m_width);
+    put16(b, m_height);
+    put32(b, 0x480000);                                     // 72 dpi
+    put32(b, 0x480000);
+    put32(b, 0);
+    put16(b, 1);                                            // frame_count
+    const char compressor[] = "\x04x265";
+    b.insert(b.end(), compressor, compressor + 5);
+    putZeros(b, 32 - 5);
+    put16(b, 0x18);                                         // depth
+    put16(b, 0xffff);
+    box = beginBox(b, "hvcC");
+    b.insert(b.end(), m_hvcC.begin(), m_hvcC.end());
+    endBox(b, box);
+    if (m_sarWidth && m_sarHeight)
+    {
+        box = beginBox(b, "pasp");
+        put32(b, m_sarWidth);
+        put32(b, m_sarHeight);
+        endBox(b, box);
+    }
+    endBox(b, entry);
+    endBox(b, stsd);
+
+    /* all samples are described by the movie fragments */
+    static const char* emptyTables[] = { "stts", "stsc", "stco" };
+    for (int i = 0; i < 3; i++)
+    {
+        box = beginFullBox(b, emptyTables[i], 0, 0);
+        put32(b, 0);
+        endBox(b, box);
+    }
+    box = beginFullBox(b, "stsz", 0, 0);
+    put32(b, 0);
+    put32(b, 0);
+    endBox(b, box);
+    endBox(b, stbl);
+    endBox(b, minf);
+    endBox(b, mdia);
+    endBox(b, trak);
+
+    size_t mvex = beginBox(b, "mvex");
+    box = beginFullBox(b, "trex", 0, 0);
+    put32(b, 1);                                            // track_ID
+    put32(b, 1);                                            // default_sample_description_index
+    put32(b, 0);
+    put32(b, 0);
+    put32(b, 0);
+    endBox(b, box);
+    endBox(b, mvex);
+    endBox(b, moov);
+
+    string initName = m_prefix + "-init.mp4";
+    FILE* fp = x265_fopen((m_dirPrefix + initName).c_str(), "wb");
+    if (!fp)
+    {
+        ERR("unable to open %s\n", initName.c_str());
+        b_fail = true;
+        return false;
+    }
+    bool ok = writeBuffer(fp, b);
+    fclose(fp);
+    if (ok)
+    {
+        fprintf(m_indexFile, "#init %s\n", initName.c_str());
+        fflush(m_indexFile);
+    }
+    return ok;
+}
+
+bool CMAFOutput::openSegment()
+{
+    char name[32];
+    sprintf(name, "-%05d.m4s", ++m_numSegments);
+    string segName = m_prefix + name;
+    m_segmentFile = x265_fopen((m_dirPrefix + segName).c_str(), "wb");
+    if (!m_segmentFile)
+    {
+        ERR("unable to open %s\n", segName.c_str());
+        b_fail = true;
+        return false;
+    }
+
+    Buffer b;
+    size_t box = beginBox(b, "styp");
+    putTag(b, "msdh");
+    put32(b, 0);
+    putTag(b, "msdh");
+    putTag(b, "cmfs");
+    endBox(b, box);
+    return writeBuffer(m_segmentFile, b);
+}
+
+bool CMAFOutput::closeSegment(int64_t endDts)
+{
+    if (!m_segmentFile)
+        return true;
+
+    fclose(m_segmentFile);
+    m_segmentFile = NULL;
+
+    /* the segment is listed in the index only once it is complete */
+    double duration = (double)(endDts - m_segmentStart) * m_info.timebaseNum / m_info.timebaseDenom;
+    fprintf(m_indexFile, "%s-%05d.m4s %.6f\n", m_prefix.c_str(), m_numSegments, duration);
+    fflush(m_indexFile);
+    m_durations.push_back(duration);
+    return writePlaylist(false);
+}
+
+bool CMAFOutput::writePlaylist(bool bEnd)
+{
+    for (size_t i = 0; i < m_durations.size(); i++)
+        m_targetDuration = X265_MAX(m_targetDuration, (int)(m_durations[i] + 0.5));
+
+    /* write a temporary file and rename it over the playlist, so a server
+     * never hands out a partially written playlist */
+    string name = m_dirPrefix + m_prefix + ".m3u8";
+    string tmpName = name + ".tmp";
+    FILE* fp = x265_fopen(tmpName.c_str(), "wb");
+    if (!fp)
+    {
+        ERR("unable to open %s\n", tmpName.c_str());
+        b_fail = true;
+        return false;
+    }
+
+    fprintf(fp, "#EXTM3U\n#EXT-X-VERSION:7\n#EXT-X-TARGETDURATION:%d\n", m_targetDuration);
+    fprintf(fp, "#EXT-X-MEDIA-SEQUENCE:1\n#EXT-X-PLAYLIST-TYPE:%s\n", bEnd ? "VOD" : "EVENT");
+    fprintf(fp, "#EXT-X-INDEPENDENT-SEGMENTS\n#EXT-X-MAP:URI=\"%s-init.mp4\"\n", m_prefix.c_str());
+    for (size_t i = 0; i < m_durations.size(); i++)
+        fprintf(fp, "#EXTINF:%.6f,\n%s-%05d.m4s\n", m_durations[i], m_prefix.c_str(), (int)i + 1);
+    if (bEnd)
+        fprintf(fp, "#EXT-X-ENDLIST\n");
+
+    bool ok = !ferror(fp);
+    ok &= !fclose(fp);
+#ifdef _WIN32
+    remove(name.c_str());
+#endif
+    if (!ok || rename(tmpName.c_str(), name.c_str()))
+    {
+        ERR("unable to write playlist %s\n", name.c_str());
+        b_fail = true;
+        return false;
+    }
+    return true;
+}
+
+bool CMAFOutput::writeChunk(int64_t nextDts)
+{
+    if (m_samples.empty())
+        return true;
+
+    uint32_t tick = m_info.timebaseNum;
+    uint32_t numSamples = (uint32_t)m_samples.size();
+
+    Buffer b;
+    size_t moof = beginBox(b, "moof");
+    size_t box = beginFullBox(b, "mfhd", 0, 0);
+    put32(b, ++m_sequence);
+    endBox(b, box);
+
+    size_t traf = beginBox(b, "traf");
+    box = beginFullBox(b, "tfhd", 0, 0x020000);             // default-base-is-moof
+    put32(b, 1);
+    endBox(b, box);
+
+    box = beginFullBox(b, "tfdt", 1, 0);
+    put64(b, (uint64_t)(m_samples[0].dts - m_dtsBase) * tick);
+    endBox(b, box);
+
+    /* data offset, duration, size, flags and signed composition offset */
+    box = beginFullBox(b, "trun", 1, 0x000f01);
+    put32(b, numSamples);
+    size_t dataOffset = b.size();
+    put32(b, 0);
+    for (uint32_t i = 0; i < numSamples; i++)
+    {
+        const Sample& s = m_samples[i];
+        int64_t next = i + 1 < numSamples ? m_samples[i + 1].dts : nextDts;
+        put32(b, (uint32_t)((next - s.dts) * tick));
+        put32(b, s.size);
+        put32(b, sampleFlags(s.bSync));
+        put32(b, (uint32_t)(int32_t)((s.pts - s.dts) * tick));
+    }
+    endBox(b, box);
+    endBox(b, traf);
+    endBox(b, moof);
+
+    patch32(b, dataOffset, (uint32_t)(b.size() - moof + 8));
+    put32(b, (uint32_t)(m_mdat.size() + 8));
+    putTag(b, "mdat");
+    b.insert(b.end(), m_mdat.begin(), m_mdat.end());
+
+    m_samples.clear();
+    m_mdat.clear();
+    return writeBuffer(m_segmentFile, b);
+}
+
+int CMAFOutput::writeFrame(const x265_nal* nal, uint32_t nalcount, x265_picture& pic)
+{
+    bool bSync = pic.sliceType == X265_TYPE_IDR;
+
+    if (!m_bStarted)
+    {
+        m_bStarted = true;
+        m_dtsBase = m_segmentStart = pic.dts;
+        if (!writeInit(pic.pts) || !openSegment())
+            return -1;
+    }
+    else if (bSync)
+    {
+        /* segments begin with an IDR picture */
+        if (!writeChunk(pic.dts) || !closeSegment(pic.dts) || !openSegment())
+            return -1;
+        m_segmentStart = pic.dts;
+    }
+    else if (m_chunkFrames && (int)m_samples.size() >= m_chunkFrames)
+    {
+        if (!writeChunk(pic.dts))
+            return -1;
+    }
+
+    Sample s;
+    s.size = 0;
+    s.dts = pic.dts;
+    s.pts = pic.pts;
+    s.bSync = bSync;
+    for (uint32_t i = 0; i < nalcount; i++)
+    {
+        m_mdat.insert(m_mdat.end(), nal[i].payload, nal[i].payload + nal[i].sizeBytes);
+        s.size += nal[i].sizeBytes;
+    }
+    m_samples.push_back(s);
+
+    return s.size;
+}
+
+void CMAFOutput::closeFile(int64_t largest_pts, int64_t second_largest_pts)
+{
+    if (m_bStarted && m_segmentFile && !m_samples.empty())
+    {
+        /* the last sample lasts as long as the last presentation interval */
+        int64_t lastDuration = largest_pts - second_largest_pts;
+        if (lastDuration <= 0)
+            lastDuration = 1;
+        int64_t endDts = m_samples.back().dts + lastDuration;
+        if (writeChunk(endDts))
+            closeSegment(endDts);
+    }
+    if (m_bStarted && !b_fail)
+        writePlaylist(true);
+}
@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_HEVC_CMAF_H
+#define X265_HEVC_CMAF_H
+
+#include "output.h"
+#include "common.h"
+#include "encoder.h"
+#include <string>
+#include <vector>
+
+namespace X265_NS {
+
+/* Fragmented MP4 (CMAF) output. For an output file name <prefix>.cmaf the
+ * muxer writes a CMAF header <prefix>-init.mp4 and one media segment file
+ * <prefix>-NNNNN.m4s per closed GOP, each beginning with an IDR picture.
+ * Within a segment a moof/mdat chunk is appended and flushed every
+ * chunkFrames pictures (or once per segment when zero), so a packager can
+ * serve a segment while it is still being written. <prefix>.cmaf itself is
+ * an index listing the init segment and every segment once it is complete,
+ * with its duration in seconds. The same list is kept as an HLS media
+ * playlist <prefix>.m3u8, rewritten whenever a segment completes and ended
+ * with EXT-X-ENDLIST when the file is closed */
+class CMAFOutput : public OutputFile
+{
+protected:
+
+    struct Sample
+    {
+        uint32_t size;
+        int64_t  dts;
+        int64_t  pts;
+        bool     bSync;
+    };
+
+    bool     b_fail;
+    FILE*    m_indexFile;
+    FILE*    m_segmentFile;
+    std::string m_prefix;
+    std::string m_dirPrefix;
+    InputFileInfo m_info;
+
+    ProfileTierLevel m_ptl;
+    SPS      m_sps;
+    int      m_width;
+    int      m_height;
+    int      m_sarWidth;
+    int      m_sarHeight;
+    int      m_bitDepth;
+    bool     m_bWavefront;
+    std::vector<uint8_t> m_hvcC;
+
+    int      m_chunkFrames;
+    int      m_numSegments;
+    uint32_t m_sequence;       // moof sequence number, across segments
+    bool     m_bStarted;
+    int64_t  m_dtsBase;        // decode time of the first sample
+    int64_t  m_segmentStart;   // decode time of the first sample of the segment
+    std::vector<Sample>  m_samples;
+    std::vector<uint8_t> m_mdat;
+    std::vector<double>  m_durations; // of the completed segments, in seconds
+    int      m_targetDuration; // EXT-X-TARGETDURATION, derived from the keyframe interval
+
+    bool writeInit(int64_t firstPts);
+    bool openSegment();
+    bool closeSegment(int64_t endDts);
+    bool writeChunk(int64_t nextDts);
+    bool writePlaylist(bool bEnd);
+    bool writeBuffer(FILE* fp, const std::vector<uint8_t>& buf);
+
+public:
+
+    CMAFOutput(const char* fname, InputFileInfo& inputInfo);
+
+    bool isFail() const { return b_fail; }
+
+    bool needPTS() const { return true; }
+
+    void release();
+
+    const char* getName() const { return "cmaf"; }
+
+    void setParam(x265_param* param);
+
+    void setPS(x265_encoder* encoder);
+
+    void setChunkFrames(int frames) { m_chunkFrames = frames; }
+
+    int writeHeaders(const x265_nal* nal, uint32_t nalcount);
+
+    int writeFrame(const x265_nal* nal, uint32_t nalcount, x265_picture& pic);
+
+    void closeFile(int64_t largest_pts, int64_t second_largest_pts);
+};
+}
+
+#endif // ifndef X265_HEVC_CMAF_H
@@ -40,6 +40,10 @@ static inline int x264_is_regular_file( FILE *filehandle )
 }
 
 #define CLSIZE 1048576
+/* clusters are closed once they exceed CLSIZE, the slack holds the last frame */
+#define CLALLOC (CLSIZE + (CLSIZE >> 1))
+/* room reserved after the Segment header for the SeekHead written at close */
+#define SEEKHEAD_RESERVED 96
 #define CHECK(x)\
 do {\
     if( (x) < 0 )\
@@ -58,22 +62,35 @@ struct mk_context
 
 typedef struct mk_context mk_context;
 
+typedef struct
+{
+    int64_t time;         // in TimecodeScale units
+    int64_t cluster_pos;  // relative to the segment data, -1 until the cluster is written
+} mk_cue;
+
 struct mk_writer
 {
     FILE *fp;
+    int64_t file_pos;
 
     unsigned duration_ptr;
+    int64_t segment_pos;
+    int64_t seekhead_pos, info_pos, tracks_pos;
 
     mk_context *root, *cluster, *frame;
     mk_context *freelist;
     mk_context *actlist;
+    mk_context *cluster_pool;
+
+    mk_cue *cues;
+    unsigned num_cues, max_cues;
 
     int64_t def_duration;
     int64_t timescale;
     int64_t cluster_tc_scaled;
     int64_t frame_tc, max_frame_tc;
 
-    char wrote_header, in_frame, keyframe, skippable;
+    char wrote_header, in_frame, keyframe, random_access, skippable;
 };
 
 typedef struct mk_writer mk_writer;
@@ -133,6 +150,31 @@ static int mk_append_context_data( mk_context *c, const void *data, unsigned siz
     return 0;
 }
 
+static int mk_reserve_context_data( mk_context *c, unsigned size )
+{
+    if( size <= c->d_max )
+        return 0;
+
+    void *dp = realloc( c->data, size );
+    if( !dp )
+        return -1;
+
+    c->data = dp;
+    c->d_max = size;
+
+    return 0;
+}
+
+static int mk_write_file( mk_writer *w, const void *data, unsigned size )
+{
+    if( fwrite( data, size, 1, w->fp ) != 1 )
+        return -1;
+
+    w->file_pos += size;
+
+    return 0;
+}
+
 static int mk_write_id( mk_context *c, unsigned id )
 {
     unsigned char c_id[4] = {
@@ -203,8 +245,8 @@ static int mk_flush_context_data( mk_context *c )
 
     if( c->parent )
         CHECK( mk_append_context_data( c->parent, c->data, c->d_cur ) );
-    else if( fwrite( c->data, c->d_cur, 1, c->owner->fp ) != 1 )
-        return -1;
+    else
+        CHECK( mk_write_file( c->owner, c->data, c->d_cur ) );
 
     c->d_cur = 0;
 
@@ -251,7 +293,21 @@ static void mk_destroy_contexts( mk_writer *w )
         free( cur );
     }
 
-    w->freelist = w->actlist = w->root = NULL;
+    if( w->cluster )
+    {
+        w->cluster->next = w->cluster_pool;
+        w->cluster_pool = w->cluster;
+        w->cluster = NULL;
+    }
+
+    for( mk_context *cur = w->cluster_pool; cur; cur = next )
+    {
+        next = cur->next;
+        free( cur->data );
+        free( cur );
+    }
+
+    w->freelist = w->actlist = w->cluster_pool = w->root = NULL;
 }
 
 static int mk_write_string( mk_context *c, unsigned id, const char *str )
@@ -319,6 +375,21 @@ static int mk_write_float( mk_context *c, unsigned id, float f )
     return 0;
 }
 
+/* EBML Void element spanning exactly size bytes, size >= 2 */
+static int mk_write_void( mk_context *c, unsigned size )
+{
+    static const unsigned char zeros[SEEKHEAD_RESERVED] = { 0 };
+    unsigned payload = size - 2;
+
+    if( size < 2 || payload >= 0x7f || payload > sizeof(zeros) )
+        return -1;
+
+    CHECK( mk_write_id( c, 0xec ) ); // Void
+    CHECK( mk_write_size( c, payload ) );
+    CHECK( mk_append_context_data( c, zeros, payload ) );
+    return 0;
+}
+
 mk_writer *mk_create_writer( const char *filename )
 {
     mk_writer *w = (mk_writer*)calloc( 1, sizeof(mk_writer) );
@@ -379,6 +450,11 @@ int mk_write_header( mk_writer *w, const char *writing_app,
         return -1;
     CHECK( mk_flush_context_id( c ) );
     CHECK( mk_close_context( c, 0 ) );
+    w->segment_pos = w->root->d_cur;
+
+    /* placeholder for the SeekHead, which needs the position of the Cues */
+    w->seekhead_pos = w->root->d_cur;
+    CHECK( mk_write_void( w->root, SEEKHEAD_RESERVED ) );
 
     if( !(c = mk_create_context( w, w->root, 0x1549a966 )) ) // SegmentInfo
         return -1;
@@ -387,6 +463,7 @@ int mk_write_header( mk_writer *w, const char *writing_app,
     CHECK( mk_write_uint( c, 0x2ad7b1, w->timescale ) );
     CHECK( mk_write_float( c, 0x4489, 0) );
     w->duration_ptr = c->d_cur - 4;
+    w->info_pos = w->root->d_cur;
     CHECK( mk_close_context( c, &w->duration_ptr ) );
 
     if( !(c = mk_create_context( w, w->root, 0x1654ae6b )) ) // tracks
@@ -416,6 +493,7 @@ int mk_write_header( mk_writer *w, const char *writing_app,
 
     CHECK( mk_close_context( ti, 0 ) );
 
+    w->tracks_pos = w->root->d_cur;
     CHECK( mk_close_context( c, 0 ) );
 
     CHECK( mk_flush_context_data( w->root ) );
@@ -425,13 +503,79 @@ int mk_write_header( mk_writer *w, const char *writing_app,
     return 0;
 }
 
+static mk_context *mk_create_cluster( mk_writer *w )
+{
+    mk_context *c = w->cluster_pool;
+
+    if( c )
+        w->cluster_pool = c->next;
+    else
+    {
+        c = (mk_context*)calloc( 1, sizeof(mk_context) );
+        if( !c )
+            return NULL;
+        if( mk_reserve_context_data( c, CLALLOC ) < 0 )
+        {
+            free( c );
+            return NULL;
+        }
+    }
+
+    c->parent = w->root;
+    c->owner = w;
+    c->id = 0x1f43b675; // Cluster
+    c->next = NULL;
+    c->prev = NULL;
+    c->d_cur = 0;
+
+    return c;
+}
+
+/* clusters bypass the root context: their header is flushed through the root
+ * and the payload written straight from the pooled buffer */
 static int mk_close_cluster( mk_writer *w )
 {
-    if( w->cluster == NULL )
+    mk_context *c = w->cluster;
+
+    if( c == NULL )
         return 0;
-    CHECK( mk_close_context( w->cluster, 0 ) );
-    w->cluster = NULL;
+
     CHECK( mk_flush_context_data( w->root ) );
+
+    /* resolve the Cues of the keyframes in this cluster */
+    int64_t cluster_pos = w->file_pos - w->segment_pos;
+    for( unsigned i = w->num_cues; i > 0 && w->cues[i - 1].cluster_pos < 0; i-- )
+        w->cues[i - 1].cluster_pos = cluster_pos;
+
+    CHECK( mk_write_id( w->root, c->id ) );
+    CHECK( mk_write_size( w->root, c->d_cur ) );
+    CHECK( mk_flush_context_data( w->root ) );
+    CHECK( mk_write_file( w, c->data, c->d_cur ) );
+
+    c->d_cur = 0;
+    c->next = w->cluster_pool;
+    w->cluster_pool = c;
+    w->cluster = NULL;
+
+    return 0;
+}
+
+static int mk_add_cue( mk_writer *w, int64_t time )
+{
+    if( w->num_cues == w->max_cues )
+    {
+        unsigned n = w->max_cues ? w->max_cues << 1 : 256;
+        mk_cue *cues = (mk_cue*)realloc( w->cues, n * sizeof(mk_cue) );
+        if( !cues )
+            return -1;
+        w->cues = cues;
+        w->max_cues = n;
+    }
+
+    w->cues[w->num_cues].time = time;
+    w->cues[w->num_cues].cluster_pos = -1;
+    w->num_cues++;
+
     return 0;
 }
 
@@ -451,7 +595,7 @@ static int mk_flush_frame( mk_writer *w )
     if( !w->cluster )
     {
         w->cluster_tc_scaled = w->frame_tc / w->timescale;
-        w->cluster = mk_create_context( w, w->root, 0x1f43b675 ); // Cluster
+        w->cluster = mk_create_cluster( w );
         if( !w->cluster )
             return -1;
 
@@ -460,6 +604,9 @@ static int mk_flush_frame( mk_writer *w )
         delta = 0;
     }
 
+    if( w->keyframe || w->random_access )
+        CHECK( mk_add_cue( w, w->frame_tc / w->timescale ) );
+
     fsize = w->frame ? w->frame->d_cur : 0;
 
     CHECK( mk_write_id( w->cluster, 0xa3 ) ); // SimpleBlock
@@ -491,18 +638,20 @@ int mk_start_frame( mk_writer *w )
 
     w->in_frame  = 1;
     w->keyframe  = 0;
+    w->random_access = 0;
     w->skippable = 0;
 
     return 0;
 }
 
-int mk_set_frame_flags( mk_writer *w, int64_t timestamp, int keyframe, int skippable )
+int mk_set_frame_flags( mk_writer *w, int64_t timestamp, int keyframe, int random_access, int skippable )
 {
     if( !w->in_frame )
         return -1;
 
     w->frame_tc  = timestamp;
     w->keyframe  = keyframe  != 0;
+    w->random_access = random_access != 0;
     w->skippable = skippable != 0;
 
     if( w->max_frame_tc < timestamp )
@@ -523,13 +672,81 @@ int mk_add_frame_data( mk_writer *w, const void *data, unsigned size )
     return mk_append_context_data( w->frame, data, size );
 }
 
+static int mk_write_cues( mk_writer *w )
+{
+    mk_context *c, *cp, *tp;
+
+    if( !(c = mk_create_context( w, w->root, 0x1c53bb6b )) ) // Cues
+        return -1;
+    for( unsigned i = 0; i < w->num_cues; i++ )
+    {
+        if( !(cp = mk_create_context( w, c, 0xbb )) ) // CuePoint
+            return -1;
+        CHECK( mk_write_uint( cp, 0xb3, w->cues[i].time ) ); // CueTime
+        if( !(tp = mk_create_context( w, cp, 0xb7 )) ) // CueTrackPositions
+            return -1;
+        CHECK( mk_write_uint( tp, 0xf7, 1 ) ); // CueTrack
+        CHECK( mk_write_uint( tp, 0xf1, w->cues[i].cluster_pos ) ); // CueClusterPosition
+        CHECK( mk_close_context( tp, 0 ) );
+        CHECK( mk_close_context( cp, 0 ) );
+    }
+    CHECK( mk_close_context( c, 0 ) );
+    return mk_flush_context_data( w->root );
+}
+
+static int mk_write_seek( mk_context *c, unsigned id, int64_t pos )
+{
+    unsigned char c_id[4] = {
+        static_cast<unsigned char>(id >> 24),
+        static_cast<unsigned char>(id >> 16),
+        static_cast<unsigned char>(id >> 8),
+        static_cast<unsigned char>(id) };
+    mk_context *s;
+
+    if( !(s = mk_create_context( c->owner, c, 0x4dbb )) ) // Seek
+        return -1;
+    CHECK( mk_write_bin( s, 0x53ab, c_id, 4 ) ); // SeekID
+    CHECK( mk_write_uint( s, 0x53ac, pos ) ); // SeekPosition
+    return mk_close_context( s, 0 );
+}
+
+/* overwrite the reserved Void after the Segment header with a SeekHead and
+ * a Void covering the remainder of the reserved space */
+static int mk_write_seekhead( mk_writer *w, int64_t cues_pos )
+{
+    mk_context *c;
+
+    if( !(c = mk_create_context( w, w->root, 0x114d9b74 )) ) // SeekHead
+        return -1;
+    CHECK( mk_write_seek( c, 0x1549a966, w->info_pos - w->segment_pos ) );
+    CHECK( mk_write_seek( c, 0x1654ae6b, w->tracks_pos - w->segment_pos ) );
+    CHECK( mk_write_seek( c, 0x1c53bb6b, cues_pos - w->segment_pos ) );
+    CHECK( mk_close_context( c, 0 ) );
+    if( w->root->d_cur + 2 > SEEKHEAD_RESERVED )
+        return -1;
+    CHECK( mk_write_void( w->root, SEEKHEAD_RESERVED - w->root->d_cur ) );
+
+    fseek( w->fp, w->seekhead_pos, SEEK_SET );
+    return mk_flush_context_data( w->root );
+}
+
 int mk_close( mk_writer *w, int64_t last_delta )
 {
     int ret = 0;
+    int64_t cues_pos = 0;
     if( mk_flush_frame( w ) < 0 || mk_close_cluster( w ) < 0 )
         ret = -1;
+    if( w->wrote_header && !ret )
+    {
+        cues_pos = w->file_pos;
+        if( mk_write_cues( w ) < 0 )
+            ret = -1;
+    }
     if( w->wrote_header && x264_is_regular_file( w->fp ) )
     {
+        if( !ret && mk_write_seekhead( w, cues_pos ) < 0 )
+            ret = -1;
+
         fseek( w->fp, w->duration_ptr, SEEK_SET );
         int64_t last_frametime = w->def_duration ? w->def_duration : last_delta;
         int64_t total_duration = w->max_frame_tc+last_frametime;
@@ -539,6 +756,7 @@ int mk_close( mk_writer *w, int64_t last_delta )
     }
     mk_destroy_contexts( w );
     fclose( w->fp );
+    free( w->cues );
     free( w );
     return ret;
 }
@@ -46,7 +46,7 @@ int mk_write_header( mk_writer *w, const char *writing_app,
 
 int mk_start_frame( mk_writer *w );
 int mk_add_frame_data( mk_writer *w, const void *data, unsigned size );
-int mk_set_frame_flags( mk_writer *w, int64_t timestamp, int keyframe, int skippable );
+int mk_set_frame_flags( mk_writer *w, int64_t timestamp, int keyframe, int random_access, int skippable );
 int mk_close( mk_writer *w, int64_t last_delta );
 
 #endif
@@ -283,6 +283,7 @@ int MKVOutput::writeFrame(const x265_nal* p_nalu, uint32_t nalcount, x265_pictur
 {
     const bool b_keyframe = pic.sliceType == X265_TYPE_IDR;
     const bool b_bframe = pic.sliceType == X265_TYPE_B;
+    bool b_irap = b_keyframe;
 
     if (!p_mkv->b_writing_frame)
     {
@@ -303,13 +304,17 @@ int MKVOutput::writeFrame(const x265_nal* p_nalu, uint32_t nalcount, x265_pictur
             return -1;
         }
         totalBytes += p_nalu[i].sizeBytes;
+        /* CRA and BLA pictures are indexed like IDRs, but are not flagged as
+         * keyframes since their leading pictures may not be decodable */
+        if (p_nalu[i].type >= NAL_UNIT_CODED_SLICE_BLA_W_LP && p_nalu[i].type <= NAL_UNIT_CODED_SLICE_CRA)
+            b_irap = true;
     }
 
     int64_t i_stamp = (int64_t)((pic.pts * 1e9 * p_mkv->i_timebase_num / p_mkv->i_timebase_den) + 0.5);
 
     p_mkv->b_writing_frame = 0;
 
-    if (mk_set_frame_flags(p_mkv->w, i_stamp, b_keyframe, b_bframe) < 0)
+    if (mk_set_frame_flags(p_mkv->w, i_stamp, b_keyframe, b_irap, b_bframe) < 0)
     {
         ERR("Error from mk_set_frame_flags!\n");
         return -1;
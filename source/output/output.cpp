@@ -26,6 +26,7 @@
 #include "yuv.h"
 #include "y4m.h"
 #include "gop.h"
+#include "cmaf.h"
 
 #include "raw.h"
 
@@ -61,6 +62,8 @@ OutputFile* OutputFile::open(const char *fname, InputFileInfo& inputInfo)
 #endif
     if (s && !strcmp(s, ".gop"))
         return new GOPOutput(fname, inputInfo);
+    if (s && !strcmp(s, ".cmaf"))
+        return new CMAFOutput(fname, inputInfo);
 
     return new RAWOutput(fname, inputInfo);
 }
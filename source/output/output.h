@@ -78,10 +78,16 @@ public:
 
     virtual void setPS(x265_encoder*) { }
 
+    /* pictures per movie fragment of fragmented containers, 0 for one per segment */
+    virtual void setChunkFrames(int) { }
+
     virtual int writeHeaders(const x265_nal* nal, uint32_t nalcount) = 0;
 
     virtual int writeFrame(const x265_nal* nal, uint32_t nalcount, x265_picture& pic) = 0;
 
+    /* wait for pending writes, returns the bytes not yet reported by writeFrame */
+    virtual int flush() { return 0; }
+
     virtual void closeFile(int64_t largest_pts, int64_t second_largest_pts) = 0;
 };
 }
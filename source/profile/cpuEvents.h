@@ -1,4 +1,5 @@
 CPU_EVENT(frameRead)
+CPU_EVENT(frameWrite)
 CPU_EVENT(bitstreamWrite)
 CPU_EVENT(frameThread)
 CPU_EVENT(encodeCTU)
@@ -9,3 +10,4 @@ CPU_EVENT(estCostSingle)
 CPU_EVENT(estCostCoop)
 CPU_EVENT(pmode)
 CPU_EVENT(pme)
+CPU_EVENT(splitSpec)
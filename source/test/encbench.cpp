@@ -0,0 +1,672 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+/* End-to-end encoder throughput benchmark. Encodes deterministic synthetic
+ * sequences (a moving gradient, noise over a slow pan, a scrolling texture
+ * and a sequence of scene cuts) at each requested resolution with each
+ * requested preset, and writes one CSV line per encode with the frame rate,
+ * bitrate, PSNR, CPU utilization and peak resident memory, followed by the
+ * time spent in each CPU_EVENT when the library was built with
+ * ENABLE_EVENT_STATS. Options given with --param are applied after the preset.
+ * The compare mode reads two such reports and flags the encodes which got
+ * slower or bigger by more than a threshold, for use between builds or
+ * between options; the bitrate and PSNR changes are shown for reference. */
+
+#include "common.h"
+#include "threadpool.h"
+#include "x265.h"
+
+#if _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace X265_NS;
+
+/* referenced by the encoder library, normally defined by the CLI */
+volatile int numErrorsDuringEncoding;
+
+namespace {
+
+#define MAX_LIST      16
+#define MAX_ROWS      512
+#define MAX_COLS      64
+#define MAX_LINE      4096
+
+/* 8bit sample values scaled to the internal depth */
+#define PIX(v) (pixel)(((v) & 255) << (X265_DEPTH - 8))
+
+inline uint32_t hashRand(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+inline int texture(int x, int y)
+{
+    return (((x * x + y * y) >> 6) ^ ((x >> 4) * (y >> 4) * 37)) + ((x ^ y) & 8) * 4;
+}
+
+void renderGradient(pixel* planes[3], int width, int height, int frame)
+{
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            planes[0][y * width + x] = PIX((x + y) / 4 + frame * 2);
+    for (int y = 0; y < height / 2; y++)
+        for (int x = 0; x < width / 2; x++)
+        {
+            planes[1][y * (width / 2) + x] = PIX(64 + x / 4 - frame);
+            planes[2][y * (width / 2) + x] = PIX(192 - y / 4 + frame);
+        }
+}
+
+void renderNoise(pixel* planes[3], int width, int height, int frame)
+{
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+        {
+            int n = (int)(hashRand((uint32_t)(frame * width * height + y * width + x)) & 31) - 16;
+            planes[0][y * width + x] = PIX(x265_clip3(0, 255, texture(x + frame, y) / 2 + 64 + n));
+        }
+    for (int y = 0; y < height / 2; y++)
+        for (int x = 0; x < width / 2; x++)
+        {
+            planes[1][y * (width / 2) + x] = PIX(128 + (texture(x, y + frame) & 15));
+            planes[2][y * (width / 2) + x] = PIX(128 - (texture(x + frame, y) & 15));
+        }
+}
+
+void renderScroll(pixel* planes[3], int width, int height, int frame)
+{
+    int dx = frame * 3, dy = frame;
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            planes[0][y * width + x] = PIX(texture(x + dx, y + dy));
+    for (int y = 0; y < height / 2; y++)
+        for (int x = 0; x < width / 2; x++)
+        {
+            planes[1][y * (width / 2) + x] = PIX(96 + (texture(2 * x + dx, 2 * y + dy) >> 3));
+            planes[2][y * (width / 2) + x] = PIX(160 - (texture(2 * x + dx, 2 * y + dy) >> 3));
+        }
+}
+
+/* a different scene every 15 frames, with motion within each scene */
+void renderSceneCuts(pixel* planes[3], int width, int height, int frame)
+{
+    int scene = frame / 15;
+    switch (scene % 3)
+    {
+    case 0:  renderScroll(planes, width, height, frame); break;
+    case 1:  renderGradient(planes, width, height, frame * 3); break;
+    default: renderNoise(planes, width, height, frame); break;
+    }
+}
+
+struct Sequence
+{
+    const char* name;
+    void (*render)(pixel* planes[3], int width, int height, int frame);
+};
+
+const Sequence sequences[] =
+{
+    { "gradient",  renderGradient },
+    { "noise",     renderNoise },
+    { "scroll",    renderScroll },
+    { "scenecuts", renderSceneCuts },
+};
+
+struct Result
+{
+    int      frames;
+    double   fps;
+    double   kbps;
+    double   psnr;        // mean of the frame PSNRs, dB
+    double   wallTime;    // seconds, from x265_encoder_open to x265_encoder_close
+    double   cpuTime;     // seconds of process CPU time, likewise
+    uint64_t peakRss;     // KiB above the resident size before the encode
+#if ENABLE_EVENT_STATS
+    double   eventTime[NUM_EVENT_STATS];
+#endif
+};
+
+double processCpuTime()
+{
+#if _WIN32
+    FILETIME create, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user))
+        return 0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime; u.HighPart = user.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) / 10000000;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru))
+        return 0;
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000000.0;
+#endif
+}
+
+/* Peak and current resident set size in KiB. On Linux the high water mark
+ * is reset before each encode, elsewhere it is the peak of the process so
+ * far. The current size is only known on Linux and Windows, 0 elsewhere */
+void resetPeakRss()
+{
+#ifdef __linux__
+    FILE* fp = fopen("/proc/self/clear_refs", "w");
+    if (fp)
+    {
+        fputs("5", fp);
+        fclose(fp);
+    }
+#endif
+}
+
+#ifdef __linux__
+uint64_t procStatusKiB(const char* format)
+{
+    unsigned long kb = 0;
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (fp)
+    {
+        char line[256];
+        while (fgets(line, sizeof(line), fp))
+            if (sscanf(line, format, &kb) == 1)
+                break;
+        fclose(fp);
+    }
+    return kb;
+}
+#endif
+
+uint64_t currentRss()
+{
+#if _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return pmc.WorkingSetSize / 1024;
+    return 0;
+#elif defined(__linux__)
+    return procStatusKiB("VmRSS: %lu kB");
+#else
+    return 0;
+#endif
+}
+
+uint64_t peakRss()
+{
+#if _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return pmc.PeakWorkingSetSize / 1024;
+    return 0;
+#else
+#ifdef __linux__
+    uint64_t kb = procStatusKiB("VmHWM: %lu kB");
+    if (kb)
+        return kb;
+#endif
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru))
+        return 0;
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1024;
+#else
+    return ru.ru_maxrss;
+#endif
+#endif
+}
+
+/* PSNR of a reconstructed picture against its source, with luma and chroma
+ * weighted 6:1:1 like the encoder's global PSNR */
+double framePsnr(pixel* const rec[3], pixel* const src[3], int width, int height)
+{
+    double maxVal = (double)((1 << X265_DEPTH) - 1);
+    double psnr = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        int size = i ? width * height / 4 : width * height;
+        uint64_t sse = 0;
+        for (int n = 0; n < size; n++)
+        {
+            int d = rec[i][n] - src[i][n];
+            sse += d * d;
+        }
+        psnr += (i ? 1 : 6) * (sse ? 10 * log10(maxVal * maxVal * size / sse) : 100);
+    }
+    return psnr / 8;
+}
+
+/* The pictures of the sequence are all rendered before the encoder is opened
+ * and the reconstructed pictures are copied aside as they are output, so the
+ * timed section only contains the encoder calls and the recon copies. The
+ * PSNR is measured once the encoder is closed */
+bool encode(x265_param* param, const Sequence& seq, Result& res)
+{
+    int width = param->sourceWidth, height = param->sourceHeight;
+    int lumaSize = width * height;
+    int chromaSize = lumaSize / 4;
+    int frameSize = lumaSize + 2 * chromaSize;
+    pixel* srcBuf = X265_MALLOC(pixel, (size_t)res.frames * frameSize);
+    pixel* recBuf = X265_MALLOC(pixel, (size_t)res.frames * frameSize);
+    char* recDone = X265_MALLOC(char, res.frames);
+    if (!srcBuf || !recBuf || !recDone)
+    {
+        X265_FREE(srcBuf);
+        X265_FREE(recBuf);
+        X265_FREE(recDone);
+        return false;
+    }
+    memset(recBuf, 0, (size_t)res.frames * frameSize * sizeof(pixel));
+    memset(recDone, 0, res.frames);
+
+    for (int i = 0; i < res.frames; i++)
+    {
+        pixel* f = srcBuf + (size_t)i * frameSize;
+        pixel* planes[3] = { f, f + lumaSize, f + lumaSize + chromaSize };
+        seq.render(planes, width, height, i);
+    }
+
+    x265_picture pic;
+    x265_picture_init(param, &pic);
+    pic.stride[0] = width * sizeof(pixel);
+    pic.stride[1] = pic.stride[2] = pic.stride[0] / 2;
+
+    resetPeakRss();
+    uint64_t baseRss = currentRss();
+#if ENABLE_EVENT_STATS
+    EventStats eventStart;
+    eventStart.get();
+#endif
+    double cpuStart = processCpuTime();
+    int64_t start = x265_mdate();
+
+    x265_encoder* encoder = x265_encoder_open(param);
+    if (!encoder)
+    {
+        X265_FREE(srcBuf);
+        X265_FREE(recBuf);
+        X265_FREE(recDone);
+        return false;
+    }
+
+    x265_nal* nal;
+    uint32_t numNal;
+    x265_picture recon;
+    uint64_t bytes = 0;
+    int ret = 0;
+    for (int i = 0; ret >= 0; i++)
+    {
+        x265_picture* in = NULL;
+        if (i < res.frames)
+        {
+            pixel* f = srcBuf + (size_t)i * frameSize;
+            pic.planes[0] = f;
+            pic.planes[1] = f + lumaSize;
+            pic.planes[2] = f + lumaSize + chromaSize;
+            pic.pts = i;
+            in = &pic;
+        }
+        ret = x265_encoder_encode(encoder, &nal, &numNal, in, &recon);
+        if (ret <= 0)
+        {
+            if (!in)
+                break;
+            continue;
+        }
+        for (uint32_t n = 0; n < numNal; n++)
+            bytes += nal[n].sizeBytes;
+
+        int poc = (int)recon.pts;
+        if (poc < 0 || poc >= res.frames)
+            continue;
+        pixel* f = recBuf + (size_t)poc * frameSize;
+        for (int p = 0; p < 3; p++)
+        {
+            int w = p ? width / 2 : width, h = p ? height / 2 : height;
+            pixel* dst = f + (p ? lumaSize + (p - 1) * chromaSize : 0);
+            for (int y = 0; y < h; y++)
+                memcpy(dst + y * w, (const uint8_t*)recon.planes[p] + y * recon.stride[p], w * sizeof(pixel));
+        }
+        recDone[poc] = 1;
+    }
+    x265_encoder_close(encoder);
+
+    res.wallTime = (double)(x265_mdate() - start) / 1000000;
+    res.cpuTime = processCpuTime() - cpuStart;
+    uint64_t peak = peakRss();
+    res.peakRss = peak > baseRss ? peak - baseRss : 0;
+#if ENABLE_EVENT_STATS
+    EventStats eventEnd;
+    eventEnd.get();
+    for (int i = 0; i < NUM_EVENT_STATS; i++)
+        res.eventTime[i] = eventEnd.seconds(eventStart, i);
+#endif
+    res.fps = res.wallTime > 0 ? res.frames / res.wallTime : 0;
+    res.kbps = (double)bytes * 8 / 1000 * param->fpsNum / param->fpsDenom / res.frames;
+
+    double psnrSum = 0;
+    int numRecon = 0;
+    for (int i = 0; i < res.frames; i++)
+    {
+        if (!recDone[i])
+            continue;
+        pixel* s = srcBuf + (size_t)i * frameSize;
+        pixel* r = recBuf + (size_t)i * frameSize;
+        pixel* src[3] = { s, s + lumaSize, s + lumaSize + chromaSize };
+        pixel* rec[3] = { r, r + lumaSize, r + lumaSize + chromaSize };
+        psnrSum += framePsnr(rec, src, width, height);
+        numRecon++;
+    }
+    res.psnr = numRecon ? psnrSum / numRecon : 0;
+
+    X265_FREE(srcBuf);
+    X265_FREE(recBuf);
+    X265_FREE(recDone);
+    return ret >= 0;
+}
+
+/* split a comma separated list in place */
+int splitList(char* str, char** items, int maxItems, char sep)
+{
+    int count = 0;
+    for (char* p = str; p && *p && count < maxItems; count++)
+    {
+        items[count] = p;
+        p = strchr(p, sep);
+        if (p)
+            *p++ = 0;
+    }
+    return count;
+}
+
+void writeHeader(FILE* fp)
+{
+    fprintf(fp, "sequence,resolution,preset,frames,fps,kbps,psnr,wall_s,cpu_s,cpu_util,cpus,peak_rss_kib");
+#if ENABLE_EVENT_STATS
+    for (int i = 0; i < NUM_EVENT_STATS; i++)
+        fprintf(fp, ",%s_s", EventStats::name(i));
+#endif
+    fprintf(fp, "\n");
+}
+
+void writeResult(FILE* fp, const char* seq, const char* res, const char* preset, const Result& r, int cpus)
+{
+    fprintf(fp, "%s,%s,%s,%d,%.3f,%.2f,%.3f,%.3f,%.3f,%.3f,%d,%llu", seq, res, preset, r.frames, r.fps, r.kbps,
+            r.psnr, r.wallTime, r.cpuTime, r.wallTime > 0 ? r.cpuTime / r.wallTime : 0, cpus, (unsigned long long)r.peakRss);
+#if ENABLE_EVENT_STATS
+    for (int i = 0; i < NUM_EVENT_STATS; i++)
+        fprintf(fp, ",%.4f", r.eventTime[i]);
+#endif
+    fprintf(fp, "\n");
+}
+
+struct Report
+{
+    char  lines[MAX_ROWS][MAX_LINE];
+    char* cells[MAX_ROWS][MAX_COLS];
+    int   numCols[MAX_ROWS];
+    int   numRows;          // including the header
+
+    bool read(const char* filename)
+    {
+        FILE* fp = x265_fopen(filename, "r");
+        if (!fp)
+        {
+            printf("unable to open report %s\n", filename);
+            return false;
+        }
+        numRows = 0;
+        while (numRows < MAX_ROWS && fgets(lines[numRows], MAX_LINE, fp))
+        {
+            char* line = lines[numRows];
+            line[strcspn(line, "\r\n")] = 0;
+            if (!*line)
+                continue;
+            numCols[numRows] = splitList(line, cells[numRows], MAX_COLS, ',');
+            numRows++;
+        }
+        fclose(fp);
+        return numRows > 0;
+    }
+
+    int column(const char* name) const
+    {
+        for (int c = 0; c < numCols[0]; c++)
+            if (!strcmp(cells[0][c], name))
+                return c;
+        return -1;
+    }
+
+    double value(int row, int col) const
+    {
+        return col >= 0 && col < numCols[row] ? atof(cells[row][col]) : 0;
+    }
+
+    /* rows are identified by their sequence, resolution and preset */
+    int find(const Report& other, int otherRow) const
+    {
+        for (int r = 1; r < numRows; r++)
+        {
+            if (numCols[r] < 3 || other.numCols[otherRow] < 3)
+                continue;
+            if (!strcmp(cells[r][0], other.cells[otherRow][0]) &&
+                !strcmp(cells[r][1], other.cells[otherRow][1]) &&
+                !strcmp(cells[r][2], other.cells[otherRow][2]))
+                return r;
+        }
+        return -1;
+    }
+};
+
+/* Flags encodes whose frame rate dropped, or whose peak memory grew, by more
+ * than threshold percent. The bitrate and PSNR changes are only reported,
+ * options such as --speculative-split trade them against speed. Returns the
+ * number of regressions */
+int compare(const char* baseName, const char* testName, double threshold)
+{
+    static Report base, test;
+    if (!base.read(baseName) || !test.read(testName))
+        return -1;
+
+    const char* metrics[] = { "fps", "peak_rss_kib" };
+    const int higherIsBetter[] = { 1, 0 };
+    int regressions = 0;
+
+    printf("%-10s %-10s %-10s %12s %12s %8s   %12s %12s %8s   %8s %8s\n", "sequence", "resolution", "preset",
+           "base fps", "test fps", "change", "base KiB", "test KiB", "change", "kbps", "psnr dB");
+    for (int r = 1; r < test.numRows; r++)
+    {
+        int br = base.find(test, r);
+        if (br < 0)
+        {
+            printf("%-10s %-10s %-10s not in %s\n", test.cells[r][0], test.cells[r][1], test.cells[r][2], baseName);
+            continue;
+        }
+
+        bool bRegressed = false;
+        printf("%-10s %-10s %-10s", test.cells[r][0], test.cells[r][1], test.cells[r][2]);
+        for (int m = 0; m < 2; m++)
+        {
+            double b = base.value(br, base.column(metrics[m]));
+            double t = test.value(r, test.column(metrics[m]));
+            double change = b > 0 ? (t - b) * 100 / b : 0;
+            printf(" %12.2f %12.2f %+7.1f%%", b, t, change);
+            if ((higherIsBetter[m] ? -change : change) > threshold)
+                bRegressed = true;
+        }
+        double baseKbps = base.value(br, base.column("kbps"));
+        double kbpsChange = baseKbps > 0 ? (test.value(r, test.column("kbps")) - baseKbps) * 100 / baseKbps : 0;
+        double psnrChange = test.value(r, test.column("psnr")) - base.value(br, base.column("psnr"));
+        printf("   %+7.1f%% %+8.3f", kbpsChange, psnrChange);
+        printf("%s\n", bRegressed ? "   REGRESSION" : "");
+        regressions += bRegressed;
+    }
+
+    printf("%d regression(s) above %.1f%%\n", regressions, threshold);
+    return regressions;
+}
+
+void usage()
+{
+    printf("usage: EncBench [--res WxH[,WxH...]] [--presets name[,name...]] [--frames N]\n"
+           "                [--pools <string>] [--param name=value]... [--report <file.csv>]\n"
+           "       EncBench --compare <base.csv> <test.csv> [--threshold <percent>]\n");
+}
+}
+
+int main(int argc, char *argv[])
+{
+    char resList[256] = "640x360,1280x720";
+    char presetList[256] = "ultrafast,medium";
+    const char* reportName = NULL;
+    const char* pools = NULL;
+    const char* compareBase = NULL;
+    const char* compareTest = NULL;
+    double threshold = 5;
+    int frames = 60;
+    char* params[MAX_LIST];
+    int numParams = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--compare") && i + 2 < argc)
+        {
+            compareBase = argv[++i];
+            compareTest = argv[++i];
+        }
+        else if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        else if (!strcmp(argv[i], "--res"))
+            snprintf(resList, sizeof(resList), "%s", argv[++i]);
+        else if (!strcmp(argv[i], "--presets"))
+            snprintf(presetList, sizeof(presetList), "%s", argv[++i]);
+        else if (!strcmp(argv[i], "--frames"))
+            frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--pools"))
+            pools = argv[++i];
+        else if (!strcmp(argv[i], "--param") && numParams < MAX_LIST)
+            params[numParams++] = argv[++i];
+        else if (!strcmp(argv[i], "--report"))
+            reportName = argv[++i];
+        else if (!strcmp(argv[i], "--threshold"))
+            threshold = atof(argv[++i]);
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if (compareBase)
+        return compare(compareBase, compareTest, threshold) ? 1 : 0;
+
+    frames = x265_clip3(1, 100000, frames);
+    char* resolutions[MAX_LIST];
+    char* presets[MAX_LIST];
+    int numRes = splitList(resList, resolutions, MAX_LIST, ',');
+    int numPresets = splitList(presetList, presets, MAX_LIST, ',');
+    int cpus = ThreadPool::getCpuCount();
+
+    FILE* report = stdout;
+    if (reportName)
+    {
+        report = x265_fopen(reportName, "w");
+        if (!report)
+        {
+            printf("unable to open report %s\n", reportName);
+            return 1;
+        }
+    }
+    writeHeader(report);
+
+    x265_param* param = x265_param_alloc();
+    int ret = !param;
+    for (int r = 0; r < numRes && !ret; r++)
+    {
+        int width = 0, height = 0;
+        if (sscanf(resolutions[r], "%dx%d", &width, &height) != 2 || width < 64 || height < 64)
+        {
+            printf("invalid resolution %s\n", resolutions[r]);
+            ret = 1;
+            break;
+        }
+
+        for (int p = 0; p < numPresets && !ret; p++)
+        {
+            for (int s = 0; s < (int)(sizeof(sequences) / sizeof(sequences[0])) && !ret; s++)
+            {
+                if (x265_param_default_preset(param, presets[p], NULL) < 0)
+                {
+                    printf("unable to configure preset %s\n", presets[p]);
+                    ret = 1;
+                    break;
+                }
+                param->sourceWidth = width & ~7;
+                param->sourceHeight = height & ~7;
+                param->fpsNum = 30;
+                param->fpsDenom = 1;
+                param->logLevel = X265_LOG_ERROR;
+                param->numaPools = pools;
+                for (int i = 0; i < numParams && !ret; i++)
+                {
+                    char name[256];
+                    const char* value = strchr(params[i], '=');
+                    snprintf(name, sizeof(name), "%.*s", value ? (int)(value - params[i]) : (int)strlen(params[i]), params[i]);
+                    if (x265_param_parse(param, name, value ? value + 1 : NULL))
+                    {
+                        printf("invalid option %s\n", params[i]);
+                        ret = 1;
+                    }
+                }
+                if (ret)
+                    break;
+
+                Result res;
+                memset(&res, 0, sizeof(res));
+                res.frames = frames;
+                if (!encode(param, sequences[s], res))
+                {
+                    printf("encode of %s %s %s failed\n", sequences[s].name, resolutions[r], presets[p]);
+                    ret = 1;
+                    break;
+                }
+                writeResult(report, sequences[s].name, resolutions[r], presets[p], res, cpus);
+                fflush(report);
+            }
+        }
+    }
+
+    if (report != stdout)
+        fclose(report);
+    x265_param_free(param);
+    x265_cleanup();
+    return ret;
+}
@@ -189,6 +189,44 @@ bool IntraPredHarness::check_allangs_primitive(const intra_allangs_t ref, const
     return true;
 }
 
+bool IntraPredHarness::check_allangs_sa8d_primitive(const intra_allangs_cost_t ref, const intra_allangs_cost_t opt, int sizeIdx)
+{
+    int j = Predict::ADI_BUF_STRIDE;
+    int costs_c[33], costs_vec[33];
+
+    const int width = 1 << (sizeIdx + 2);
+    const int isLuma = width <= 16;
+
+    for (int i = 0; i <= 100; i++)
+    {
+        int index = rand() % TEST_CASES;
+        const pixel* fenc = pixel_test_buff[index] + rand() % (INCR * ITERS);
+
+        pixel * refAbove0 = pixel_buff + j + 3 * FENC_STRIDE;
+        pixel * refLeft0 = refAbove0 + 3 * width + FENC_STRIDE;
+
+        refLeft0[0] = refAbove0[0];
+
+        ref(costs_c, fenc, STRIDE, refAbove0, refLeft0, isLuma);
+        checked(opt, costs_vec, fenc, STRIDE, refAbove0, refLeft0, isLuma);
+
+        for (int p = 0; p < 33; p++)
+        {
+            if (costs_c[p] != costs_vec[p])
+            {
+                printf("\nFailed: (%dx%d) Mode(%2d), bfilter=%d\n", width, width, p + 2, isLuma);
+                opt(costs_vec, fenc, STRIDE, refAbove0, refLeft0, isLuma);
+                return false;
+            }
+        }
+
+        reportfail();
+        j += FENC_STRIDE;
+    }
+
+    return true;
+}
+
 bool IntraPredHarness::check_intra_filter_primitive(const intra_filter_t ref, const intra_filter_t opt)
 {
     memset(pixel_out_c, 0, 64 * 64 * sizeof(pixel));
@@ -246,6 +284,14 @@ bool IntraPredHarness::testCorrectness(const EncoderPrimitives& ref, const Encod
                 return false;
             }
         }
+        if (opt.cu[i].intra_allangs_sa8d)
+        {
+            if (!check_allangs_sa8d_primitive(ref.cu[i].intra_allangs_sa8d, opt.cu[i].intra_allangs_sa8d, i))
+            {
+                printf("intra_allangs_sa8d failed\n");
+                return false;
+            }
+        }
         if (opt.cu[i].intra_filter)
         {
             if (!check_intra_filter_primitive(ref.cu[i].intra_filter, opt.cu[i].intra_filter))
@@ -295,6 +341,17 @@ void IntraPredHarness::measureSpeed(const EncoderPrimitives& ref, const EncoderP
             REPORT_SPEEDUP(opt.cu[i].intra_pred_allangs, ref.cu[i].intra_pred_allangs,
                            pixel_out_33_vec, refAbove, refLeft, bFilter);
         }
+        if (opt.cu[i].intra_allangs_sa8d)
+        {
+            bool bFilter = (size <= 16);
+            int costs[33];
+            pixel * refAbove = pixel_buff + srcStride;
+            pixel * refLeft = refAbove + 3 * size;
+            refLeft[0] = refAbove[0];
+            printf("intra_allangs_sa8d%dx%d", size, size);
+            REPORT_SPEEDUP(opt.cu[i].intra_allangs_sa8d, ref.cu[i].intra_allangs_sa8d,
+                           costs, pixel_test_buff[0], STRIDE, refAbove, refLeft, bFilter);
+        }
         for (int mode = 2; mode <= 34; mode += 1)
         {
             if (opt.cu[i].intra_pred[mode])
@@ -53,6 +53,7 @@ protected:
     bool check_planar_primitive(intra_pred_t ref, intra_pred_t opt, int width);
     bool check_angular_primitive(const intra_pred_t ref[], const intra_pred_t opt[], int size);
     bool check_allangs_primitive(const intra_allangs_t ref, const intra_allangs_t opt, int size);
+    bool check_allangs_sa8d_primitive(const intra_allangs_cost_t ref, const intra_allangs_cost_t opt, int size);
     bool check_intra_filter_primitive(const intra_filter_t ref, const intra_filter_t opt);
 
 public:
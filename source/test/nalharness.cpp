@@ -0,0 +1,271 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "bitstream.h"
+#include "nal.h"
+#include "nalharness.h"
+
+using namespace X265_NS;
+
+namespace {
+/* byte-wise NAL serializer, the reference for the escaping done by NALList */
+uint32_t serialize_ref(uint8_t* out, NalUnitType nalUnitType, const uint8_t* payload, uint32_t payloadSize, bool bFirst)
+{
+    static const uint8_t startCodePrefix[] = { 0, 0, 0, 1 };
+    uint32_t bytes = 0;
+
+    if (bFirst || nalUnitType == NAL_UNIT_VPS || nalUnitType == NAL_UNIT_SPS || nalUnitType == NAL_UNIT_PPS || nalUnitType == NAL_UNIT_UNSPECIFIED)
+    {
+        memcpy(out, startCodePrefix, 4);
+        bytes += 4;
+    }
+    else
+    {
+        memcpy(out, startCodePrefix + 1, 3);
+        bytes += 3;
+    }
+
+    out[bytes++] = (uint8_t)nalUnitType << 1;
+    out[bytes++] = 1 + (nalUnitType == NAL_UNIT_CODED_SLICE_TSA_N);
+
+    for (uint32_t i = 0; i < payloadSize; i++)
+    {
+        if (i > 2 && !out[bytes - 2] && !out[bytes - 3] && out[bytes - 1] <= 0x03 && nalUnitType != NAL_UNIT_UNSPECIFIED)
+        {
+            out[bytes] = out[bytes - 1];
+            out[bytes - 1] = 0x03;
+            bytes++;
+        }
+
+        out[bytes++] = payload[i];
+    }
+
+    if (!out[bytes - 1])
+        out[bytes++] = 0x03;
+
+    return bytes;
+}
+
+uint32_t serializeSubstreams_ref(uint8_t* out, uint32_t* streamSizeBytes, const uint8_t* const* streams, const uint32_t* sizes, uint32_t streamCount)
+{
+    uint32_t bytes = 0;
+    for (uint32_t s = 0; s < streamCount; s++)
+    {
+        uint32_t prevBufSize = bytes;
+        for (uint32_t i = 0; i < sizes[s]; i++)
+        {
+            if (bytes >= 2 && !out[bytes - 2] && !out[bytes - 1] && streams[s][i] <= 0x03)
+                out[bytes++] = 3;
+
+            out[bytes++] = streams[s][i];
+        }
+        streamSizeBytes[s] = bytes - prevBufSize;
+    }
+
+    return bytes;
+}
+}
+
+NALHarness::NALHarness()
+{
+    /* [0] --- Random values
+     * [1] --- Sparse zeros, like CABAC output
+     * [2] --- Mostly zeros and emulation sensitive values
+     * [3] --- Runs of zeros */
+    for (int i = 0; i < BUFFSIZE; i++)
+    {
+        byte_buff[0][i] = rand() & 0xff;
+        byte_buff[1][i] = (rand() & 63) ? (rand() % 255) + 1 : 0;
+        byte_buff[2][i] = (rand() & 1) ? 0 : rand() & 3;
+        byte_buff[3][i] = (i / 7) & 1 ? 0 : (uint8_t)(rand() & 0xff);
+    }
+}
+
+bool NALHarness::check_findZeroPair(findZeroPair_t ref, findZeroPair_t opt)
+{
+    for (int i = 0; i < ITERS; i++)
+    {
+        int pattern = i % NUM_PATTERNS;
+        uint32_t offset = rand() % 64;
+        uint32_t size = rand() % (i & 1 ? 96 : BUFFSIZE - 64);
+        const uint8_t* src = byte_buff[pattern] + offset;
+
+        uint32_t ref_pos = ref(src, size);
+        uint32_t vec_pos = (uint32_t)checked(opt, src, size);
+        if (ref_pos != vec_pos)
+            return false;
+
+        /* continue behind the found pair, as the serializer does */
+        if (ref_pos + 2 < size)
+        {
+            ref_pos = ref(src + ref_pos + 2, size - ref_pos - 2);
+            vec_pos = (uint32_t)checked(opt, src + vec_pos + 2, size - vec_pos - 2);
+            if (ref_pos != vec_pos)
+                return false;
+        }
+
+        reportfail();
+    }
+
+    return true;
+}
+
+bool NALHarness::check_serialize(findZeroPair_t opt)
+{
+    static const NalUnitType types[] = { NAL_UNIT_CODED_SLICE_TRAIL_R, NAL_UNIT_CODED_SLICE_TSA_N, NAL_UNIT_SPS, NAL_UNIT_PREFIX_SEI, NAL_UNIT_UNSPECIFIED };
+
+    findZeroPair_t saved = primitives.findZeroPair;
+    primitives.findZeroPair = opt;
+
+    bool ok = true;
+    for (int i = 0; i < ITERS && ok; i++)
+    {
+        NalUnitType type = types[i % (sizeof(types) / sizeof(types[0]))];
+        const uint8_t* payload = byte_buff[rand() % NUM_PATTERNS] + rand() % 64;
+        uint32_t size = 1 + rand() % (i & 1 ? 128 : 4096);
+
+        Bitstream bs;
+        for (uint32_t j = 0; j < size; j++)
+            bs.write(payload[j], 8);
+
+        NALList list;
+        uint32_t bytes = serialize_ref(out_ref, type, payload, size, true);
+        list.serialize(type, bs);
+        if (list.m_numNal != 1 || list.m_nal[0].sizeBytes != bytes || memcmp(list.m_nal[0].payload, out_ref, bytes))
+            ok = false;
+    }
+
+    primitives.findZeroPair = saved;
+    return ok;
+}
+
+/* payloads written with mixed code lengths and serialized without byte
+ * alignment, as NAL_UNIT_UNSPECIFIED payloads are; every whole byte must
+ * reach the NAL, whatever the number of bytes left in the word cache */
+bool NALHarness::check_unalignedWrites()
+{
+    for (int i = 0; i < ITERS; i++)
+    {
+        const uint8_t* payload = byte_buff[rand() % NUM_PATTERNS] + rand() % 64;
+        uint32_t size = 1 + rand() % (i & 1 ? 16 : 1024);
+
+        /* big-endian bit reader over the payload */
+        Bitstream bs;
+        uint32_t pos = 0;
+        while (pos < size * 8)
+        {
+            uint32_t numBits = 1 + rand() % 32;
+            numBits = X265_MIN(numBits, size * 8 - pos);
+            uint32_t val = 0;
+            for (uint32_t b = 0; b < numBits; b++, pos++)
+                val = (val << 1) | ((payload[pos >> 3] >> (7 - (pos & 7))) & 1);
+            bs.write(val, numBits);
+        }
+
+        if (bs.getNumberOfWrittenBytes() != size || memcmp(bs.getFIFO(), payload, size))
+            return false;
+
+        NALList list;
+        uint32_t bytes = serialize_ref(out_ref, NAL_UNIT_UNSPECIFIED, payload, size, true);
+        list.serialize(NAL_UNIT_UNSPECIFIED, bs);
+        if (list.m_numNal != 1 || list.m_nal[0].sizeBytes != bytes || memcmp(list.m_nal[0].payload, out_ref, bytes))
+            return false;
+    }
+
+    return true;
+}
+
+bool NALHarness::check_serializeSubstreams(findZeroPair_t opt)
+{
+    enum { MAX_STREAMS = 8 };
+
+    findZeroPair_t saved = primitives.findZeroPair;
+    primitives.findZeroPair = opt;
+
+    bool ok = true;
+    for (int i = 0; i < ITERS / 10 && ok; i++)
+    {
+        uint32_t streamCount = 1 + rand() % MAX_STREAMS;
+        const uint8_t* streams[MAX_STREAMS];
+        uint32_t sizes[MAX_STREAMS];
+        uint32_t refSizes[MAX_STREAMS], optSizes[MAX_STREAMS];
+        Bitstream bs[MAX_STREAMS];
+
+        for (uint32_t s = 0; s < streamCount; s++)
+        {
+            /* short streams of zeros exercise the escaping across substreams */
+            sizes[s] = rand() % (i & 1 ? 8 : 2048);
+            streams[s] = byte_buff[rand() % NUM_PATTERNS] + rand() % 64;
+            for (uint32_t j = 0; j < sizes[s]; j++)
+                bs[s].write(streams[s][j], 8);
+        }
+
+        NALList list;
+        uint32_t bytes = serializeSubstreams_ref(out_ref, refSizes, streams, sizes, streamCount);
+        list.serializeSubstreams(optSizes, streamCount, bs);
+        if (list.m_extraOccupancy != bytes || memcmp(list.m_extraBuffer, out_ref, bytes) ||
+            memcmp(optSizes, refSizes, sizeof(uint32_t) * streamCount))
+            ok = false;
+    }
+
+    primitives.findZeroPair = saved;
+    return ok;
+}
+
+bool NALHarness::testCorrectness(const EncoderPrimitives& ref, const EncoderPrimitives& opt)
+{
+    if (!check_unalignedWrites())
+    {
+        printf("Bitstream writes without byte alignment failed!\n");
+        return false;
+    }
+
+    if (opt.findZeroPair)
+    {
+        if (!check_findZeroPair(ref.findZeroPair, opt.findZeroPair))
+        {
+            printf("findZeroPair failed!\n");
+            return false;
+        }
+        if (!check_serialize(opt.findZeroPair))
+        {
+            printf("NALList::serialize with findZeroPair failed!\n");
+            return false;
+        }
+        if (!check_serializeSubstreams(opt.findZeroPair))
+        {
+            printf("NALList::serializeSubstreams with findZeroPair failed!\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void NALHarness::measureSpeed(const EncoderPrimitives& ref, const EncoderPrimitives& opt)
+{
+    if (opt.findZeroPair)
+    {
+        printf("findZeroPair[64KB]");
+        REPORT_SPEEDUP(opt.findZeroPair, ref.findZeroPair, byte_buff[1], BUFFSIZE);
+    }
+}
@@ -0,0 +1,55 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef _NALHARNESS_H_1
+#define _NALHARNESS_H_1 1
+
+#include "testharness.h"
+#include "primitives.h"
+
+class NALHarness : public TestHarness
+{
+protected:
+
+    enum { BUFFSIZE = 64 * 1024 };
+    enum { ITERS = 1000 };
+    enum { NUM_PATTERNS = 4 };
+
+    uint8_t byte_buff[NUM_PATTERNS][BUFFSIZE];
+    uint8_t out_ref[BUFFSIZE * 2];
+
+    bool check_findZeroPair(findZeroPair_t ref, findZeroPair_t opt);
+    bool check_serialize(findZeroPair_t opt);
+    bool check_unalignedWrites();
+    bool check_serializeSubstreams(findZeroPair_t opt);
+
+public:
+
+    NALHarness();
+
+    const char *getName() const { return "nal"; }
+
+    bool testCorrectness(const EncoderPrimitives& ref, const EncoderPrimitives& opt);
+
+    void measureSpeed(const EncoderPrimitives& ref, const EncoderPrimitives& opt);
+};
+
+#endif // ifndef _NALHARNESS_H_1
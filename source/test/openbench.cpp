@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * Copyright (C) 2013-2020 MulticoreWare, Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+/* Encoder startup latency benchmark. Repeatedly opens an encoder, feeds it
+ * synthetic pictures until the first access unit is returned, and closes it
+ * again; once with private thread pools and once with a shared x265_context.
+ * Reports the average time spent in x265_encoder_open() and the time from
+ * open to the first encoded frame. */
+
+#include "common.h"
+#include "x265.h"
+
+using namespace X265_NS;
+
+/* referenced by the encoder library, normally defined by the CLI */
+volatile int numErrorsDuringEncoding;
+
+namespace {
+
+struct Latency
+{
+    int64_t open;
+    int64_t firstFrame;
+};
+
+bool runOnce(x265_param* param, Latency& lat)
+{
+    int64_t start = x265_mdate();
+    x265_encoder* encoder = x265_encoder_open(param);
+    if (!encoder)
+        return false;
+    lat.open = x265_mdate() - start;
+
+    x265_picture pic;
+    x265_picture_init(param, &pic);
+    int lumaSize = param->sourceWidth * param->sourceHeight;
+    int chromaSize = lumaSize / 4;
+    pixel* buf = X265_MALLOC(pixel, lumaSize + 2 * chromaSize);
+    if (!buf)
+    {
+        x265_encoder_close(encoder);
+        return false;
+    }
+    memset(buf, 128, sizeof(pixel) * (lumaSize + 2 * chromaSize));
+    pic.planes[0] = buf;
+    pic.planes[1] = buf + lumaSize;
+    pic.planes[2] = buf + lumaSize + chromaSize;
+    pic.stride[0] = param->sourceWidth * sizeof(pixel);
+    pic.stride[1] = pic.stride[2] = pic.stride[0] / 2;
+
+    x265_nal* nal;
+    uint32_t numNal = 0;
+    int ret = 0;
+    for (int i = 0; !ret && i < param->lookaheadDepth + param->bframes + 16; i++)
+    {
+        pic.pts = i;
+        ret = x265_encoder_encode(encoder, &nal, &numNal, &pic, NULL);
+    }
+    while (!ret)
+    {
+        ret = x265_encoder_encode(encoder, &nal, &numNal, NULL, NULL);
+        if (!ret && !numNal)
+            break;
+    }
+    lat.firstFrame = x265_mdate() - start;
+
+    /* drain, so that close does not measure a flush of the pipeline */
+    while (x265_encoder_encode(encoder, &nal, &numNal, NULL, NULL) > 0)
+    {}
+
+    x265_encoder_close(encoder);
+    X265_FREE(buf);
+    return ret > 0;
+}
+
+void report(const char* name, const Latency* lat, int iterations)
+{
+    /* the first iteration pays for one-time process initialization */
+    int64_t open = 0, firstFrame = 0;
+    for (int i = 1; i < iterations; i++)
+    {
+        open += lat[i].open;
+        firstFrame += lat[i].firstFrame;
+    }
+    int count = X265_MAX(iterations - 1, 1);
+    printf("%-16s first open %8.2f ms   open %8.2f ms   first frame %8.2f ms\n", name,
+           lat[0].open / 1000.0, open / 1000.0 / count, firstFrame / 1000.0 / count);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    const char* preset = "ultrafast";
+    int width = 1280, height = 720, iterations = 10;
+
+    for (int i = 1; i < argc - 1; i += 2)
+    {
+        if (!strcmp(argv[i], "--preset"))
+            preset = argv[i + 1];
+        else if (!strcmp(argv[i], "--input-res"))
+            sscanf(argv[i + 1], "%dx%d", &width, &height);
+        else if (!strcmp(argv[i], "--iterations"))
+            iterations = atoi(argv[i + 1]);
+        else
+        {
+            printf("usage: OpenBench [--preset <name>] [--input-res WxH] [--iterations N]\n");
+            return 1;
+        }
+    }
+    iterations = x265_clip3(2, 1000, iterations);
+
+    x265_param* param = x265_param_alloc();
+    if (!param || x265_param_default_preset(param, preset, "zerolatency") < 0)
+    {
+        printf("unable to configure preset %s\n", preset);
+        return 1;
+    }
+    param->sourceWidth = width & ~7;
+    param->sourceHeight = height & ~7;
+    param->fpsNum = 30;
+    param->fpsDenom = 1;
+    param->logLevel = X265_LOG_ERROR;
+    param->bRepeatHeaders = 1;
+
+    Latency* lat = new Latency[iterations];
+    printf("x265 open latency, %s %dx%d, %d iterations\n", preset, param->sourceWidth, param->sourceHeight, iterations);
+
+    int ret = 0;
+    for (int i = 0; i < iterations && !ret; i++)
+        ret = !runOnce(param, lat[i]);
+    if (!ret)
+        report("private pools", lat, iterations);
+
+    x265_context* context = x265_context_create(param);
+    if (!context)
+        ret = 1;
+    param->context = context;
+    for (int i = 0; i < iterations && !ret; i++)
+        ret = !runOnce(param, lat[i]);
+    if (!ret)
+        report("shared context", lat, iterations);
+
+    x265_context_free(context);
+    x265_param_free(param);
+    delete [] lat;
+    x265_cleanup();
+    return ret;
+}
@@ -100,6 +100,38 @@ bool PixelHarness::check_pixelcmp(pixelcmp_t ref, pixelcmp_t opt)
     return true;
 }
 
+/* a bounded cost must be exact when it is not above the bound and may be any
+ * value above the bound otherwise, the C and the optimized version need not
+ * abandon the block at the same point */
+bool PixelHarness::check_pixelcmp_bounded(pixelcmp_bounded_t ref, pixelcmp_bounded_t opt, pixelcmp_t full)
+{
+    int j = 0;
+    intptr_t stride = STRIDE;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index1 = rand() % TEST_CASES;
+        int index2 = rand() % TEST_CASES;
+        int cost = full(pixel_test_buff[index1], stride, pixel_test_buff[index2] + j, stride);
+        const int bounds[] = { INT_MAX, -1, 0, cost, cost - 1, cost >> 1, rand() % (cost + 1) };
+
+        for (int b = 0; b < (int)(sizeof(bounds) / sizeof(bounds[0])); b++)
+        {
+            int bound = bounds[b];
+            int vres = (int)checked(opt, pixel_test_buff[index1], stride, pixel_test_buff[index2] + j, stride, bound);
+            int cres = ref(pixel_test_buff[index1], stride, pixel_test_buff[index2] + j, stride, bound);
+            if (cost <= bound ? (vres != cost || cres != cost) : (vres <= bound || cres <= bound))
+                return false;
+
+            reportfail();
+        }
+
+        j += INCR;
+    }
+
+    return true;
+}
+
 bool PixelHarness::check_pixel_sse(pixel_sse_t ref, pixel_sse_t opt)
 {
     int j = 0;
@@ -170,6 +202,43 @@ bool PixelHarness::check_pixelcmp_x3(pixelcmp_x3_t ref, pixelcmp_x3_t opt)
     return true;
 }
 
+bool PixelHarness::check_ads(pixelcmp_ads_t ref, pixelcmp_ads_t opt)
+{
+    /* box sums of up to 32x32 pixels and MV costs, as seen by the SEA search;
+     * deltas of a sub-block width and of rows of an integral plane */
+    enum { SUMS = 4096 };
+    ALIGN_VAR_32(uint32_t, sums[SUMS]);
+    ALIGN_VAR_32(uint16_t, costs[256]);
+    ALIGN_VAR_32(int16_t, cmvs[256]);
+    ALIGN_VAR_32(int16_t, vmvs[256]);
+    int encDC[4];
+
+    for (int i = 0; i < SUMS; i++)
+        sums[i] = rand() % (1024 * PIXEL_MAX + 1);
+    for (int i = 0; i < 256; i++)
+        costs[i] = (uint16_t)(rand() % 1024);
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        for (int k = 0; k < 4; k++)
+            encDC[k] = sums[rand() % SUMS] + rand() % 64 - 32;
+        int delta = (rand() & 1) ? 32 : 32 * STRIDE;
+        int width = (rand() % 64 + 1) * 4;
+        int thresh = rand() % (4 * 256 * PIXEL_MAX);
+        int offset = rand() % 256;
+
+        int cnum = ref(encDC, sums + offset, delta, costs, cmvs, width, thresh);
+        int vnum = (int)checked(opt, encDC, sums + offset, delta, costs, vmvs, width, thresh);
+
+        if (cnum != vnum || memcmp(cmvs, vmvs, cnum * sizeof(int16_t)))
+            return false;
+
+        reportfail();
+    }
+
+    return true;
+}
+
 bool PixelHarness::check_pixelcmp_x4(pixelcmp_x4_t ref, pixelcmp_x4_t opt)
 {
     ALIGN_VAR_16(int, cres[16]);
@@ -2340,6 +2409,24 @@ bool PixelHarness::testPU(int part, const EncoderPrimitives& ref, const EncoderP
         }
     }
 
+    if (opt.pu[part].satd_bounded)
+    {
+        if (!check_pixelcmp_bounded(ref.pu[part].satd_bounded, opt.pu[part].satd_bounded, ref.pu[part].satd))
+        {
+            printf("satd_bounded[%s]: failed!\n", lumaPartStr[part]);
+            return false;
+        }
+    }
+
+    if (opt.pu[part].sad_bounded)
+    {
+        if (!check_pixelcmp_bounded(ref.pu[part].sad_bounded, opt.pu[part].sad_bounded, ref.pu[part].sad))
+        {
+            printf("sad_bounded[%s]: failed!\n", lumaPartStr[part]);
+            return false;
+        }
+    }
+
     if (opt.pu[part].sad_x3)
     {
         if (!check_pixelcmp_x3(ref.pu[part].sad_x3, opt.pu[part].sad_x3))
@@ -2357,6 +2444,15 @@ bool PixelHarness::testPU(int part, const EncoderPrimitives& ref, const EncoderP
             return false;
         }
     }
+
+    if (opt.pu[part].ads)
+    {
+        if (!check_ads(ref.pu[part].ads, opt.pu[part].ads))
+        {
+            printf("ads[%s]: failed!\n", lumaPartStr[part]);
+            return false;
+        }
+    }
     if (opt.pu[part].pixelavg_pp[NONALIGNED])
     {
         if (!check_pixelavg_pp(ref.pu[part].pixelavg_pp[NONALIGNED], opt.pu[part].pixelavg_pp[NONALIGNED]))
@@ -3196,6 +3292,19 @@ void PixelHarness::measurePartition(int part, const EncoderPrimitives& ref, cons
         HEADER("sad[%s]", lumaPartStr[part]);
         REPORT_SPEEDUP(opt.pu[part].sad, ref.pu[part].sad, pbuf1, STRIDE, fref, STRIDE);
     }
+    /* bounded at half the full cost, as a search which is far from its best */
+    if (opt.pu[part].satd_bounded)
+    {
+        int bound = ref.pu[part].satd(pbuf1, STRIDE, fref, STRIDE) >> 1;
+        HEADER("satd_bounded[%s]", lumaPartStr[part]);
+        REPORT_SPEEDUP(opt.pu[part].satd_bounded, ref.pu[part].satd_bounded, pbuf1, STRIDE, fref, STRIDE, bound);
+    }
+    if (opt.pu[part].sad_bounded)
+    {
+        int bound = ref.pu[part].sad(pbuf1, STRIDE, fref, STRIDE) >> 1;
+        HEADER("sad_bounded[%s]", lumaPartStr[part]);
+        REPORT_SPEEDUP(opt.pu[part].sad_bounded, ref.pu[part].sad_bounded, pbuf1, STRIDE, fref, STRIDE, bound);
+    }
 
     if (opt.pu[part].sad_x3)
     {
@@ -3209,6 +3318,13 @@ void PixelHarness::measurePartition(int part, const EncoderPrimitives& ref, cons
         REPORT_SPEEDUP(opt.pu[part].sad_x4, ref.pu[part].sad_x4, pbuf1, fref, fref + 1, fref - 1, fref - INCR, FENC_STRIDE + 5, &cres[0]);
     }
 
+    if (opt.pu[part].ads)
+    {
+        int encDC[4] = { 100, 200, 300, 400 };
+        HEADER("ads[%s]", lumaPartStr[part]);
+        REPORT_SPEEDUP(opt.pu[part].ads, ref.pu[part].ads, encDC, (uint32_t*)ibuf1, 32, ushort_test_buff[0], sbuf1, 128, 1000);
+    }
+
     if (opt.pu[part].copy_pp)
     {
         HEADER("copy_pp[%s]", lumaPartStr[part]);
@@ -70,10 +70,12 @@ protected:
     ALIGN_VAR_64(int16_t,  residual_test_buff[TEST_CASES][BUFFSIZE]);
 
     bool check_pixelcmp(pixelcmp_t ref, pixelcmp_t opt);
+    bool check_pixelcmp_bounded(pixelcmp_bounded_t ref, pixelcmp_bounded_t opt, pixelcmp_t full);
     bool check_pixel_sse(pixel_sse_t ref, pixel_sse_t opt);
     bool check_pixel_sse_ss(pixel_sse_ss_t ref, pixel_sse_ss_t opt);
     bool check_pixelcmp_x3(pixelcmp_x3_t ref, pixelcmp_x3_t opt);
     bool check_pixelcmp_x4(pixelcmp_x4_t ref, pixelcmp_x4_t opt);
+    bool check_ads(pixelcmp_ads_t ref, pixelcmp_ads_t opt);
     bool check_copy_pp(copy_pp_t ref, copy_pp_t opt);
     bool check_copy_sp(copy_sp_t ref, copy_sp_t opt);
     bool check_copy_ps(copy_ps_t ref, copy_ps_t opt);
@@ -31,6 +31,7 @@
 #include "mbdstharness.h"
 #include "ipfilterharness.h"
 #include "intrapredharness.h"
+#include "nalharness.h"
 #include "param.h"
 #include "cpu.h"
 
@@ -85,7 +86,7 @@ void do_help()
     printf("x265 optimized primitive testbench\n\n");
     printf("usage: TestBench [--cpuid CPU] [--testbench BENCH] [--help]\n\n");
     printf("       CPU is comma separated SIMD arch list, example: SSE4,AVX\n");
-    printf("       BENCH is one of (pixel,transforms,interp,intrapred)\n\n");
+    printf("       BENCH is one of (pixel,transforms,interp,intrapred,nal)\n\n");
     printf("By default, the test bench will test all benches on detected CPU architectures\n");
     printf("Options and testbench name may be truncated.\n");
 }
@@ -94,6 +95,7 @@ PixelHarness  HPixel;
 MBDstHarness  HMBDist;
 IPFilterHarness HIPFilter;
 IntraPredHarness HIPred;
+NALHarness HNAL;
 
 int main(int argc, char *argv[])
 {
@@ -149,7 +151,8 @@ int main(int argc, char *argv[])
         &HPixel,
         &HMBDist,
         &HIPFilter,
-        &HIPred
+        &HIPred,
+        &HNAL
     };
 
     EncoderPrimitives cprim;
@@ -217,6 +220,7 @@ int main(int argc, char *argv[])
         setupAliasCPrimitives(cprim, asmprim, test_arch[i].flag);
 #endif
 
+        setupAllAnglesSa8dPrimitives(asmprim);
         setupAliasPrimitives(asmprim);
         memcpy(&primitives, &asmprim, sizeof(EncoderPrimitives));
         for (size_t h = 0; h < sizeof(harness) / sizeof(TestHarness*); h++)
@@ -247,6 +251,7 @@ int main(int argc, char *argv[])
      * Otherwise, segment fault occurs. */
     setupAliasCPrimitives(cprim, optprim, cpuid);
 #endif
+    setupAllAnglesSa8dPrimitives(optprim);
 
     /* Note that we do not setup aliases for performance tests, that would be
      * redundant. The testbench only verifies they are correctly aliased */
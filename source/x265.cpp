@@ -90,10 +90,11 @@ static int get_argv_utf8(int *argc_ptr, char ***argv_ptr)
 
 /* Checks for abr-ladder config file in the command line.
  * Returns true if abr-config file is present. Returns 
- * false otherwise */
+ * false otherwise. The optional ladder playlist is returned in playlist */
 
-static bool checkAbrLadder(int argc, char **argv, FILE **abrConfig)
+static bool checkAbrLadder(int argc, char **argv, FILE **abrConfig, const char **playlist)
 {
+    bool isAbrLadder = false;
     for (optind = 0;;)
     {
         int long_options_index = -1;
@@ -129,10 +130,12 @@ static bool checkAbrLadder(int argc, char **argv, FILE **abrConfig)
             *abrConfig = x265_fopen(optarg, "rb");
             if (!abrConfig)
                 x265_log_file(NULL, X265_LOG_ERROR, "%s abr-ladder config file not found or error in opening zone file\n", optarg);
-            return true;
+            isAbrLadder = true;
         }
+        else if (!strcmp(long_options[long_options_index].name, "abr-ladder-playlist"))
+            *playlist = optarg;
     }
-    return false;
+    return isAbrLadder;
 }
 
 static uint8_t getNumAbrEncodes(FILE* abrConfig)
@@ -274,7 +277,8 @@ int main(int argc, char **argv)
 
     uint8_t numEncodes = 1;
     FILE *abrConfig = NULL;
-    bool isAbrLadder = checkAbrLadder(argc, argv, &abrConfig);
+    const char *playlist = NULL;
+    bool isAbrLadder = checkAbrLadder(argc, argv, &abrConfig, &playlist);
 
     if (isAbrLadder)
         numEncodes = getNumAbrEncodes(abrConfig);
@@ -298,7 +302,7 @@ int main(int argc, char **argv)
 
     int ret = 0;
 
-    AbrEncoder* abrEnc = new AbrEncoder(cliopt, numEncodes, ret);
+    AbrEncoder* abrEnc = new AbrEncoder(cliopt, numEncodes, isAbrLadder ? playlist : NULL, ret);
     int threadsActive = abrEnc->m_numActiveEncodes.get();
     while (threadsActive)
     {
@@ -39,6 +39,10 @@ extern "C" {
  *      opaque handler for encoder */
 typedef struct x265_encoder x265_encoder;
 
+/* x265_context:
+ *      opaque handler for process-wide encoder state shared by encoders */
+typedef struct x265_context x265_context;
+
 /* x265_picyuv:
  *      opaque handler for PicYuv */
 typedef struct x265_picyuv x265_picyuv;
@@ -311,6 +315,8 @@ typedef struct x265_frame_stats
     double           vmafFrameScore;
     double           bufferFillFinal;
     double           unclippedBufferFillFinal;
+    double           filterTime;
+    double           filterRowLatency;
 } x265_frame_stats;
 
 typedef struct x265_ctu_info_t
@@ -564,6 +570,7 @@ typedef enum
 
 #define X265_BFRAME_MAX         16
 #define X265_MAX_FRAME_THREADS  16
+#define X265_LATENCY_TRACE_FRAMES 1024
 
 #define X265_TYPE_AUTO          0x0000  /* Let x265 choose the right type */
 #define X265_TYPE_IDR           0x0001
@@ -671,6 +678,9 @@ typedef struct x265_stats
     x265_sliceType_stats  statsB;               /* statistics of B slice */
     uint16_t              maxCLL;               /* maximum content light level */
     uint16_t              maxFALL;              /* maximum frame average light level */
+    double                workerTime;           /* worker thread seconds spent on this encoder's jobs in shared pools */
+    double                poolShare;            /* fraction of the shared pools' worker time received since open */
+    uint32_t              deadlineMisses;       /* frames output later than their deadline (--deadline-sched) */
 } x265_stats;
 
 /* String values accepted by x265_param_parse() (and CLI) for various parameters */
@@ -1961,6 +1971,120 @@ typedef struct x265_param
 
     /* The offset by which QP is incremented for non-referenced inter-frames before a scenecut when bEnableSceneCutAwareQp is 2 or 3. */
     double    bwdNonRefQpDelta;
+
+    /* Run the deblocking and SAO filters of each frame as a separate job
+     * provider in the thread pool, trailing CTU compression by this many CTU
+     * rows (never less than the rows required by the enabled filters). The
+     * filter stage of a referenced frame is scheduled ahead of all frame
+     * encoders, since they block on its reconstructed rows. Requires WPP.
+     * Default 0, loop filters are interleaved with the row encoders */
+    int       filterLag;
+
+    /* Allocate the per-frame buffers (picture and lowres planes, CU data
+     * pools, frame add-on arrays) from a process-wide arena which keeps them
+     * cached when the encoder is closed, so subsequent encoders opened in the
+     * same process with compatible dimensions reuse them instead of going
+     * back to the system allocator. The cache is bounded by the estimated
+     * footprint of the encoders that were open concurrently and is released
+     * by x265_cleanup(). Default disabled */
+    int       bFrameArena;
+
+    /* Shared encoder context created by x265_context_create(). When set, the
+     * encoder borrows the context's thread pools instead of creating its own
+     * (numaPools is then ignored). The context must be created by the same
+     * libx265 build as the encoder. Default NULL */
+    x265_context* context;
+
+    /* Relative share of the shared thread pools' workers given to this
+     * encoder when other encoders are attached to the same context. Workers
+     * prefer the encoder which received the least worker time for its
+     * weight. Has no effect without a context. Default 1 */
+    int       poolWeight;
+
+    /* Deadline-aware scheduling of the frame encoders for live encoding.
+     * Worker threads prefer the frame encoder holding up the most CTU rows
+     * of other frame encoders, then the one whose frame is next in output
+     * order, instead of ranking them by slice type. Frames which are output
+     * later than their input time plus deadlineLatency are counted as
+     * deadline misses. Has no effect on the output bitstream. Default
+     * disabled */
+    int       bDeadlineSched;
+
+    /* Output latency budget of deadline scheduling, in milliseconds from the
+     * time a picture is passed to x265_encoder_encode(). 0 derives it from
+     * the frames the encoder holds: lookahead depth plus B-frames plus frame
+     * threads plus one frame durations at the frame rate. Default 0 */
+    int       deadlineLatency;
+
+    /* Number of output frames whose latency trace is kept in a ring buffer:
+     * the time each frame's picture was passed to x265_encoder_encode(), its
+     * slice type decided, its frame encoder started, row 0 allowed to start,
+     * its CTUs compressed, the frame finished and its access unit returned.
+     * x265_encoder_latency_trace() writes the ring as Chrome trace JSON.
+     * 0 disables tracing. Default 0 */
+    int       latencyTraceFrames;
+
+    /* File the latency trace is written to when the encoder is closed, or
+     * NULL. Setting it through x265_param_parse() enables tracing of
+     * X265_LATENCY_TRACE_FRAMES frames unless latencyTraceFrames is set.
+     * Default NULL */
+    const char* latencyTraceFile;
+
+    /* File the analysis effort of every CTU of every frame is written to: the
+     * time spent compressing it, the number of RD mode evaluations and motion
+     * searches, the shallowest and deepest CU depths chosen, and how many
+     * times VBV had it compressed. The layout is described in
+     * doc/reST/cli.rst. Default NULL, disabled */
+    const char* ctuStatsFile;
+
+    /* Enable writing a PGM heatmap of the CTU compression times of each
+     * frame, named <ctuStatsFile>.<POC>.pgm, with one pixel per CTU. Has no
+     * effect without ctuStatsFile. Default disabled */
+    int       bCtuHeatmap;
+
+    /* Enable searching the references of a list together: the integer pel
+     * DIA and HEX searches of up to four references are evaluated with one
+     * SAD primitive call per search point. The output is identical to
+     * separate searches. Has no effect with SEA, HME or analyze-src-pics.
+     * Default disabled */
+    int       bMultiRefME;
+
+    /* Enable the lookahead motion field as a source of motion search
+     * candidates. The lowres MVs of each frame, and the MVs of the lower
+     * resolution HME level, are upsampled once per frame into a field of
+     * candidates per 16x16 block, which seed the full-res searches in place
+     * of the single lowres MV. Allows a smaller merange at similar quality;
+     * the integer search steps per search are reported in the summary.
+     * Default disabled */
+    int       bMVField;
+
+    /* Enable speculative analysis of the four sub-CUs of the first split of
+     * each CTU. Idle worker threads analyse sub-CUs 1 to 3 concurrently
+     * with sub-CU 0, without access to the preceding sub-CUs of the CTU;
+     * their decisions are then coded in order with the final CABAC state
+     * and neighbours, and a sub-CU whose merge candidate no longer exists
+     * is analysed again. Applies to inter slices at rd levels 2 to 4; the
+     * output is deterministic but differs from an encode without it.
+     * Default disabled */
+    int       bSpeculativeSplit;
+
+    /* Enable refinement of the lookahead's luma weight estimates in the
+     * weighted prediction analysis of the frame encoders. The lookahead
+     * keeps the weights it finds for each reference distance; the analysis
+     * of list 0 searches a small window around them instead of its full
+     * range. Requires weightp; the output differs from an encode without
+     * it. Default disabled */
+    int       bWeightpRefine;
+
+    /* Memory budget, in MiB, for caching the luma sub-pel planes of reference
+     * frames used by the sub-pel refinement of motion searches. The planes of
+     * each fractional phase are interpolated one band of CTU rows at a time
+     * when a motion search first needs them, and are shared by all frame
+     * encoders referencing the frame, instead of being interpolated again
+     * for every candidate of every PU. Weighted references are not cached.
+     * The gain grows with subme; the output is unchanged. 0 disables.
+     * Default 0 */
+    int       subpelCacheSize;
 } x265_param;
 
 /* x265_param_alloc:
@@ -2200,6 +2324,30 @@ int x265_set_analysis_data(x265_encoder *encoder, x265_analysis_data *analysis_d
  *       release library static allocations, reset configured CTU size */
 void x265_cleanup(void);
 
+/* x265_context_create:
+ *       perform the process-wide encoder initialization once (CPU primitives,
+ *       motion vector cost tables) and create thread pools as configured by
+ *       param (numaPools, cpuid, logLevel; lookaheadThreads is ignored).
+ *       Encoders opened with param->context set to the returned handle
+ *       attach to these pools instead of spawning their own worker threads,
+ *       which makes x265_encoder_open() cheaper and lets several concurrent
+ *       encoders share the machine without oversubscribing it. Returns NULL
+ *       on failure */
+x265_context* x265_context_create(x265_param *);
+
+/* x265_context_free:
+ *       release the caller's reference on a shared context. The thread pools
+ *       are stopped once the last encoder using the context is closed */
+void x265_context_free(x265_context *);
+
+/* x265_encoder_latency_trace:
+ *       write the latency trace of the most recently output frames (see
+ *       param->latencyTraceFrames) to filename in the Chrome trace event
+ *       format, viewable in chrome://tracing or Perfetto. Must not be called
+ *       concurrently with x265_encoder_close(). Returns 0 on success, -1 if
+ *       tracing is disabled or the file could not be written */
+int x265_encoder_latency_trace(x265_encoder *, const char *filename);
+
 /* Open a CSV log file. On success it returns a file handle which must be passed
  * to x265_csvlog_frame() and/or x265_csvlog_encode(). The file handle must be
  * closed by the caller using fclose(). If csv-loglevel is 0, then no frame logging
@@ -2296,6 +2444,9 @@ typedef struct x265_api
     void          (*vmaf_encoder_log)(x265_encoder*, int, char**, x265_param *, x265_vmaf_data *);
 #endif
     int           (*zone_param_parse)(x265_param*, const char*, const char*);
+    x265_context* (*context_create)(x265_param*);
+    void          (*context_free)(x265_context*);
+    int           (*encoder_latency_trace)(x265_encoder*, const char*);
     /* add new pointers to the end, or increment X265_MAJOR_VERSION */
 } x265_api;
 
@@ -27,6 +27,7 @@
 
 #include "x265cli.h"
 #include "svt.h"
+#include "output/asyncoutput.h"
 
 #ifdef ENABLE_LSMASH
 #include <lsmash.h>
@@ -87,9 +88,15 @@ namespace X265_NS {
         H1("   --log-file-level <string>     Log-file logging level: none error warning info debug full. Default %s\n", X265_NS::logLevelNames[param->logfLevel + 1]);
         H1("   --progress-file <filename>    Save progress to file\n" );
         H0("   --no-progress                 Disable CLI progress reports\n");
+        H1("   --output-queue <integer>      Frames buffered for the output writer thread, 0 writes synchronously. Default 0\n");
+        H1("   --cmaf-chunk <integer>        Pictures per moof/mdat chunk of .cmaf output, 0 for one chunk per segment. Default 0\n");
         H0("   --stylish                     Enable x264-r2204 style awesome progress indicator\n");
         H0("   --csv <filename>              Comma separated log file, if csv-log-level > 0 frame level statistics, else one line per run\n");
         H0("   --csv-log-level <integer>     Level of csv logging, if csv-log-level > 0 frame level statistics, else one line per run: 0-2\n");
+        H1("   --latency-trace <filename>    Write per-frame latency stages of the last frames as Chrome trace JSON on close\n");
+        H1("   --latency-trace-frames <integer> Number of frames kept in the latency trace. Default %d with --latency-trace\n", X265_LATENCY_TRACE_FRAMES);
+        H1("   --ctu-stats <filename>        Write the compression time, RD evaluations, motion searches and CU depths of every CTU\n");
+        H1("   --[no-]ctu-heatmap            Also write a PGM heatmap of CTU compression times per frame. Default %s\n", OPT(param->bCtuHeatmap));
         H0("\nInput Options:\n");
         H0("   --input <filename>            Raw YUV or Y4M input file name. `-` for stdin\n");
         H1("   --y4m                         Force parsing of input stream as YUV4MPEG2 regardless of file extension\n");
@@ -132,6 +139,12 @@ namespace X265_NS {
         H0("   --[no-]slices <integer>       Enable Multiple Slices feature. Default %d\n", param->maxSlices);
         H0("   --[no-]pmode                  Parallel mode analysis. Default %s\n", OPT(param->bDistributeModeAnalysis));
         H0("   --[no-]pme                    Parallel motion estimation. Default %s\n", OPT(param->bDistributeMotionEstimation));
+        H1("   --[no-]speculative-split      Analyse the sub-CUs of the first CTU split in parallel, then code them in order. Default %s\n", OPT(param->bSpeculativeSplit));
+        H1("   --filter-lag <integer>        Run deblock/SAO as a pipeline stage trailing CTU compression by N rows. 0: inline. Default %d\n", param->filterLag);
+        H1("   --[no-]frame-arena            Cache per-frame buffers process-wide for reuse by later encoders. Default %s\n", OPT(param->bFrameArena));
+        H1("   --pool-weight <integer>       Share of the worker threads shared by the encodes of an ABR ladder. Default %d\n", param->poolWeight);
+        H1("   --[no-]deadline-sched         Schedule frame encoders by output deadline and blocked rows, count missed deadlines. Default %s\n", OPT(param->bDeadlineSched));
+        H1("   --deadline-latency <integer>  Output latency budget of deadline scheduling in ms. 0: from the frame rate. Default %d\n", param->deadlineLatency);
         H0("   --[no-]asm <bool|int|string>  Override CPU detection. Default: auto\n");
         H0("\nPresets:\n");
         H0("-p/--preset <string>             Trade off performance for compression efficiency. Default medium\n");
@@ -170,6 +183,7 @@ namespace X265_NS {
         H0("\nCoding tools:\n");
         H0("-w/--[no-]weightp                Enable weighted prediction in P slices. Default %s\n", OPT(param->bEnableWeightedPred));
         H0("   --[no-]weightb                Enable weighted prediction in B slices. Default %s\n", OPT(param->bEnableWeightedBiPred));
+        H1("   --[no-]weightp-refine         Refine the lookahead's luma weights instead of searching them again. Default %s\n", OPT(param->bWeightpRefine));
         H0("   --[no-]cu-lossless            Consider lossless mode in CU RDO decisions. Default %s\n", OPT(param->bCULossless));
         H0("   --[no-]signhide               Hide sign bit of one coeff per TU (rdo). Default %s\n", OPT(param->bEnableSignHiding));
         H1("   --[no-]tskip                  Enable intra 4x4 transform skipping. Default %s\n", OPT(param->bEnableTransformSkip));
@@ -187,6 +201,9 @@ namespace X265_NS {
         H1("   --[no-]hme                    Enable Hierarchical Motion Estimation. Default %s\n", OPT(param->bEnableHME));
         H1("   --hme-search <string>         Motion search-method for HME L0,L1 and L2. Default(L0,L1,L2) is %d,%d,%d\n", param->hmeSearchMethod[0], param->hmeSearchMethod[1], param->hmeSearchMethod[2]);
         H1("   --hme-range <int>,<int>,<int> Motion search-range for HME L0,L1 and L2. Default(L0,L1,L2) is %d,%d,%d\n", param->hmeRange[0], param->hmeRange[1], param->hmeRange[2]);
+        H1("   --[no-]multi-ref-me           Search the references of a list together with one SAD call per point. Default %s\n", OPT(param->bMultiRefME));
+        H1("   --[no-]mv-field               Seed the motion searches with the upsampled lookahead motion field. Default %s\n", OPT(param->bMVField));
+        H1("   --subpel-cache <integer>      MiB of reference sub-pel planes cached for motion search, 0 disables. Default %d\n", param->subpelCacheSize);
         H0("\nSpatial / intra options:\n");
         H0("   --[no-]strong-intra-smoothing Enable strong intra smoothing for 32x32 blocks. Default %s\n", OPT(param->bEnableStrongIntraSmoothing));
         H0("   --[no-]constrained-intra      Constrained intra prediction (use only intra coded reference pixels) Default %s\n", OPT(param->bEnableConstrainedIntra));
@@ -393,6 +410,7 @@ namespace X265_NS {
 #endif
         H0(" ABR-ladder settings\n");
         H0("   --abr-ladder <file>           File containing config settings required for the generation of ABR-ladder\n");
+        H0("   --abr-ladder-playlist <file>  Align the keyframes of all encodes to the first one and write an HLS master playlist of their .cmaf outputs\n");
         H1("\nExecutable return codes:\n");
         H1("    0 - encode successful\n");
         H1("    1 - unable to parse command line\n");
@@ -781,6 +799,9 @@ namespace X265_NS {
                 OPT2("frame-skip", "seek") this->seek = (uint32_t)x265_atoi(optarg, bError);
                 OPT("frames") this->framesToBeEncoded = (uint32_t)x265_atoi(optarg, bError);
                 OPT("no-progress") this->bProgress = false;
+                OPT("output-queue") this->outputQueue = x265_atoi(optarg, bError);
+                OPT("cmaf-chunk") this->cmafChunk = x265_atoi(optarg, bError);
+                OPT("abr-ladder-playlist") x265_log(NULL, X265_LOG_WARNING, "--abr-ladder-playlist requires --abr-ladder, ignored\n");
                 OPT("output") outputfn = optarg;
                 OPT("input") inputfn = optarg;
                 OPT("recon") reconfn = optarg;
@@ -1033,6 +1054,12 @@ namespace X265_NS {
             return true;
         }
         general_log_file(param, this->output->getName(), X265_LOG_INFO, "output file: %s\n", outputfn);
+        this->outputName = outputfn;
+        this->output->setChunkFrames(cmafChunk);
+#if ENABLE_THREADING
+        if (outputQueue > 0)
+            this->output = new AsyncOutput(this->output, outputQueue);
+#endif
         return false;
     }
 
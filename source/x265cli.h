@@ -64,6 +64,13 @@ static const struct option long_options[] =
     { "pmode",                no_argument, NULL, 0 },
     { "no-pme",               no_argument, NULL, 0 },
     { "pme",                  no_argument, NULL, 0 },
+    { "filter-lag",     required_argument, NULL, 0 },
+    { "frame-arena",          no_argument, NULL, 0 },
+    { "no-frame-arena",       no_argument, NULL, 0 },
+    { "pool-weight",    required_argument, NULL, 0 },
+    { "deadline-sched",       no_argument, NULL, 0 },
+    { "no-deadline-sched",    no_argument, NULL, 0 },
+    { "deadline-latency", required_argument, NULL, 0 },
     { "log-level",      required_argument, NULL, 0 },
     { "log-file",       required_argument, NULL, 0 },
     { "log-file-level", required_argument, NULL, 0 },
@@ -77,10 +84,17 @@ static const struct option long_options[] =
     { "no-allow-non-conformance",no_argument, NULL, 0 },
     { "csv",            required_argument, NULL, 0 },
     { "csv-log-level",  required_argument, NULL, 0 },
+    { "latency-trace",  required_argument, NULL, 0 },
+    { "latency-trace-frames", required_argument, NULL, 0 },
+    { "ctu-stats",      required_argument, NULL, 0 },
+    { "ctu-heatmap",          no_argument, NULL, 0 },
+    { "no-ctu-heatmap",       no_argument, NULL, 0 },
     { "no-cu-stats",          no_argument, NULL, 0 },
     { "cu-stats",             no_argument, NULL, 0 },
     { "y4m",                  no_argument, NULL, 0 },
     { "no-progress",          no_argument, NULL, 0 },
+    { "output-queue",   required_argument, NULL, 0 },
+    { "cmaf-chunk",     required_argument, NULL, 0 },
     { "stylish",              no_argument, NULL, 0 },
     { "output",         required_argument, NULL, 'o' },
     { "output-depth",   required_argument, NULL, 'D' },
@@ -115,6 +129,12 @@ static const struct option long_options[] =
     { "temporal-mvp",         no_argument, NULL, 0 },
     { "hme",                  no_argument, NULL, 0 },
     { "no-hme",               no_argument, NULL, 0 },
+    { "multi-ref-me",         no_argument, NULL, 0 },
+    { "no-multi-ref-me",      no_argument, NULL, 0 },
+    { "mv-field",             no_argument, NULL, 0 },
+    { "no-mv-field",          no_argument, NULL, 0 },
+    { "speculative-split",    no_argument, NULL, 0 },
+    { "no-speculative-split", no_argument, NULL, 0 },
     { "hme-search",     required_argument, NULL, 0 },
     { "rdpenalty",      required_argument, NULL, 0 },
     { "no-rect",              no_argument, NULL, 0 },
@@ -174,6 +194,9 @@ static const struct option long_options[] =
     { "weightp",              no_argument, NULL, 'w' },
     { "no-weightb",           no_argument, NULL, 0 },
     { "weightb",              no_argument, NULL, 0 },
+    { "no-weightp-refine",    no_argument, NULL, 0 },
+    { "weightp-refine",       no_argument, NULL, 0 },
+    { "subpel-cache",   required_argument, NULL, 0 },
     { "crf",            required_argument, NULL, 0 },
     { "crf-max",        required_argument, NULL, 0 },
     { "crf-min",        required_argument, NULL, 0 },
@@ -378,6 +401,7 @@ static const struct option long_options[] =
     { "no-cll", no_argument, NULL, 0 },
     { "hme-range", required_argument, NULL, 0 },
     { "abr-ladder", required_argument, NULL, 0 },
+    { "abr-ladder-playlist", required_argument, NULL, 0 },
     { "min-vbv-fullness", required_argument, NULL, 0 },
     { "max-vbv-fullness", required_argument, NULL, 0 },
     { 0, 0, 0, 0 },
@@ -392,6 +416,7 @@ static const struct option long_options[] =
         InputFile* input;
         ReconFile* recon;
         OutputFile* output;
+        const char* outputName;
         FILE*       qpfile;
         FILE*       zoneFile;
         FILE*    dolbyVisionRpu;    /* File containing Dolby Vision BL RPU metadata */
@@ -405,6 +430,8 @@ static const struct option long_options[] =
         uint32_t seek;              // number of frames to skip from the beginning
         uint32_t framesToBeEncoded; // number of frames to encode
         uint64_t totalbytes;
+        int outputQueue;            // frames buffered by the output writer thread, 0 for synchronous writes
+        int cmafChunk;              // pictures per CMAF chunk, 0 for one chunk per segment
         int64_t startTime;
         int64_t prevUpdateTime;
         int64_t prevUpdateTimeFile;
@@ -433,6 +460,7 @@ static const struct option long_options[] =
             input = NULL;
             recon = NULL;
             output = NULL;
+            outputName = NULL;
             qpfile = NULL;
             zoneFile = NULL;
             dolbyVisionRpu = NULL;
@@ -442,6 +470,8 @@ static const struct option long_options[] =
             vmafData = NULL;
             framesToBeEncoded = seek = 0;
             totalbytes = 0;
+            outputQueue = 0;
+            cmafChunk = 0;
             bProgress = true;
             bForceY4m = false;
             startTime = x265_mdate();